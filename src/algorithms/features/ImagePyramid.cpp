@@ -0,0 +1,168 @@
+#include "ImagePyramid.hpp"
+
+#include "helpers/cpu_features.hpp"
+
+#include <stdexcept>
+
+#include <boost/gil/image_view.hpp>
+#include <boost/gil/image_view_factory.hpp>
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <emmintrin.h>
+#endif
+
+namespace uniclop
+{
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Half sampling kernels
+
+static inline void scalar_half_sample_row(const uint8_t *row0, const uint8_t *row1,
+                                          uint8_t *dst, const int x_begin, const int x_end)
+{
+    int x;
+    for (x = x_begin; x < x_end; x+=1)
+    {
+        const int sum = row0[2*x] + row0[2*x + 1] + row1[2*x] + row1[2*x + 1];
+        dst[x] = static_cast<uint8_t>((sum + 2) >> 2);
+    }
+    return;
+}
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define IMAGE_PYRAMID_X86_KERNELS
+
+/// 16 output pixels per iteration, the sums are done in 16 bits so the rounding is exact
+__attribute__((target("sse2")))
+static int sse2_half_sample_row(const uint8_t *row0, const uint8_t *row1,
+                                uint8_t *dst, const int dst_width)
+{
+    const __m128i low_bytes_mask = _mm_set1_epi16(0x00FF);
+    const __m128i two = _mm_set1_epi16(2);
+
+    int x = 0;
+    for (; x + 16 <= dst_width; x+=16)
+    {
+        const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + 2*x));
+        const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + 2*x + 16));
+        const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + 2*x));
+        const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + 2*x + 16));
+
+        // even pixels are in the low bytes, odd pixels in the high bytes
+        __m128i sum0 = _mm_add_epi16(_mm_and_si128(a0, low_bytes_mask), _mm_srli_epi16(a0, 8));
+        sum0 = _mm_add_epi16(sum0, _mm_add_epi16(_mm_and_si128(b0, low_bytes_mask), _mm_srli_epi16(b0, 8)));
+        __m128i sum1 = _mm_add_epi16(_mm_and_si128(a1, low_bytes_mask), _mm_srli_epi16(a1, 8));
+        sum1 = _mm_add_epi16(sum1, _mm_add_epi16(_mm_and_si128(b1, low_bytes_mask), _mm_srli_epi16(b1, 8)));
+
+        sum0 = _mm_srli_epi16(_mm_add_epi16(sum0, two), 2);
+        sum1 = _mm_srli_epi16(_mm_add_epi16(sum1, two), 2);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), _mm_packus_epi16(sum0, sum1));
+    }
+    return x;
+}
+
+#endif // IMAGE_PYRAMID_X86_KERNELS
+
+void half_sample(const uint8_t *src, const int src_stride,
+                 uint8_t *dst, const int dst_width, const int dst_height, const int dst_stride)
+{
+#if defined(IMAGE_PYRAMID_X86_KERNELS)
+    static const bool use_sse2 = cpu_has_sse2();
+#endif
+
+    int y;
+    for (y = 0; y < dst_height; y+=1)
+    {
+        const uint8_t *row0 = src + (2*y)*src_stride;
+        const uint8_t *row1 = row0 + src_stride;
+        uint8_t *dst_row = dst + y*dst_stride;
+
+        int x = 0;
+#if defined(IMAGE_PYRAMID_X86_KERNELS)
+        if (use_sse2)
+            x = sse2_half_sample_row(row0, row1, dst_row, dst_width);
+#endif
+        scalar_half_sample_row(row0, row1, dst_row, x, dst_width);
+    }
+
+    return;
+}
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// class ImagePyramid methods implementation
+
+ImagePyramid::ImagePyramid(const int _max_levels)
+{
+    max_levels = _max_levels;
+    if (max_levels < 1)
+        throw runtime_error("ImagePyramid requires at least one level");
+
+    levels_data.resize(max_levels);
+    levels.reserve(max_levels);
+    return;
+}
+
+ImagePyramid::~ImagePyramid()
+{
+    return;
+}
+
+void ImagePyramid::compute(const gray8c_view_t &view)
+{
+    levels.clear();
+    levels.push_back(view);
+
+    const uint8_t *src = boost::gil::interleaved_view_get_raw_data(view);
+    int src_stride = static_cast<int>(view.pixels().row_size());
+    int width = view.dimensions()[0], height = view.dimensions()[1];
+
+    int level;
+    for (level = 1; level < max_levels; level+=1)
+    {
+        width /= 2;
+        height /= 2;
+        if (width < min_level_size || height < min_level_size)
+            break;
+
+        // resize keeps the memory when the image size does not change
+        vector<uint8_t> &data = levels_data[level];
+        data.resize(width*height);
+
+        half_sample(src, src_stride, &data[0], width, height, width);
+
+        levels.push_back(boost::gil::interleaved_view(
+                             width, height,
+                             reinterpret_cast<const boost::gil::gray8_pixel_t *>(&data[0]), width));
+        src = &data[0];
+        src_stride = width;
+    }
+
+    return;
+}
+
+int ImagePyramid::get_num_levels() const
+{
+    return static_cast<int>(levels.size());
+}
+
+int ImagePyramid::get_max_levels() const
+{
+    return max_levels;
+}
+
+const gray8c_view_t &ImagePyramid::get_level(const int level) const
+{
+    return levels[level];
+}
+
+const uint8_t *ImagePyramid::get_level_data(const int level) const
+{
+    return boost::gil::interleaved_view_get_raw_data(levels[level]);
+}
+
+int ImagePyramid::get_level_stride(const int level) const
+{
+    return static_cast<int>(levels[level].pixels().row_size());
+}
+
+}
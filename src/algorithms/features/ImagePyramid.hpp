@@ -0,0 +1,80 @@
+#if !defined(IMAGE_PYRAMID_HEADER_INCLUDED)
+#define IMAGE_PYRAMID_HEADER_INCLUDED
+
+// Features detection
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Headers
+
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/gil/typedefs.hpp>
+
+namespace uniclop
+{
+
+using namespace std;
+
+using boost::uint8_t;
+using boost::gil::gray8c_view_t;
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Classes definition
+
+/**
+Half sample image pyramid, computed once per frame and shared by the consumers
+(multi-scale FAST detection, KLT trackers).
+
+The level 0 is the input view itself (it is not copied, so it must stay valid
+while the pyramid is used), each next level is a 2x2 box filtered half sample of the
+previous one: pixel (x, y) of level l covers the pixels [x*2^l, (x+1)*2^l) of level 0.
+The downsampling uses SSE2 when available, the scalar fallback gives the same values.
+
+The levels memory is kept between frames, at steady state no allocation is done.
+The level 0 keeps the stride of the input view, the next levels are stored
+contiguously (stride equal to the width).
+*/
+class ImagePyramid
+{
+
+    int max_levels;
+
+    vector< vector<uint8_t> > levels_data; ///< levels_data[0] is unused, the level 0 is the input view
+    vector<gray8c_view_t> levels;
+
+public:
+
+    /// levels smaller than this size are not computed
+    static const int min_level_size = 16;
+
+    ImagePyramid(const int max_levels);
+    ~ImagePyramid();
+
+    void compute(const gray8c_view_t &view);
+
+    /// number of levels computed for the last view, lower or equal to max_levels
+    int get_num_levels() const;
+    int get_max_levels() const;
+
+    const gray8c_view_t &get_level(const int level) const;
+
+    /// raw pixels of the level (e.g. for the KLT C code), rows are get_level_stride(level) bytes apart
+    const uint8_t *get_level_data(const int level) const;
+    int get_level_stride(const int level) const;
+
+    /// level 0 coordinates of the center of the pixel x of the given level
+    static int to_level_zero(const int x, const int level)
+    {
+        return (x << level) + ((1 << level) >> 1);
+    }
+};
+
+/// 2x2 box filter and half sampling, dst[x] = (sum of the 4 pixels + 2) / 4.
+/// dst_width and dst_height should be at most src_width/2 and src_height/2
+void half_sample(const uint8_t *src, const int src_stride,
+                 uint8_t *dst, const int dst_width, const int dst_height, const int dst_stride);
+
+}
+
+#endif // IMAGE_PYRAMID_HEADER_INCLUDED
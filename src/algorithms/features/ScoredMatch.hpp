@@ -9,6 +9,7 @@
 
 #include "IFeature.hpp"
 
+#include <vector>
 #include <stdexcept>
 
 namespace uniclop
@@ -27,6 +28,10 @@ public:
     ///< the vector memory area will change as its content grows
     ///< should only keep pointers to std::list
 
+    int index_a, index_b;
+    ///< index of the features A and B in their respective features sets
+    ///< (e.g. FASTFeatureSet), -1 when the match was built from IFeature pointers
+
     float distance;
     ///< distance between features A and B (given a metric)
 
@@ -34,6 +39,8 @@ public:
     {
         feature_a = NULL;
         feature_b = NULL;
+        index_a = -1;
+        index_b = -1;
         distance = -1;
         return;
     }
@@ -42,14 +49,28 @@ public:
     {
         feature_a = a;
         feature_b = b;
+        index_a = -1;
+        index_b = -1;
         distance = a->distance(*b);
         return;
     }
 
+    ScoredMatch(const int a, const int b, const float _distance)
+    {
+        feature_a = NULL;
+        feature_b = NULL;
+        index_a = a;
+        index_b = b;
+        distance = _distance;
+        return;
+    }
+
     ScoredMatch(const ScoredMatch &m)
     {
         feature_a = m.feature_a;
         feature_b = m.feature_b;
+        index_a = m.index_a;
+        index_b = m.index_b;
         distance = m.distance;
         return;
     }
@@ -70,6 +91,22 @@ public:
 
 };
 
+
+/// The parametric models read the features coordinates through feature_a and feature_b,
+/// so the matches that only hold features indexes (e.g. FASTFeaturesMatcher::match over
+/// FASTFeatureSet) can not be given to the model estimators.
+/// Returns false if any of the matches has no feature pointers
+inline bool have_features(const std::vector< ScoredMatch > &matches)
+{
+    std::vector< ScoredMatch >::const_iterator matches_it;
+    for (matches_it = matches.begin(); matches_it != matches.end(); ++matches_it)
+    {
+        if (matches_it->feature_a == NULL || matches_it->feature_b == NULL)
+            return false;
+    }
+    return true;
+}
+
 } // end of namespace uniclop
 
 
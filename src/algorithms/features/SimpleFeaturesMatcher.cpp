@@ -13,6 +13,8 @@
 // implementation specific headers
 #include <iostream> // cout definition
 #include <limits> // to use numeric_limits<float>::max() and similars
+#include <stdexcept>
+#include <algorithm>
 
 
 namespace uniclop
@@ -20,6 +22,47 @@ namespace uniclop
 
 using namespace std;
 
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Distances helpers
+
+/// Computes out[i] = feature_a.distance(features_b[i]).
+/// The feature type is known at compile time, so the calls are not virtual
+template<typename T>
+inline void compute_distances(const T &feature_a, const vector<T> &features_b, float *out)
+{
+    const size_t num_features = features_b.size();
+    size_t i;
+    for (i=0; i < num_features; i+=1)
+        out[i] = feature_a.distance(features_b[i]);
+    return;
+}
+
+/// FASTFeature specialization, uses the batched SIMD kernels
+template<>
+inline void compute_distances<FASTFeature>(const FASTFeature &feature_a, const vector<FASTFeature> &features_b,
+                                           float *out)
+{
+    if (features_b.empty() == false)
+        distances(feature_a, &features_b[0], features_b.size(), out);
+    return;
+}
+
+/// Returns the distance if it is lower or equal to bound, otherwise any value greater than bound.
+/// The generic version computes the complete distance
+template<typename T>
+inline float bounded_distance(const T &feature_a, const T &feature_b, const float)
+{
+    return feature_a.distance(feature_b);
+}
+
+/// FASTFeature specialization, stops the sum of squared differences once it exceeds the bound
+template<>
+inline float bounded_distance<FASTFeature>(const FASTFeature &feature_a, const FASTFeature &feature_b,
+                                           const float bound)
+{
+    return feature_a.distance(feature_b, bound);
+}
+
 // ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
 // ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
 // Class SimpleFeaturesMatcher methods implementations
@@ -37,6 +80,9 @@ args::options_description SimpleFeaturesMatcher<T>::get_options_description()
     ( "simple_features_matcher.num_near_features", args::value<int>()->default_value(3),
       "for each feature the nearest num_near_features will be proposed as putative matches")
 
+    ( "simple_features_matcher.search_radius", args::value<int>()->default_value(0),
+      "only match features whose x and y coordinates differ by at most search_radius pixels. 0 means no limit")
+
     ;
 
     return desc;
@@ -60,6 +106,23 @@ SimpleFeaturesMatcher<T>::SimpleFeaturesMatcher(args::variables_map &options)
         _num_near_features = options["simple_features_matcher.num_near_features"].as<int>();
     }
 
+    _search_radius = 0;
+    if ( options.count("simple_features_matcher.search_radius") )
+    {
+        _search_radius = options["simple_features_matcher.search_radius"].as<int>();
+    }
+
+    if (_search_radius > 0)
+    { // with cells of the radius size, each query visits at most 3x3 cells
+        features_b_grid_p.reset(new SpatialGridIndex(_search_radius));
+    }
+
+    if (_num_near_features < 1)
+        throw runtime_error("SimpleFeaturesMatcher requires simple_features_matcher.num_near_features >= 1");
+
+    candidate_indices.resize(_num_near_features);
+    candidate_distances.resize(_num_near_features);
+
     return;
 }
 
@@ -81,91 +144,111 @@ vector< ScoredMatch >& SimpleFeaturesMatcher<T>::match(
 
     const float &max_distance = _max_distance;
     const int &num_near_features = _num_near_features;
+    const int &search_radius = _search_radius;
+    const bool use_search_window = search_radius > 0;
+
+    // the memory is kept between calls, so these only allocate when the lists grow
+    matchings.reserve(features_list_a.size() * num_near_features);
 
-    typename vector<T>::const_iterator features_it_a, features_it_b;
+    const int num_features_b = static_cast<int>(features_list_b.size());
 
-    for (features_it_a = features_list_a.begin();
-            features_it_a != features_list_a.end();
-            ++features_it_a)
+    if (use_search_window)
+        features_b_grid_p->build(features_list_b); // O(N)
+    else
+        distances_to_b.resize(features_list_b.size());
+
+    int index_a;
+    for (index_a = 0; index_a < static_cast<int>(features_list_a.size()); index_a+=1)
     { // for each feature in list a
 
+        const T &feature_a = features_list_a[index_a];
+
         // search for the num_near_features nearest features
+        int num_candidates = 0, worst_candidate = 0;
 
-        vector< ScoredMatch > candidate_matches(num_near_features);
-        // keep the list of candidates for the current feature
-
-        typename vector< ScoredMatch >::iterator candidate_matches_it;
-
-        typename vector< ScoredMatch >::iterator worst_candidate_it = candidate_matches.begin();
-
-        for (features_it_b = features_list_b.begin();
-                features_it_b != features_list_b.end();
-                ++features_it_b)
-        { // for each feature in list b
-
-            float t_distance = features_it_a->distance( *features_it_b );
-
-            if (t_distance > max_distance) break;
-            // distance is out of the range of interest, so we skip this one
-
-            // we suppose that num_near_features is small so a direct iteration
-            // over the candidates list is the fastest option
-            for (candidate_matches_it = candidate_matches.begin();
-                    candidate_matches_it != candidate_matches.end();
-                    ++candidate_matches_it)
-            { // search for the worst candidate
-
-                if ( candidate_matches_it->feature_a != &(*features_it_a) )
-                {
-                    // candidate slot has not been initialized
-                    // by default this is the worst one
-                    worst_candidate_it = candidate_matches_it;
-
-                    // we set some members (the others will be done later)
-                    worst_candidate_it->feature_a = &(*features_it_a);
-                    worst_candidate_it->distance = numeric_limits<float>::max();
-
-                    break; // stop searching for worst
-                }
-                else
-                { // if candidate has been initialized
-                    if ( (worst_candidate_it->distance) < (candidate_matches_it->distance) )
-                    { // this one is the worst found up to now
-                        worst_candidate_it = candidate_matches_it;
-                    }
-                }
-            } // end of 'search for the worst candidate'
-
-            if ( (worst_candidate_it->distance) > t_distance)
-            { // current candidate is better than the worst of the previous ones
-                // thus we replace it
-                worst_candidate_it->feature_b = &(*features_it_b);
-                worst_candidate_it->distance = t_distance;
-            }
+        if (use_search_window)
+        { // only visit the features of list b inside the window
 
-        } // end of 'for each feature in list b'
+            features_b_grid_p->rectangle_query(feature_a.x - search_radius, feature_a.y - search_radius,
+                                               feature_a.x + search_radius, feature_a.y + search_radius,
+                                               window_indexes);
+            vector<int>::const_iterator window_it;
+            for (window_it = window_indexes.begin(); window_it != window_indexes.end(); ++window_it)
+            {
+                const int index_b = *window_it;
+                const T &feature_b = features_list_b[index_b];
 
+                // once the candidates list is full, there is no need to compute
+                // the exact distance of a feature worse than the worst candidate
+                float bound = max_distance;
+                if (num_candidates == num_near_features)
+                    bound = min(bound, candidate_distances[worst_candidate]);
 
-        typename vector< ScoredMatch >::const_iterator const_candidate_matches_it;
+                add_candidate(index_b, bounded_distance(feature_a, feature_b, bound),
+                              num_candidates, worst_candidate);
+            }
+        }
+        else
+        { // all the distances of the row are computed in a single batch
 
-        // now candidate_matches has the list of putative matches for feature_a
-        for (const_candidate_matches_it = candidate_matches.begin();
-                const_candidate_matches_it != candidate_matches.end();
-                ++const_candidate_matches_it)
-        { // add the putative matches to the result list
+            compute_distances(feature_a, features_list_b, &distances_to_b[0]);
 
-            if ( const_candidate_matches_it->feature_a == &(*features_it_a) ) // sanity check
-            {
-                matchings.push_back(*const_candidate_matches_it); // copy the content
+            int index_b;
+            for (index_b = 0; index_b < num_features_b; index_b+=1)
+            { // for each feature in list b
+                add_candidate(index_b, distances_to_b[index_b], num_candidates, worst_candidate);
             }
         }
 
+        // now the candidates are the putative matches for feature_a
+        int c;
+        for (c = 0; c < num_candidates; c+=1)
+        { // add the putative matches to the result list
+            matchings.push_back(ScoredMatch(index_a, candidate_indices[c], candidate_distances[c]));
+            matchings.back().feature_a = &feature_a;
+            matchings.back().feature_b = &features_list_b[candidate_indices[c]];
+        }
+
     } // end of 'for each feature in list a'
 
     return matchings;
 }
 
 
+template<typename T>
+inline void SimpleFeaturesMatcher<T>::add_candidate(const int index_b, const float t_distance,
+        int &num_candidates, int &worst_candidate)
+{
+    if (t_distance > _max_distance)
+        return; // distance is out of the range of interest, so we skip this one
+
+    // we suppose that num_near_features is small so a direct iteration
+    // over the candidates list is the fastest option
+    if (num_candidates < _num_near_features)
+    { // free slot available
+        candidate_indices[num_candidates] = index_b;
+        candidate_distances[num_candidates] = t_distance;
+        if (candidate_distances[worst_candidate] < t_distance)
+            worst_candidate = num_candidates;
+        num_candidates += 1;
+    }
+    else if (candidate_distances[worst_candidate] > t_distance)
+    { // current candidate is better than the worst of the previous ones
+        // thus we replace it, and search for the new worst
+        candidate_indices[worst_candidate] = index_b;
+        candidate_distances[worst_candidate] = t_distance;
+
+        int c;
+        for (c = 0; c < num_candidates; c+=1)
+        {
+            if (candidate_distances[worst_candidate] < candidate_distances[c])
+                worst_candidate = c;
+        }
+    }
+    return;
+}
+
+
 // ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
 // Force the compilation of the following types
 // for some strange reason, in linux, this hast to be at the end of the defitions (?!)
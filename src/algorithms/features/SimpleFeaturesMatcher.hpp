@@ -3,9 +3,11 @@
 #define SIMPLE_FEATURES_MATCHER_HEADER
 
 #include "IFeaturesMatcher.hpp"
+#include "SpatialGridIndex.hpp"
 
 #include <vector>
 #include <boost/program_options.hpp>
+#include <boost/scoped_ptr.hpp>
 
 namespace uniclop
 {
@@ -25,6 +27,23 @@ class SimpleFeaturesMatcher: public IFeaturesMatcher<F>
     float _max_distance;
     int _num_near_features;
     // for each feature, search the num_near_features nearest with respect to a distance threshold
+
+    int _search_radius;
+    // when > 0, only the features of list b inside a (2*radius + 1) pixels square window are considered
+
+    ///@name buffers reused between calls, at steady state match does not allocate memory
+    ///@{
+    vector<int> candidate_indices; ///< the num_near_features best candidates of the current feature
+    vector<float> candidate_distances;
+    vector<float> distances_to_b; ///< distances between the current feature and all the features of list b
+    boost::scoped_ptr<SpatialGridIndex> features_b_grid_p; ///< NULL when not using a search window
+    vector<int> window_indexes; ///< indexes of the features b inside the current search window
+    ///@}
+
+    /// keeps the num_near_features nearest candidates
+    inline void add_candidate(const int index_b, const float distance,
+                              int &num_candidates, int &worst_candidate);
+
 public:
 
     static args::options_description get_options_description();
@@ -0,0 +1,186 @@
+#include "SpatialGridIndex.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace uniclop
+{
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// class SpatialGridIndex methods implementation
+
+SpatialGridIndex::SpatialGridIndex(const int _cell_size)
+{
+    cell_size = _cell_size;
+    if (cell_size < 1)
+        throw runtime_error("SpatialGridIndex cell_size should be positive");
+
+    effective_cell_size = cell_size;
+    min_x = 0;
+    min_y = 0;
+    num_columns = 0;
+    num_rows = 0;
+    return;
+}
+
+SpatialGridIndex::~SpatialGridIndex()
+{
+    return;
+}
+
+void SpatialGridIndex::build(const vector<int> &x, const vector<int> &y)
+{
+    if (x.size() != y.size())
+        throw runtime_error("SpatialGridIndex::build expects as many x as y values");
+
+    const int num_points = x.size();
+
+    sorted_indexes.resize(num_points);
+    sorted_x.resize(num_points);
+    sorted_y.resize(num_points);
+    points_cell.resize(num_points);
+
+    if (num_points == 0)
+    {
+        num_columns = 0;
+        num_rows = 0;
+        cell_start.assign(1, 0);
+        return;
+    }
+
+    const int max_x = *max_element(x.begin(), x.end());
+    const int max_y = *max_element(y.begin(), y.end());
+    min_x = *min_element(x.begin(), x.end());
+    min_y = *min_element(y.begin(), y.end());
+
+    // far away outliers would create a huge grid, so the number of cells is bounded
+    const long max_cells = max(1024, 4*num_points);
+    effective_cell_size = cell_size;
+    while (true)
+    {
+        num_columns = (max_x - min_x) / effective_cell_size + 1;
+        num_rows = (max_y - min_y) / effective_cell_size + 1;
+        if (static_cast<long>(num_columns) * num_rows <= max_cells)
+            break;
+        effective_cell_size *= 2;
+    }
+
+    // counting sort --
+    const int num_cells = num_columns * num_rows;
+    cell_start.assign(num_cells + 1, 0);
+
+    int i;
+    for (i=0; i < num_points; i+=1)
+    {
+        const int column = (x[i] - min_x) / effective_cell_size;
+        const int row = (y[i] - min_y) / effective_cell_size;
+        points_cell[i] = row*num_columns + column;
+        cell_start[points_cell[i] + 1] += 1;
+    }
+
+    int cell;
+    for (cell = 0; cell < num_cells; cell+=1)
+        cell_start[cell + 1] += cell_start[cell];
+
+    // cell_start[cell] is used as insertion cursor, then restored
+    for (i=0; i < num_points; i+=1)
+    {
+        const int position = cell_start[points_cell[i]]++;
+        sorted_indexes[position] = i;
+        sorted_x[position] = x[i];
+        sorted_y[position] = y[i];
+    }
+
+    for (cell = num_cells; cell > 0; cell-=1)
+        cell_start[cell] = cell_start[cell - 1];
+    cell_start[0] = 0;
+
+    return;
+}
+
+template<typename Visitor>
+void SpatialGridIndex::visit_cells(const int x_min, const int y_min, const int x_max, const int y_max,
+                                   Visitor &visitor) const
+{
+    if (num_columns == 0 || x_max < x_min || y_max < y_min || x_max < min_x || y_max < min_y)
+        return;
+
+    // clamp the rectangle to the grid
+    const int first_column = max(0, x_min - min_x) / effective_cell_size;
+    const int first_row = max(0, y_min - min_y) / effective_cell_size;
+    const int last_column = min(num_columns - 1, (x_max - min_x) / effective_cell_size);
+    const int last_row = min(num_rows - 1, (y_max - min_y) / effective_cell_size);
+
+    int row, column, k;
+    for (row = first_row; row <= last_row; row+=1)
+    {
+        for (column = first_column; column <= last_column; column+=1)
+        {
+            const int cell = row*num_columns + column;
+            for (k = cell_start[cell]; k < cell_start[cell + 1]; k+=1)
+                visitor(sorted_indexes[k], sorted_x[k], sorted_y[k]);
+        }
+    }
+    return;
+}
+
+class RectangleFilter
+{
+    const int x_min, y_min, x_max, y_max;
+    vector<int> &indexes;
+
+public:
+    RectangleFilter(const int _x_min, const int _y_min, const int _x_max, const int _y_max,
+                    vector<int> &_indexes)
+            : x_min(_x_min), y_min(_y_min), x_max(_x_max), y_max(_y_max), indexes(_indexes)
+    {
+        return;
+    }
+
+    void operator()(const int index, const int x, const int y)
+    {
+        if (x >= x_min && x <= x_max && y >= y_min && y <= y_max)
+            indexes.push_back(index);
+        return;
+    }
+};
+
+class RadiusFilter
+{
+    const int center_x, center_y, squared_radius;
+    vector<int> &indexes;
+
+public:
+    RadiusFilter(const int _x, const int _y, const int radius, vector<int> &_indexes)
+            : center_x(_x), center_y(_y), squared_radius(radius*radius), indexes(_indexes)
+    {
+        return;
+    }
+
+    void operator()(const int index, const int x, const int y)
+    {
+        const int dx = x - center_x, dy = y - center_y;
+        if (dx*dx + dy*dy <= squared_radius)
+            indexes.push_back(index);
+        return;
+    }
+};
+
+void SpatialGridIndex::rectangle_query(const int x_min, const int y_min, const int x_max, const int y_max,
+                                       vector<int> &indexes) const
+{
+    indexes.clear();
+    RectangleFilter filter(x_min, y_min, x_max, y_max, indexes);
+    visit_cells(x_min, y_min, x_max, y_max, filter);
+    return;
+}
+
+void SpatialGridIndex::radius_query(const int x, const int y, const int radius, vector<int> &indexes) const
+{
+    indexes.clear();
+    RadiusFilter filter(x, y, radius, indexes);
+    visit_cells(x - radius, y - radius, x + radius, y + radius, filter);
+    return;
+}
+
+}
@@ -0,0 +1,90 @@
+#if !defined(SPATIAL_GRID_INDEX_HEADER_INCLUDED)
+#define SPATIAL_GRID_INDEX_HEADER_INCLUDED
+
+// Noisy features matching
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Headers
+
+#include <vector>
+#include <cstddef>
+
+namespace uniclop
+{
+
+using namespace std;
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Classes definition
+
+/**
+Uniform grid over the features positions, used to restrict the matching candidates
+to a search window (between consecutive video frames the displacements are bounded).
+
+build() buckets the points with a counting sort, in O(N).
+The queries return the indexes of the points (in the order given to build),
+grouped by cell and ascending inside each cell.
+All the buffers are kept between calls (including the indexes vector given to the queries),
+so at steady state neither build nor the queries allocate memory.
+*/
+class SpatialGridIndex
+{
+
+    int cell_size; ///< requested cell size, in pixels
+    int effective_cell_size; ///< may be larger than cell_size to bound the number of cells
+    int min_x, min_y;
+    int num_columns, num_rows;
+
+    vector<int> cell_start; ///< first position in sorted_indexes of each cell, num_cells + 1 values
+    vector<int> sorted_indexes; ///< points indexes, grouped by cell
+    vector<int> sorted_x, sorted_y; ///< points positions, in the same order as sorted_indexes
+    vector<int> points_cell;
+
+    vector<int> points_x, points_y; ///< used by the templated build
+
+public:
+
+    SpatialGridIndex(const int cell_size);
+    ~SpatialGridIndex();
+
+    void build(const vector<int> &x, const vector<int> &y);
+
+    /// F is any type with x and y members (IFeature, SURF Ipoint, ...), the positions are truncated to int
+    template<typename F>
+    void build(const vector<F> &features)
+    {
+        points_x.resize(features.size());
+        points_y.resize(features.size());
+        size_t i;
+        for (i=0; i < features.size(); i+=1)
+        {
+            points_x[i] = static_cast<int>(features[i].x);
+            points_y[i] = static_cast<int>(features[i].y);
+        }
+        build(points_x, points_y);
+        return;
+    }
+
+    size_t size() const
+    {
+        return sorted_indexes.size();
+    }
+
+    /// points with x_min <= x <= x_max and y_min <= y <= y_max
+    void rectangle_query(const int x_min, const int y_min, const int x_max, const int y_max,
+                         vector<int> &indexes) const;
+
+    /// points with (x - px)^2 + (y - py)^2 <= radius^2
+    void radius_query(const int x, const int y, const int radius, vector<int> &indexes) const;
+
+private:
+
+    /// calls visitor(index, x, y) for all the points in the cells touched by the rectangle
+    template<typename Visitor>
+    void visit_cells(const int x_min, const int y_min, const int x_max, const int y_max,
+                     Visitor &visitor) const;
+};
+
+}
+
+#endif // SPATIAL_GRID_INDEX_HEADER_INCLUDED
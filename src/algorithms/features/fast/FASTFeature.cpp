@@ -2,7 +2,13 @@
 
 #include "FASTFeature.hpp"
 
+#include "helpers/cpu_features.hpp"
+
 #include <stdexcept>
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <immintrin.h>
+#endif
 
 namespace uniclop
 {
@@ -12,6 +18,7 @@ namespace uniclop
 
 FASTFeature::FASTFeature()
 {
+    level = 0;
     return;
 }
 
@@ -19,6 +26,7 @@ FASTFeature::FASTFeature(const FASTFeature& f) : IFeature()
 {
     x = f.x;
     y = f.y;
+    level = f.level;
 
     int i;
     for (i=0;i<16;i+=1)
@@ -48,21 +56,179 @@ template <class R, class D, class T> struct SumSquaredDifferences
 };
 
 /// Compute sum of (a_i - b_i)^2 (the SSD)
-/// This is accelerated using SIMD for some platforms and data types (alignment is checked at runtime)
 /// Do not specify template parameters explicitly so that overloading can choose the right implementation
-/// Look at LibCVD to get the SIMD accelerated versions
+/// This is the scalar reference, the SIMD accelerated versions for the 16 circle intensities are below
 template <class T> inline float sum_squared_differences(const T* a, const T* b, size_t count)
 {
     return SumSquaredDifferences<float,float,T>::sum_squared_differences(a,b,count);
 }
 
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// SSD kernels for the 16 bytes descriptors
+// all the partial sums are integers lower than 2^24 (16*255*255),
+// so the SIMD and scalar versions give exactly the same float values
+
+typedef void (*distances_function_t)(const uint8_t *query,
+                                     const uint8_t *many, const size_t stride, const size_t n,
+                                     float *out);
+
+static void scalar_distances(const uint8_t *query,
+                             const uint8_t *many, const size_t stride, const size_t n,
+                             float *out)
+{
+    size_t i;
+    for (i=0; i < n; i+=1, many+=stride)
+        out[i] = sum_squared_differences(query, many, 16);
+    return;
+}
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define FAST_FEATURE_X86_KERNELS
+
+// the target attributes allow to compile the kernels without changing the global compiler flags
+#define SSE2_TARGET __attribute__((target("sse2")))
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+/// four int32 partial sums of the squared differences between two descriptors
+SSE2_TARGET static inline __m128i sse2_partial_ssd(const __m128i a, const __m128i b)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    // |a - b| fits in uint8_t, then is expanded to int16 and squared by pmaddwd
+    const __m128i absolute_difference = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+    const __m128i low = _mm_unpacklo_epi8(absolute_difference, zero);
+    const __m128i high = _mm_unpackhi_epi8(absolute_difference, zero);
+    return _mm_add_epi32(_mm_madd_epi16(low, low), _mm_madd_epi16(high, high));
+}
+
+SSE2_TARGET static inline float sse2_ssd(const __m128i a, const __m128i b)
+{
+    __m128i sum = sse2_partial_ssd(a, b);
+    sum = _mm_add_epi32(sum, _mm_unpackhi_epi64(sum, sum));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 1, 1, 1)));
+    return static_cast<float>(_mm_cvtsi128_si32(sum));
+}
+
+SSE2_TARGET static void sse2_distances(const uint8_t *query,
+                                       const uint8_t *many, const size_t stride, const size_t n,
+                                       float *out)
+{
+    const __m128i q = _mm_loadu_si128(reinterpret_cast<const __m128i *>(query));
+
+    size_t i = 0;
+    for (; i + 4 <= n; i+=4, many+=4*stride)
+    {
+        const __m128i s0 = sse2_partial_ssd(q, _mm_loadu_si128(reinterpret_cast<const __m128i *>(many)));
+        const __m128i s1 = sse2_partial_ssd(q, _mm_loadu_si128(reinterpret_cast<const __m128i *>(many + stride)));
+        const __m128i s2 = sse2_partial_ssd(q, _mm_loadu_si128(reinterpret_cast<const __m128i *>(many + 2*stride)));
+        const __m128i s3 = sse2_partial_ssd(q, _mm_loadu_si128(reinterpret_cast<const __m128i *>(many + 3*stride)));
+
+        // transpose and add, so that each int32 lane contains one complete sum
+        const __m128i t01 = _mm_add_epi32(_mm_unpacklo_epi32(s0, s1), _mm_unpackhi_epi32(s0, s1));
+        const __m128i t23 = _mm_add_epi32(_mm_unpacklo_epi32(s2, s3), _mm_unpackhi_epi32(s2, s3));
+        const __m128i sums = _mm_add_epi32(_mm_unpacklo_epi64(t01, t23), _mm_unpackhi_epi64(t01, t23));
+        _mm_storeu_ps(out + i, _mm_cvtepi32_ps(sums));
+    }
+
+    for (; i < n; i+=1, many+=stride)
+        out[i] = sse2_ssd(q, _mm_loadu_si128(reinterpret_cast<const __m128i *>(many)));
+
+    return;
+}
+
+/// eight int32 partial sums of the squared differences, the query is already expanded to int16
+AVX2_TARGET static inline __m256i avx2_partial_ssd(const __m256i query16, const uint8_t *descriptor)
+{
+    const __m256i d = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(descriptor)));
+    const __m256i delta = _mm256_sub_epi16(query16, d);
+    return _mm256_madd_epi16(delta, delta);
+}
+
+AVX2_TARGET static void avx2_distances(const uint8_t *query,
+                                       const uint8_t *many, const size_t stride, const size_t n,
+                                       float *out)
+{
+    const __m128i q = _mm_loadu_si128(reinterpret_cast<const __m128i *>(query));
+    const __m256i query16 = _mm256_cvtepu8_epi16(q);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i+=8, many+=8*stride)
+    {
+        const __m256i s0 = avx2_partial_ssd(query16, many);
+        const __m256i s1 = avx2_partial_ssd(query16, many + stride);
+        const __m256i s2 = avx2_partial_ssd(query16, many + 2*stride);
+        const __m256i s3 = avx2_partial_ssd(query16, many + 3*stride);
+        const __m256i s4 = avx2_partial_ssd(query16, many + 4*stride);
+        const __m256i s5 = avx2_partial_ssd(query16, many + 5*stride);
+        const __m256i s6 = avx2_partial_ssd(query16, many + 6*stride);
+        const __m256i s7 = avx2_partial_ssd(query16, many + 7*stride);
+
+        // horizontal adds work per 128 bits lane,
+        // the low lanes hold the first half of the sums and the high lanes the second half
+        const __m256i h0123 = _mm256_hadd_epi32(_mm256_hadd_epi32(s0, s1), _mm256_hadd_epi32(s2, s3));
+        const __m256i h4567 = _mm256_hadd_epi32(_mm256_hadd_epi32(s4, s5), _mm256_hadd_epi32(s6, s7));
+        const __m256i sums = _mm256_add_epi32(_mm256_permute2x128_si256(h0123, h4567, 0x20),
+                                              _mm256_permute2x128_si256(h0123, h4567, 0x31));
+        _mm256_storeu_ps(out + i, _mm256_cvtepi32_ps(sums));
+    }
+
+    for (; i < n; i+=1, many+=stride)
+        out[i] = sse2_ssd(q, _mm_loadu_si128(reinterpret_cast<const __m128i *>(many)));
+
+    return;
+}
+
+#endif // FAST_FEATURE_X86_KERNELS
+
+static distances_function_t select_distances_function()
+{
+#if defined(FAST_FEATURE_X86_KERNELS)
+    if (cpu_has_avx2())
+        return avx2_distances;
+    if (cpu_has_sse2())
+        return sse2_distances;
+#endif
+    return scalar_distances;
+}
+
+void circle_intensities_distances(const uint8_t *query,
+                                  const uint8_t *many, const size_t stride, const size_t n,
+                                  float *out)
+{
+    // the cpu is queried only once
+    static const distances_function_t distances_function = select_distances_function();
+    distances_function(query, many, stride, n, out);
+    return;
+}
+
+void distances(const FASTFeature &query, const FASTFeature *many, const size_t n, float *out)
+{
+    if (n == 0)
+        return;
+
+    circle_intensities_distances(query.circle_intensities,
+                                 many[0].circle_intensities, sizeof(FASTFeature), n,
+                                 out);
+    return;
+}
+
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+
 float FASTFeature::distance(const IFeature &f) const {
 
+#if defined(DEBUG)
 	const FASTFeature *feature_p = dynamic_cast<const FASTFeature *>(&f);
 	
 	if(feature_p == NULL) {
-		std::runtime_error("FASTFeature::distance received an unexpected feature type");
+		throw std::runtime_error("FASTFeature::distance received an unexpected feature type");
 	}
+#else
+	// this method is called in the inner loops of the matchers,
+	// the type check is only done on debug builds
+	const FASTFeature *feature_p = static_cast<const FASTFeature *>(&f);
+#endif
 		
 	return distance(*feature_p);
 }
@@ -70,9 +236,29 @@ float FASTFeature::distance(const IFeature &f) const {
    
 float FASTFeature::distance(const FASTFeature &f) const
 {
-    return sum_squared_differences(circle_intensities, f.circle_intensities, 16);
+    float ssd;
+    circle_intensities_distances(circle_intensities, f.circle_intensities, 0, 1, &ssd);
+    return ssd;
 }
 
+float FASTFeature::distance(const FASTFeature &f, const float bound) const
+{
+    // the sum is checked every 4 intensities, testing at each one costs more than it saves
+    int ssd = 0;
+    int i;
+    for (i=0; i < 16; i+=4)
+    {
+        const int d0 = circle_intensities[i] - f.circle_intensities[i];
+        const int d1 = circle_intensities[i+1] - f.circle_intensities[i+1];
+        const int d2 = circle_intensities[i+2] - f.circle_intensities[i+2];
+        const int d3 = circle_intensities[i+3] - f.circle_intensities[i+3];
+        ssd += d0*d0 + d1*d1 + d2*d2 + d3*d3;
+
+        if (ssd > bound)
+            break;
+    }
+    return static_cast<float>(ssd);
+}
 
 }
 
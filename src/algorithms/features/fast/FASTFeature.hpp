@@ -11,6 +11,7 @@
 // ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
 // Headers
 
+#include <cstddef>
 #include <boost/cstdint.hpp>
 
 namespace uniclop
@@ -35,6 +36,8 @@ class FASTFeature : public IFeature
 public:
     // int x,y herited from IFeature
 
+    int level; ///< image pyramid level where the feature was detected, 0 is the full resolution
+
     uint8_t circle_intensities[16];
     // see Edward Rosten PhD thesis chapter 2.4 "Efficient feature matching Features"
     // http://mi.eng.cam.ac.uk/~er258/work/rosten_2006_thesis.pdf
@@ -50,8 +53,23 @@ public:
     ///@}
     
     float distance(const FASTFeature &f) const;
+
+    /// Partial distance with early exit: returns the exact distance if it is lower or equal to bound,
+    /// otherwise stops as soon as the running sum exceeds bound and returns a value greater than bound
+    float distance(const FASTFeature &f, const float bound) const;
 };
 
+/// Computes out[i] = query.distance(many[i]) for the n features in many,
+/// scoring a whole block of candidates in one call.
+/// Uses SSE2 or AVX2 kernels when the cpu supports them (checked at runtime)
+void distances(const FASTFeature &query, const FASTFeature *many, const size_t n, float *out);
+
+/// Same as distances, but operating directly over 16 bytes circle intensities.
+/// The i-th descriptor starts at many + i*stride, no alignment is required
+void circle_intensities_distances(const uint8_t *query,
+                                  const uint8_t *many, const size_t stride, const size_t n,
+                                  float *out);
+
 
 }
 
@@ -0,0 +1,177 @@
+
+
+#include "FASTFeatureSet.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace uniclop
+{
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// class FASTFeatureSet methods implementation
+
+FASTFeatureSet::FASTFeatureSet()
+{
+    descriptors = NULL;
+    return;
+}
+
+FASTFeatureSet::FASTFeatureSet(const FASTFeatureSet &other)
+{
+    descriptors = NULL;
+    (*this) = other;
+    return;
+}
+
+FASTFeatureSet &FASTFeatureSet::operator=(const FASTFeatureSet &other)
+{
+    if (this == &other)
+        return *this;
+
+    // the old content is dropped before sizing the descriptors buffer,
+    // so that reserve_descriptors does not copy it (x may already hold the new size)
+    clear();
+    reserve_descriptors(other.size());
+
+    x = other.x;
+    y = other.y;
+    score = other.score;
+    level = other.level;
+
+    // the aligned pointer can not be copied, the descriptors are copied one by one
+    if (other.empty() == false)
+        memcpy(descriptors, other.descriptors, 16*other.size());
+
+    return *this;
+}
+
+FASTFeatureSet::~FASTFeatureSet()
+{
+    return;
+}
+
+void FASTFeatureSet::clear()
+{
+    x.clear();
+    y.clear();
+    score.clear();
+    level.clear();
+    return;
+}
+
+void FASTFeatureSet::reserve(const size_t num_features)
+{
+    x.reserve(num_features);
+    y.reserve(num_features);
+    score.reserve(num_features);
+    level.reserve(num_features);
+    reserve_descriptors(num_features);
+    return;
+}
+
+void FASTFeatureSet::reserve_descriptors(const size_t num_features)
+{
+    const size_t required_size = 16*num_features + 15;
+    if (descriptors != NULL && descriptors_buffer.size() >= required_size)
+        return;
+
+    // grow geometrically, like std::vector does
+    const size_t new_size = max(required_size, 2*descriptors_buffer.size());
+    vector<uint8_t> new_buffer(new_size);
+
+    const size_t misalignment = reinterpret_cast<size_t>(&new_buffer[0]) % 16;
+    uint8_t *new_descriptors = &new_buffer[0] + ((16 - misalignment) % 16);
+
+    if (descriptors != NULL && x.empty() == false)
+        memcpy(new_descriptors, descriptors, 16*x.size());
+
+    // the swap does not move the buffer memory, so new_descriptors stays valid
+    descriptors_buffer.swap(new_buffer);
+    descriptors = new_descriptors;
+    return;
+}
+
+void FASTFeatureSet::push_back(const int _x, const int _y)
+{
+    reserve_descriptors(x.size() + 1);
+    x.push_back(_x);
+    y.push_back(_y);
+    score.push_back(0);
+    level.push_back(0);
+    return;
+}
+
+void FASTFeatureSet::push_back(const int _x, const int _y, const int _score, const uint8_t *_circle_intensities)
+{
+    push_back(_x, _y, _score, _circle_intensities, 0);
+    return;
+}
+
+void FASTFeatureSet::push_back(const int _x, const int _y, const int _score, const uint8_t *_circle_intensities,
+                               const int _level)
+{
+    reserve_descriptors(x.size() + 1);
+    memcpy(descriptors + 16*x.size(), _circle_intensities, 16);
+    x.push_back(_x);
+    y.push_back(_y);
+    score.push_back(_score);
+    level.push_back(_level);
+    return;
+}
+
+void FASTFeatureSet::append(const FASTFeatureSet &other)
+{
+    if (other.empty())
+        return;
+
+    reserve_descriptors(size() + other.size());
+    memcpy(descriptors + 16*size(), other.descriptors, 16*other.size());
+
+    x.insert(x.end(), other.x.begin(), other.x.end());
+    y.insert(y.end(), other.y.begin(), other.y.end());
+    score.insert(score.end(), other.score.begin(), other.score.end());
+    level.insert(level.end(), other.level.begin(), other.level.end());
+    return;
+}
+
+void FASTFeatureSet::swap(FASTFeatureSet &other)
+{
+    x.swap(other.x);
+    y.swap(other.y);
+    score.swap(other.score);
+    level.swap(other.level);
+    descriptors_buffer.swap(other.descriptors_buffer);
+    std::swap(descriptors, other.descriptors);
+    return;
+}
+
+void FASTFeatureSet::to_features(vector<FASTFeature> &features) const
+{
+    features.resize(size());
+
+    size_t i;
+    for (i=0; i < size(); i+=1)
+    {
+        features[i].x = x[i];
+        features[i].y = y[i];
+        features[i].level = level[i];
+        memcpy(features[i].circle_intensities, circle_intensities(i), 16);
+    }
+    return;
+}
+
+void FASTFeatureSet::from_features(const vector<FASTFeature> &features)
+{
+    clear();
+    reserve(features.size());
+
+    vector<FASTFeature>::const_iterator features_it;
+    for (features_it = features.begin(); features_it != features.end(); ++features_it)
+        push_back(features_it->x, features_it->y, 0, features_it->circle_intensities, features_it->level);
+
+    return;
+}
+
+
+}
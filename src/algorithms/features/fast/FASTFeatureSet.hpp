@@ -0,0 +1,104 @@
+#if !defined(FAST_FEATURE_SET_HEADER_INCLUDED)
+#define FAST_FEATURE_SET_HEADER_INCLUDED
+
+// Features detection
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Headers
+
+#include "FASTFeature.hpp"
+
+#include <vector>
+#include <boost/cstdint.hpp>
+
+namespace uniclop
+{
+
+using namespace std;
+
+using boost::uint8_t;
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Classes definition
+
+/**
+ Structure of arrays storage for FAST features.
+
+ vector<FASTFeature> stores a vtable pointer next to each feature, and every copy
+ of the vector touches all of it. FASTFeatureSet keeps the coordinates, scores and
+ circle intensities in separate contiguous arrays, the circle intensities being
+ 16 bytes aligned so that they can be fed directly to the SIMD distance kernels.
+
+ Features are referred to by their index in the set.
+ The memory is kept between calls to clear(), so at steady state no allocation is done.
+
+ SimpleFAST detects into it and FASTFeaturesMatcher matches it directly. The matches
+ built from it only hold indexes, the applications that estimate models from the
+ matches (e.g. features_tracking) keep using vector<FASTFeature>.
+*/
+class FASTFeatureSet
+{
+
+public:
+
+    vector<int> x, y;
+    vector<int> score; ///< nonmax score of each feature, 0 if not computed
+    vector<int> level; ///< image pyramid level where the feature was detected, 0 is the full resolution
+
+    FASTFeatureSet();
+    FASTFeatureSet(const FASTFeatureSet &other);
+    FASTFeatureSet &operator=(const FASTFeatureSet &other);
+    ~FASTFeatureSet();
+
+    size_t size() const
+    {
+        return x.size();
+    }
+
+    bool empty() const
+    {
+        return x.empty();
+    }
+
+    void clear();
+    void reserve(const size_t num_features);
+
+    /// adds a new feature, its circle intensities are left uninitialized
+    void push_back(const int x, const int y);
+    void push_back(const int x, const int y, const int score, const uint8_t *circle_intensities);
+    void push_back(const int x, const int y, const int score, const uint8_t *circle_intensities,
+                   const int level);
+
+    /// adds all the features of other at the end of this set
+    void append(const FASTFeatureSet &other);
+
+    /// constant time exchange of the content of the two sets
+    void swap(FASTFeatureSet &other);
+
+    /// pointer to the 16 circle intensities of the i-th feature
+    uint8_t *circle_intensities(const size_t i)
+    {
+        return descriptors + 16*i;
+    }
+
+    const uint8_t *circle_intensities(const size_t i) const
+    {
+        return descriptors + 16*i;
+    }
+
+    /// conversion helpers, to use the interfaces based on vector<FASTFeature>
+    void to_features(vector<FASTFeature> &features) const;
+    void from_features(const vector<FASTFeature> &features);
+
+private:
+
+    vector<uint8_t> descriptors_buffer; ///< oversized, to allow the alignment of descriptors
+    uint8_t *descriptors; ///< 16 bytes aligned pointer inside descriptors_buffer
+
+    void reserve_descriptors(const size_t num_features);
+};
+
+
+}
+
+#endif // FAST_FEATURE_SET_HEADER_INCLUDED
@@ -1,7 +1,13 @@
+
 
 #include "FASTFeaturesMatcher.hpp"
 
+#include "FASTFeature.hpp"
+#include "FASTFeatureSet.hpp"
 
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
 
 namespace uniclop
 {
@@ -15,9 +21,25 @@ args::options_description FASTFeaturesMatcher::get_options_description()
     args::options_description desc("FASTFeaturesMatcher options");
     desc.add_options()
 
-    /* ( "blur_sigma,b", args::value<double>()->default_value(1.0f),
-       "defines a bluring level for images") */
+    ( "fast_features_matcher.max_distance", args::value<float>()->default_value(1e10),
+      "maximum sum of squared difference between two features to do a match (16 uint8_t pixels)")
+
+    ( "fast_features_matcher.num_near_features", args::value<int>()->default_value(3),
+      "for each feature the nearest num_near_features will be proposed as putative matches")
+
+    ( "fast_features_matcher.leaf_size", args::value<int>()->default_value(64),
+      "maximum number of features stored in each leaf of the matching tree")
+
+    ( "fast_features_matcher.max_leaves_visited", args::value<int>()->default_value(0),
+      "maximum number of tree leaves visited per query, 0 means exact search. "
+      "A budget trades recall for speed: on features_matching_benchmark (3000 features, 20% without "
+      "correspondent) 2 leaves of 64 features is 9x faster than the brute force matcher, "
+      "but only 80% of the queries get the exhaustive search best match, "
+      "the features without correspondent lose their nearest neighbour")
 
+    ( "fast_features_matcher.search_radius", args::value<int>()->default_value(0),
+      "only match features whose x and y coordinates differ by at most search_radius pixels "
+      "(exhaustive search inside the window). 0 means no limit (decision tree search)")
     ;
 
     return desc;
@@ -25,6 +47,36 @@ args::options_description FASTFeaturesMatcher::get_options_description()
 
 FASTFeaturesMatcher::FASTFeaturesMatcher(args::variables_map &options)
 {
+    max_distance = 1e10;
+    num_near_features = 3;
+    leaf_size = 64;
+    max_leaves_visited = 0;
+    search_radius = 0;
+
+    if ( options.count("fast_features_matcher.max_distance") )
+        max_distance = options["fast_features_matcher.max_distance"].as<float>();
+
+    if ( options.count("fast_features_matcher.num_near_features") )
+        num_near_features = options["fast_features_matcher.num_near_features"].as<int>();
+
+    if ( options.count("fast_features_matcher.leaf_size") )
+        leaf_size = options["fast_features_matcher.leaf_size"].as<int>();
+
+    if ( options.count("fast_features_matcher.max_leaves_visited") )
+        max_leaves_visited = options["fast_features_matcher.max_leaves_visited"].as<int>();
+
+    if ( options.count("fast_features_matcher.search_radius") )
+        search_radius = options["fast_features_matcher.search_radius"].as<int>();
+
+    if (search_radius > 0)
+        features_b_grid_p.reset(new SpatialGridIndex(search_radius));
+
+    if (num_near_features < 1 || leaf_size < 1)
+        throw runtime_error("FASTFeaturesMatcher num_near_features and leaf_size should be positive");
+
+    candidates.resize(num_near_features);
+    num_candidates = 0;
+    leaves_visited = 0;
     return;
 }
 
@@ -39,10 +91,374 @@ vector< ScoredMatch >& FASTFeaturesMatcher::match(
 {
     matchings.clear();
 
+    if (features_list_a.empty() || features_list_b.empty())
+        return matchings;
+
+    // the circle intensities of the list b are packed once per call,
+    // the vector and the set versions then share the same code
+    features_b_descriptors.resize(features_list_b.size()*16);
+    size_t j;
+    for (j=0; j < features_list_b.size(); j+=1)
+        copy(features_list_b[j].circle_intensities, features_list_b[j].circle_intensities + 16,
+             features_b_descriptors.begin() + j*16);
+
+    if (features_b_grid_p)
+    {
+        features_b_grid_p->build(features_list_b);
+        set_identity_order(features_list_b.size());
+    }
+    else
+    { // the tree is built once per call over the list b
+        build_tree(&features_b_descriptors[0], features_list_b.size());
+    }
+
+    matchings.reserve(features_list_a.size() * num_near_features);
+
+    vector<FASTFeature>::const_iterator features_it_a;
+    for (features_it_a = features_list_a.begin();
+            features_it_a != features_list_a.end();
+            ++features_it_a)
+    { // for each feature in list a
+
+        if (features_b_grid_p)
+            find_nearest_in_window(features_it_a->circle_intensities, features_it_a->x, features_it_a->y,
+                                   &features_b_descriptors[0]);
+        else
+            find_nearest(features_it_a->circle_intensities);
+
+        int i;
+        for (i=0; i < num_candidates; i+=1)
+        { // candidates are sorted by increasing distance
+            ScoredMatch m;
+            m.feature_a = &(*features_it_a);
+            m.feature_b = &features_list_b[ features_b_order[candidates[i].index] ];
+            m.index_a = features_it_a - features_list_a.begin();
+            m.index_b = features_b_order[candidates[i].index];
+            m.distance = candidates[i].distance;
+            matchings.push_back(m);
+        }
+    }
+
+    return matchings;
+}
+
+vector< ScoredMatch >& FASTFeaturesMatcher::match(
+    const FASTFeatureSet& features_set_a,
+    const FASTFeatureSet& features_set_b)
+{
+    matchings.clear();
+
+    if (features_set_a.empty() || features_set_b.empty())
+        return matchings;
+
+    if (features_b_grid_p)
+    {
+        features_b_grid_p->build(features_set_b.x, features_set_b.y);
+        set_identity_order(features_set_b.size());
+    }
+    else
+    { // the circle intensities of the set are already packed
+        build_tree(features_set_b.circle_intensities(0), features_set_b.size());
+    }
+
+    matchings.reserve(features_set_a.size() * num_near_features);
+
+    const int num_features_a = features_set_a.size();
+    int index_a;
+    for (index_a = 0; index_a < num_features_a; index_a+=1)
+    { // for each feature in set a
+
+        if (features_b_grid_p)
+            find_nearest_in_window(features_set_a.circle_intensities(index_a),
+                                   features_set_a.x[index_a], features_set_a.y[index_a],
+                                   features_set_b.circle_intensities(0));
+        else
+            find_nearest(features_set_a.circle_intensities(index_a));
+
+        int i;
+        for (i=0; i < num_candidates; i+=1)
+        { // candidates are sorted by increasing distance
+            matchings.push_back(
+                ScoredMatch(index_a, features_b_order[candidates[i].index], candidates[i].distance));
+        }
+    }
+
     return matchings;
 }
 
 
+// helper comparison class, used to sort the features along one of the circle intensities
+class compare_circle_intensity
+{
+    const uint8_t *descriptors;
+    const int split_index;
+
+public:
+    compare_circle_intensity(const uint8_t *_descriptors, const int _split_index)
+            : descriptors(_descriptors), split_index(_split_index)
+    {
+        return;
+    }
+
+    bool operator()(const int a, const int b) const
+    {
+        return descriptors[a*16 + split_index] < descriptors[b*16 + split_index];
+    }
+};
+
+class is_lower_than_split_value
+{
+    const uint8_t *descriptors;
+    const int split_index;
+    const int split_value;
+
+public:
+    is_lower_than_split_value(const uint8_t *_descriptors, const int _split_index, const int _split_value)
+            : descriptors(_descriptors), split_index(_split_index), split_value(_split_value)
+    {
+        return;
+    }
+
+    bool operator()(const int a) const
+    {
+        return descriptors[a*16 + split_index] < split_value;
+    }
+};
+
+
+void FASTFeaturesMatcher::build_tree(const uint8_t *descriptors, const int num_descriptors)
+{
+    // vectors are kept between calls, so at steady state no memory is allocated
+    tree_nodes.clear();
+    features_b_order.resize(num_descriptors);
+
+    int i;
+    for (i=0; i < num_descriptors; i+=1)
+        features_b_order[i] = i;
+
+    build_node(descriptors, 0, num_descriptors);
+
+    // pack the descriptors in leaf order, so that each leaf is a contiguous memory block
+    leaf_descriptors.resize(num_descriptors*16);
+    leaf_distances.resize(num_descriptors);
+    for (i=0; i < num_descriptors; i+=1)
+    {
+        const uint8_t *source = descriptors + features_b_order[i]*16;
+        copy(source, source + 16, leaf_descriptors.begin() + i*16);
+    }
+
+    return;
+}
+
+int FASTFeaturesMatcher::build_node(const uint8_t *descriptors, const int begin, const int end)
+{
+    const int node_index = tree_nodes.size();
+    tree_nodes.push_back(TreeNode());
+
+    TreeNode node;
+    node.split_index = -1;
+    node.split_value = 0;
+    node.left_child = -1;
+    node.right_child = -1;
+    node.begin = begin;
+    node.end = end;
+
+    if ((end - begin) > leaf_size)
+    {
+        // search the circle intensity with the largest spread
+        uint8_t min_values[16], max_values[16];
+        int i, j;
+        for (j=0; j < 16; j+=1)
+        {
+            min_values[j] = 255;
+            max_values[j] = 0;
+        }
+
+        for (i=begin; i < end; i+=1)
+        {
+            const uint8_t *d = descriptors + features_b_order[i]*16;
+            for (j=0; j < 16; j+=1)
+            {
+                min_values[j] = min(min_values[j], d[j]);
+                max_values[j] = max(max_values[j], d[j]);
+            }
+        }
+
+        int largest_spread = 0;
+        for (j=0; j < 16; j+=1)
+        {
+            const int spread = max_values[j] - min_values[j];
+            if (spread > largest_spread)
+            {
+                largest_spread = spread;
+                node.split_index = j;
+            }
+        }
+
+        if (node.split_index >= 0)
+        { // else all the descriptors are identical, this node stays a leaf
+
+            // the median value is used as threshold
+            vector<int>::iterator order_begin = features_b_order.begin() + begin;
+            vector<int>::iterator order_middle = features_b_order.begin() + (begin + end) / 2;
+            vector<int>::iterator order_end = features_b_order.begin() + end;
+            nth_element(order_begin, order_middle, order_end,
+                        compare_circle_intensity(descriptors, node.split_index));
+
+            int split_value = descriptors[(*order_middle)*16 + node.split_index];
+            if (split_value == min_values[node.split_index])
+            { // the left side would be empty
+                split_value += 1;
+            }
+            node.split_value = static_cast<uint8_t>(split_value);
+
+            vector<int>::iterator order_split =
+                partition(order_begin, order_end,
+                          is_lower_than_split_value(descriptors, node.split_index, split_value));
+            const int split = begin + (order_split - order_begin);
+
+            node.left_child = build_node(descriptors, begin, split);
+            node.right_child = build_node(descriptors, split, end);
+        }
+    }
+
+    tree_nodes[node_index] = node; // tree_nodes may have been reallocated by the children
+    return node_index;
+}
+
+
+void FASTFeaturesMatcher::find_nearest(const uint8_t *query)
+{
+    num_candidates = 0;
+    leaves_visited = 0;
+    fill(query_offsets, query_offsets + 16, 0);
+    search_node(0, query, 0);
+    return;
+}
+
+void FASTFeaturesMatcher::set_identity_order(const int num_features_b)
+{
+    // without tree, the candidates indexes are directly the features b indexes
+    features_b_order.resize(num_features_b);
+    int i;
+    for (i=0; i < num_features_b; i+=1)
+        features_b_order[i] = i;
+    return;
+}
+
+void FASTFeaturesMatcher::find_nearest_in_window(const uint8_t *query, const int x, const int y,
+        const uint8_t *descriptors)
+{
+    num_candidates = 0;
+
+    features_b_grid_p->rectangle_query(x - search_radius, y - search_radius,
+                                       x + search_radius, y + search_radius,
+                                       window_indexes);
+
+    const int num_window_features = window_indexes.size();
+    if (num_window_features == 0)
+        return;
+
+    // the window descriptors are packed, so that they are scored in one call
+    window_descriptors.resize(num_window_features*16);
+    window_distances.resize(num_window_features);
+
+    int i;
+    for (i=0; i < num_window_features; i+=1)
+    {
+        const uint8_t *source = descriptors + window_indexes[i]*16;
+        copy(source, source + 16, window_descriptors.begin() + i*16);
+    }
+
+    circle_intensities_distances(query, &window_descriptors[0], 16, num_window_features,
+                                 &window_distances[0]);
+
+    for (i=0; i < num_window_features; i+=1)
+        add_candidate(window_distances[i], window_indexes[i]);
+
+    return;
+}
+
+void FASTFeaturesMatcher::search_node(const int node_index, const uint8_t *query, const float cell_distance)
+{
+    const TreeNode &node = tree_nodes[node_index];
+
+    if (node.split_index < 0)
+    { // leaf node, compare against all its features
+        // the whole leaf is scored in one call
+        const int leaf_features = node.end - node.begin;
+        circle_intensities_distances(query, &leaf_descriptors[node.begin*16], 16, leaf_features,
+                                     &leaf_distances[0]);
+        int i;
+        for (i=0; i < leaf_features; i+=1)
+            add_candidate(leaf_distances[i], node.begin + i);
+        leaves_visited += 1;
+        return;
+    }
+
+    const int q = query[node.split_index];
+    int near_child, far_child, bound_delta;
+    if (q < node.split_value)
+    {
+        near_child = node.left_child;
+        far_child = node.right_child;
+        bound_delta = node.split_value - q; // far side values are >= split_value
+    }
+    else
+    {
+        near_child = node.right_child;
+        far_child = node.left_child;
+        bound_delta = q - (node.split_value - 1); // far side values are < split_value
+    }
+
+    search_node(near_child, query, cell_distance);
+
+    if (max_leaves_visited > 0 && leaves_visited >= max_leaves_visited)
+        return; // search budget exhausted
+
+    // the far side is visited only if it can contain a better candidate.
+    // cell_distance is the squared distance from the query to the cell of the node,
+    // only the offset along the split circle intensity changes for the far child
+    float worst_distance = max_distance;
+    if (num_candidates == num_near_features)
+        worst_distance = min(worst_distance, candidates[num_candidates - 1].distance);
+
+    const int previous_offset = query_offsets[node.split_index];
+    const float far_cell_distance = cell_distance
+                                    - static_cast<float>(previous_offset*previous_offset)
+                                    + static_cast<float>(bound_delta*bound_delta);
+    if (far_cell_distance < worst_distance)
+    {
+        query_offsets[node.split_index] = bound_delta;
+        search_node(far_child, query, far_cell_distance);
+        query_offsets[node.split_index] = previous_offset;
+    }
+
+    return;
+}
+
+void FASTFeaturesMatcher::add_candidate(const float distance, const int index)
+{
+    if (distance > max_distance)
+        return; // out of the range of interest
+
+    if (num_candidates == num_near_features && distance >= candidates[num_candidates - 1].distance)
+        return; // worse than the worst candidate
+
+    // we suppose that num_near_features is small, so a sorted insertion is the fastest option
+    int i = (num_candidates < num_near_features) ? num_candidates : (num_candidates - 1);
+    while (i > 0 && candidates[i - 1].distance > distance)
+    {
+        candidates[i] = candidates[i - 1];
+        i -= 1;
+    }
+    candidates[i].distance = distance;
+    candidates[i].index = index;
+
+    if (num_candidates < num_near_features)
+        num_candidates += 1;
+    return;
+}
 
 
-}
\ No newline at end of file
+}
@@ -9,28 +9,84 @@
 // Headers
 
 #include "../IFeaturesMatcher.hpp"
+#include "../SpatialGridIndex.hpp"
 
 #include <vector>
+#include <boost/cstdint.hpp>
 #include <boost/program_options.hpp>
+#include <boost/scoped_ptr.hpp>
 
 namespace uniclop
 {
 	
 	using namespace std;
 namespace args = boost::program_options;
+using boost::uint8_t;
 
 class FASTFeature; // forward declaration
+class FASTFeatureSet;
 
 /**
  will return an ordered list of ScoredMatches
     implement the fast matching algorithm for FAST features as
-    described in Edward Rosten thesis
-
+    described in Edward Rosten thesis, chapter 2.4 "Efficient feature matching"
+    http://mi.eng.cam.ac.uk/~er258/work/rosten_2006_thesis.pdf
+
+    A quantized decision tree is built once over the circle_intensities of the
+    features list b. Each node splits on the circle intensity with the largest
+    spread, using the median value as threshold. For each feature of list a we
+    descend the tree and only compare against the features stored in the
+    visited leaves. The other branches are visited only when their cell can
+    contain a better candidate, so by default the search is exact.
+    With max_leaves_visited the search stops after that many leaves, the cost per
+    query is then O(log N + max_leaves_visited*leaf_size) instead of O(N),
+    but the best match is not always found
+
+    When a search radius is set, the tree is not used: each feature of list a is
+    exhaustively compared against the features of list b inside its search window
+    (found using a SpatialGridIndex)
 */
-class FASTFeaturesMatcher : IFeaturesMatcher<FASTFeature>
+class FASTFeaturesMatcher : public IFeaturesMatcher<FASTFeature>
 {
 
     vector< ScoredMatch > matchings;
+
+    float max_distance;
+    int num_near_features;
+    int leaf_size;
+    int max_leaves_visited;
+    int search_radius;
+
+    struct TreeNode
+    {
+        int split_index; ///< index in circle_intensities used to split, -1 for leaves
+        uint8_t split_value; ///< intensities lower than split_value go to the left child
+        int left_child, right_child;
+        int begin, end; ///< range of features_b_order covered by this node
+    };
+
+    struct Candidate
+    {
+        float distance;
+        int index; ///< index in features_b_order
+    };
+
+    vector<TreeNode> tree_nodes;
+    vector<uint8_t> features_b_descriptors; ///< circle_intensities of the features list b, packed (16 bytes each)
+    vector<int> features_b_order; ///< indexes of the features b, sorted in leaf order
+    vector<uint8_t> leaf_descriptors; ///< circle_intensities of the features b, packed in leaf order
+    vector<float> leaf_distances; ///< distances between the current query and the features of one leaf
+
+    boost::scoped_ptr<SpatialGridIndex> features_b_grid_p; ///< NULL when not using a search window
+    vector<int> window_indexes; ///< features b inside the current search window
+    vector<uint8_t> window_descriptors; ///< their circle intensities, packed
+    vector<float> window_distances;
+
+    vector<Candidate> candidates; ///< num_near_features best candidates of the current query
+    int num_candidates;
+    int leaves_visited;
+    int query_offsets[16]; ///< distance from the query to the current node cell, along each circle intensity
+
 public:
 
     static args::options_description get_options_description();
@@ -41,6 +97,26 @@ public:
     vector< ScoredMatch >& match(
         const vector<FASTFeature>& features_list_a,
         const vector<FASTFeature>& features_list_b);
+
+    /// Same matching, over structure of arrays features sets.
+    /// The returned matches only contain the features indexes (index_a and index_b),
+    /// feature_a and feature_b are left to NULL, so they can not be given to the model
+    /// estimators (see have_features in ScoredMatch.hpp)
+    vector< ScoredMatch >& match(
+        const FASTFeatureSet& features_set_a,
+        const FASTFeatureSet& features_set_b);
+
+private:
+
+    // the descriptors are packed, 16 bytes per feature
+    void build_tree(const uint8_t *descriptors, const int num_descriptors);
+    int build_node(const uint8_t *descriptors, const int begin, const int end);
+
+    void find_nearest(const uint8_t *query);
+    void find_nearest_in_window(const uint8_t *query, const int x, const int y, const uint8_t *descriptors);
+    void set_identity_order(const int num_features_b);
+    void search_node(const int node_index, const uint8_t *query, const float cell_distance);
+    void add_candidate(const float distance, const int index);
 };
 
 
@@ -0,0 +1,158 @@
+
+
+#include "GridFeaturesSelector.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace uniclop
+{
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// class GridFeaturesSelector methods implementation
+
+GridFeaturesSelector::GridFeaturesSelector(const int _grid_columns, const int _grid_rows)
+{
+    grid_columns = _grid_columns;
+    grid_rows = _grid_rows;
+
+    if (grid_columns < 1 || grid_rows < 1)
+        throw runtime_error("GridFeaturesSelector expects a grid of at least one cell");
+
+    cell_start.resize(grid_columns*grid_rows + 1);
+    return;
+}
+
+GridFeaturesSelector::~GridFeaturesSelector()
+{
+    return;
+}
+
+// helper comparison class, higher scores first, lower indexes first on ties
+class has_better_score
+{
+    const vector<int> &scores;
+
+public:
+    has_better_score(const vector<int> &_scores) : scores(_scores)
+    {
+        return;
+    }
+
+    bool operator()(const int a, const int b) const
+    {
+        if (scores[a] != scores[b])
+            return scores[a] > scores[b];
+        return a < b;
+    }
+};
+
+void GridFeaturesSelector::select(const FASTFeatureSet &features, const int image_width, const int image_height,
+                                  const int max_features, FASTFeatureSet &selected_features)
+{
+    const int num_features = features.size();
+    const int num_cells = grid_columns*grid_rows;
+
+    selected_features.clear();
+
+    if (max_features <= 0)
+        return;
+
+    if (num_features <= max_features)
+    { // nothing to remove
+        selected_features = features;
+        return;
+    }
+
+    // bucket the features (counting sort, keeps the raster order inside each cell) --
+    const int cell_width = max(1, (image_width + grid_columns - 1) / grid_columns);
+    const int cell_height = max(1, (image_height + grid_rows - 1) / grid_rows);
+
+    fill(cell_start.begin(), cell_start.end(), 0);
+
+    int i;
+    for (i=0; i < num_features; i+=1)
+    {
+        const int column = min(grid_columns - 1, features.x[i] / cell_width);
+        const int row = min(grid_rows - 1, features.y[i] / cell_height);
+        cell_start[row*grid_columns + column + 1] += 1;
+    }
+
+    int cell;
+    for (cell=0; cell < num_cells; cell+=1)
+        cell_start[cell + 1] += cell_start[cell];
+
+    cells_features.resize(num_features);
+    cells_best_features.clear();
+    remaining_features.clear();
+    {
+        // cell_start[cell] is used as insertion cursor, then restored
+        for (i=0; i < num_features; i+=1)
+        {
+            const int column = min(grid_columns - 1, features.x[i] / cell_width);
+            const int row = min(grid_rows - 1, features.y[i] / cell_height);
+            cells_features[cell_start[row*grid_columns + column]] = i;
+            cell_start[row*grid_columns + column] += 1;
+        }
+        for (cell=num_cells; cell > 0; cell-=1)
+            cell_start[cell] = cell_start[cell - 1];
+        cell_start[0] = 0;
+    }
+
+    // keep the best features of each cell --
+    is_selected.assign(num_features, false);
+    const int cell_quota = max(1, max_features / num_cells);
+    const has_better_score comparator(features.score);
+
+    for (cell=0; cell < num_cells; cell+=1)
+    {
+        vector<int>::iterator cell_begin = cells_features.begin() + cell_start[cell];
+        vector<int>::iterator cell_end = cells_features.begin() + cell_start[cell + 1];
+        const int cell_size = cell_end - cell_begin;
+
+        if (cell_size > cell_quota)
+        { // the best ones first, the others are candidates to fill the remaining budget
+            nth_element(cell_begin, cell_begin + cell_quota, cell_end, comparator);
+            remaining_features.insert(remaining_features.end(), cell_begin + cell_quota, cell_end);
+            cell_end = cell_begin + cell_quota;
+        }
+
+        cells_best_features.insert(cells_best_features.end(), cell_begin, cell_end);
+    }
+
+    // more cells than budget (the quota was clamped to 1),
+    // the cells best features compete on score, instead of favoring the first cells in raster order
+    int num_selected = cells_best_features.size();
+    if (num_selected > max_features)
+    {
+        nth_element(cells_best_features.begin(), cells_best_features.begin() + max_features,
+                    cells_best_features.end(), comparator);
+        num_selected = max_features;
+    }
+
+    for (i=0; i < num_selected; i+=1)
+        is_selected[cells_best_features[i]] = true;
+
+    // spend the remaining budget on the best remaining features --
+    const int num_extra = min<int>(max_features - num_selected, remaining_features.size());
+    if (num_extra > 0)
+    {
+        nth_element(remaining_features.begin(), remaining_features.begin() + num_extra,
+                    remaining_features.end(), comparator);
+        for (i=0; i < num_extra; i+=1)
+            is_selected[remaining_features[i]] = true;
+    }
+
+    // copy in the original order --
+    selected_features.reserve(max_features);
+    for (i=0; i < num_features; i+=1)
+    {
+        if (is_selected[i])
+            selected_features.push_back(features.x[i], features.y[i], features.score[i],
+                                        features.circle_intensities(i), features.level[i]);
+    }
+
+    return;
+}
+
+}
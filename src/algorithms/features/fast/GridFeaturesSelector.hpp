@@ -0,0 +1,56 @@
+#if !defined(GRID_FEATURES_SELECTOR_HEADER_INCLUDED)
+#define GRID_FEATURES_SELECTOR_HEADER_INCLUDED
+
+// Features detection
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Headers
+
+#include "FASTFeatureSet.hpp"
+
+#include <vector>
+
+namespace uniclop
+{
+
+using namespace std;
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Classes definition
+
+/**
+Keeps at most max_features features, spread over the image.
+
+The image is split in a grid_columns x grid_rows grid, each cell keeps its best features
+(using FASTFeatureSet::score, as computed by fast::nonmax) up to an equal share of the budget.
+When the budget is smaller than the number of cells, only the best feature of each cell
+is a candidate, and the best max_features candidates are kept (whatever their position in the grid).
+The budget left by the cells with few features is then given to the best remaining features.
+Ties are broken using the features order, so the selection is deterministic,
+and the selected features keep their original (raster) order.
+
+The internal buffers are kept between calls, at steady state no memory is allocated.
+*/
+class GridFeaturesSelector
+{
+
+    int grid_columns, grid_rows;
+
+    vector<int> cell_start; ///< first index in cells_features of each cell (counting sort)
+    vector<int> cells_features; ///< features indexes, grouped by cell
+    vector<int> cells_best_features; ///< the best features of each cell, up to the cell quota
+    vector<int> remaining_features;
+    vector<bool> is_selected;
+
+public:
+
+    GridFeaturesSelector(const int grid_columns, const int grid_rows);
+    ~GridFeaturesSelector();
+
+    void select(const FASTFeatureSet &features, const int image_width, const int image_height,
+                const int max_features, FASTFeatureSet &selected_features);
+};
+
+}
+
+#endif // GRID_FEATURES_SELECTOR_HEADER_INCLUDED
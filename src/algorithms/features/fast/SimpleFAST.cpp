@@ -5,6 +5,15 @@
 #include "FASTFeature.hpp"
 
 #include "fast.hpp"
+
+#include "helpers/ThreadPool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <boost/bind.hpp>
+#include <boost/gil/image_view.hpp>
 
 
 namespace uniclop
@@ -22,6 +31,36 @@ args::options_description SimpleFAST::get_options_description()
 
     ( "fast.barrier", args::value<int>()->default_value(20),
       "threshold used to detect FAST features")
+
+    ( "fast.threads", args::value<int>()->default_value(1),
+      "number of threads used to detect the features, the image is split in horizontal bands")
+
+    ( "fast.detector", args::value<string>()->default_value("tree"),
+      "corners detection method: tree (learned decision tree) or segment_test (SIMD exact segment test)")
+
+    ( "fast.max_features", args::value<int>()->default_value(0),
+      "maximum number of features returned per frame, the best ones are kept on a grid. 0 means no limit")
+
+    ( "fast.grid_columns", args::value<int>()->default_value(8),
+      "number of grid columns used to spread the features when fast.max_features is set")
+
+    ( "fast.grid_rows", args::value<int>()->default_value(6),
+      "number of grid rows used to spread the features when fast.max_features is set")
+
+    ( "fast.adaptive_barrier", args::value<bool>()->default_value(true),
+      "when fast.max_features is set, adjust the barrier at each frame to obtain fast.target_corners corners")
+
+    ( "fast.target_corners", args::value<int>()->default_value(0),
+      "number of corners (before the grid selection) targeted by the adaptive barrier. 0 means 2*fast.max_features")
+
+    ( "fast.min_barrier", args::value<int>()->default_value(5),
+      "lowest barrier value allowed by the adaptive barrier")
+
+    ( "fast.max_barrier", args::value<int>()->default_value(120),
+      "highest barrier value allowed by the adaptive barrier")
+
+    ( "fast.pyramid_levels", args::value<int>()->default_value(1),
+      "number of half sampled image pyramid levels where the features are detected, 1 means full resolution only")
     ;
 
     return desc;
@@ -34,6 +73,71 @@ SimpleFAST::SimpleFAST(args::variables_map &options)
     if ( options.count("fast.barrier") )
         barrier = options["fast.barrier"].as<int>();
 
+    int num_threads = 1;
+    if ( options.count("fast.threads") )
+        num_threads = options["fast.threads"].as<int>();
+
+    if (num_threads > 1)
+        thread_pool_p.reset(new ThreadPool(num_threads));
+
+    string detector = "tree";
+    if ( options.count("fast.detector") )
+        detector = options["fast.detector"].as<string>();
+
+    if (detector == "tree")
+        use_segment_test = false;
+    else if (detector == "segment_test")
+        use_segment_test = true;
+    else
+        throw runtime_error("SimpleFAST received an unknown fast.detector value");
+
+    max_features = 0;
+    if ( options.count("fast.max_features") )
+        max_features = options["fast.max_features"].as<int>();
+
+    int grid_columns = 8, grid_rows = 6;
+    if ( options.count("fast.grid_columns") )
+        grid_columns = options["fast.grid_columns"].as<int>();
+    if ( options.count("fast.grid_rows") )
+        grid_rows = options["fast.grid_rows"].as<int>();
+
+    if (max_features > 0)
+        features_selector_p.reset(new GridFeaturesSelector(grid_columns, grid_rows));
+
+    adaptive_barrier = true;
+    if ( options.count("fast.adaptive_barrier") )
+        adaptive_barrier = options["fast.adaptive_barrier"].as<bool>();
+
+    target_corners = 0;
+    if ( options.count("fast.target_corners") )
+        target_corners = options["fast.target_corners"].as<int>();
+    if (target_corners <= 0)
+        target_corners = 2*max_features;
+
+    min_barrier = 5;
+    max_barrier = 120;
+    if ( options.count("fast.min_barrier") )
+        min_barrier = options["fast.min_barrier"].as<int>();
+    if ( options.count("fast.max_barrier") )
+        max_barrier = options["fast.max_barrier"].as<int>();
+
+    if (min_barrier > max_barrier)
+        throw runtime_error("SimpleFAST fast.min_barrier should be lower than fast.max_barrier");
+
+    barrier_value = barrier;
+    barrier_gain = 0.25f;
+    barrier_direction = 0;
+
+    int pyramid_levels = 1;
+    if ( options.count("fast.pyramid_levels") )
+        pyramid_levels = options["fast.pyramid_levels"].as<int>();
+
+    if (pyramid_levels < 1)
+        throw runtime_error("SimpleFAST fast.pyramid_levels should be at least 1");
+
+    if (pyramid_levels > 1)
+        image_pyramid_p.reset(new ImagePyramid(pyramid_levels));
+
     return;
 }
 
@@ -46,15 +150,196 @@ const vector<FASTFeature> & SimpleFAST::detect_features(const gray8c_view_t& vie
 {
     // no need to clear the vectors features it is done inside the functions
 
-    // find corners
-    fast::corner_detect(view, barrier, detected_features);
+    if (max_features > 0)
+    { // the selected features are few, converting them is cheap
+        detect_budgeted_features(view, selected_corners);
+        selected_corners.to_features(best_features);
+        return best_features;
+    }
 
-    // keep the best ones
-    fast::nonmax(view, barrier, detected_features, best_features);
+    if (image_pyramid_p)
+    { // the levels are merged in a FASTFeatureSet
+        detect_pyramid_corners(view, nonmax_corners);
+        nonmax_corners.to_features(best_features);
+        return best_features;
+    }
+
+    // find corners and keep the best ones
+    find_nonmax_corners(view, detected_features, best_features, thread_pool_p.get());
 
     return best_features;
 }
 
+void SimpleFAST::detect_features(const gray8c_view_t& view, FASTFeatureSet &features)
+{
+    if (max_features > 0)
+    {
+        detect_budgeted_features(view, features);
+        return;
+    }
+
+    detect_all_corners(view, features);
+    return;
+}
+
+void SimpleFAST::detect_all_corners(const gray8c_view_t& view, FASTFeatureSet &corners)
+{
+    if (image_pyramid_p)
+        detect_pyramid_corners(view, corners);
+    else
+        find_nonmax_corners(view, detected_corners, corners, thread_pool_p.get());
+    return;
+}
+
+void SimpleFAST::detect_pyramid_corners(const gray8c_view_t& view, FASTFeatureSet &corners)
+{
+    image_pyramid_p->compute(view);
+
+    const int num_levels = image_pyramid_p->get_num_levels();
+    levels_corners.resize(num_levels);
+    levels_nonmax_corners.resize(num_levels);
+
+    if (thread_pool_p)
+    {
+        // the level 0 holds 3/4 of the pixels, so it is split in bands over all the threads,
+        // then the smaller levels are processed in parallel, one level per task
+        detect_pyramid_level(0, thread_pool_p.get());
+        thread_pool_p->run(num_levels - 1, boost::bind(&SimpleFAST::detect_upper_pyramid_level, this, _1));
+    }
+    else
+    {
+        int level;
+        for (level = 0; level < num_levels; level+=1)
+            detect_pyramid_level(level, NULL);
+    }
+
+    // merge the levels, using the level 0 coordinates --
+    size_t num_corners = 0;
+    int level;
+    for (level = 0; level < num_levels; level+=1)
+        num_corners += levels_nonmax_corners[level].size();
+
+    corners.clear();
+    corners.reserve(num_corners);
+    corners.append(levels_nonmax_corners[0]);
+
+    for (level = 1; level < num_levels; level+=1)
+    {
+        const FASTFeatureSet &level_corners = levels_nonmax_corners[level];
+        size_t i;
+        for (i=0; i < level_corners.size(); i+=1)
+        {
+            corners.push_back(ImagePyramid::to_level_zero(level_corners.x[i], level),
+                              ImagePyramid::to_level_zero(level_corners.y[i], level),
+                              level_corners.score[i], level_corners.circle_intensities(i),
+                              level);
+        }
+    }
+
+    return;
+}
+
+void SimpleFAST::detect_pyramid_level(const int level, ThreadPool *thread_pool)
+{
+    find_nonmax_corners(image_pyramid_p->get_level(level),
+                        levels_corners[level], levels_nonmax_corners[level], thread_pool);
+    return;
+}
+
+void SimpleFAST::detect_upper_pyramid_level(const int index)
+{
+    // called from inside the thread pool, so the single threaded versions are used
+    detect_pyramid_level(index + 1, NULL);
+    return;
+}
+
+const ImagePyramid *SimpleFAST::get_image_pyramid() const
+{
+    return image_pyramid_p.get();
+}
+
+void SimpleFAST::detect_budgeted_features(const gray8c_view_t& view, FASTFeatureSet &features)
+{
+    detect_all_corners(view, nonmax_corners);
+
+    // the nonmax scores are used to keep the best features of each grid cell
+    features_selector_p->select(nonmax_corners, view.dimensions()[0], view.dimensions()[1],
+                                max_features, features);
+
+    if (adaptive_barrier)
+        update_barrier(nonmax_corners.size());
+
+    return;
+}
+
+void SimpleFAST::update_barrier(const int num_corners)
+{
+    // the number of corners decreases roughly exponentially when the barrier grows,
+    // so we use a proportional controller over the logarithm of the corners count.
+    // The ratio is clamped to avoid big jumps on sudden scene changes (e.g. motion blur)
+    const float ratio = static_cast<float>(num_corners + 1) / static_cast<float>(target_corners + 1);
+
+    if (ratio > 0.8f && ratio < 1.25f)
+        return; // close enough, the dead band avoids oscillations
+
+    // when the correction changes of direction we overshot, so the gain is reduced,
+    // it slowly recovers while the corrections keep the same direction
+    const int direction = (ratio > 1) ? 1 : -1;
+    if (direction != barrier_direction)
+        barrier_gain = max(0.05f, barrier_gain*0.5f);
+    else
+        barrier_gain = min(0.25f, barrier_gain*1.25f);
+    barrier_direction = direction;
+
+    const float clamped_ratio = max(0.25f, min(4.0f, ratio));
+    barrier_value *= pow(clamped_ratio, barrier_gain);
+    barrier_value = max(static_cast<float>(min_barrier), min(static_cast<float>(max_barrier), barrier_value));
+
+    barrier = static_cast<int>(barrier_value + 0.5f);
+    return;
+}
+
+int SimpleFAST::get_barrier() const
+{
+    return barrier;
+}
+
+template<typename CornersContainer>
+void SimpleFAST::find_corners(const gray8c_view_t& view, CornersContainer &corners, ThreadPool *thread_pool)
+{
+    // the multi-threaded versions give the same results
+    if (use_segment_test)
+    {
+        if (thread_pool)
+            fast::segment_test_corner_detect(view, barrier, corners, *thread_pool);
+        else
+            fast::segment_test_corner_detect(view, barrier, corners);
+    }
+    else
+    {
+        if (thread_pool)
+            fast::corner_detect(view, barrier, corners, *thread_pool);
+        else
+            fast::corner_detect(view, barrier, corners);
+    }
+    return;
+}
+
+template<typename CornersContainer>
+void SimpleFAST::find_nonmax_corners(const gray8c_view_t& view,
+                                     CornersContainer &corners, CornersContainer &best_corners,
+                                     ThreadPool *thread_pool)
+{
+    find_corners(view, corners, thread_pool);
+
+    // keep the best ones
+    if (thread_pool)
+        fast::nonmax(view, barrier, corners, best_corners, *thread_pool);
+    else
+        fast::nonmax(view, barrier, corners, best_corners);
+    return;
+}
+
 
 
 }
\ No newline at end of file
@@ -9,10 +9,14 @@
 
 #include "../IFeaturesDetector.hpp"
 #include "FASTFeature.hpp"
+#include "FASTFeatureSet.hpp"
+#include "GridFeaturesSelector.hpp"
+#include "../ImagePyramid.hpp"
 
 #include <vector>
 
 #include <boost/cstdint.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/program_options.hpp>
 #include <boost/gil/typedefs.hpp>
 
@@ -20,6 +24,8 @@
 namespace uniclop
 {
 
+class ThreadPool; // forward declaration
+
 using namespace std;
 
 namespace args = boost::program_options;
@@ -35,7 +41,30 @@ class SimpleFAST : public IFeaturesDetector<FASTFeature, gray8c_view_t>
     // FAST features detection and matching by Edward Rosten and Tom Drummond
 
     vector<FASTFeature> detected_features, best_features;
+    FASTFeatureSet detected_corners;
     int barrier;
+    bool use_segment_test; ///< use fast::segment_test_corner_detect instead of the decision tree
+
+    ///@name budgeted mode, used when max_features > 0
+    ///@{
+    int max_features;
+    boost::scoped_ptr<GridFeaturesSelector> features_selector_p;
+    FASTFeatureSet nonmax_corners, selected_corners;
+
+    bool adaptive_barrier;
+    int target_corners, min_barrier, max_barrier;
+    float barrier_value; ///< continuous version of the barrier, updated after each frame
+    float barrier_gain;
+    int barrier_direction; ///< sign of the last barrier correction
+    ///@}
+
+    ///@name multi-scale mode, used when pyramid_levels > 1
+    ///@{
+    boost::scoped_ptr<ImagePyramid> image_pyramid_p;
+    vector<FASTFeatureSet> levels_corners, levels_nonmax_corners; ///< in the coordinates of each level
+    ///@}
+
+    boost::scoped_ptr<ThreadPool> thread_pool_p; ///< NULL when using a single thread
 public:
 
     static args::options_description get_options_description();
@@ -44,6 +73,37 @@ public:
     ~SimpleFAST();
 
     const vector<FASTFeature> &detect_features(const gray8c_view_t& view);
+
+    /// Detect the features directly in a FASTFeatureSet,
+    /// the caller owns the set so that it can be kept (or swapped) without copies
+    void detect_features(const gray8c_view_t& view, FASTFeatureSet &features);
+
+private:
+
+    /// thread_pool can be NULL
+    template<typename CornersContainer>
+    void find_corners(const gray8c_view_t& view, CornersContainer &corners, ThreadPool *thread_pool);
+
+    template<typename CornersContainer>
+    void find_nonmax_corners(const gray8c_view_t& view,
+                             CornersContainer &corners, CornersContainer &best_corners,
+                             ThreadPool *thread_pool);
+
+    /// nonmax corners of the view, at all the pyramid levels when in multi-scale mode
+    void detect_all_corners(const gray8c_view_t& view, FASTFeatureSet &corners);
+    void detect_pyramid_corners(const gray8c_view_t& view, FASTFeatureSet &corners);
+    void detect_pyramid_level(const int level, ThreadPool *thread_pool);
+    void detect_upper_pyramid_level(const int index);
+
+    void detect_budgeted_features(const gray8c_view_t& view, FASTFeatureSet &features);
+    void update_barrier(const int num_corners);
+
+public:
+    int get_barrier() const;
+
+    /// Pyramid built for the last frame, NULL when not in multi-scale mode.
+    /// Other consumers of the same frame (e.g. the KLT trackers) can reuse it instead of building their own
+    const ImagePyramid *get_image_pyramid() const;
 };
 
 
@@ -8,7 +8,11 @@
 // Headers
 
 #include "fast.hpp"
+#include "fast_segment_test.hpp"
 
+#include "helpers/ThreadPool.hpp"
+
+#include <algorithm>
 #include <typeinfo>
 #include <boost/gil/image.hpp>
 
@@ -29,7 +33,136 @@ typedef struct
 }
 xy;
 
-void corner_detect(const gray8c_view_t& view, const int barrier, std::vector<FASTFeature>& corners)
+
+// helper classes, give the same interface to vector<FASTFeature> and FASTFeatureSet
+// so that the detection and non maximal suppression code is written only once
+
+class FeaturesVectorAdapter
+{
+    vector<FASTFeature> &features;
+    FASTFeature new_feature;
+
+public:
+    typedef vector<FASTFeature> container_t;
+
+    FeaturesVectorAdapter(vector<FASTFeature> &_features) : features(_features)
+    {
+        return;
+    }
+
+    int size() const
+    {
+        return features.size();
+    }
+
+    int x(const int i) const
+    {
+        return features[i].x;
+    }
+
+    int y(const int i) const
+    {
+        return features[i].y;
+    }
+
+    uint8_t *circle_intensities(const int i)
+    {
+        return features[i].circle_intensities;
+    }
+
+    void set_score(const int, const int)
+    { // FASTFeature does not store the score
+        return;
+    }
+
+    void clear()
+    {
+        features.clear();
+    }
+
+    void push_back(const int x, const int y)
+    {
+        new_feature.x = x;
+        new_feature.y = y;
+        features.push_back(new_feature); // copy
+    }
+
+    void push_back(const FeaturesVectorAdapter &other, const int i, const int)
+    {
+        features.push_back(other.features[i]); // copy
+    }
+
+    void append(const vector<FASTFeature> &other)
+    {
+        features.insert(features.end(), other.begin(), other.end());
+    }
+};
+
+class FeatureSetAdapter
+{
+    FASTFeatureSet &features;
+
+public:
+    typedef FASTFeatureSet container_t;
+
+    FeatureSetAdapter(FASTFeatureSet &_features) : features(_features)
+    {
+        return;
+    }
+
+    int size() const
+    {
+        return features.size();
+    }
+
+    int x(const int i) const
+    {
+        return features.x[i];
+    }
+
+    int y(const int i) const
+    {
+        return features.y[i];
+    }
+
+    uint8_t *circle_intensities(const int i)
+    {
+        return features.circle_intensities(i);
+    }
+
+    void set_score(const int i, const int score)
+    {
+        features.score[i] = score;
+    }
+
+    void clear()
+    {
+        features.clear();
+    }
+
+    void push_back(const int x, const int y)
+    {
+        features.push_back(x, y);
+    }
+
+    void push_back(const FeatureSetAdapter &other, const int i, const int score)
+    {
+        features.push_back(other.features.x[i], other.features.y[i], score,
+                           other.features.circle_intensities(i));
+    }
+
+    void append(const FASTFeatureSet &other)
+    {
+        features.append(other);
+    }
+};
+
+
+/// Detects the corners of the rows [y_begin, y_end),
+/// reading the 3 rows above and below the range (the band halo) directly from the full view
+template<typename CornersAdapter>
+void corner_detect_impl(const gray8c_view_t& view, const int barrier,
+                        const int y_begin, const int y_end, CornersAdapter& corners)
 {
     // This looks like generated code
 
@@ -39,7 +172,6 @@ void corner_detect(const gray8c_view_t& view, const int barrier, std::vector<FAS
 
     corners.clear();
 
-    FASTFeature success_xy; // helper variable
     const int boundary = 3;
     int y, cb, c_b;
     const byte  *line_max, *line_min;
@@ -63,7 +195,7 @@ void corner_detect(const gray8c_view_t& view, const int barrier, std::vector<FAS
     pixel[13] = -3 + 1 * xsize;
     pixel[14] = -2 + 2 * xsize;
     pixel[15] = -1 + 3 * xsize;
-    for (y = boundary ; y < ysize - boundary; y++)
+    for (y = max(y_begin, boundary) ; y < min(y_end, ysize - boundary); y++)
     {
         cache_0 = im + boundary + y*xsize;
         line_min = cache_0 - boundary;
@@ -2670,19 +2802,55 @@ void corner_detect(const gray8c_view_t& view, const int barrier, std::vector<FAS
                     continue;
 success:
 
-            success_xy.x =  cache_0-line_min;
-            success_xy.y = y;
-            corners.push_back(success_xy); // copy
+            corners.push_back(cache_0-line_min, y);
         }
     }
 
     return;
 }
 
+/// Exact FAST-9 segment test over the rows [y_begin, y_end), see fast_segment_test.cpp
+template<typename CornersAdapter>
+void segment_test_impl(const gray8c_view_t& view, const int barrier,
+                       const int y_begin, const int y_end, CornersAdapter& corners)
+{
+    const int xsize = view.dimensions()[0];
+    const int ysize = view.dimensions()[1];
+    const byte* im = boost::gil::interleaved_view_get_raw_data(view);
+
+    corners.clear();
+
+    const int boundary = 3;
+    vector<int> row_corners_x(xsize);
+    int y, i;
+    for (y = max(y_begin, boundary) ; y < min(y_end, ysize - boundary); y++)
+    {
+        const int num_row_corners = segment_test_row(im + y*xsize, xsize, barrier, &row_corners_x[0]);
+        for (i=0; i < num_row_corners; i+=1)
+            corners.push_back(row_corners_x[i], y);
+    }
+
+    return;
+}
+
+void corner_detect(const gray8c_view_t& view, const int barrier, std::vector<FASTFeature>& corners)
+{
+    FeaturesVectorAdapter corners_adapter(corners);
+    corner_detect_impl(view, barrier, 0, view.dimensions()[1], corners_adapter);
+    return;
+}
+
+void corner_detect(const gray8c_view_t& view, const int barrier, FASTFeatureSet& corners)
+{
+    FeatureSetAdapter corners_adapter(corners);
+    corner_detect_impl(view, barrier, 0, view.dimensions()[1], corners_adapter);
+    return;
+}
+
 
 // ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
 
-int corner_score(const byte*  imp, const int *pointer_dir, const int barrier, FASTFeature &feature)
+int corner_score(const byte*  imp, const int *pointer_dir, const int barrier, uint8_t *circle_intensities)
 {
     /*The score for a positive feature is sum of the difference between the pixels
       and the barrier if the difference is positive. Negative is similar.
@@ -2694,7 +2862,7 @@ int corner_score(const byte*  imp, const int *pointer_dir, const int barrier, FA
 
        Score = max sum(Sp), sum(Sn)
 
-       Will also fill the feature.circle_intensities vector (used to match or not two features)
+       Will also fill the circle_intensities vector (used to match or not two features)
        */
 
     int cb = *imp + barrier;
@@ -2706,7 +2874,7 @@ int corner_score(const byte*  imp, const int *pointer_dir, const int barrier, FA
     for (i=0; i<16; i++)
     {
         const byte val = imp[pointer_dir[i]];
-        feature.circle_intensities[i] = val;
+        circle_intensities[i] = val;
         int p = val;
 
         if (p > cb)
@@ -2722,34 +2890,10 @@ int corner_score(const byte*  imp, const int *pointer_dir, const int barrier, FA
 }
 
 
-void nonmax(const gray8c_view_t& view,  const int barrier, std::vector<FASTFeature>& corners,
-            std::vector<FASTFeature>& nonmax_corners)
-// void fast_nonmax(const BasicImage<byte>& im, const vector<ImageRef>& corners, int barrier, vector<ReturnType>& nonmax_corners)
-//xy*  fast_nonmax(const byte* im, int xsize, int ysize, xy* corners, int numcorners, int barrier, int* numnx)
+void compute_circle_offsets(const int xsize, int *pointer_dir)
 {
-
-    const int xsize = view.dimensions()[0];
-    const int ysize = view.dimensions()[1];
-    // FIXME why static_cast or dynamic_cast fails here ?
-    //const byte* im = static_cast<const byte *>(&view.begin()[0]);
-    //const byte* im = dynamic_cast<const byte *>(&view.begin()[0]);
-    const byte* im = (const byte *)(&view.begin()[0]);
-
-    const int numcorners = corners.size();
-
-    nonmax_corners.clear();
-    vector<int> row_start(ysize);
-    vector<int> scores(corners.size());
-
     /*Create a list of integer pointer offsets, corresponding to the */
     /*direction offsets in dir[]*/
-    int	pointer_dir[16];
-
-    int prev_row = -1;
-    int i, j;
-    int point_above = 0;
-    int point_below = 0;
-
     pointer_dir[0] = 0 + 3 * xsize;
     pointer_dir[1] = 1 + 3 * xsize;
     pointer_dir[2] = 2 + 2 * xsize;
@@ -2766,75 +2910,83 @@ void nonmax(const gray8c_view_t& view,  const int barrier, std::vector<FASTFeatu
     pointer_dir[13] = -3 + 1 * xsize;
     pointer_dir[14] = -2 + 2 * xsize;
     pointer_dir[15] = -1 + 3 * xsize;
+    return;
+}
 
-    if (numcorners < 5)
-    {
-        return;
-    }
-
-    /*xsize ysize numcorners corners*/
-
-    /*Compute the score for each detected corner, and find where each row begins*/
-    /* (the corners are output in raster scan order). A beginning of -1 signifies*/
-    /* that there are no corners on that row.*/
-
-
-    for (i=0; i <ysize; i++)
-        row_start[i] = -1;
-
-
-    for (i=0; i< numcorners; i++)
+/// Computes the score of the corners [i_begin, i_end) and find where each row begins
+/// (the corners are output in raster scan order). A beginning of -1 signifies
+/// that there are no corners on that row.
+template<typename CornersAdapter>
+void compute_scores(const byte* im, const int xsize, const int *pointer_dir, const int barrier,
+                    CornersAdapter& corners, const int i_begin, const int i_end,
+                    vector<int> &row_start, vector<int> &scores)
+{
+    int i;
+    for (i=i_begin; i < i_end; i++)
     {
-        if (corners[i].y != prev_row)
-        {
-            row_start[corners[i].y] = i;
-            prev_row = corners[i].y;
-        }
+        if (i == 0 || corners.y(i) != corners.y(i-1))
+            row_start[corners.y(i)] = i;
 
-        scores[i] = corner_score(im + corners[i].x + corners[i].y * xsize, pointer_dir, barrier, corners[i]);
+        scores[i] = corner_score(im + corners.x(i) + corners.y(i) * xsize, pointer_dir, barrier,
+                                 corners.circle_intensities(i));
+        corners.set_score(i, scores[i]);
     }
+    return;
+}
 
+/// Non maximal suppression of the corners [i_begin, i_end), the survivors are added to nonmax_corners.
+/// point_above and point_below only depend on the position of the current corner,
+/// so disjoint index ranges can be processed independently and give the same result as a single pass
+template<typename CornersAdapter>
+void suppress_non_maxima(const int ysize, CornersAdapter& corners,
+                         const vector<int> &row_start, const vector<int> &scores,
+                         const int i_begin, const int i_end,
+                         CornersAdapter& nonmax_corners)
+{
+    const int numcorners = corners.size();
+    int i, j;
+    int point_above = 0;
+    int point_below = 0;
 
     // Point above points (roughly) to the pixel above the one of interest,
     // if there is a feature there.
 
-    for (i=1; i < numcorners-1; i++)
+    for (i=i_begin; i < i_end; i++)
     {
         int score = scores[i];
-        const FASTFeature &f = corners[i];
-        const int pos_x = f.x;
-        const int pos_y = f.y;
+        const int pos_x = corners.x(i);
+        const int pos_y = corners.y(i);
 
 
         /*Check left*/
         /*if(corners[i-1] == pos-ImageRef(1,0) && scores[i-1] > score)*/
         if (i > 0)
-            if (corners[i-1].x == pos_x-1 && corners[i-1].y == pos_y && scores[i-1] > score)
+            if (corners.x(i-1) == pos_x-1 && corners.y(i-1) == pos_y && scores[i-1] > score)
                 continue;
 
         /*Check right*/
         /*if(corners[i+1] == pos+ImageRef(1,0) && scores[i+1] > score)*/
         if (i < (numcorners - 1))
-            if (corners[i+1].x == pos_x+1 && corners[i+1].y == pos_y && scores[i-1] > score)
+            if (corners.x(i+1) == pos_x+1 && corners.y(i+1) == pos_y && scores[i-1] > score)
                 continue;
 
         /*Check above*/
         if (pos_y != 0 && row_start[pos_y - 1] != -1 && point_above < numcorners )
         {
-            if (corners[point_above].y < pos_y - 1)
+            if (corners.y(point_above) < pos_y - 1)
                 point_above = row_start[pos_y-1];
 
             /*Make point above point to the first of the pixels above the current point,*/
             /*if it exists.*/
             for (; point_above < numcorners
-                    && corners[point_above].y < pos_y
-                    && corners[point_above].x < pos_x - 1;
+                    && corners.y(point_above) < pos_y
+                    && corners.x(point_above) < pos_x - 1;
                     point_above++);
 
 
-            for (j=point_above; j < numcorners && corners[j].y < pos_y && corners[j].x <= pos_x + 1; j++)
+            for (j=point_above; j < numcorners && corners.y(j) < pos_y && corners.x(j) <= pos_x + 1; j++)
             {
-                int x = corners[j].x;
+                int x = corners.x(j);
                 if ( (x == pos_x - 1 || x ==pos_x || x == pos_x+1) && scores[j] > score)
                 {
                     goto cont;
@@ -2846,20 +2998,20 @@ void nonmax(const gray8c_view_t& view,  const int barrier, std::vector<FASTFeatu
         /*Check below*/
         if (pos_y != ysize-1 && row_start[pos_y + 1] != -1 && point_below < numcorners) /*Nothing below*/
         {
-            if (corners[point_below].y < pos_y + 1)
+            if (corners.y(point_below) < pos_y + 1)
                 point_below = row_start[pos_y+1];
 
             /* Make point below point to one of the pixels belowthe current point, if it*/
             /* exists.*/
             for (; point_below < numcorners
-                    && corners[point_below].y == pos_y+1
-                    && corners[point_below].x < pos_x - 1; point_below++);
+                    && corners.y(point_below) == pos_y+1
+                    && corners.x(point_below) < pos_x - 1; point_below++);
 
             for (j=point_below;
-                    j < numcorners && corners[j].y == pos_y+1 && corners[j].x <= pos_x + 1;
+                    j < numcorners && corners.y(j) == pos_y+1 && corners.x(j) <= pos_x + 1;
                     j++)
             {
-                int x = corners[j].x;
+                int x = corners.x(j);
                 if ( (x == pos_x - 1 || x ==pos_x || x == pos_x+1) && scores[j] > score)
                 {
                     goto cont;
@@ -2867,8 +3019,7 @@ void nonmax(const gray8c_view_t& view,  const int barrier, std::vector<FASTFeatu
             }
         }
 
-        nonmax_corners.push_back(corners[i]); // copy
-        // scores[i] contains the score the corners[i]
+        nonmax_corners.push_back(corners, i, scores[i]);
 
 cont:
         ;
@@ -2877,6 +3028,273 @@ cont:
     return;
 }
 
+
+template<typename CornersAdapter>
+void nonmax_impl(const gray8c_view_t& view,  const int barrier, CornersAdapter& corners,
+                 CornersAdapter& nonmax_corners)
+// void fast_nonmax(const BasicImage<byte>& im, const vector<ImageRef>& corners, int barrier, vector<ReturnType>& nonmax_corners)
+//xy*  fast_nonmax(const byte* im, int xsize, int ysize, xy* corners, int numcorners, int barrier, int* numnx)
+{
+
+    const int xsize = view.dimensions()[0];
+    const int ysize = view.dimensions()[1];
+    // FIXME why static_cast or dynamic_cast fails here ?
+    //const byte* im = static_cast<const byte *>(&view.begin()[0]);
+    //const byte* im = dynamic_cast<const byte *>(&view.begin()[0]);
+    const byte* im = (const byte *)(&view.begin()[0]);
+
+    const int numcorners = corners.size();
+
+    nonmax_corners.clear();
+
+    if (numcorners < 5)
+    {
+        return;
+    }
+
+    vector<int> row_start(ysize, -1);
+    vector<int> scores(numcorners);
+
+    int	pointer_dir[16];
+    compute_circle_offsets(xsize, pointer_dir);
+
+    compute_scores(im, xsize, pointer_dir, barrier, corners, 0, numcorners, row_start, scores);
+
+    suppress_non_maxima(ysize, corners, row_start, scores, 1, numcorners - 1, nonmax_corners);
+
+    return;
+}
+
+void nonmax(const gray8c_view_t& view,  const int barrier, std::vector<FASTFeature>& corners,
+            std::vector<FASTFeature>& nonmax_corners)
+{
+    FeaturesVectorAdapter corners_adapter(corners), nonmax_corners_adapter(nonmax_corners);
+    nonmax_impl(view, barrier, corners_adapter, nonmax_corners_adapter);
+    return;
+}
+
+void nonmax(const gray8c_view_t& view,  const int barrier, FASTFeatureSet& corners,
+            FASTFeatureSet& nonmax_corners)
+{
+    FeatureSetAdapter corners_adapter(corners), nonmax_corners_adapter(nonmax_corners);
+    nonmax_impl(view, barrier, corners_adapter, nonmax_corners_adapter);
+    return;
+}
+
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Multi-threaded versions
+
+void segment_test_corner_detect(const gray8c_view_t& view, const int barrier, std::vector<FASTFeature>& corners)
+{
+    FeaturesVectorAdapter corners_adapter(corners);
+    segment_test_impl(view, barrier, 0, view.dimensions()[1], corners_adapter);
+    return;
+}
+
+void segment_test_corner_detect(const gray8c_view_t& view, const int barrier, FASTFeatureSet& corners)
+{
+    FeatureSetAdapter corners_adapter(corners);
+    segment_test_impl(view, barrier, 0, view.dimensions()[1], corners_adapter);
+    return;
+}
+
+
+/// Splits [begin, end) in num_parts contiguous ranges and returns the range of the given part
+void split_range(const int begin, const int end, const int num_parts, const int part,
+                 int &part_begin, int &part_end)
+{
+    const int length = max(0, end - begin);
+    part_begin = begin + (length * part) / num_parts;
+    part_end = begin + (length * (part + 1)) / num_parts;
+    return;
+}
+
+template<typename CornersAdapter>
+class CornerDetectionTask
+{
+    typedef typename CornersAdapter::container_t container_t;
+
+    const gray8c_view_t &view;
+    const int barrier;
+    const bool use_segment_test;
+    vector<container_t> &bands_corners;
+
+public:
+    CornerDetectionTask(const gray8c_view_t &_view, const int _barrier, const bool _use_segment_test,
+                        vector<container_t> &_bands_corners)
+            : view(_view), barrier(_barrier), use_segment_test(_use_segment_test), bands_corners(_bands_corners)
+    {
+        return;
+    }
+
+    void operator()(const int band) const
+    {
+        const int boundary = 3;
+        int y_begin, y_end;
+        split_range(boundary, view.dimensions()[1] - boundary, bands_corners.size(), band, y_begin, y_end);
+
+        CornersAdapter band_corners_adapter(bands_corners[band]);
+        if (use_segment_test)
+            segment_test_impl(view, barrier, y_begin, y_end, band_corners_adapter);
+        else
+            corner_detect_impl(view, barrier, y_begin, y_end, band_corners_adapter);
+        return;
+    }
+};
+
+template<typename CornersAdapter>
+void corner_detect_parallel(const gray8c_view_t& view, const int barrier, const bool use_segment_test,
+                            typename CornersAdapter::container_t& corners, ThreadPool &thread_pool)
+{
+    // more bands than threads, so that the threads stay busy when the corners density is uneven
+    const int num_bands = 4*thread_pool.get_num_threads();
+    vector<typename CornersAdapter::container_t> bands_corners(num_bands);
+
+    thread_pool.run(num_bands, CornerDetectionTask<CornersAdapter>(view, barrier, use_segment_test, bands_corners));
+
+    // the bands are in raster order, so their concatenation is identical to the single threaded scan
+    CornersAdapter corners_adapter(corners);
+    corners_adapter.clear();
+    int band;
+    for (band=0; band < num_bands; band+=1)
+        corners_adapter.append(bands_corners[band]);
+
+    return;
+}
+
+template<typename CornersAdapter>
+class NonmaxTask
+{
+    typedef typename CornersAdapter::container_t container_t;
+
+    const byte* im;
+    const int xsize, ysize, barrier;
+    const int *pointer_dir;
+    CornersAdapter &corners;
+    vector<int> &row_start, &scores;
+    vector<container_t> &bands_nonmax_corners;
+    const bool compute_scores_pass;
+
+public:
+    NonmaxTask(const byte* _im, const int _xsize, const int _ysize, const int _barrier,
+               const int *_pointer_dir, CornersAdapter &_corners,
+               vector<int> &_row_start, vector<int> &_scores,
+               vector<container_t> &_bands_nonmax_corners, const bool _compute_scores_pass)
+            : im(_im), xsize(_xsize), ysize(_ysize), barrier(_barrier),
+            pointer_dir(_pointer_dir), corners(_corners),
+            row_start(_row_start), scores(_scores),
+            bands_nonmax_corners(_bands_nonmax_corners), compute_scores_pass(_compute_scores_pass)
+    {
+        return;
+    }
+
+    void operator()(const int band) const
+    {
+        const int num_bands = bands_nonmax_corners.size();
+        const int numcorners = corners.size();
+        int i_begin, i_end;
+
+        if (compute_scores_pass)
+        { // each band writes its own scores and row_start entries
+            split_range(0, numcorners, num_bands, band, i_begin, i_end);
+            compute_scores(im, xsize, pointer_dir, barrier, corners, i_begin, i_end, row_start, scores);
+        }
+        else
+        {
+            split_range(1, numcorners - 1, num_bands, band, i_begin, i_end);
+            CornersAdapter band_nonmax_corners_adapter(bands_nonmax_corners[band]);
+            band_nonmax_corners_adapter.clear();
+            suppress_non_maxima(ysize, corners, row_start, scores, i_begin, i_end, band_nonmax_corners_adapter);
+        }
+        return;
+    }
+};
+
+template<typename CornersAdapter>
+void nonmax_parallel(const gray8c_view_t& view,  const int barrier,
+                     typename CornersAdapter::container_t& corners,
+                     typename CornersAdapter::container_t& nonmax_corners,
+                     ThreadPool &thread_pool)
+{
+    const int xsize = view.dimensions()[0];
+    const int ysize = view.dimensions()[1];
+    const byte* im = (const byte *)(&view.begin()[0]);
+
+    CornersAdapter corners_adapter(corners), nonmax_corners_adapter(nonmax_corners);
+    const int numcorners = corners_adapter.size();
+
+    nonmax_corners_adapter.clear();
+
+    if (numcorners < 5)
+    {
+        return;
+    }
+
+    vector<int> row_start(ysize, -1);
+    vector<int> scores(numcorners);
+
+    int	pointer_dir[16];
+    compute_circle_offsets(xsize, pointer_dir);
+
+    const int num_bands = thread_pool.get_num_threads();
+    vector<typename CornersAdapter::container_t> bands_nonmax_corners(num_bands);
+
+    // the suppression reads the scores of the neighbouring bands, so we need two passes
+    thread_pool.run(num_bands, NonmaxTask<CornersAdapter>(im, xsize, ysize, barrier, pointer_dir, corners_adapter,
+                    row_start, scores, bands_nonmax_corners, true));
+    thread_pool.run(num_bands, NonmaxTask<CornersAdapter>(im, xsize, ysize, barrier, pointer_dir, corners_adapter,
+                    row_start, scores, bands_nonmax_corners, false));
+
+    int band;
+    for (band=0; band < num_bands; band+=1)
+        nonmax_corners_adapter.append(bands_nonmax_corners[band]);
+
+    return;
+}
+
+void corner_detect(const gray8c_view_t& view, const int barrier, std::vector<FASTFeature>& corners,
+                   ThreadPool &thread_pool)
+{
+    corner_detect_parallel<FeaturesVectorAdapter>(view, barrier, false, corners, thread_pool);
+    return;
+}
+
+void corner_detect(const gray8c_view_t& view, const int barrier, FASTFeatureSet& corners,
+                   ThreadPool &thread_pool)
+{
+    corner_detect_parallel<FeatureSetAdapter>(view, barrier, false, corners, thread_pool);
+    return;
+}
+
+void segment_test_corner_detect(const gray8c_view_t& view, const int barrier, std::vector<FASTFeature>& corners,
+                                ThreadPool &thread_pool)
+{
+    corner_detect_parallel<FeaturesVectorAdapter>(view, barrier, true, corners, thread_pool);
+    return;
+}
+
+void segment_test_corner_detect(const gray8c_view_t& view, const int barrier, FASTFeatureSet& corners,
+                                ThreadPool &thread_pool)
+{
+    corner_detect_parallel<FeatureSetAdapter>(view, barrier, true, corners, thread_pool);
+    return;
+}
+
+void nonmax(const gray8c_view_t& view,  const int barrier, std::vector<FASTFeature>& corners,
+            std::vector<FASTFeature>& nonmax_corners, ThreadPool &thread_pool)
+{
+    nonmax_parallel<FeaturesVectorAdapter>(view, barrier, corners, nonmax_corners, thread_pool);
+    return;
+}
+
+void nonmax(const gray8c_view_t& view,  const int barrier, FASTFeatureSet& corners,
+            FASTFeatureSet& nonmax_corners, ThreadPool &thread_pool)
+{
+    nonmax_parallel<FeatureSetAdapter>(view, barrier, corners, nonmax_corners, thread_pool);
+    return;
+}
+
 }
 }
 // ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
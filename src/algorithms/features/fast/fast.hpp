@@ -8,6 +8,7 @@
 // Headers
 
 #include "FASTFeature.hpp"
+#include "FASTFeatureSet.hpp"
 
 #include <vector>
 #include <boost/cstdint.hpp>
@@ -18,6 +19,9 @@
 
 namespace uniclop
 {
+
+class ThreadPool; // forward declaration
+
 namespace fast
 {
 
@@ -38,6 +42,9 @@ using boost::gil::gray8c_view_t;
 **/
 void corner_detect(const gray8c_view_t& view, const int barrier, vector<FASTFeature>& corners);
 
+/// Same as above, but storing the corners in a FASTFeatureSet (no per feature copies)
+void corner_detect(const gray8c_view_t& view, const int barrier, FASTFeatureSet& corners);
+
 /** Perform non-maximal suppression on a set of FAST features. This cleans up
 areas where there are multiple adjacent features, using a computed score
 function to leave only the 'best' features. This function is typically called
@@ -53,6 +60,42 @@ Will also fill the feature.circle_intensities vector (used to match or not two f
 */
 void nonmax(const gray8c_view_t& view,  const int barrier, vector<FASTFeature>& corners, vector<FASTFeature>& nonmax_corners);
 
+/// Same as above, operating over FASTFeatureSet.
+/// The scores of the corners are stored in corners.score and nonmax_corners.score
+void nonmax(const gray8c_view_t& view,  const int barrier, FASTFeatureSet& corners, FASTFeatureSet& nonmax_corners);
+
+/** Multi-threaded versions of corner_detect and nonmax.
+The image is split in horizontal bands processed in parallel by the thread pool
+(each band reads a 3 pixels halo above and below from the full image),
+the results are identical to the single threaded versions.
+*/
+void corner_detect(const gray8c_view_t& view, const int barrier, vector<FASTFeature>& corners,
+                   ThreadPool &thread_pool);
+void corner_detect(const gray8c_view_t& view, const int barrier, FASTFeatureSet& corners,
+                   ThreadPool &thread_pool);
+void nonmax(const gray8c_view_t& view,  const int barrier, vector<FASTFeature>& corners, vector<FASTFeature>& nonmax_corners,
+            ThreadPool &thread_pool);
+void nonmax(const gray8c_view_t& view,  const int barrier, FASTFeatureSet& corners, FASTFeatureSet& nonmax_corners,
+            ThreadPool &thread_pool);
+
+/** Exact FAST-9 segment test detector, an alternative to corner_detect.
+
+    corner_detect uses the decision tree learned by E. Rosten, which visits the circle pixels
+    in a data dependent order (and is itself a close approximation of the segment test,
+    it returns slightly different corners). This version tests 16 or 32 pixels at once
+    with SSE2 or AVX2 (selected at runtime): candidates are first rejected using the
+    compass pixels 0, 4, 8 and 12, then the longest brighter and darker arcs are counted.
+    The scalar fallback returns exactly the same corners, in the same raster order,
+    so the output can be fed to nonmax.
+    The barrier is clamped to [0, 255].
+*/
+void segment_test_corner_detect(const gray8c_view_t& view, const int barrier, vector<FASTFeature>& corners);
+void segment_test_corner_detect(const gray8c_view_t& view, const int barrier, FASTFeatureSet& corners);
+void segment_test_corner_detect(const gray8c_view_t& view, const int barrier, vector<FASTFeature>& corners,
+                                ThreadPool &thread_pool);
+void segment_test_corner_detect(const gray8c_view_t& view, const int barrier, FASTFeatureSet& corners,
+                                ThreadPool &thread_pool);
+
 /*
 Usage example:
 FAST::corner_detect_9(image, 30, corners);
@@ -0,0 +1,305 @@
+
+
+// FAST-9 segment test, SIMD implementation
+// the decision tree in fast.cpp visits the circle pixels in a data dependent order,
+// here all the pixels of a block are tested at once, without branches
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Headers
+
+#include "fast_segment_test.hpp"
+
+#include "helpers/cpu_features.hpp"
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <immintrin.h>
+#endif
+
+namespace uniclop
+{
+namespace fast
+{
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Functions definition
+
+/// Bresenham circle of radius 3, same order as pixel[] in fast::corner_detect
+static const int circle_dx[16] = { 0, 1, 2, 3, 3, 3, 2, 1, 0, -1, -2, -3, -3, -3, -2, -1 };
+static const int circle_dy[16] = { 3, 3, 2, 1, 0, -1, -2, -3, -3, -3, -2, -1, 0, 1, 2, 3 };
+
+static void compute_circle_offsets(const int xsize, int *offsets)
+{
+    int i;
+    for (i=0; i < 16; i+=1)
+        offsets[i] = circle_dx[i] + circle_dy[i]*xsize;
+    return;
+}
+
+/// true if the 16 bits circular mask contains 9 contiguous set bits
+static inline bool has_nine_contiguous_bits(const unsigned int mask)
+{
+    unsigned int m = mask | (mask << 16); // unroll the circle
+    m &= m >> 1; // now bit i is set if bits i..i+1 were set
+    m &= m >> 2; // i..i+3
+    m &= m >> 4; // i..i+7
+    m &= m >> 1; // i..i+8
+    return (m & 0xFFFF) != 0;
+}
+
+int segment_test_row_scalar(const uint8_t *row_p, const int xsize, const int barrier,
+                            const int x_begin, const int x_end, int *corners_x)
+{
+    int offsets[16];
+    compute_circle_offsets(xsize, offsets);
+
+    int num_corners = 0;
+    int x, i;
+    for (x=x_begin; x < x_end; x+=1)
+    {
+        const uint8_t *p = row_p + x;
+        const int cb = *p + barrier;
+        const int c_b = *p - barrier;
+
+        unsigned int brighter = 0, darker = 0;
+        for (i=0; i < 16; i+=1)
+        {
+            const int value = p[offsets[i]];
+            brighter |= (value > cb) ? (1 << i) : 0;
+            darker |= (value < c_b) ? (1 << i) : 0;
+        }
+
+        if (has_nine_contiguous_bits(brighter) || has_nine_contiguous_bits(darker))
+        {
+            corners_x[num_corners] = x;
+            num_corners += 1;
+        }
+    }
+
+    return num_corners;
+}
+
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define FAST_SEGMENT_TEST_X86_KERNELS
+
+#define SSE2_TARGET __attribute__((target("sse2")))
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+/// 0xFF on the lanes where value > center + barrier, computed with saturated arithmetic
+/// (when center + barrier saturates to 255 no value can be brighter, as in the scalar version)
+SSE2_TARGET static inline __m128i sse2_brighter(const __m128i value, const __m128i center_plus_barrier)
+{
+    const __m128i zero = _mm_setzero_si128();
+    return _mm_xor_si128(_mm_cmpeq_epi8(_mm_subs_epu8(value, center_plus_barrier), zero), _mm_set1_epi8(-1));
+}
+
+SSE2_TARGET static inline __m128i sse2_darker(const __m128i value, const __m128i center_minus_barrier)
+{
+    const __m128i zero = _mm_setzero_si128();
+    return _mm_xor_si128(_mm_cmpeq_epi8(_mm_subs_epu8(center_minus_barrier, value), zero), _mm_set1_epi8(-1));
+}
+
+/// longest run of 0xFF masks along the circle (unrolled to 16 + 8 positions), per lane
+SSE2_TARGET static inline __m128i sse2_longest_arc(const __m128i *masks)
+{
+    const __m128i one = _mm_set1_epi8(1);
+    __m128i run = _mm_setzero_si128(), longest_run = _mm_setzero_si128();
+    int i;
+    for (i=0; i < 16 + 8; i+=1)
+    {
+        run = _mm_and_si128(_mm_add_epi8(run, one), masks[i & 15]);
+        longest_run = _mm_max_epu8(longest_run, run);
+    }
+    return longest_run;
+}
+
+SSE2_TARGET static int sse2_segment_test_row(const uint8_t *row_p, const int xsize, const int barrier,
+                                             const int x_begin, const int x_end, int *corners_x)
+{
+    int offsets[16];
+    compute_circle_offsets(xsize, offsets);
+
+    const __m128i barrier_vector = _mm_set1_epi8(static_cast<char>(barrier));
+    const __m128i eight = _mm_set1_epi8(8);
+
+    int num_corners = 0;
+    int x = x_begin;
+    for (; x + 16 <= x_end; x+=16)
+    {
+        const uint8_t *p = row_p + x;
+        const __m128i center = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const __m128i center_plus_barrier = _mm_adds_epu8(center, barrier_vector);
+        const __m128i center_minus_barrier = _mm_subs_epu8(center, barrier_vector);
+
+        // any arc of 9 pixels contains two consecutive compass points (0, 4, 8, 12)
+        __m128i brighter[16], darker[16];
+        int i;
+        for (i=0; i < 16; i+=4)
+        {
+            const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + offsets[i]));
+            brighter[i] = sse2_brighter(value, center_plus_barrier);
+            darker[i] = sse2_darker(value, center_minus_barrier);
+        }
+
+        const __m128i compass_brighter =
+            _mm_or_si128(_mm_or_si128(_mm_and_si128(brighter[0], brighter[4]), _mm_and_si128(brighter[4], brighter[8])),
+                         _mm_or_si128(_mm_and_si128(brighter[8], brighter[12]), _mm_and_si128(brighter[12], brighter[0])));
+        const __m128i compass_darker =
+            _mm_or_si128(_mm_or_si128(_mm_and_si128(darker[0], darker[4]), _mm_and_si128(darker[4], darker[8])),
+                         _mm_or_si128(_mm_and_si128(darker[8], darker[12]), _mm_and_si128(darker[12], darker[0])));
+
+        if (_mm_movemask_epi8(_mm_or_si128(compass_brighter, compass_darker)) == 0)
+            continue; // no candidate in this block
+
+        for (i=0; i < 16; i+=1)
+        {
+            if ((i & 3) == 0)
+                continue; // already loaded
+            const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + offsets[i]));
+            brighter[i] = sse2_brighter(value, center_plus_barrier);
+            darker[i] = sse2_darker(value, center_minus_barrier);
+        }
+
+        // a pixel is not a corner if both longest arcs are shorter than 9
+        const __m128i is_not_corner = _mm_and_si128(
+                                          _mm_cmpeq_epi8(_mm_max_epu8(sse2_longest_arc(brighter), eight), eight),
+                                          _mm_cmpeq_epi8(_mm_max_epu8(sse2_longest_arc(darker), eight), eight));
+        unsigned int corners_mask = (~_mm_movemask_epi8(is_not_corner)) & 0xFFFF;
+
+        while (corners_mask != 0)
+        { // output in increasing x order
+            const int lane = __builtin_ctz(corners_mask);
+            corners_x[num_corners] = x + lane;
+            num_corners += 1;
+            corners_mask &= corners_mask - 1;
+        }
+    }
+
+    return num_corners + segment_test_row_scalar(row_p, xsize, barrier, x, x_end, corners_x + num_corners);
+}
+
+
+AVX2_TARGET static inline __m256i avx2_brighter(const __m256i value, const __m256i center_plus_barrier)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    return _mm256_xor_si256(_mm256_cmpeq_epi8(_mm256_subs_epu8(value, center_plus_barrier), zero),
+                            _mm256_set1_epi8(-1));
+}
+
+AVX2_TARGET static inline __m256i avx2_darker(const __m256i value, const __m256i center_minus_barrier)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    return _mm256_xor_si256(_mm256_cmpeq_epi8(_mm256_subs_epu8(center_minus_barrier, value), zero),
+                            _mm256_set1_epi8(-1));
+}
+
+AVX2_TARGET static inline __m256i avx2_longest_arc(const __m256i *masks)
+{
+    const __m256i one = _mm256_set1_epi8(1);
+    __m256i run = _mm256_setzero_si256(), longest_run = _mm256_setzero_si256();
+    int i;
+    for (i=0; i < 16 + 8; i+=1)
+    {
+        run = _mm256_and_si256(_mm256_add_epi8(run, one), masks[i & 15]);
+        longest_run = _mm256_max_epu8(longest_run, run);
+    }
+    return longest_run;
+}
+
+AVX2_TARGET static int avx2_segment_test_row(const uint8_t *row_p, const int xsize, const int barrier,
+                                             const int x_begin, const int x_end, int *corners_x)
+{
+    int offsets[16];
+    compute_circle_offsets(xsize, offsets);
+
+    const __m256i barrier_vector = _mm256_set1_epi8(static_cast<char>(barrier));
+    const __m256i eight = _mm256_set1_epi8(8);
+
+    int num_corners = 0;
+    int x = x_begin;
+    for (; x + 32 <= x_end; x+=32)
+    {
+        const uint8_t *p = row_p + x;
+        const __m256i center = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        const __m256i center_plus_barrier = _mm256_adds_epu8(center, barrier_vector);
+        const __m256i center_minus_barrier = _mm256_subs_epu8(center, barrier_vector);
+
+        __m256i brighter[16], darker[16];
+        int i;
+        for (i=0; i < 16; i+=4)
+        {
+            const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + offsets[i]));
+            brighter[i] = avx2_brighter(value, center_plus_barrier);
+            darker[i] = avx2_darker(value, center_minus_barrier);
+        }
+
+        const __m256i compass_brighter =
+            _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(brighter[0], brighter[4]),
+                                            _mm256_and_si256(brighter[4], brighter[8])),
+                            _mm256_or_si256(_mm256_and_si256(brighter[8], brighter[12]),
+                                            _mm256_and_si256(brighter[12], brighter[0])));
+        const __m256i compass_darker =
+            _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(darker[0], darker[4]),
+                                            _mm256_and_si256(darker[4], darker[8])),
+                            _mm256_or_si256(_mm256_and_si256(darker[8], darker[12]),
+                                            _mm256_and_si256(darker[12], darker[0])));
+
+        if (_mm256_movemask_epi8(_mm256_or_si256(compass_brighter, compass_darker)) == 0)
+            continue; // no candidate in this block
+
+        for (i=0; i < 16; i+=1)
+        {
+            if ((i & 3) == 0)
+                continue; // already loaded
+            const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + offsets[i]));
+            brighter[i] = avx2_brighter(value, center_plus_barrier);
+            darker[i] = avx2_darker(value, center_minus_barrier);
+        }
+
+        const __m256i is_not_corner = _mm256_and_si256(
+                                          _mm256_cmpeq_epi8(_mm256_max_epu8(avx2_longest_arc(brighter), eight), eight),
+                                          _mm256_cmpeq_epi8(_mm256_max_epu8(avx2_longest_arc(darker), eight), eight));
+        unsigned int corners_mask = ~static_cast<unsigned int>(_mm256_movemask_epi8(is_not_corner));
+
+        while (corners_mask != 0)
+        {
+            const int lane = __builtin_ctz(corners_mask);
+            corners_x[num_corners] = x + lane;
+            num_corners += 1;
+            corners_mask &= corners_mask - 1;
+        }
+    }
+
+    // the remaining pixels are processed 16 at a time, then one by one
+    return num_corners + sse2_segment_test_row(row_p, xsize, barrier, x, x_end, corners_x + num_corners);
+}
+
+#endif // FAST_SEGMENT_TEST_X86_KERNELS
+
+
+typedef int (*segment_test_row_function_t)(const uint8_t *row_p, const int xsize, const int barrier,
+        const int x_begin, const int x_end, int *corners_x);
+
+static segment_test_row_function_t select_segment_test_row_function()
+{
+#if defined(FAST_SEGMENT_TEST_X86_KERNELS)
+    if (cpu_has_avx2())
+        return avx2_segment_test_row;
+    if (cpu_has_sse2())
+        return sse2_segment_test_row;
+#endif
+    return segment_test_row_scalar;
+}
+
+int segment_test_row(const uint8_t *row_p, const int xsize, const int barrier, int *corners_x)
+{
+    // the cpu is queried only once
+    static const segment_test_row_function_t segment_test_row_function = select_segment_test_row_function();
+
+    // the SIMD versions use saturated 8 bits arithmetic, barriers outside [0, 255] are clamped for all versions
+    const int clamped_barrier = (barrier < 0) ? 0 : ((barrier > 255) ? 255 : barrier);
+    return segment_test_row_function(row_p, xsize, clamped_barrier, 3, xsize - 3, corners_x);
+}
+
+} // end of namespace fast
+} // end of namespace uniclop
@@ -0,0 +1,37 @@
+#if !defined(FAST_SEGMENT_TEST_HEADER_INCLUDED)
+#define FAST_SEGMENT_TEST_HEADER_INCLUDED
+
+// FAST-9 segment test kernels, used by fast::segment_test_corner_detect
+// this header is internal to the fast module
+
+#include <boost/cstdint.hpp>
+
+namespace uniclop
+{
+namespace fast
+{
+
+using boost::uint8_t;
+
+/** Exact FAST-9 segment test over one image row.
+
+    A pixel p is a corner if 9 contiguous pixels of the Bresenham circle of radius 3
+    are all brighter than p + barrier, or all darker than p - barrier.
+
+    Tests the pixels x in [3, xsize - 3) of the row starting at row_p
+    (the image is contiguous, with xsize pixels per row, and 3 rows are available above and below).
+    Writes the x coordinates of the corners found, in increasing order, and returns their number.
+    corners_x should have space for xsize values.
+
+    Uses SSE2 (16 pixels) or AVX2 (32 pixels) when available, the scalar version gives exactly the same corners.
+**/
+int segment_test_row(const uint8_t *row_p, const int xsize, const int barrier, int *corners_x);
+
+/// scalar reference of segment_test_row, used for the rows tails and on non x86 platforms
+int segment_test_row_scalar(const uint8_t *row_p, const int xsize, const int barrier,
+                            const int x_begin, const int x_end, int *corners_x);
+
+} // end of namespace fast
+} // end of namespace uniclop
+
+#endif // FAST_SEGMENT_TEST_HEADER_INCLUDED
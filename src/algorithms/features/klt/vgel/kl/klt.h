@@ -130,6 +130,17 @@ void KLTTrackFeatures(
   int ncols,
   int nrows,
   KLT_FeatureList fl);
+void KLTTrackFeaturesWithPyramids(
+  KLT_TrackingContext tc,
+  const unsigned char **levels1,
+  const int *strides1,
+  int nlevels1,
+  const unsigned char **levels2,
+  const int *strides2,
+  int nlevels2,
+  int ncols,
+  int nrows,
+  KLT_FeatureList fl);
 void KLTReplaceLostFeatures(
   KLT_TrackingContext tc,
   KLT_PixelType *img,
@@ -80,6 +80,38 @@ void _KLTFreePyramid(
 }
 
 
+/*********************************************************************
+ *
+ */
+
+void _KLTComputePyramidFromLevels(
+  const unsigned char **levels,
+  const int *strides,
+  int nlevels,
+  _KLT_Pyramid pyramid)
+{
+  int i, x, y;
+  const unsigned char *src;
+  float *dst;
+
+  if (pyramid->subsampling != 2)
+    KLTError("(_KLTComputePyramidFromLevels)  Pyramid's subsampling must "
+             "be 2 to use precomputed levels");
+  if (nlevels < pyramid->nLevels)
+    KLTError("(_KLTComputePyramidFromLevels)  Only %d precomputed levels, "
+             "%d are needed", nlevels, pyramid->nLevels);
+
+  for (i = 0 ; i < pyramid->nLevels ; i++)  {
+    dst = pyramid->img[i]->data;
+    for (y = 0 ; y < pyramid->nrows[i] ; y++)  {
+      src = levels[i] + y * strides[i];
+      for (x = 0 ; x < pyramid->ncols[i] ; x++)
+        *dst++ = (float) *src++;
+    }
+  }
+}
+
+
 /*********************************************************************
  *
  */
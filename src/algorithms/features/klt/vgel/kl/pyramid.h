@@ -29,4 +29,15 @@ void _KLTComputePyramid(
 void _KLTFreePyramid(
   _KLT_Pyramid pyramid);
 
+/* Fills the pyramid with 8 bits levels computed elsewhere (e.g. the */
+/* uniclop::ImagePyramid shared with the FAST detector), instead of */
+/* smoothing and subsampling the image again.  levels[i] must be */
+/* ncols[i] by nrows[i] pixels, with rows strides[i] bytes apart. */
+/* Dies when nlevels is lower than the pyramid's number of levels. */
+void _KLTComputePyramidFromLevels(
+  const unsigned char **levels,
+  const int *strides,
+  int nlevels,
+  _KLT_Pyramid pyramid);
+
 #endif
@@ -389,20 +389,29 @@ static KLT_BOOL _outOfBounds(
 
 
 /*********************************************************************
- * KLTTrackFeatures
+ * _trackFeatures
  *
  * Tracks feature points from one image to the next.
+ * When levels1 (or levels2) is not NULL, the image pyramid is built from
+ * these precomputed 8 bits levels instead of the image (see
+ * _KLTComputePyramidFromLevels).
  */
 
-void KLTTrackFeatures(
+static void _trackFeatures(
                       KLT_TrackingContext tc,
                       KLT_PixelType *img1,
                       KLT_PixelType *img2,
+                      const unsigned char **levels1,
+                      const int *strides1,
+                      int nlevels1,
+                      const unsigned char **levels2,
+                      const int *strides2,
+                      int nlevels2,
                       int ncols,
                       int nrows,
                       KLT_FeatureList featurelist)
 {
-  _KLT_FloatImage tmpimg, floatimg1=NULL, floatimg2;
+  _KLT_FloatImage tmpimg, floatimg1=NULL, floatimg2=NULL;
   _KLT_Pyramid pyramid1, pyramid1_gradx, pyramid1_grady,
     pyramid2, pyramid2_gradx, pyramid2_grady;
   int subsampling = tc->subsampling;
@@ -410,6 +419,7 @@ void KLTTrackFeatures(
   int val = 0;
   int indx, r;
   KLT_BOOL floatimg1_created = FALSE;
+  KLT_BOOL floatimg2_created = FALSE;
   int i;
 
   if (KLT_verbose >= 1)  {
@@ -455,6 +465,15 @@ void KLTTrackFeatures(
                ncols, nrows, pyramid1->ncols[0], pyramid1->nrows[0]);
     assert(pyramid1_gradx != NULL);
     assert(pyramid1_grady != NULL);
+  } else if (levels1 != NULL)  {
+    pyramid1 = _KLTCreatePyramid(ncols, nrows, subsampling, tc->nPyramidLevels);
+    _KLTComputePyramidFromLevels(levels1, strides1, nlevels1, pyramid1);
+    pyramid1_gradx = _KLTCreatePyramid(ncols, nrows, subsampling, tc->nPyramidLevels);
+    pyramid1_grady = _KLTCreatePyramid(ncols, nrows, subsampling, tc->nPyramidLevels);
+    for (i = 0 ; i < tc->nPyramidLevels ; i++)
+      _KLTComputeGradients(pyramid1->img[i], tc->grad_sigma,
+                           pyramid1_gradx->img[i],
+                           pyramid1_grady->img[i]);
   } else  {
     floatimg1_created = TRUE;
     floatimg1 = _KLTCreateFloatImage(ncols, nrows);
@@ -471,11 +490,16 @@ void KLTTrackFeatures(
   }
 
   /* Do the same thing with second image */
-  floatimg2 = _KLTCreateFloatImage(ncols, nrows);
-  _KLTToFloatImage(img2, ncols, nrows, tmpimg);
-  _KLTComputeSmoothedImage(tmpimg, _KLTComputeSmoothSigma(tc), floatimg2);
   pyramid2 = _KLTCreatePyramid(ncols, nrows, subsampling, tc->nPyramidLevels);
-  _KLTComputePyramid(floatimg2, pyramid2, tc->pyramid_sigma_fact);
+  if (levels2 != NULL)  {
+    _KLTComputePyramidFromLevels(levels2, strides2, nlevels2, pyramid2);
+  } else  {
+    floatimg2_created = TRUE;
+    floatimg2 = _KLTCreateFloatImage(ncols, nrows);
+    _KLTToFloatImage(img2, ncols, nrows, tmpimg);
+    _KLTComputeSmoothedImage(tmpimg, _KLTComputeSmoothSigma(tc), floatimg2);
+    _KLTComputePyramid(floatimg2, pyramid2, tc->pyramid_sigma_fact);
+  }
   pyramid2_gradx = _KLTCreatePyramid(ncols, nrows, subsampling, tc->nPyramidLevels);
   pyramid2_grady = _KLTCreatePyramid(ncols, nrows, subsampling, tc->nPyramidLevels);
   for (i = 0 ; i < tc->nPyramidLevels ; i++)
@@ -586,7 +610,7 @@ void KLTTrackFeatures(
   /* Free memory */
   _KLTFreeFloatImage(tmpimg);
   if (floatimg1_created)  _KLTFreeFloatImage(floatimg1);
-  _KLTFreeFloatImage(floatimg2);
+  if (floatimg2_created)  _KLTFreeFloatImage(floatimg2);
   _KLTFreePyramid(pyramid1);
   _KLTFreePyramid(pyramid1_gradx);
   _KLTFreePyramid(pyramid1_grady);
@@ -599,3 +623,51 @@ void KLTTrackFeatures(
     fflush(stderr);
   }
 }
+
+
+/*********************************************************************
+ * KLTTrackFeatures
+ *
+ * Tracks feature points from one image to the next.
+ */
+
+void KLTTrackFeatures(
+  KLT_TrackingContext tc,
+  KLT_PixelType *img1,
+  KLT_PixelType *img2,
+  int ncols,
+  int nrows,
+  KLT_FeatureList featurelist)
+{
+  _trackFeatures(tc, img1, img2, NULL, NULL, 0, NULL, NULL, 0,
+                 ncols, nrows, featurelist);
+}
+
+
+/*********************************************************************
+ * KLTTrackFeaturesWithPyramids
+ *
+ * Same as KLTTrackFeatures, but using image pyramids computed elsewhere
+ * (e.g. by uniclop::ImagePyramid, that the FAST detector also uses).
+ * levels1 and levels2 hold nlevels1 and nlevels2 8 bits images, each level
+ * being half the size of the previous one (tc->subsampling must be 2), with
+ * rows strides1[i] (strides2[i]) bytes apart.  At least tc->nPyramidLevels
+ * levels are needed.  The levels are used as they are, no extra smoothing
+ * is applied.
+ */
+
+void KLTTrackFeaturesWithPyramids(
+  KLT_TrackingContext tc,
+  const unsigned char **levels1,
+  const int *strides1,
+  int nlevels1,
+  const unsigned char **levels2,
+  const int *strides2,
+  int nlevels2,
+  int ncols,
+  int nrows,
+  KLT_FeatureList featurelist)
+{
+  _trackFeatures(tc, NULL, NULL, levels1, strides1, nlevels1,
+                 levels2, strides2, nlevels2, ncols, nrows, featurelist);
+}
@@ -3,6 +3,7 @@
 #include <vector>
 
 #include "ipoint.h"
+#include "../SpatialGridIndex.hpp"
 
 //! Populate IpPairVec with matched ipts
 void getMatches(IpVec &ipts1, IpVec &ipts2, IpPairVec &matches)
@@ -43,6 +44,61 @@ void getMatches(IpVec &ipts1, IpVec &ipts2, IpPairVec &matches)
     }
 }
 
+//! Populate IpPairVec with matched ipts, searching only inside a window around each ipoint
+void getMatches(IpVec &ipts1, IpVec &ipts2, IpPairVec &matches,
+                uniclop::SpatialGridIndex &ipts2_grid, std::vector<int> &window, float search_radius)
+{
+    float dist, d1, d2;
+    Ipoint *match;
+
+    matches.clear();
+    ipts2_grid.build(ipts2); // O(N), positions truncated to int
+
+    for (unsigned int i = 0; i < ipts1.size(); i++)
+    {
+        d1 = d2 = FLT_MAX;
+        match = NULL;
+
+        // the grid works on truncated positions, so the query is slightly enlarged
+        // and the exact window is checked below
+        ipts2_grid.rectangle_query((int) floor(ipts1[i].x - search_radius),
+                                   (int) floor(ipts1[i].y - search_radius),
+                                   (int) ceil(ipts1[i].x + search_radius),
+                                   (int) ceil(ipts1[i].y + search_radius),
+                                   window);
+
+        for (unsigned int k = 0; k < window.size(); k++)
+        {
+            Ipoint &candidate = ipts2[window[k]];
+            if (fabs(candidate.x - ipts1[i].x) > search_radius ||
+                fabs(candidate.y - ipts1[i].y) > search_radius)
+                continue;
+
+            dist = ipts1[i] - candidate;
+
+            if (dist<d1) // if this feature matches better than current best
+            {
+                d2 = d1;
+                d1 = dist;
+                match = &candidate;
+            }
+            else if (dist<d2) // this feature matches better than second best
+            {
+                d2 = dist;
+            }
+        }
+
+        // If match has a d1:d2 ratio < 0.65 ipoints are a match
+        if (match != NULL && d1/d2 < 0.65)
+        {
+            // Store the change in position
+            ipts1[i].dx = match->x - ipts1[i].x;
+            ipts1[i].dy = match->y - ipts1[i].y;
+            matches.push_back(std::make_pair(ipts1[i], *match));
+        }
+    }
+}
+
 //
 // This function uses homography with CV_RANSAC (OpenCV 1.1)
 // Won't compile on most linux distributions
@@ -20,10 +20,22 @@ class Ipoint; // Pre-declaration
 typedef std::vector<Ipoint> IpVec;
 typedef std::vector<std::pair<Ipoint, Ipoint> > IpPairVec;
 
+namespace uniclop
+{
+class SpatialGridIndex; // Pre-declaration
+}
+
 //-------------------------------------------------------
 
 //! Ipoint operations
 void getMatches(IpVec &ipts1, IpVec &ipts2, IpPairVec &matches);
+
+//! Same as getMatches, but only compares the ipoints of ipts2 whose x and y
+//! differ by at most search_radius pixels. ipts2_grid is rebuilt over ipts2 and
+//! window receives the indexes of each query, keeping both between frames
+//! avoids reallocating their memory
+void getMatches(IpVec &ipts1, IpVec &ipts2, IpPairVec &matches,
+                uniclop::SpatialGridIndex &ipts2_grid, std::vector<int> &window, float search_radius);
 int translateCorners(IpPairVec &matches, const CvPoint src_corners[4], CvPoint dst_corners[4]);
 
 //-------------------------------------------------------
@@ -0,0 +1,71 @@
+
+#if !defined(IHYPOTHESIS_VERIFIER_HEADER_INCLUDED)
+#define IHYPOTHESIS_VERIFIER_HEADER_INCLUDED
+
+// IHypothesisVerifier
+
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Headers
+
+// C++ standard
+#include <vector>
+
+// Boost http://boost.org
+#include <boost/random.hpp>
+
+
+namespace uniclop
+{
+
+using namespace std;
+
+class ScoredMatch;
+class IParametricModel;
+
+// Interfaces definition
+class IHypothesisVerifier
+{ // decides if a model hypothesis is worth being evaluated on all the data points,
+  // used by the estimators to reject the bad hypotheses after computing only a few residuals
+
+public:
+
+    virtual int verify(const IParametricModel &model, const int num_hypotheses, const vector< ScoredMatch > &data_points,
+                       const int min_num_inliers, boost::mt19937 &random_generator, int &num_inliers) = 0;
+    // the model holds num_hypotheses hypotheses (see IParametricModel::estimate_hypotheses_from_minimal_set),
+    // they are verified together, in one pass over the data points.
+    // Returns -1 as soon as all of them are known to be bad, or to have less than min_num_inliers inliers.
+    // Otherwise returns the index of the hypothesis with the most inliers, num_inliers is then
+    // its support over all the data points
+
+    virtual void set_inliers_fraction(const double inliers_fraction) = 0;
+    // inliers fraction of the best model found so far (epsilon)
+
+    virtual double get_acceptance_probability() const = 0;
+    // probability of a good model passing the verification,
+    // the estimators use it to correct their number of iterations
+
+    virtual long get_num_residuals_evaluated() const = 0;
+    // number of residuals computed since the last reset
+
+    virtual void reset_num_residuals_evaluated() = 0;
+
+    virtual IHypothesisVerifier *clone() const = 0;
+    // returns a new copy of the verifier, the caller is in charge of deleting it
+
+
+    IHypothesisVerifier()
+    {
+        return;
+    }
+    virtual ~IHypothesisVerifier()
+    {
+        return;
+    }
+};
+
+}
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+
+#endif // #if !defined(IHYPOTHESIS_VERIFIER_HEADER_INCLUDED)
@@ -11,6 +11,7 @@
 
 // C++ standard
 #include <vector>
+#include <stdexcept>
 
 // Boost http://boost.org
 #include <boost/numeric/ublas/vector.hpp>
@@ -52,6 +53,58 @@ public:
     // residuals -> errors
     // Compute the residuals relative to the given parameter vector.
 
+    virtual float compute_residual(const ScoredMatch &data_point) const = 0;
+    // residual of a single data point, allows the estimators to stop evaluating a model early
+    // (compute_residuals gives the same values, for all the data points)
+
+    virtual IParametricModel *clone() const = 0;
+    // returns a new copy of the model, the caller is in charge of deleting it
+    // (used to give each estimation thread its own model)
+
+
+    // The minimal solvers of polynomial systems give several models per sample
+    // (e.g. up to 10 for the 5 points essential matrix). The estimators score all of them
+    // before drawing the next sample. The models with a single solution keep the default implementations
+
+    virtual unsigned int get_max_num_hypotheses() const
+    { // maximum number of models given by estimate_hypotheses_from_minimal_set
+        return 1;
+    }
+
+    virtual int estimate_hypotheses_from_minimal_set(const vector< ScoredMatch > &data_points)
+    { // given m points estimate all the models that fit them, returns their number.
+      // The hypotheses are kept until the next estimation or set_parameters call
+        estimate_from_minimal_set(data_points);
+        return 1;
+    }
+
+    virtual void select_hypothesis(const int index)
+    { // sets the parameters to one of the hypotheses
+        if (index != 0)
+            throw std::runtime_error("IParametricModel::select_hypothesis index out of range");
+        return;
+    }
+
+    virtual void compute_hypotheses_residual(const ScoredMatch &data_point, float residuals[]) const
+    { // residual of the data point for each hypothesis, the data point is read once for all of them
+        residuals[0] = compute_residual(data_point);
+        return;
+    }
+
+
+    // Some models have minimal sets that are degenerate without being singular
+    // (e.g. a fundamental matrix sample with five or more points on a plane): the model fits
+    // the dominant structure and a few random matches, and its support is misleading.
+    // The estimators call this method on each new best model, with the minimal set it came from
+
+    virtual bool correct_degenerate_sample(const vector< ScoredMatch > &/*minimal_set*/,
+                                           const vector< ScoredMatch > &/*data_points*/,
+                                           const float /*inlier_threshold*/, int &/*num_inliers*/)
+    { // when the minimal set is degenerate and a better model is found from the rest of the data,
+      // sets the parameters to it, updates num_inliers and returns true
+        return false;
+    }
+
 
     IParametricModel()
     {
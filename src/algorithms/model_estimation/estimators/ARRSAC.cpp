@@ -1,12 +1,19 @@
-
 #include "ARRSAC.hpp"
+#include "SPRTVerifier.hpp"
 
 #include "algorithms/features/ScoredMatch.hpp"
 #include "algorithms/features/fast/FASTFeature.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <iostream>
+
 namespace uniclop
 {
 
+namespace posix_time = boost::posix_time;
 
 // ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
 // Class ARRSAC methods implementation
@@ -17,17 +24,110 @@ args::options_description ARRSAC::get_options_description()
     args::options_description desc("ARRSAC options");
     desc.add_options()
 
-    /* ( "blur_sigma,b", args::value<double>()->default_value(1.0f),
-       "defines a bluring level for images") */
+    ( "arrsac.inlier_threshold", args::value<float>()->default_value(1.0f),
+      "maximum residual for a match to be considered an inlier")
+
+    ( "arrsac.confidence", args::value<float>()->default_value(0.99f),
+      "confidence used to adapt the number of hypotheses to the estimated inliers fraction")
+
+    ( "arrsac.max_hypotheses", args::value<int>()->default_value(500),
+      "maximum size of the hypotheses set")
+
+    ( "arrsac.block_size", args::value<int>()->default_value(100),
+      "number of matches evaluated between two preemption steps")
+
+    ( "arrsac.inner_samples", args::value<int>()->default_value(10),
+      "number of samples drawn from the inliers of each new best hypothesis")
+
+    ( "arrsac.max_ms", args::value<float>()->default_value(30.0f),
+      "time budget per estimation in milliseconds, the best model found so far is returned "
+      "when it runs out (0 means no limit)")
+
+    ( "arrsac.model_cost", args::value<float>()->default_value(200.0f),
+      "time needed to estimate a model, relative to the time needed to evaluate one match")
+
+    ( "arrsac.epsilon", args::value<float>()->default_value(0.1f),
+      "initial guess of the probability of a match being consistent with a good model")
+
+    ( "arrsac.delta", args::value<float>()->default_value(0.05f),
+      "initial guess of the probability of a match being consistent with a bad model")
+
+    ( "arrsac.trace_level", args::value<int>()->default_value(0),
+      "debugging verbosity")
     ;
 
     return desc;
 }
 
 
-ARRSAC::ARRSAC(args::variables_map &options, IParametricModel &)
+ARRSAC::ARRSAC(args::variables_map &options, IParametricModel &_model)
+        : model(_model)
 {
-    throw runtime_error("ARRSAC model estimation is not yet implemented");
+
+    inlier_threshold = 1.0f;
+    confidence = 0.99f;
+    max_hypotheses = 500;
+    block_size = 100;
+    inner_samples = 10;
+    max_ms = 30.0f;
+    model_cost = 200.0f;
+    initial_epsilon = 0.1f;
+    initial_delta = 0.05f;
+    trace_level = 0;
+
+    if (options.count("arrsac.inlier_threshold"))
+        inlier_threshold = options["arrsac.inlier_threshold"].as<float>();
+
+    if (options.count("arrsac.confidence"))
+        confidence = options["arrsac.confidence"].as<float>();
+
+    if (options.count("arrsac.max_hypotheses"))
+        max_hypotheses = options["arrsac.max_hypotheses"].as<int>();
+
+    if (options.count("arrsac.block_size"))
+        block_size = options["arrsac.block_size"].as<int>();
+
+    if (options.count("arrsac.inner_samples"))
+        inner_samples = options["arrsac.inner_samples"].as<int>();
+
+    if (options.count("arrsac.max_ms"))
+        max_ms = options["arrsac.max_ms"].as<float>();
+
+    if (options.count("arrsac.model_cost"))
+        model_cost = options["arrsac.model_cost"].as<float>();
+
+    if (options.count("arrsac.epsilon"))
+        initial_epsilon = options["arrsac.epsilon"].as<float>();
+
+    if (options.count("arrsac.delta"))
+        initial_delta = options["arrsac.delta"].as<float>();
+
+    if (options.count("arrsac.trace_level"))
+        trace_level = options["arrsac.trace_level"].as<int>();
+
+    if (confidence <= 0 || confidence >= 1)
+        throw runtime_error("ARRSAC expects arrsac.confidence to be in the range (0, 1)");
+
+    if (initial_delta <= 0 || initial_epsilon <= initial_delta || initial_epsilon >= 1)
+        throw runtime_error("ARRSAC expects 0 < arrsac.delta < arrsac.epsilon < 1");
+
+    if (max_hypotheses < 1 || block_size < 1)
+        throw runtime_error("ARRSAC expects arrsac.max_hypotheses and arrsac.block_size to be strictly positive");
+
+    epsilon = initial_epsilon;
+    delta = initial_delta;
+    update_sprt_threshold();
+
+    num_hypotheses_tested = 0;
+    num_residuals_evaluated = 0;
+    num_alive = 0;
+
+    // the hypotheses set is allocated once, each sample may give several hypotheses
+    const int max_set_size = max_hypotheses * static_cast<int>(model.get_max_num_hypotheses());
+    hypotheses.resize(max_set_size);
+    alive.resize(max_set_size);
+
+    local_optimization_p.reset(new LocalOptimization(options, inlier_threshold));
     return;
 }
 
@@ -36,17 +136,424 @@ ARRSAC::~ARRSAC()
     return;
 }
 
-const ublas::vector<float> &ARRSAC::estimate_model_parameters(const vector< ScoredMatch > &)
+
+void ARRSAC::update_sprt_threshold()
 {
-    return estimated_model_parameters;
+    // when delta >= epsilon the test can not discriminate the good models, and SPRT is disabled
+    sprt_threshold = SPRTVerifier::compute_decision_threshold(epsilon, delta, model_cost);
+    return;
+}
+
+
+bool ARRSAC::is_out_of_time() const
+{
+    if (max_ms <= 0)
+        return false;
+
+    const posix_time::time_duration elapsed = posix_time::microsec_clock::universal_time() - start_time;
+    return elapsed.total_microseconds() > 1000 * max_ms;
+}
+
+
+void ARRSAC::shuffle_matches(const vector< ScoredMatch > &matches)
+{
+    const int num_matches = static_cast<int>(matches.size());
+
+    // random order of evaluation, so that each block is a random subset of the data
+    shuffled_indices.resize(num_matches);
+    int i;
+    for (i=0; i < num_matches; i+=1)
+        shuffled_indices[i] = i;
+
+    for (i = num_matches - 1; i > 0; i-=1)
+    {
+        boost::uniform_int<int> uniform_index(0, i);
+        swap(shuffled_indices[i], shuffled_indices[uniform_index(random_generator)]);
+    }
+
+    shuffled_matches.resize(num_matches);
+    for (i=0; i < num_matches; i+=1)
+        shuffled_matches[i] = matches[shuffled_indices[i]];
+
+    const int num_blocks = (num_matches + block_size - 1) / block_size;
+    blocks.resize(num_blocks);
+    int b;
+    for (b=0; b < num_blocks; b+=1)
+    {
+        const int begin = b * block_size;
+        const int end = min(begin + block_size, num_matches);
+        blocks[b].assign(shuffled_matches.begin() + begin, shuffled_matches.begin() + end);
+    }
+
+    return;
+}
+
+
+void ARRSAC::draw_sample(const vector< ScoredMatch > &data)
+{
+    const int m = model.get_num_points_to_estimate();
+    boost::uniform_int<int> uniform_index(0, static_cast<int>(data.size()) - 1);
+
+    minimal_set.resize(m);
+
+    // m is small, checking the previously selected indices is cheap
+    int selected_indices[16];
+    if (m > 16)
+        throw runtime_error("ARRSAC::draw_sample only supports models with up to 16 points per sample");
+
+    int i = 0;
+    while (i < m)
+    {
+        const int index = uniform_index(random_generator);
+        bool already_selected = false;
+        int j;
+        for (j=0; j < i; j+=1)
+            already_selected = already_selected || (selected_indices[j] == index);
+
+        if (already_selected) continue;
+
+        selected_indices[i] = index;
+        minimal_set[i] = data[index];
+        i += 1;
+    }
+
+    return;
+}
+
+
+void ARRSAC::compute_block_residuals(const int block_index, const int num_hypotheses)
+{
+    const vector< ScoredMatch > &block = blocks[block_index];
+
+    if (num_hypotheses == 1)
+    { // the model is expected to hold the hypothesis parameters
+        model.compute_residuals(block, residuals);
+        return;
+    }
+
+    const int block_length = static_cast<int>(block.size());
+    residuals.resize(block_length * num_hypotheses);
+    int i;
+    for (i=0; i < block_length; i+=1)
+        model.compute_hypotheses_residual(block[i], &residuals[num_hypotheses * i]);
+
+    return;
+}
+
+
+bool ARRSAC::evaluate(Hypothesis &hypothesis, const int hypothesis_index, const int num_hypotheses)
+{
+    const double inlier_factor = delta / epsilon;
+    const double outlier_factor = (1 - delta) / (1 - epsilon);
+
+    const int num_residuals = static_cast<int>(residuals.size());
+    int i;
+    for (i = hypothesis_index; i < num_residuals; i+=num_hypotheses)
+    {
+        if (residuals[i] < inlier_threshold)
+        {
+            hypothesis.num_inliers += 1;
+            hypothesis.likelihood_ratio *= inlier_factor;
+        }
+        else
+        {
+            hypothesis.likelihood_ratio *= outlier_factor;
+        }
+        hypothesis.num_evaluated += 1;
+        num_residuals_evaluated += 1;
+
+        if (hypothesis.likelihood_ratio > sprt_threshold)
+            return false; // the model is rejected as bad
+    }
+
+    return true;
 }
 
+
+// helper functor, orders the hypotheses by inliers fraction, best first
+class HypothesesOrder
+{
+    const vector< ARRSAC::Hypothesis > &hypotheses;
+public:
+    HypothesesOrder(const vector< ARRSAC::Hypothesis > &_hypotheses)
+            : hypotheses(_hypotheses)
+    {
+        return;
+    }
+
+    bool operator()(const int a, const int b) const
+    {
+        const ARRSAC::Hypothesis &ha = hypotheses[a], &hb = hypotheses[b];
+        const long score_a = static_cast<long>(ha.num_inliers) * hb.num_evaluated;
+        const long score_b = static_cast<long>(hb.num_inliers) * ha.num_evaluated;
+        if (score_a != score_b)
+            return score_a > score_b;
+        return ha.num_inliers > hb.num_inliers;
+    }
+};
+
+
+int ARRSAC::generate_hypotheses()
+{
+    const int m = model.get_num_points_to_estimate();
+    const double log_eta = log(1.0 - confidence);
+
+    int hypotheses_set_size = max_hypotheses; // M, adapted as epsilon gets estimated
+    int best_num_inliers = -1;
+    int inner_samples_left = 0;
+    long rejected_inliers = 0, rejected_evaluated = 0;
+
+    best_inliers.clear();
+    best_rejected.num_evaluated = 0;
+
+    while (num_hypotheses_tested < hypotheses_set_size)
+    {
+        if (num_hypotheses_tested > 0 && is_out_of_time())
+            break;
+
+        num_hypotheses_tested += 1;
+
+        // the inliers of the best hypothesis are sampled first (inner RANSAC)
+        if (inner_samples_left > 0 && static_cast<int>(best_inliers.size()) > m)
+        {
+            draw_sample(best_inliers);
+            inner_samples_left -= 1;
+        }
+        else
+            draw_sample(shuffled_matches);
+
+        int num_sample_hypotheses = 0;
+        try
+        {
+            num_sample_hypotheses = model.estimate_hypotheses_from_minimal_set(minimal_set);
+        }
+        catch (runtime_error &)
+        {
+            continue; // degenerate sample
+        }
+
+        // the first block is read once for all the hypotheses of the sample
+        if (num_sample_hypotheses > 0)
+            compute_block_residuals(0, num_sample_hypotheses);
+
+        int h;
+        for (h=0; h < num_sample_hypotheses; h+=1)
+        {
+            model.select_hypothesis(h);
+            Hypothesis &hypothesis = hypotheses[alive[num_alive] = num_alive];
+            hypothesis.parameters = model.get_parameters();
+            hypothesis.num_inliers = 0;
+            hypothesis.num_evaluated = 0;
+            hypothesis.likelihood_ratio = 1;
+
+            if (evaluate(hypothesis, h, num_sample_hypotheses) == false)
+            {
+                // delta is the average inliers fraction of the rejected models
+                rejected_inliers += hypothesis.num_inliers;
+                rejected_evaluated += hypothesis.num_evaluated;
+                delta = max(1e-3, static_cast<double>(rejected_inliers) / rejected_evaluated);
+                update_sprt_threshold();
+
+                if (num_alive == 0 &&
+                        (best_rejected.num_evaluated == 0 ||
+                         static_cast<long>(hypothesis.num_inliers) * best_rejected.num_evaluated >
+                         static_cast<long>(best_rejected.num_inliers) * hypothesis.num_evaluated))
+                {
+                    best_rejected = hypothesis;
+                }
+                continue;
+            }
+
+            if (hypothesis.num_inliers > best_num_inliers)
+            { // a new best hypothesis, update the estimate of epsilon
+                const bool is_corrected =
+                    model.correct_degenerate_sample(minimal_set, blocks[0], inlier_threshold, hypothesis.num_inliers);
+                if (is_corrected)
+                { // the plane and parallax model replaces the hypothesis, scored on the same block
+                    hypothesis.parameters = model.get_parameters();
+                    num_residuals_evaluated += blocks[0].size();
+                }
+
+                best_num_inliers = hypothesis.num_inliers;
+                epsilon = min(0.99, max(static_cast<double>(best_num_inliers) / hypothesis.num_evaluated,
+                                        static_cast<double>(initial_epsilon)));
+                update_sprt_threshold();
+
+                const double probability_all_inliers = pow(epsilon, m);
+                if (probability_all_inliers > 0 && probability_all_inliers < 1)
+                {
+                    const double needed = ceil(log_eta / log(1.0 - probability_all_inliers));
+                    hypotheses_set_size = static_cast<int>(min(needed, static_cast<double>(max_hypotheses)));
+                }
+
+                best_inliers.clear();
+                unsigned int i;
+                for (i=0; i < blocks[0].size(); i+=1)
+                {
+                    const float residual = is_corrected ?
+                                           model.compute_residual(blocks[0][i]) : residuals[num_sample_hypotheses * i + h];
+                    if (residual < inlier_threshold)
+                        best_inliers.push_back(blocks[0][i]);
+                }
+                inner_samples_left = inner_samples;
+            }
+
+            num_alive += 1;
+        }
+    }
+
+    return max(hypotheses_set_size, num_alive);
+}
+
+
+void ARRSAC::preemptive_evaluation(const int hypotheses_set_size)
+{
+    const int num_blocks = static_cast<int>(blocks.size());
+
+    int b;
+    for (b=1; b < num_blocks && num_alive > 1; b+=1)
+    {
+        // preemption function f(i) = floor(M * 2^-floor(i/B))
+        const int num_to_keep = max(1, hypotheses_set_size >> min(b, 30));
+        if (num_alive > num_to_keep)
+        {
+            nth_element(alive.begin(), alive.begin() + num_to_keep, alive.begin() + num_alive,
+                        HypothesesOrder(hypotheses));
+            num_alive = num_to_keep;
+        }
+
+        int i = 0;
+        while (i < num_alive)
+        {
+            if (is_out_of_time())
+                return;
+
+            Hypothesis &hypothesis = hypotheses[alive[i]];
+            model.set_parameters(hypothesis.parameters);
+            compute_block_residuals(b, 1);
+            if (evaluate(hypothesis, 0, 1) == false && num_alive > 1)
+            {
+                alive[i] = alive[num_alive - 1];
+                num_alive -= 1;
+                continue;
+            }
+            i += 1;
+        }
+    }
+
+    return;
+}
+
+
+int ARRSAC::select_best_hypothesis() const
+{
+    if (num_alive == 0)
+        return -1;
+
+    // when the time budget runs out in the middle of a block
+    // the hypotheses were not all evaluated on the same matches, so the inliers fraction is used
+    const HypothesesOrder order(hypotheses);
+    int best_index = alive[0];
+    int i;
+    for (i=1; i < num_alive; i+=1)
+    {
+        if (order(alive[i], best_index))
+            best_index = alive[i];
+    }
+
+    return best_index;
+}
+
+
+const ublas::vector<float> &ARRSAC::estimate_model_parameters(const vector< ScoredMatch > &matches)
+{
+    start_time = posix_time::microsec_clock::universal_time();
+
+    const int m = model.get_num_points_to_estimate();
+    const int num_matches = static_cast<int>(matches.size());
+
+    if (num_matches < m)
+        throw runtime_error("ARRSAC::estimate_model_parameters received not enough input data");
+
+    if (have_features(matches) == false)
+        throw runtime_error("ARRSAC::estimate_model_parameters requires matches with feature pointers, not only indexes");
+
+    num_hypotheses_tested = 0;
+    num_residuals_evaluated = 0;
+    num_alive = 0;
+    local_optimization_p->reset();
+
+    // epsilon is re-estimated on each frame, delta is kept from the previous frames
+    epsilon = initial_epsilon;
+    delta = min(delta, 0.5 * epsilon);
+    update_sprt_threshold();
+
+    shuffle_matches(matches);
+
+    const int hypotheses_set_size = generate_hypotheses();
+    preemptive_evaluation(hypotheses_set_size);
+
+    const int best_index = select_best_hypothesis();
+
+    // retrieve the estimated parameters and the inliers --
+    is_inlier.resize(num_matches);
+    if (best_index < 0 && best_rejected.num_evaluated == 0)
+    {
+        if (trace_level > 0)
+            cout << "ARRSAC::estimate_model_parameters did not find any valid model" << endl;
+        fill(is_inlier.begin(), is_inlier.end(), false);
+        estimated_model_parameters.resize(model.get_num_parameters());
+        fill(estimated_model_parameters.begin(), estimated_model_parameters.end(), 0.0f);
+        return estimated_model_parameters;
+    }
+
+    if (best_index >= 0)
+        estimated_model_parameters = hypotheses[best_index].parameters;
+    else
+        estimated_model_parameters = best_rejected.parameters;
+
+    model.set_parameters(estimated_model_parameters);
+    model.compute_residuals(matches, residuals);
+    int i, num_inliers = 0;
+    for (i=0; i < num_matches; i+=1)
+        num_inliers += (residuals[i] < inlier_threshold) ? 1 : 0;
+
+    // the hypotheses were only scored on blocks of the data,
+    // so the local optimization is run once, on all the matches, for the selected hypothesis
+    if (is_out_of_time() == false && local_optimization_p->optimize(model, matches, num_inliers))
+    {
+        estimated_model_parameters = model.get_parameters();
+        model.compute_residuals(matches, residuals);
+    }
+
+    if (local_optimization_p->uses_graph_cut())
+        local_optimization_p->label_inliers(model, matches, is_inlier); // spatially coherent inliers
+    else
+    {
+        for (i=0; i < num_matches; i+=1)
+            is_inlier[i] = (residuals[i] < inlier_threshold);
+    }
+    num_residuals_evaluated += local_optimization_p->get_num_residuals_evaluated();
+
+    return estimated_model_parameters;
+
+} // end of 'ARRSAC::estimate_model_parameters'
+
+
 const vector< bool > &  ARRSAC::get_is_inlier()
 {
     return is_inlier;
 }
 
-
+int ARRSAC::get_num_hypotheses_tested() const
+{
+    return num_hypotheses_tested;
+}
+
+long ARRSAC::get_num_residuals_evaluated() const
+{
+    return num_residuals_evaluated;
+}
 
 
-}
\ No newline at end of file
+}
@@ -12,8 +12,12 @@ provides 50x faster results than RANSAC and about 2x~3x faster results than PROS
 
 #include "../IModelEstimator.hpp"
 #include "../IParametricModel.hpp"
+#include "LocalOptimization.hpp"
 
+#include <boost/random.hpp>
 #include <boost/program_options.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/scoped_ptr.hpp>
 
 
 namespace uniclop
@@ -27,6 +31,53 @@ class ARRSAC: public IModelEstimator
 
     ublas::vector<float> estimated_model_parameters;
     vector<bool> is_inlier;
+
+    IParametricModel &model;
+
+    // arrsac algorithm parameters
+    float inlier_threshold; ///< maximum residual of an inlier, in the model residuals units
+    float confidence; ///< used to adapt the size of the hypotheses set to the inliers fraction
+    int max_hypotheses; ///< M, maximum size of the hypotheses set
+    int block_size; ///< B, number of matches evaluated between two preemption steps
+    int inner_samples; ///< number of samples drawn from the inliers of each new best hypothesis
+    float max_ms; ///< wall-clock budget per call, in milliseconds (0 means no limit)
+    float model_cost; ///< cost of one model estimation, relative to one residual evaluation
+    int trace_level;
+
+    // SPRT state
+    float initial_epsilon, initial_delta;
+    double epsilon; ///< probability that a match is consistent with a good model
+    double delta; ///< probability that a match is consistent with a bad model
+    double sprt_threshold; ///< A, the decision threshold
+
+    int num_hypotheses_tested;
+    long num_residuals_evaluated;
+
+    boost::mt19937 random_generator; // pseudo-random number generators
+    boost::posix_time::ptime start_time;
+
+    boost::scoped_ptr<LocalOptimization> local_optimization_p; ///< run on the selected hypothesis
+
+    class Hypothesis
+    {
+    public:
+        ublas::vector<float> parameters;
+        int num_inliers, num_evaluated;
+        double likelihood_ratio; ///< SPRT lambda
+    };
+
+    // internal buffers, reused between calls
+    vector< ScoredMatch > shuffled_matches, minimal_set, best_inliers;
+    vector<int> shuffled_indices;
+    vector< vector< ScoredMatch > > blocks;
+    vector<float> residuals; ///< residuals of one block, interleaved per match when a sample gives several hypotheses
+    vector< Hypothesis > hypotheses;
+    vector<int> alive; ///< indices of the hypotheses not yet discarded, the first num_alive are valid
+    int num_alive;
+    Hypothesis best_rejected; ///< returned when all the hypotheses were rejected by the SPRT
+
+    friend class HypothesesOrder;
+
 public:
 
     static args::options_description get_options_description();
@@ -38,6 +89,36 @@ public:
     const ublas::vector<float> &estimate_model_parameters(const vector< ScoredMatch > &);
 
     const vector< bool > & get_is_inlier();
+
+    int get_num_hypotheses_tested() const;
+    ///< number of hypotheses generated by the last call to estimate_model_parameters
+
+    long get_num_residuals_evaluated() const;
+    ///< number of residuals computed to verify the hypotheses in the last call to estimate_model_parameters
+
+private:
+
+    void shuffle_matches(const vector< ScoredMatch > &matches);
+
+    void draw_sample(const vector< ScoredMatch > &data);
+
+    void compute_block_residuals(const int block_index, const int num_hypotheses);
+    ///< residuals of the model hypotheses on one block, each match is read once for all of them
+
+    bool evaluate(Hypothesis &hypothesis, const int hypothesis_index, const int num_hypotheses);
+    ///< scores the hypothesis on the block residuals, returns false when the SPRT rejects it
+
+    void update_sprt_threshold();
+
+    bool is_out_of_time() const;
+
+    int generate_hypotheses();
+    ///< competitive evaluation of new hypotheses on the first block,
+    ///< returns the size of the hypotheses set
+
+    void preemptive_evaluation(const int hypotheses_set_size);
+
+    int select_best_hypothesis() const;
 };
 
 }
@@ -8,6 +8,14 @@
 
 #include "OneDimensionalKMeans.hpp"
 
+#include "helpers/ThreadPool.hpp"
+
+#include <boost/bind.hpp>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 // Boost http://boost.org
 #include <boost/numeric/ublas/io.hpp>
 #include <boost/tuple/tuple.hpp>
@@ -46,225 +54,180 @@ using namespace cimg_library;
 
 
 // ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
-// Helper classes KurtosisIncrementalEstimator and HistogramKurtosis
-template<typename T = double> // T: double or float
-class KurtosisIncrementalEstimator
-{
-    // based on information available at
-    // http://en.wikipedia.org/wiki/Kurtosis
-    // http://en.wikipedia.org/wiki/Moment_about_the_mean
-    // http://mathcentral.uregina.ca/QQ/database/QQ.09.02/carlos1.html
+// Class KurtosisAccumulators methods implementation
 
-    T min_value, max_value;
-
-    int n;
-    long double mean, central_moment2, central_moment4;
-    // kurtosis computation is numerically unstable
-    // so we would like to use the largest representation available
-    // central_moment2 is also knowns as variance
+KurtosisAccumulators::KurtosisAccumulators()
+{
+    num_points = 0;
+    num_bins = 0;
+    min_value = 0;
+    max_value = 0;
+    delta_value = 0;
+    count = sum1 = sum2 = sum3 = sum4 = NULL;
+    return;
+}
 
-public:
-    KurtosisIncrementalEstimator(T _min_value = 0, T _max_value = numeric_limits<T>::max())
-    {
-        // min_value and max_value define the bound of the values that will be
-        // actually used to compute the Kurtosis
-        // when using the Ensemble method we want to reject the too low errors, and the too large errors
-
-        min_value = _min_value;
-        max_value = _max_value;
-
-        n = 0;
-        mean = 0.0;
-        central_moment2= 0.0;
-        central_moment4 = 0.0;
-        return;
-    }
+KurtosisAccumulators::~KurtosisAccumulators()
+{
+    return;
+}
 
-    KurtosisIncrementalEstimator(const KurtosisIncrementalEstimator<T> &k)
-    {
-        min_value = k.min_value;
-        max_value = k.max_value;
-
-        n = 0;
-        mean = 0.0;
-        central_moment2= 0.0;
-        central_moment4 = 0.0;
-        return;
-    }
+void KurtosisAccumulators::reset(const int _num_points, const double _min_value, const double _max_value,
+                                 const int _num_bins)
+{
+    // min_value and max_value define the bound of the values that will be
+    // actually used to compute the kurtosis
+    // when using the Ensemble method we want to reject the too low errors, and the too large errors
+    num_points = _num_points;
+    min_value = _min_value;
+    max_value = _max_value;
+    num_bins = max(0, _num_bins);
+    delta_value = (num_bins > 0) ? (max_value - min_value) / num_bins : 0;
+
+    // each array starts on a 16 bytes boundary
+    const int stride = (num_points + 1) & ~1;
+    const size_t required_size = 5*stride + 1;
+    if (buffer.size() < required_size)
+        buffer.resize(required_size);
+
+    const size_t misalignment = reinterpret_cast<size_t>(&buffer[0]) % 16;
+    count = &buffer[0] + ((misalignment == 0) ? 0 : 1);
+    sum1 = count + stride;
+    sum2 = sum1 + stride;
+    sum3 = sum2 + stride;
+    sum4 = sum3 + stride;
+    fill(count, count + 5*stride, 0.0);
+
+    histograms.resize(num_points * num_bins);
+    fill(histograms.begin(), histograms.end(), 0);
+    return;
+}
 
-    ~KurtosisIncrementalEstimator()
+void KurtosisAccumulators::add_residuals(const vector<float> &residuals)
+{
+    if (static_cast<int>(residuals.size()) != num_points)
+        throw runtime_error("KurtosisAccumulators::add_residuals expected one residual per data point");
+
+    // the values out of the range of interest are masked instead of skipped,
+    // so that the loop has no branch. The power sums are used instead of the incremental
+    // central moments, they need no division per value and double has enough precision
+    // for residuals in pixels
+    const float *r = (num_points > 0) ? &residuals[0] : NULL;
+    int i = 0;
+
+#if defined(__SSE2__)
+    const __m128d min_values = _mm_set1_pd(min_value), max_values = _mm_set1_pd(max_value);
+    const __m128d ones = _mm_set1_pd(1.0);
+    for ( ; i + 2 <= num_points; i+=2)
     {
-        return;
+        const __m128d x = _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(r + i))));
+        const __m128d mask = _mm_and_pd(_mm_cmpge_pd(x, min_values), _mm_cmple_pd(x, max_values));
+        const __m128d masked_x = _mm_and_pd(mask, x);
+        const __m128d masked_x2 = _mm_mul_pd(masked_x, masked_x);
+
+        _mm_store_pd(count + i, _mm_add_pd(_mm_load_pd(count + i), _mm_and_pd(mask, ones)));
+        _mm_store_pd(sum1 + i, _mm_add_pd(_mm_load_pd(sum1 + i), masked_x));
+        _mm_store_pd(sum2 + i, _mm_add_pd(_mm_load_pd(sum2 + i), masked_x2));
+        _mm_store_pd(sum3 + i, _mm_add_pd(_mm_load_pd(sum3 + i), _mm_mul_pd(masked_x2, masked_x)));
+        _mm_store_pd(sum4 + i, _mm_add_pd(_mm_load_pd(sum4 + i), _mm_mul_pd(masked_x2, masked_x2)));
     }
+#endif
 
-    void add_value(T x)
+    for ( ; i < num_points; i+=1)
     {
-        if (x < min_value || x > max_value) return;
-        // we omit values out of the range of interest
-
-        T delta1 = (x - mean);
-        T delta2 = delta1 / static_cast<T>(n + 1);
-        mean += delta2;
-        central_moment2 += n*delta2*delta2 + delta1*delta1;
-        central_moment4 += n*delta2*delta2*delta2*delta2 + delta1*delta1*delta1*delta1;
-        n += 1;
-        return;
+        const double x = r[i];
+        const bool is_in_range = (x >= min_value && x <= max_value);
+        const double masked_x = is_in_range ? x : 0.0;
+        const double masked_x2 = masked_x * masked_x;
+
+        count[i] += is_in_range ? 1.0 : 0.0;
+        sum1[i] += masked_x;
+        sum2[i] += masked_x2;
+        sum3[i] += masked_x2 * masked_x;
+        sum4[i] += masked_x2 * masked_x2;
     }
 
-    T get_kurtosis() const
+    if (num_bins > 0)
     {
+        int *bins = &histograms[0];
+        for (i=0; i < num_points; i+=1, bins += num_bins)
+        {
+            const double x = r[i];
+            if (x < min_value || x >= max_value)
+                continue; // we omit values out of the range of interest
 
-        T kurtosis = -3.0;
-        if (n > 0)
-            kurtosis += static_cast<T>((n*central_moment4/(central_moment2*central_moment2)));
-        return kurtosis;
+            const int num_bin = static_cast<int>((x - min_value) / delta_value);
+            if (num_bin < num_bins) // safety check
+                bins[num_bin] += 1;
+        }
     }
 
+    return;
 }
-; // end helper class KurtosisIncrementalEstimator<>
-
-
-
-
-// HistogramKurtosis<> methods implementation ----
-
-template<typename T>
-HistogramKurtosis<T>::HistogramKurtosis(float _min_value, float _max_value, int num_bins)
-    {
-        min_value = _min_value;
-        max_value = _max_value;
-        delta_value = (max_value - min_value) / num_bins;
-        bins.resize(num_bins);
-        fill(bins.begin(), bins.end(), 0);
-
-        n = 0;
-        mean = 0.0;
-        central_moment2= 0.0;
-        central_moment4 = 0.0;
-        return;
-    }
-    
-template<typename T>
-HistogramKurtosis<T>::HistogramKurtosis(const HistogramKurtosis &hk)
-    {
-        min_value = hk.min_value;
-        max_value = hk.max_value;
-        delta_value = hk.delta_value;
-        bins.resize(hk.bins.size());
-        fill(bins.begin(), bins.end(), 0);
-
-        n = 0;
-        mean = 0.0;
-        central_moment2= 0.0;
-        central_moment4 = 0.0;
-    }
-    
-template<typename T>
-HistogramKurtosis<T>::~HistogramKurtosis()
-    {
-        return;
-    }
-    
-template<typename T>
-void HistogramKurtosis<T>::add_value(const T x)
-    {
-
-        if (x < min_value || x >= max_value) return;
-        // we omit values out of the range of interest
-
 
-        const int num_bin = static_cast<int>(floor((x - min_value) / delta_value));
-        if (num_bin < 0)
-        { // this should neve happen, but still is a safety check
-            throw runtime_error("HistogramKurtosis::add_value internal error");
-        }
+int KurtosisAccumulators::size() const
+{
+    return num_points;
+}
 
-        if (num_bin >= static_cast<int>(bins.size()) ) return; // safety check
-        bins[num_bin] += 1;
+bool KurtosisAccumulators::has_histograms() const
+{
+    return num_bins > 0 && num_points > 0;
+}
 
-        T delta1 = (x - mean);
-        T delta2 = delta1 / static_cast<T>(n + 1);
-        mean += delta2;
-        central_moment2 += n*delta2*delta2 + delta1*delta1;
-        central_moment4 += n*delta2*delta2*delta2*delta2 + delta1*delta1*delta1*delta1;
-        n += 1;
-        return;
-    }
-template<typename T>
-T HistogramKurtosis<T>::get_kurtosis() //const
+void KurtosisAccumulators::get_kurtosis(vector<double> &kurtosis_values) const
+{
+    // based on information available at
+    // http://en.wikipedia.org/wiki/Kurtosis
+    // http://en.wikipedia.org/wiki/Moment_about_the_mean
+    kurtosis_values.resize(num_points);
+    int i;
+    for (i=0; i < num_points; i+=1)
     {
-
-        if (false)
-        {
-            // iterate over the bins to compute, mean, second central moment and fourth central moment
-
-            // incremental mean estimation is stable
-            // the central moments are not, so we recompute them
-            central_moment2 = 0.0;
-            central_moment4 = 0.0;
-
-            vector<int>::const_iterator bins_it;
-            T t_value = 0.0;
-            for (bins_it = (bins.begin() + 1), t_value = delta_value + delta_value*0.5;
-                    bins_it != bins.end();
-                    ++bins_it, t_value += delta_value)
-            {
-                const float weight = static_cast<float>(*bins_it) / n;
-                //long double delta = t_value - mean;
-                long double delta = t_value; // <<< just for testing
-                central_moment2 += weight*delta*delta;
-                central_moment4 += weight*delta*delta*delta*delta;
-            }
-
-            return (central_moment4/(central_moment2*central_moment2)) - 3.0;
-        }
-        else if (true)
+        double kurtosis = -3.0;
+        const double n = count[i];
+        if (n > 0)
         {
-            // test hack for the LineModel scenario
-            // <<< works quite fine
-            int max_delta = 0;
-
-            unsigned int i;
-            for (i = 0; i < (bins.size() - 1); i+=1)
-            {
-                const int delta = bins[i + 1] - bins[i];
-                if (delta > max_delta)
-                    max_delta = delta;
-            }
-
-            return static_cast<T>(max_delta);
+            const double mean = sum1[i] / n;
+            const double mean2 = mean * mean;
+            const double central_moment2 = sum2[i] / n - mean2; // also known as variance
+            const double central_moment4 =
+                (sum4[i] - 4*mean*sum3[i] + 6*mean2*sum2[i]) / n - 3*mean2*mean2;
+            if (central_moment2 > 0)
+                kurtosis += central_moment4 / (central_moment2*central_moment2);
         }
-        else
-        {
-            // (ultra dirty) test hack for the HomographyModel scenario
-            //return static_cast<T>(mean);
-
-            int max_bin_value = 0;
-            unsigned int max_bin_index = 0;
+        kurtosis_values[i] = kurtosis;
+    }
 
-            unsigned int i;
-            for (i = 0; i < (bins.size() - 1); i+=1)
-            {
-                if (bins[i] > max_bin_value)
-                {
-                    max_bin_value = bins[i];
-                    max_bin_index = i;
-                }
-            }
-            return static_cast<T>(max_bin_index);
-        }
+    return;
+}
 
-    }
-
-template<typename T>
-const vector<int> & HistogramKurtosis<T>::get_bins() const
-    
+void KurtosisAccumulators::get_histograms_max_rise(vector<double> &max_rise_values) const
+{
+    // test hack for the LineModel scenario
+    // <<< works quite fine
+    max_rise_values.resize(num_points);
+    int i;
+    for (i=0; i < num_points; i+=1)
     {
-        return bins;
+        const int *bins = &histograms[i*num_bins];
+        int max_delta = 0, b;
+        for (b=0; b < num_bins - 1; b+=1)
+            max_delta = max(max_delta, bins[b + 1] - bins[b]);
+        max_rise_values[i] = max_delta;
     }
 
+    return;
+}
+
+void KurtosisAccumulators::get_histogram(const int index, vector<int> &bins) const
+{
+    if (index < 0 || index >= num_points || num_bins == 0)
+        throw runtime_error("KurtosisAccumulators::get_histogram index out of range");
 
-// end helper class HistogramKurtosis<> methods implementation
+    bins.assign(histograms.begin() + index*num_bins, histograms.begin() + (index + 1)*num_bins);
+    return;
+}
 
 
 // ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
@@ -277,6 +240,23 @@ args::options_description EnsembleMethod::get_options_description()
 
     ( "ensemble_method.num_samples", args::value<int>()->default_value(500),
       "define the number of samples used to estimate the kurtosis of the error distribution")
+
+    ( "ensemble_method.threads", args::value<int>()->default_value(1),
+      "number of threads used to draw the samples and compute their residuals")
+
+    ( "ensemble_method.random_seed", args::value<int>()->default_value(0),
+      "seed of the samples generator, results are reproducible for a given seed and number of threads")
+
+    ( "ensemble_method.degeneracy_checks", args::value<string>()->default_value("none"),
+      "samples rejected before the model fit: none, distinct_features (the matches of a sample do not share features) "
+      "or distinct_non_collinear (also no three collinear points, for homographies)")
+
+    ( "ensemble_method.histogram_bins", args::value<int>()->default_value(50),
+      "number of bins of the residuals histogram of each data point, the inliers are classified using the histograms shape. "
+      "0 disables the histograms, the inliers are then classified using the kurtosis of the residuals")
+
+    ( "ensemble_method.trace_level", args::value<int>()->default_value(0),
+      "0 is silent, 1 prints the classification summary, 2 also prints the kurtosis values and the k-means details")
     ;
 
     return desc;
@@ -294,10 +274,68 @@ EnsembleMethod::EnsembleMethod(args::variables_map &options, IParametricModel &m
     if (options.count("ensemble_method.num_samples"))
         num_samples = options["ensemble_method.num_samples"].as<int>();
 
+    histogram_bins = 50;
+    if (options.count("ensemble_method.histogram_bins"))
+        histogram_bins = options["ensemble_method.histogram_bins"].as<int>();
+
+    trace_level = 0;
+    if (options.count("ensemble_method.trace_level"))
+        trace_level = options["ensemble_method.trace_level"].as<int>();
+
+    RandomSampler::DegeneracyChecks degeneracy_checks = RandomSampler::no_checks;
+    if (options.count("ensemble_method.degeneracy_checks"))
+    {
+        const string checks = options["ensemble_method.degeneracy_checks"].as<string>();
+        if (checks == "distinct_features")
+            degeneracy_checks = RandomSampler::distinct_features;
+        else if (checks == "distinct_non_collinear")
+            degeneracy_checks = RandomSampler::distinct_non_collinear;
+        else if (checks != "none")
+            throw runtime_error("Unknown ensemble_method.degeneracy_checks value " + checks);
+    }
+
+    if (histogram_bins < 0 || histogram_bins == 1)
+        throw runtime_error("EnsembleMethod expects ensemble_method.histogram_bins to be 0 or at least 2");
+
+    int num_threads = 1, random_seed = 0;
+    if (options.count("ensemble_method.threads"))
+        num_threads = options["ensemble_method.threads"].as<int>();
+
+    if (options.count("ensemble_method.random_seed"))
+        random_seed = options["ensemble_method.random_seed"].as<int>();
+
     model_p = &model;
     if (model_p == NULL)
         throw runtime_error("EnsembleMethod input parametric model can not be NULL");
 
+    samples_per_round = 16;
+    matches_p = NULL;
+
+    // each worker has its own model and its own random stream,
+    // seeded from the worker index so that the results are reproducible
+    num_threads = max(1, num_threads);
+    workers.resize(num_threads);
+    int w;
+    for (w=0; w < num_threads; w+=1)
+    {
+        Worker &worker = workers[w];
+        if (w == 0)
+            worker.model_p = model_p;
+        else
+        {
+            worker.model_clone_p.reset(model_p->clone());
+            worker.model_p = worker.model_clone_p.get();
+        }
+        worker.sampler = RandomSampler(degeneracy_checks);
+        worker.sampler.seed(static_cast<boost::uint64_t>(random_seed), static_cast<boost::uint64_t>(w));
+        worker.sample_set.resize(model_p->get_num_points_to_estimate());
+        worker.samples_residuals.resize(samples_per_round);
+        worker.num_samples = 0;
+    }
+
+    if (num_threads > 1)
+        thread_pool_p.reset(new ThreadPool(num_threads));
+
     return;
 }
 
@@ -314,96 +352,114 @@ void EnsembleMethod::set_min_max_values(double _min_error_value, double _max_err
     return;
 }
 
-const ublas::vector<float> &EnsembleMethod::estimate_model_parameters(const vector< ScoredMatch > &matches)
+void EnsembleMethod::run_worker(const int worker_index)
 {
-    // estimate the kurtosis of the each data point ---
-    vector<int> indexes;
+    Worker &worker = workers[worker_index];
+    const vector< ScoredMatch > &matches = *matches_p;
+
     vector<int>::const_iterator indexes_it;
-    vector< ScoredMatch > sample_set(model_p->get_num_points_to_estimate());
     vector< ScoredMatch >::iterator sample_set_it;
 
-    vector< ScoredMatch >::const_iterator matches_it;
+    // the samples for which the model estimation fails are drawn again
+    const int max_estimation_attempts = 100;
 
-    vector<float> residuals(matches.size());
-    vector<float>::const_iterator residuals_it;
+    int c;
+    for (c=0; c < worker.num_samples; c+=1)
+    {
+        int attempt;
+        for (attempt=0; attempt < max_estimation_attempts; attempt+=1)
+        {
+            // grab randomly "num_points_to_estimate" samples --
+            worker.sampler.draw(matches, worker.model_p->get_num_points_to_estimate(), worker.indexes);
 
-    kurtosis_estimators.clear();
-    kurtosis_estimators.resize(matches.size(),
-                               KurtosisIncrementalEstimator<double>(min_error_value, max_error_value));
+            // estimate the model parameters --
+            for (sample_set_it = worker.sample_set.begin(), indexes_it = worker.indexes.begin();
+                    sample_set_it != worker.sample_set.end() && indexes_it != worker.indexes.end();
+                    ++sample_set_it, ++indexes_it)
+            {
+                *sample_set_it = matches[*indexes_it]; // copy
+            }
 
-    histogram_kurtosis_estimators.clear();
-    histogram_kurtosis_estimators.resize(matches.size(),
-                                         HistogramKurtosis<double>(min_error_value, max_error_value, 50));
+            try
+            {
+                worker.model_p->estimate_from_minimal_set(worker.sample_set);
+                break;
+            }
+            catch (runtime_error &)
+            {
+                // degenerate sample
+            }
+        }
 
-    // for each sample we will estimate the kurtosis of his residuals of each estimated model
-    vector< KurtosisIncrementalEstimator<double> >::iterator kurtosis_estimators_it;
-    vector< KurtosisIncrementalEstimator<double> >::const_iterator const_kurtosis_estimators_it;
+        if (attempt == max_estimation_attempts)
+            throw runtime_error("EnsembleMethod::run_worker dataset ill conditioned, the model estimation always failed");
 
-    vector< HistogramKurtosis<double> >::iterator histogram_kurtosis_estimators_it;
-    //vector< HistogramKurtosis<double> >::const_iterator const_histogram_kurtosis_estimators_it;
-    vector< HistogramKurtosis<double> >::iterator const_histogram_kurtosis_estimators_it;
+        // evaluate the error of each sample --
+        worker.model_p->compute_residuals(matches, worker.samples_residuals[c]);
+    }
+
+    return;
+}
+
+const ublas::vector<float> &EnsembleMethod::estimate_model_parameters(const vector< ScoredMatch > &matches)
+{
+    if (have_features(matches) == false)
+        throw runtime_error("EnsembleMethod::estimate_model_parameters requires matches with feature pointers, not only indexes");
 
-    kurtosis_values.resize(matches.size());
-    vector<double>::iterator kurtosis_values_it;
+    // estimate the kurtosis of the each data point ---
+    kurtosis_accumulators.reset(static_cast<int>(matches.size()), min_error_value, max_error_value, histogram_bins);
 
+    matches_p = &matches;
+    const int num_workers = static_cast<int>(workers.size());
 
-    int c;
-    for (c=0;c<num_samples;c+=1)
+    // the samples are drawn in rounds, each worker draws its share of the round
+    // and the kurtosis accumulators are updated in the workers order, so that the result
+    // does not depend on the threads scheduling
+    int num_drawn_samples = 0;
+    while (num_drawn_samples < num_samples)
     {
-        // grab randomly "num_points_to_estimate" samples --
-        retrieve_random_indexes(matches, model_p->get_num_points_to_estimate(), indexes);
+        const int round_size = min(num_samples - num_drawn_samples, samples_per_round * num_workers);
 
-        // estimate the model parameters --
-        for (sample_set_it = sample_set.begin(), indexes_it = indexes.begin();
-                sample_set_it != sample_set.end() && indexes_it != indexes.end();
-                ++sample_set_it, ++indexes_it)
-        {
-            *sample_set_it = matches[*indexes_it]; // copy
-        }
+        int w;
+        for (w=0; w < num_workers; w+=1)
+            workers[w].num_samples = round_size / num_workers + ((w < round_size % num_workers) ? 1 : 0);
 
-        model_p->estimate_from_minimal_set(sample_set);
+        if (thread_pool_p)
+            thread_pool_p->run(num_workers, boost::bind(&EnsembleMethod::run_worker, this, _1));
+        else
+            run_worker(0);
 
-        // evaluate the error of each sample --
-        model_p->compute_residuals(matches, residuals);
-
-        // update the kurtosis of the error distribution of each sample --
-        for (residuals_it = residuals.begin(),
-                kurtosis_estimators_it = kurtosis_estimators.begin(),
-                histogram_kurtosis_estimators_it = histogram_kurtosis_estimators.begin();
-                residuals_it != residuals.end()
-                && kurtosis_estimators_it != kurtosis_estimators.end()
-                && histogram_kurtosis_estimators_it != histogram_kurtosis_estimators.end();
-                ++residuals_it, ++kurtosis_estimators_it, ++histogram_kurtosis_estimators_it)
+        // update the moments of the error distribution of each data point,
+        // one pass over all the data points per sample --
+        for (w=0; w < num_workers; w+=1)
         {
-            kurtosis_estimators_it->add_value( *residuals_it );
-            histogram_kurtosis_estimators_it->add_value( *residuals_it );
+            int c;
+            for (c=0; c < workers[w].num_samples; c+=1)
+                kurtosis_accumulators.add_residuals(workers[w].samples_residuals[c]);
         }
 
-    } // end of 'for c in [0, num_samples)
+        num_drawn_samples += round_size;
+
+    } // end of 'while num_drawn_samples < num_samples'
 
     // classifier the kurtosis values distribution into inliers and outliers samples ---
     // (using rank or k-means)
 
     // retrieve the estimated values -
-    const bool print_kurtosis_values = true;
-    if (print_kurtosis_values) cout << "kurtosis values == ";
-    for (const_kurtosis_estimators_it = kurtosis_estimators.begin(),
-            const_histogram_kurtosis_estimators_it = histogram_kurtosis_estimators.begin(),
-            kurtosis_values_it = kurtosis_values.begin();
-            const_kurtosis_estimators_it != kurtosis_estimators.end()
-            && const_histogram_kurtosis_estimators_it != histogram_kurtosis_estimators.end()
-            && kurtosis_values_it != kurtosis_values.end();
-            ++const_kurtosis_estimators_it,
-            ++const_histogram_kurtosis_estimators_it,
-            ++kurtosis_values_it)
+    if (histogram_bins > 0)
+        kurtosis_accumulators.get_histograms_max_rise(kurtosis_values);
+    else
+        kurtosis_accumulators.get_kurtosis(kurtosis_values);
+
+    if (trace_level > 1)
     {
-        //*kurtosis_values_it = const_kurtosis_estimators_it->get_kurtosis();
-        *kurtosis_values_it = const_histogram_kurtosis_estimators_it->get_kurtosis();
-        if (print_kurtosis_values) cout << *kurtosis_values_it << " ";
+        cout << "kurtosis values == ";
+        unsigned int i;
+        for (i=0; i < kurtosis_values.size(); i+=1)
+            cout << kurtosis_values[i] << " ";
+        cout << endl;
     }
 
-    if (print_kurtosis_values) cout << endl;
-
     // do k-means -
     OneDimensionalKMeans kmeans;
     kmeans.compute(kurtosis_values, 2);
@@ -426,25 +482,21 @@ const ublas::vector<float> &EnsembleMethod::estimate_model_parameters(const vect
             ++permutations_it, permutations_index+=1)
     {
         // the lower set of kurtosis are the inliers, the rest are outliers
-        bool point_is_inlier = false;
-        if (permutations_index >= split_point)
-            point_is_inlier = false;
-        else if (permutations_index < split_point)
-            point_is_inlier = true;
-        else
-        {
-            throw runtime_error("debugging");
-            const float t_val = kurtosis_values[permutations_index];
-            const float delta_up = abs(t_val - kmeans_result[1]);
-            const float delta_down = abs(t_val - kmeans_result[0]);
-            point_is_inlier = (delta_up < delta_down); // nearer to the upper set
-        }
+        const bool point_is_inlier = (permutations_index < split_point);
         is_inlier[*permutations_it] = point_is_inlier;
         if (point_is_inlier)
             inliers_subset.push_back( matches[*permutations_it] ); // keep a copy
     }
 
-    if (true)
+    if (trace_level > 0)
+    {
+        cout << "EnsembleMethod classified " << inliers_subset.size() << " inliers out of "
+             << matches.size() << " matches, kmeans.get_kmeans() == ";
+        for (unsigned int i=0; i < kmeans_result.size(); i+=1) cout << " " << kmeans_result[i];
+        cout << endl;
+    }
+
+    if (trace_level > 1)
     {
 
         vector<double> set_one, set_two;
@@ -464,10 +516,6 @@ const ublas::vector<float> &EnsembleMethod::estimate_model_parameters(const vect
         for (unsigned int i=0; i < permutations.size(); i+=1) cout << " " << permutations[i];
         cout << endl;
 
-        cout << "kmeans.get_kmeans() == " ;
-        for (unsigned int i=0; i < kmeans_result.size(); i+=1) cout << " " << kmeans_result[i];
-        cout << endl;
-
         cout << "set_one == " ;
         for (unsigned int i=0; i < set_one.size(); i+=1) cout << " " << set_one[i];
         cout << endl;
@@ -490,143 +538,9 @@ const vector< bool > &  EnsembleMethod::get_is_inlier()
 }
 
 
-// helper search class
-class compare_matches_unary_predicate // : UnaryPredicate<int>
-{
-    const vector< ScoredMatch > &data;
-    const ScoredMatch &match;
-
-public:
-    compare_matches_unary_predicate(const vector< ScoredMatch > &_data, const unsigned int match_index)
-            : data(_data), match(_data[match_index])
-    {
-        return;
-    }
-
-    bool operator()(int index) const;
-
-};
-
-bool compare_matches_unary_predicate::operator()(int index) const
-{ // we want to ensure that we have different
-
-    if (index >= static_cast<int>(data.size()) )
-        throw runtime_error("compare_matches_unary_predicate::operator() index out of range");
-
-    const ScoredMatch &m = this->data[index];
-    return (match.feature_a == m.feature_a) || (match.feature_b == m.feature_b);
-}
-
-/*
-template<>
-bool compare_matches_unary_predicate< boost::tuple<float, float> >::operator()(int index) const
-{
-// in order to ensure numerical stability we have to avoid using pairs of points where
-// the x values are too similar
-
-    const boost::tuple<float, float> &m = this->data[index];
-    const float x0 = match.get<0>();
-    const float x1 = m.get<0>();
-    return abs(x0 - x1) < 1e-10;
-}
-
-template<>
-bool compare_matches_unary_predicate<double>::operator()(int index) const
-{
-    throw runtime_error("This method should never be called");
-}
-
-template<>
-bool compare_matches_unary_predicate<float>::operator()(int index) const
-{
-    throw runtime_error("This method should never be called");
-}
-
-*/
-
-// helper function used for
-// partial specialization of retrieve_random_indexes when comparing scored matches
-void EnsembleMethod::retrieve_random_matches_indexes
-(const vector< ScoredMatch > &data, const unsigned int num_indexes, vector<int> &indexes)
-{
-    // we expect T to be ScoredMatch<F>
-
-    const int max_index_value = data.size() - 1;
-    indexes.clear(); // erase previous indexes
-
-    boost::variate_generator<boost::mt19937&, boost::uniform_int<int> >
-    get_random_index(random_generator, boost::uniform_int<int>(0, max_index_value));
-
-    int counter = 0;
-
-    while (indexes.size() != num_indexes)
-    {
-        // sample an index
-        const unsigned int t_index = get_random_index();
-
-        if (t_index >= data.size() ) // sanity check
-            throw runtime_error("EnsembleMethod::retrieve_random_matches_indexes index out of range");
-
-        if ( std::find_if(indexes.begin(), indexes.end(),
-                          compare_matches_unary_predicate(data, t_index) ) == indexes.end())
-        { // the index was not listed, we can add it
-            indexes.push_back(t_index);
-        }
-
-        counter+=1;
-        if ( counter > 10*max_index_value)
-            throw runtime_error("EnsembleMethod< ScoredMatch<F> >::retrieve_random_indexes dataset ill conditioned");
-    } // end of 'while not enough indexes have been retrieved'
-
-    return;
-}
-
-// generic case
-void EnsembleMethod::retrieve_random_indexes(const vector< ScoredMatch > &data, const unsigned int num_indexes,
-        vector<int> &indexes)
-{
-
-    indexes.clear(); // erase previous indexes
-
-    const int max_index_value = data.size();
-    boost::variate_generator<boost::mt19937&, boost::uniform_int<int> >
-    get_random_index(random_generator, boost::uniform_int<int>(0, max_index_value));
-    int counter = 0;
-
-    while (indexes.size() != num_indexes)
-    {
-        // sample an index
-        int t_index = get_random_index();
-
-        if ( find(indexes.begin(), indexes.end(), t_index) == indexes.end())
-        { // the index was not listed, we can add it
-            indexes.push_back(t_index);
-        }
-
-        counter+=1;
-        if ( counter > 10*max_index_value)
-            throw runtime_error("EnsembleMethod::retrieve_random_indexes dataset ill conditioned");
-    } // end of 'while not enough indexes have been retrieved'
-
-    return;
-}
-
-// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
-// Force the compilation of the following types
-// for some strange reason, in linux, this has to be at the end of the defitions (?!)
-
-
-template void HistogramKurtosis<double>::display_histogram
-(const float, const vector<int> &, const int , CImgDisplay &);
-
-
-
-
 // ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
-// class HistogramKurtosis methods implementation
 
-template<typename T>
-void HistogramKurtosis<T>::display_histogram(const float kurtosis,
+void KurtosisAccumulators::display_histogram(const float kurtosis,
         const vector<int> &bins, const int bins_max_value, CImgDisplay &image_display)
 { // helper method that draws an histogram
 
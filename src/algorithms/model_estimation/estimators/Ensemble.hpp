@@ -4,9 +4,12 @@
 
 #include "../IParametricModel.hpp"
 #include "../IModelEstimator.hpp"
+#include "RandomSampler.hpp"
 
 #include <boost/random.hpp>
 #include <boost/program_options.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 
 namespace cimg_library {
 	class CImgDisplay; 
@@ -18,9 +21,52 @@ namespace uniclop
 namespace args = ::boost::program_options;
 
 class ScoredMatch;
+class ThreadPool; // forward declaration
 
-template<typename T> class KurtosisIncrementalEstimator; // forward declaration
-template<typename T> class HistogramKurtosis; // forward declaration
+
+/// Moments (and optionally histograms) of the residuals of each data point,
+/// accumulated over the models drawn by the EnsembleMethod.
+/// The accumulators are stored as a structure of arrays of doubles, 16 bytes aligned,
+/// so that the residuals of one model update all the data points in a single SIMD pass.
+/// The memory is kept between calls to reset(), so at steady state no allocation is done.
+class KurtosisAccumulators
+{
+    int num_points, num_bins;
+    double min_value, max_value, delta_value;
+
+    vector<double> buffer; ///< oversized, to allow the alignment of the accumulators
+    double *count, *sum1, *sum2, *sum3, *sum4; ///< power sums of the residuals in [min_value, max_value]
+    vector<int> histograms; ///< num_bins bins per data point, empty when num_bins == 0
+
+public:
+    KurtosisAccumulators();
+    ~KurtosisAccumulators();
+
+    void reset(const int num_points, const double min_value, const double max_value, const int num_bins);
+    ///< num_bins == 0 disables the histograms
+
+    void add_residuals(const vector<float> &residuals);
+    ///< residuals of one model, one per data point
+
+    int size() const;
+    bool has_histograms() const;
+
+    void get_kurtosis(vector<double> &kurtosis_values) const;
+    ///< excess kurtosis of the residuals of each data point, -3 when no residual was in range
+
+    void get_histograms_max_rise(vector<double> &max_rise_values) const;
+    ///< largest increase between two consecutive bins of each histogram
+
+    void get_histogram(const int index, vector<int> &bins) const;
+
+    static void display_histogram(const float kurtosis,
+                                  const vector<int> &bins, const int bins_max_value, cimg_library::CImgDisplay &image_display);
+    ///< helper method that draws an histogram
+
+private:
+    KurtosisAccumulators(const KurtosisAccumulators &); // the aligned pointers can not be copied
+    KurtosisAccumulators &operator=(const KurtosisAccumulators &);
+};
 
 class EnsembleMethod: public  IModelEstimator
 { // implementation of the W. Zhang and J. Kosecka "Ensemble method for robust estimation"
@@ -31,9 +77,8 @@ protected:
 
 public:
 
-    vector< KurtosisIncrementalEstimator<double> > kurtosis_estimators;
-    vector< HistogramKurtosis<double> > histogram_kurtosis_estimators;
-    vector<double> kurtosis_values;
+    KurtosisAccumulators kurtosis_accumulators;
+    vector<double> kurtosis_values; ///< value used to classify each data point, see ensemble_method.histogram_bins
 
     static args::options_description get_options_description();
 	
@@ -52,52 +97,35 @@ protected:
     double min_error_value, max_error_value;
 
     int num_samples;
+    int histogram_bins; ///< 0 when the kurtosis is computed from the moments
+    int trace_level;
     IParametricModel  *model_p;
-    boost::mt19937 random_generator; // pseudo-random number generators
-
-    void retrieve_random_indexes(const vector< ScoredMatch > &data,
-                                 const unsigned int num_indexes, vector<int> &indexes);
-
-    void retrieve_random_matches_indexes(const vector<ScoredMatch> &data, const unsigned int num_indexes,
-                                         vector<int> &indexes);
-};
-
-
-// Helper classes KurtosisIncrementalEstimator and HistogramKurtosis
-
-// T: double or float
-template<typename T = double>
-class HistogramKurtosis
-{
-    // Do an histogram and compute the kurtosis based on all but the first bin
 
-    T min_value, max_value, delta_value;
-    vector<int> bins;
+    int samples_per_round; ///< samples drawn by each thread before the kurtosis estimators are updated
 
-    int n;
-    long double mean, central_moment2, central_moment4;
-    // central_moment2 is also knowns as variance
+    /// each thread draws its own samples and computes their residuals
+    class Worker
+    {
+    public:
+        IParametricModel *model_p;
+        boost::shared_ptr<IParametricModel> model_clone_p; ///< NULL for the first worker, that uses the input model
+        RandomSampler sampler; ///< seeded with the worker index as stream
 
-public:
-    HistogramKurtosis(float _min_value, float _max_value, int num_bins);
+        vector<int> indexes;
+        vector< ScoredMatch > sample_set;
+        vector< vector<float> > samples_residuals; ///< residuals of each sample of the current round
 
-    HistogramKurtosis(const HistogramKurtosis &hk);
-    ~HistogramKurtosis();
-    
-    void add_value(const T x);
-    T get_kurtosis(); //const
-    
-    const vector<int> &get_bins() const;
+        int num_samples; ///< samples to draw in the current round
+    };
 
-    static void display_histogram(const float kurtosis,
-                                  const vector<int> &bins, const int bins_max_value, cimg_library::CImgDisplay &image_display);
-    // helper method that draws an histogram
+    vector<Worker> workers;
+    boost::scoped_ptr<ThreadPool> thread_pool_p; ///< NULL when using a single thread
+    const vector< ScoredMatch > *matches_p; ///< data of the current call, read by the workers
 
-}
-; // end helper class HistogramKurtosis<>
+    void run_worker(const int worker_index);
+};
 
 
-
 }
 
 #endif // ENSEMBLE_HEADER
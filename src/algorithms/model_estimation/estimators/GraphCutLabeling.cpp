@@ -0,0 +1,314 @@
+
+#include "GraphCutLabeling.hpp"
+
+#include "algorithms/features/ScoredMatch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace uniclop
+{
+
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Class GraphCutLabeling methods implementation
+
+// the grid cell size is tuned for a few hundred features on a video frame,
+// the neighbors search radius adapts to the actual density
+GraphCutLabeling::GraphCutLabeling(const int _num_neighbors, const float _spatial_coherence)
+        : num_neighbors(_num_neighbors), spatial_coherence(_spatial_coherence), grid(32)
+{
+    if (num_neighbors < 1)
+        throw runtime_error("GraphCutLabeling expects at least one neighbor per point");
+
+    if (spatial_coherence < 0)
+        throw runtime_error("GraphCutLabeling expects a non negative spatial coherence weight");
+
+    graph_data_p = NULL;
+    return;
+}
+
+GraphCutLabeling::~GraphCutLabeling()
+{
+    return;
+}
+
+
+void GraphCutLabeling::invalidate_graph()
+{
+    graph_data_p = NULL;
+    return;
+}
+
+
+void GraphCutLabeling::build_graph(const vector< ScoredMatch > &data_points)
+{
+    const int num_points = static_cast<int>(data_points.size());
+    const int k = min(num_neighbors, max(0, num_points - 1));
+
+    points_x.resize(num_points);
+    points_y.resize(num_points);
+    int i;
+    for (i=0; i < num_points; i+=1)
+    {
+        points_x[i] = data_points[i].feature_a->x;
+        points_y[i] = data_points[i].feature_a->y;
+    }
+
+    neighbors.assign(num_points * num_neighbors, -1);
+    edges.clear();
+    graph_data_p = &data_points;
+
+    if (k == 0)
+        return;
+
+    grid.build(points_x, points_y);
+
+    // initial search radius, the disk expected to hold k + 1 points for a uniform density
+    const int width = *max_element(points_x.begin(), points_x.end()) - *min_element(points_x.begin(), points_x.end()) + 1;
+    const int height = *max_element(points_y.begin(), points_y.end()) - *min_element(points_y.begin(), points_y.end()) + 1;
+    const double diagonal = sqrt(static_cast<double>(width)*width + static_cast<double>(height)*height);
+    const int initial_radius =
+        max(1, static_cast<int>(ceil(sqrt(static_cast<double>(width) * height * (k + 1) / (M_PI * num_points)))));
+
+    int p;
+    for (p=0; p < num_points; p+=1)
+    {
+        // the radius doubles until the disk holds k neighbors,
+        // then the k nearest points of the disk are the k nearest neighbors
+        int radius = initial_radius;
+        while (true)
+        {
+            grid.radius_query(points_x[p], points_y[p], radius, candidates);
+            if (static_cast<int>(candidates.size()) > k || radius > diagonal)
+                break;
+            radius *= 2;
+        }
+
+        candidates_distances.clear();
+        vector<int>::const_iterator candidates_it;
+        for (candidates_it = candidates.begin(); candidates_it != candidates.end(); ++candidates_it)
+        {
+            const int q = *candidates_it;
+            if (q == p)
+                continue;
+            const int dx = points_x[q] - points_x[p], dy = points_y[q] - points_y[p];
+            candidates_distances.push_back(make_pair(dx*dx + dy*dy, q));
+        }
+
+        const int num_found = min(k, static_cast<int>(candidates_distances.size()));
+        partial_sort(candidates_distances.begin(), candidates_distances.begin() + num_found, candidates_distances.end());
+        for (i=0; i < num_found; i+=1)
+            neighbors[p*num_neighbors + i] = candidates_distances[i].second;
+    }
+
+    // undirected edges, (p, q) is kept once when p and q are neighbors of each other
+    for (p=0; p < num_points; p+=1)
+    {
+        for (i=0; i < k; i+=1)
+        {
+            const int q = neighbors[p*num_neighbors + i];
+            if (q < 0)
+                break;
+
+            bool is_mutual = false;
+            int j;
+            for (j=0; j < k; j+=1)
+                is_mutual = is_mutual || (neighbors[q*num_neighbors + j] == p);
+
+            if (p < q || is_mutual == false)
+                edges.push_back(make_pair(p, q));
+        }
+    }
+
+    return;
+}
+
+
+void GraphCutLabeling::add_arcs(const int from, const int to, const double capacity, const double reverse_capacity)
+{
+    // arcs are added by pairs, so the reverse of arc a is a^1
+    arc_to.push_back(to);
+    arc_capacity.push_back(capacity);
+    arc_next.push_back(arc_head[from]);
+    arc_head[from] = static_cast<int>(arc_to.size()) - 1;
+
+    arc_to.push_back(from);
+    arc_capacity.push_back(reverse_capacity);
+    arc_next.push_back(arc_head[to]);
+    arc_head[to] = static_cast<int>(arc_to.size()) - 1;
+    return;
+}
+
+
+bool GraphCutLabeling::compute_levels(const int source, const int sink)
+{
+    // breadth first search on the arcs with residual capacity
+    fill(node_level.begin(), node_level.end(), -1);
+    node_level[source] = 0;
+
+    int queue_begin = 0, queue_end = 0;
+    bfs_queue[queue_end++] = source;
+    while (queue_begin < queue_end)
+    {
+        const int node = bfs_queue[queue_begin++];
+        int arc;
+        for (arc = arc_head[node]; arc != -1; arc = arc_next[arc])
+        {
+            const int to = arc_to[arc];
+            if (arc_capacity[arc] > 1e-12 && node_level[to] < 0)
+            {
+                node_level[to] = node_level[node] + 1;
+                bfs_queue[queue_end++] = to;
+            }
+        }
+    }
+
+    return node_level[sink] >= 0;
+}
+
+
+double GraphCutLabeling::push_flow(const int node, const int sink, const double flow)
+{
+    if (node == sink)
+        return flow;
+
+    // node_current_arc skips the arcs already saturated in this phase
+    int &arc = node_current_arc[node];
+    for ( ; arc != -1; arc = arc_next[arc])
+    {
+        const int to = arc_to[arc];
+        if (arc_capacity[arc] > 1e-12 && node_level[to] == node_level[node] + 1)
+        {
+            const double pushed = push_flow(to, sink, min(flow, arc_capacity[arc]));
+            if (pushed > 0)
+            {
+                arc_capacity[arc] -= pushed;
+                arc_capacity[arc ^ 1] += pushed;
+                return pushed;
+            }
+        }
+    }
+
+    return 0;
+}
+
+
+void GraphCutLabeling::solve(const vector< ScoredMatch > &data_points, const float threshold)
+{
+    const int num_points = static_cast<int>(data_points.size());
+    const int source = num_points, sink = num_points + 1;
+    const double lambda = spatial_coherence;
+
+    kernel.resize(num_points);
+    unary_inlier.resize(num_points);
+    unary_outlier.resize(num_points);
+
+    const double squared_threshold = static_cast<double>(threshold) * threshold;
+    int p;
+    for (p=0; p < num_points; p+=1)
+    {
+        const double r = residuals[p];
+        kernel[p] = (r < threshold) ? exp(-r*r / (2 * squared_threshold)) : 0;
+        unary_inlier[p] = 1 - kernel[p];
+        unary_outlier[p] = kernel[p];
+    }
+
+    arc_head.assign(num_points + 2, -1);
+    arc_to.clear();
+    arc_next.clear();
+    arc_capacity.clear();
+
+    // the pairwise term is rewritten as
+    //   E00 + (E11 - E00)/2 * (L_p + L_q) + lambda/2 * [L_p != L_q]
+    // the first part goes to the unary terms and the second one to the p <-> q arcs
+    vector< pair<int, int> >::const_iterator edges_it;
+    for (edges_it = edges.begin(); edges_it != edges.end(); ++edges_it)
+    {
+        const int a = edges_it->first, b = edges_it->second;
+        const double term = lambda * (1 - kernel[a] - kernel[b]) / 2;
+        if (term > 0)
+        {
+            unary_inlier[a] += term;
+            unary_inlier[b] += term;
+        }
+        else
+        {
+            unary_outlier[a] -= term;
+            unary_outlier[b] -= term;
+        }
+        add_arcs(a, b, lambda / 2, lambda / 2);
+    }
+
+    // an inlier stays on the source side, so it cuts its arc to the sink
+    for (p=0; p < num_points; p+=1)
+    {
+        const double constant = min(unary_inlier[p], unary_outlier[p]);
+        add_arcs(source, p, unary_outlier[p] - constant, 0);
+        add_arcs(p, sink, unary_inlier[p] - constant, 0);
+    }
+
+    // Dinic max-flow
+    node_level.resize(num_points + 2);
+    node_current_arc.resize(num_points + 2);
+    bfs_queue.resize(num_points + 2);
+    while (compute_levels(source, sink))
+    {
+        copy(arc_head.begin(), arc_head.end(), node_current_arc.begin());
+        while (push_flow(source, sink, numeric_limits<double>::max()) > 0)
+        {
+            // saturate all the shortest paths
+        }
+    }
+
+    // the last search gives the nodes still reachable from the source
+    return;
+}
+
+
+int GraphCutLabeling::label_inliers(const IParametricModel &model, const vector< ScoredMatch > &data_points,
+                                    const float threshold, vector<bool> &is_inlier)
+{
+    if (graph_data_p != &data_points)
+        build_graph(data_points);
+
+    model.compute_residuals(data_points, residuals);
+    solve(data_points, threshold);
+
+    const int num_points = static_cast<int>(data_points.size());
+    is_inlier.resize(num_points);
+    int num_inliers = 0, p;
+    for (p=0; p < num_points; p+=1)
+    {
+        is_inlier[p] = (node_level[p] >= 0);
+        num_inliers += is_inlier[p] ? 1 : 0;
+    }
+
+    return num_inliers;
+}
+
+int GraphCutLabeling::label_inliers(const IParametricModel &model, const vector< ScoredMatch > &data_points,
+                                    const float threshold, vector< ScoredMatch > &inliers)
+{
+    if (graph_data_p != &data_points)
+        build_graph(data_points);
+
+    model.compute_residuals(data_points, residuals);
+    solve(data_points, threshold);
+
+    inliers.clear();
+    const int num_points = static_cast<int>(data_points.size());
+    int p;
+    for (p=0; p < num_points; p+=1)
+    {
+        if (node_level[p] >= 0)
+            inliers.push_back(data_points[p]);
+    }
+
+    return static_cast<int>(inliers.size());
+}
+
+
+} // end of namespace uniclop
@@ -0,0 +1,82 @@
+#if !defined(GRAPH_CUT_LABELING_HEADER)
+#define GRAPH_CUT_LABELING_HEADER
+
+// GraphCutLabeling, spatially coherent inliers labeling
+// D. Barath and J. Matas "Graph-Cut RANSAC", CVPR 2018
+
+
+#include "../IParametricModel.hpp"
+#include "algorithms/features/SpatialGridIndex.hpp"
+
+#include <vector>
+
+
+namespace uniclop
+{
+
+using namespace std;
+
+class ScoredMatch;
+
+class GraphCutLabeling
+{ // the matches are the nodes of a graph where each match is linked to its k nearest neighbors
+  // (feature_a positions), the inliers are the labeling that minimizes
+  //   E(L) = sum_p unary_p(L_p) + lambda * sum_(p,q) pairwise_pq(L_p, L_q)
+  // with K_p = exp(-r_p^2 / (2 threshold^2)) for r_p < threshold, 0 otherwise,
+  // unary_p = 1 - K_p for an inlier, K_p for an outlier,
+  // and pairwise_pq = 1 when L_p != L_q, 1 - (K_p + K_q)/2 for two inliers, (K_p + K_q)/2 for two outliers.
+  // The energy is submodular, its exact minimum is found with a minimum s-t cut (Dinic max-flow).
+  // All the buffers are kept between calls, so at steady state no memory is allocated.
+
+    int num_neighbors; ///< k
+    float spatial_coherence; ///< lambda
+
+    // neighborhood graph, undirected edges stored once
+    const vector< ScoredMatch > *graph_data_p; ///< data the graph was built for, NULL when invalidated
+    SpatialGridIndex grid;
+    vector<int> points_x, points_y, candidates;
+    vector< pair<int, int> > candidates_distances;
+    vector<int> neighbors; ///< k nearest neighbors of each point, num_points * k values (-1 padded)
+    vector< pair<int, int> > edges;
+
+    // flow network, nodes are the points plus the source and the sink
+    vector<int> arc_head; ///< first arc of each node, -1 when none
+    vector<int> arc_to, arc_next;
+    vector<double> arc_capacity; ///< residual capacities, arc i^1 is the reverse of arc i
+    vector<int> node_level, node_current_arc, bfs_queue;
+    vector<double> kernel, unary_inlier, unary_outlier;
+    vector<float> residuals;
+
+public:
+
+    GraphCutLabeling(const int num_neighbors, const float spatial_coherence);
+    ~GraphCutLabeling();
+
+    void invalidate_graph();
+    ///< to be called when the data changes (e.g. on a new frame), the next call rebuilds the graph
+
+    int label_inliers(const IParametricModel &model, const vector< ScoredMatch > &data_points,
+                      const float threshold, vector<bool> &is_inlier);
+    ///< minimum energy labeling of the data points for the model residuals, returns the number of inliers
+
+    int label_inliers(const IParametricModel &model, const vector< ScoredMatch > &data_points,
+                      const float threshold, vector< ScoredMatch > &inliers);
+    ///< same as above, but returns the inliers themselves
+
+private:
+
+    void build_graph(const vector< ScoredMatch > &data_points);
+
+    void solve(const vector< ScoredMatch > &data_points, const float threshold);
+    ///< computes the labeling, the inliers are the nodes left on the source side of the cut
+
+    void add_arcs(const int from, const int to, const double capacity, const double reverse_capacity);
+
+    bool compute_levels(const int source, const int sink);
+
+    double push_flow(const int node, const int sink, const double flow);
+};
+
+}
+
+#endif // GRAPH_CUT_LABELING_HEADER
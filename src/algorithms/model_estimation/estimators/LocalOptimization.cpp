@@ -0,0 +1,300 @@
+
+#include "LocalOptimization.hpp"
+
+#include "algorithms/features/ScoredMatch.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace uniclop
+{
+
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Class LocalOptimization methods implementation
+
+args::options_description LocalOptimization::get_options_description()
+{
+
+    args::options_description desc("LocalOptimization options");
+    desc.add_options()
+
+    ( "lo.max_invocations", args::value<int>()->default_value(10),
+      "maximum number of local optimizations per estimation, 0 disables them")
+
+    ( "lo.inner_iterations", args::value<int>()->default_value(10),
+      "number of non minimal samples drawn from the inliers of the new best hypothesis")
+
+    ( "lo.inner_sample_ratio", args::value<int>()->default_value(7),
+      "size of the inner samples, in minimal sample sizes (at most half of the inliers)")
+
+    ( "lo.least_squares_iterations", args::value<int>()->default_value(4),
+      "number of least squares fits done to refine each inner model")
+
+    ( "lo.threshold_multiplier", args::value<float>()->default_value(3.0f),
+      "the least squares fits start with this multiple of the inlier threshold, and end with the inlier threshold")
+
+    ( "lo.graph_cut", args::value<bool>()->default_value(false),
+      "label the inliers with a graph cut over the k nearest neighbors graph of the matches (GC-RANSAC), "
+      "the estimators then return this labeling")
+
+    ( "lo.neighbors", args::value<int>()->default_value(8),
+      "number of nearest neighbors of each match in the graph, using the feature_a positions")
+
+    ( "lo.spatial_coherence", args::value<float>()->default_value(0.14f),
+      "weight of the graph cut term that favors neighbors with the same label")
+    ;
+
+    return desc;
+}
+
+
+LocalOptimization::LocalOptimization(args::variables_map &options, const float _inlier_threshold)
+        : inlier_threshold(_inlier_threshold)
+{
+
+    max_invocations = 10;
+    inner_iterations = 10;
+    inner_sample_ratio = 7;
+    least_squares_iterations = 4;
+    threshold_multiplier = 3.0f;
+    bool use_graph_cut = false;
+    int num_neighbors = 8;
+    float spatial_coherence = 0.14f;
+
+    if (options.count("lo.max_invocations"))
+        max_invocations = options["lo.max_invocations"].as<int>();
+
+    if (options.count("lo.inner_iterations"))
+        inner_iterations = options["lo.inner_iterations"].as<int>();
+
+    if (options.count("lo.inner_sample_ratio"))
+        inner_sample_ratio = options["lo.inner_sample_ratio"].as<int>();
+
+    if (options.count("lo.least_squares_iterations"))
+        least_squares_iterations = options["lo.least_squares_iterations"].as<int>();
+
+    if (options.count("lo.threshold_multiplier"))
+        threshold_multiplier = options["lo.threshold_multiplier"].as<float>();
+
+    if (options.count("lo.graph_cut"))
+        use_graph_cut = options["lo.graph_cut"].as<bool>();
+
+    if (options.count("lo.neighbors"))
+        num_neighbors = options["lo.neighbors"].as<int>();
+
+    if (options.count("lo.spatial_coherence"))
+        spatial_coherence = options["lo.spatial_coherence"].as<float>();
+
+    if (max_invocations < 0 || inner_iterations < 0 || least_squares_iterations < 1)
+        throw runtime_error("LocalOptimization expects lo.max_invocations >= 0, lo.inner_iterations >= 0 "
+                            "and lo.least_squares_iterations >= 1");
+
+    if (inner_sample_ratio < 2)
+        throw runtime_error("LocalOptimization expects lo.inner_sample_ratio to be at least 2 (non minimal samples)");
+
+    if (threshold_multiplier < 1)
+        throw runtime_error("LocalOptimization expects lo.threshold_multiplier to be at least 1");
+
+    if (use_graph_cut)
+        graph_cut_p.reset(new GraphCutLabeling(num_neighbors, spatial_coherence));
+
+    reset();
+    return;
+}
+
+LocalOptimization::~LocalOptimization()
+{
+    return;
+}
+
+
+void LocalOptimization::reset()
+{
+    num_invocations = 0;
+    num_residuals_evaluated = 0;
+
+    // the data of the new estimation has other positions, the graph is built again on first use
+    if (graph_cut_p)
+        graph_cut_p->invalidate_graph();
+    return;
+}
+
+bool LocalOptimization::is_available() const
+{
+    return num_invocations < max_invocations;
+}
+
+
+int LocalOptimization::count_inliers(const IParametricModel &model, const vector< ScoredMatch > &data_points,
+                                     const float threshold, vector< ScoredMatch > *inliers_p)
+{
+    model.compute_residuals(data_points, residuals);
+    num_residuals_evaluated += static_cast<long>(data_points.size());
+
+    if (inliers_p)
+        inliers_p->clear();
+
+    int num_inliers = 0;
+    unsigned int i;
+    for (i=0; i < residuals.size(); i+=1)
+    {
+        if (residuals[i] < threshold)
+        {
+            num_inliers += 1;
+            if (inliers_p)
+                inliers_p->push_back(data_points[i]);
+        }
+    }
+
+    return num_inliers;
+}
+
+
+int LocalOptimization::select_inliers(const IParametricModel &model, const vector< ScoredMatch > &data_points,
+                                      const float threshold, vector< ScoredMatch > &selected_inliers)
+{
+    if (graph_cut_p)
+    {
+        num_residuals_evaluated += static_cast<long>(data_points.size());
+        return graph_cut_p->label_inliers(model, data_points, threshold, selected_inliers);
+    }
+
+    return count_inliers(model, data_points, threshold, &selected_inliers);
+}
+
+
+bool LocalOptimization::refine(IParametricModel &model, const vector< ScoredMatch > &data_points)
+{
+    const unsigned int m = model.get_num_points_to_estimate();
+
+    // the threshold decreases linearly from threshold_multiplier * inlier_threshold to inlier_threshold,
+    // the wide first threshold lets the model move away from the bias of its sample
+    int i;
+    for (i=0; i < least_squares_iterations; i+=1)
+    {
+        float threshold = inlier_threshold;
+        if (least_squares_iterations > 1)
+            threshold *= threshold_multiplier -
+                         (threshold_multiplier - 1) * static_cast<float>(i) / (least_squares_iterations - 1);
+
+        select_inliers(model, data_points, threshold, least_squares_inliers);
+        if (least_squares_inliers.size() <= m)
+            break; // not enough support for a least squares fit, the model is kept as is
+
+        try
+        {
+            model.estimate(least_squares_inliers);
+        }
+        catch (runtime_error &)
+        {
+            return false; // degenerate inliers set
+        }
+    }
+
+    return true;
+}
+
+
+bool LocalOptimization::optimize(IParametricModel &model, const vector< ScoredMatch > &data_points, int &num_inliers)
+{
+    if (is_available() == false)
+        return false;
+
+    num_invocations += 1;
+
+    const int m = model.get_num_points_to_estimate();
+
+    start_parameters = model.get_parameters();
+    best_parameters = start_parameters;
+    int best_num_inliers = num_inliers;
+
+    // the inner samples are drawn from the inliers of the hypothesis
+    const int num_hypothesis_inliers = select_inliers(model, data_points, inlier_threshold, inliers);
+    const int sample_size = min(inner_sample_ratio * m, num_hypothesis_inliers / 2);
+
+    sample_indices.resize(num_hypothesis_inliers);
+    int i;
+    for (i=0; i < num_hypothesis_inliers; i+=1)
+        sample_indices[i] = i;
+
+    // the first candidate is the hypothesis itself, refined,
+    // the next ones are the inner samples models (when there are enough inliers to draw non minimal samples)
+    const int num_candidates = 1 + ((sample_size > m) ? inner_iterations : 0);
+    int k;
+    for (k=0; k < num_candidates; k+=1)
+    {
+        model.set_parameters(start_parameters);
+
+        if (k > 0)
+        {
+            // partial Fisher-Yates shuffle, the sample is the first sample_size indices
+            sample.resize(sample_size);
+            for (i=0; i < sample_size; i+=1)
+            {
+                boost::uniform_int<int> uniform_index(i, num_hypothesis_inliers - 1);
+                swap(sample_indices[i], sample_indices[uniform_index(random_generator)]);
+                sample[i] = inliers[sample_indices[i]];
+            }
+
+            try
+            {
+                model.estimate(sample);
+            }
+            catch (runtime_error &)
+            {
+                continue; // degenerate sample
+            }
+        }
+
+        if (refine(model, data_points) == false)
+            continue;
+
+        const int candidate_num_inliers = count_inliers(model, data_points, inlier_threshold, NULL);
+        if (candidate_num_inliers > best_num_inliers)
+        {
+            best_num_inliers = candidate_num_inliers;
+            best_parameters = model.get_parameters();
+        }
+    }
+
+    model.set_parameters(best_parameters);
+
+    if (best_num_inliers > num_inliers)
+    {
+        num_inliers = best_num_inliers;
+        return true;
+    }
+
+    return false;
+}
+
+
+bool LocalOptimization::uses_graph_cut() const
+{
+    return graph_cut_p.get() != NULL;
+}
+
+int LocalOptimization::label_inliers(const IParametricModel &model, const vector< ScoredMatch > &data_points,
+                                     vector<bool> &is_inlier)
+{
+    if (graph_cut_p.get() == NULL)
+        throw runtime_error("LocalOptimization::label_inliers requires lo.graph_cut");
+
+    num_residuals_evaluated += static_cast<long>(data_points.size());
+    return graph_cut_p->label_inliers(model, data_points, inlier_threshold, is_inlier);
+}
+
+
+int LocalOptimization::get_num_invocations() const
+{
+    return num_invocations;
+}
+
+long LocalOptimization::get_num_residuals_evaluated() const
+{
+    return num_residuals_evaluated;
+}
+
+
+} // end of namespace uniclop
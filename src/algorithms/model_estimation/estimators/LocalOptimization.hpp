@@ -0,0 +1,97 @@
+#if !defined(LOCAL_OPTIMIZATION_HEADER)
+#define LOCAL_OPTIMIZATION_HEADER
+
+// LocalOptimization, the LO step of LO-RANSAC
+// O. Chum, J. Matas and J. Kittler "Locally Optimized RANSAC", DAGM 2003
+// K. Lebeda, J. Matas and O. Chum "Fixing the Locally Optimized RANSAC", BMVC 2012
+// D. Barath and J. Matas "Graph-Cut RANSAC", CVPR 2018 (optional spatially coherent labeling)
+
+
+#include "../IParametricModel.hpp"
+#include "GraphCutLabeling.hpp"
+
+#include <boost/random.hpp>
+#include <boost/program_options.hpp>
+#include <boost/scoped_ptr.hpp>
+
+
+namespace uniclop
+{
+
+namespace args = ::boost::program_options;
+
+class ScoredMatch;
+
+class LocalOptimization
+{ // called by the estimators each time they find a new best hypothesis:
+  // an inner RANSAC draws non minimal samples from the inliers of the hypothesis,
+  // each sample model is then refined by least squares (IParametricModel::estimate)
+  // on the inliers of a threshold that shrinks down to the inlier threshold.
+  // With lo.graph_cut the inliers used to sample and to fit are labeled by a graph cut
+  // over the matches neighborhood graph instead of being thresholded independently
+
+    float inlier_threshold; ///< maximum residual of an inlier, in the model residuals units
+    int max_invocations; ///< per estimation, bounds the latency (0 disables the local optimization)
+    int inner_iterations; ///< number of non minimal samples drawn from the inliers
+    int inner_sample_ratio; ///< size of the inner samples, in minimal sample sizes
+    int least_squares_iterations; ///< number of least squares fits of the iterative refinement
+    float threshold_multiplier; ///< the iterative refinement starts with threshold_multiplier * inlier_threshold
+
+    boost::scoped_ptr<GraphCutLabeling> graph_cut_p; ///< NULL when the inliers are thresholded
+
+    int num_invocations;
+    long num_residuals_evaluated;
+
+    boost::mt19937 random_generator; // pseudo-random number generators
+
+    // internal buffers, reused between calls
+    vector<float> residuals;
+    vector< ScoredMatch > inliers, least_squares_inliers, sample;
+    vector<int> sample_indices;
+    ublas::vector<float> best_parameters, start_parameters;
+
+public:
+
+    static args::options_description get_options_description();
+
+    LocalOptimization(args::variables_map &options, const float inlier_threshold);
+    ~LocalOptimization();
+
+    void reset();
+    ///< to be called at the start of each estimation, resets the invocations and residuals counters
+
+    bool is_available() const;
+    ///< false when disabled or when the invocations budget of the current estimation is spent
+
+    bool optimize(IParametricModel &model, const vector< ScoredMatch > &data_points, int &num_inliers);
+    ///< the model holds a hypothesis with num_inliers inliers,
+    ///< returns true when a model with more inliers was found, the model and num_inliers are then updated
+
+    bool uses_graph_cut() const;
+
+    int label_inliers(const IParametricModel &model, const vector< ScoredMatch > &data_points, vector<bool> &is_inlier);
+    ///< graph cut labeling of the inliers of the model, returns the number of inliers
+    ///< (only available when uses_graph_cut is true)
+
+    int get_num_invocations() const;
+    ///< number of calls to optimize since the last reset
+
+    long get_num_residuals_evaluated() const;
+    ///< number of residuals computed since the last reset
+
+private:
+
+    int count_inliers(const IParametricModel &model, const vector< ScoredMatch > &data_points,
+                      const float threshold, vector< ScoredMatch > *inliers_p);
+
+    int select_inliers(const IParametricModel &model, const vector< ScoredMatch > &data_points,
+                       const float threshold, vector< ScoredMatch > &selected_inliers);
+    ///< thresholded or graph cut inliers, depending on the mode
+
+    bool refine(IParametricModel &model, const vector< ScoredMatch > &data_points);
+    ///< iterative least squares, returns false if an estimation failed
+};
+
+}
+
+#endif // LOCAL_OPTIMIZATION_HEADER
@@ -4,6 +4,11 @@
 #include "algorithms/features/ScoredMatch.hpp"
 #include "algorithms/features/fast/FASTFeature.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <iostream>
 
 namespace uniclop
 {
@@ -18,17 +23,78 @@ namespace uniclop
     args::options_description desc("PROSAC options");
     desc.add_options()
 
-    /* ( "blur_sigma,b", args::value<double>()->default_value(1.0f),
-       "defines a bluring level for images") */
+    ( "prosac.inlier_threshold", args::value<float>()->default_value(1.0f),
+      "maximum residual for a match to be considered an inlier")
+
+    ( "prosac.confidence", args::value<float>()->default_value(0.99f),
+      "probability of not missing a better solution when stopping (maximality criterion)")
+
+    ( "prosac.max_iterations", args::value<int>()->default_value(20000),
+      "maximum number of samples drawn per estimation, after these PROSAC behaves as RANSAC")
+
+    ( "prosac.beta", args::value<float>()->default_value(0.05f),
+      "probability that a match is consistent with a wrong model (non-randomness criterion)")
+
+    ( "prosac.psi", args::value<float>()->default_value(0.05f),
+      "probability that the selected solution support is due to chance (non-randomness criterion)")
+
+    ( "prosac.min_stopping_length", args::value<int>()->default_value(20),
+      "minimum number of top ranked matches used to decide when to stop sampling")
+
+    ( "prosac.trace_level", args::value<int>()->default_value(0),
+      "debugging verbosity")
     ;
 
     return desc;
 }
 
 
-PROSAC::PROSAC(args::variables_map &options, IParametricModel &)
+PROSAC::PROSAC(args::variables_map &options, IParametricModel &_model)
+        : model(_model)
 {
-    throw runtime_error("PROSAC model estimation is not yet implemented");
+
+    inlier_threshold = 1.0f;
+    confidence = 0.99f;
+    max_iterations = 20000;
+    beta = 0.05f;
+    psi = 0.05f;
+    min_stopping_length = 20;
+    trace_level = 0;
+
+    if (options.count("prosac.inlier_threshold"))
+        inlier_threshold = options["prosac.inlier_threshold"].as<float>();
+
+    if (options.count("prosac.confidence"))
+        confidence = options["prosac.confidence"].as<float>();
+
+    if (options.count("prosac.max_iterations"))
+        max_iterations = options["prosac.max_iterations"].as<int>();
+
+    if (options.count("prosac.beta"))
+        beta = options["prosac.beta"].as<float>();
+
+    if (options.count("prosac.psi"))
+        psi = options["prosac.psi"].as<float>();
+
+    if (options.count("prosac.min_stopping_length"))
+        min_stopping_length = options["prosac.min_stopping_length"].as<int>();
+
+    if (options.count("prosac.trace_level"))
+        trace_level = options["prosac.trace_level"].as<int>();
+
+    if (confidence <= 0 || confidence >= 1)
+        throw runtime_error("PROSAC expects prosac.confidence to be in the range (0, 1)");
+
+    if (beta <= 0 || beta >= 1 || psi <= 0 || psi >= 1)
+        throw runtime_error("PROSAC expects prosac.beta and prosac.psi to be in the range (0, 1)");
+
+    if (max_iterations < 1)
+        throw runtime_error("PROSAC expects prosac.max_iterations to be strictly positive");
+
+    num_hypotheses_tested = 0;
+    num_residuals_evaluated = 0;
+
+    local_optimization_p.reset(new LocalOptimization(options, inlier_threshold));
     return;
 }
 
@@ -37,15 +103,347 @@ PROSAC::~PROSAC()
     return;
 }
 
-const ublas::vector<float> &PROSAC::estimate_model_parameters(const vector< ScoredMatch > &)
+
+// helper functor used to rank the matches, the best matches (smallest distance) come first
+class MatchesRankingOrder
 {
-    return estimated_model_parameters;
+    const vector< ScoredMatch > &matches;
+public:
+    MatchesRankingOrder(const vector< ScoredMatch > &_matches)
+            : matches(_matches)
+    {
+        return;
+    }
+
+    bool operator()(const int a, const int b) const
+    {
+        if (matches[a].distance != matches[b].distance)
+            return matches[a].distance < matches[b].distance;
+        return a < b; // ties are broken by index, so that the ranking is deterministic
+    }
+};
+
+
+void PROSAC::sort_matches(const vector< ScoredMatch > &matches)
+{
+    const int num_matches = static_cast<int>(matches.size());
+
+    sorted_indices.resize(num_matches);
+    int i;
+    for (i=0; i < num_matches; i+=1)
+        sorted_indices[i] = i;
+
+    sort(sorted_indices.begin(), sorted_indices.end(), MatchesRankingOrder(matches));
+
+    sorted_matches.resize(num_matches);
+    for (i=0; i < num_matches; i+=1)
+        sorted_matches[i] = matches[sorted_indices[i]];
+
+    return;
+}
+
+
+void PROSAC::update_min_inliers(const int num_matches)
+{
+    // I_n^min is the smallest support such that the probability of a wrong model
+    // being supported by I_n^min matches or more among the top n is below psi.
+    // The support of a wrong model, beyond the m sample matches, follows a
+    // binomial distribution B(n - m, beta) (equation 7 of the paper)
+
+    const int m = model.get_num_points_to_estimate();
+    if (static_cast<int>(min_inliers.size()) > num_matches)
+        return; // already computed
+
+    const int first_n = static_cast<int>(min_inliers.size());
+    min_inliers.resize(num_matches + 1);
+
+    const double log_beta = log(static_cast<double>(beta));
+    const double log_one_minus_beta = log(1.0 - beta);
+
+    int n;
+    for (n = first_n; n <= num_matches; n+=1)
+    {
+        if (n <= m)
+        {
+            min_inliers[n] = m;
+            continue;
+        }
+
+        const int trials = n - m;
+        double cdf = 0; // P(X < j)
+        double log_pmf = trials * log_one_minus_beta; // log P(X = 0)
+        int j = 0;
+        while ( j < trials && (1.0 - cdf) >= psi)
+        {
+            cdf += exp(log_pmf);
+            log_pmf += log(static_cast<double>(trials - j) / (j + 1)) + log_beta - log_one_minus_beta;
+            j += 1;
+        }
+        min_inliers[n] = m + j;
+    }
+
+    return;
+}
+
+
+void PROSAC::draw_sample(const int n, const bool include_last)
+{
+    const int m = model.get_num_points_to_estimate();
+    const int num_random = include_last ? (m - 1) : m;
+    const int range = include_last ? (n - 1) : n;
+
+    boost::uniform_int<int> uniform_index(0, range - 1);
+
+    minimal_set.resize(m);
+
+    // m is small, checking the previously selected indices is cheap
+    int selected_indices[16];
+    if (m > 16)
+        throw runtime_error("PROSAC::draw_sample only supports models with up to 16 points per sample");
+
+    int i = 0;
+    while (i < num_random)
+    {
+        const int index = uniform_index(random_generator);
+        bool already_selected = false;
+        int j;
+        for (j=0; j < i; j+=1)
+            already_selected = already_selected || (selected_indices[j] == index);
+
+        if (already_selected) continue;
+
+        selected_indices[i] = index;
+        minimal_set[i] = sorted_matches[index];
+        i += 1;
+    }
+
+    if (include_last)
+        minimal_set[m - 1] = sorted_matches[n - 1];
+
+    return;
 }
 
+
+int PROSAC::count_inliers() const
+{
+    int num_inliers = 0;
+    vector<float>::const_iterator residuals_it;
+    for (residuals_it = residuals.begin(); residuals_it != residuals.end(); ++residuals_it)
+        num_inliers += (*residuals_it < inlier_threshold) ? 1 : 0;
+    return num_inliers;
+}
+
+
+int PROSAC::verify_hypotheses(const int num_hypotheses)
+{
+    const int num_matches = static_cast<int>(sorted_matches.size());
+    num_residuals_evaluated += static_cast<long>(num_matches) * num_hypotheses;
+
+    if (num_hypotheses == 1)
+    {
+        model.compute_residuals(sorted_matches, residuals);
+        return count_inliers();
+    }
+
+    // each match is read once for all the hypotheses
+    hypotheses_residuals.resize(num_matches * num_hypotheses);
+    hypotheses_num_inliers.assign(num_hypotheses, 0);
+    int i, h;
+    for (i=0; i < num_matches; i+=1)
+    {
+        float *match_residuals = &hypotheses_residuals[num_hypotheses * i];
+        model.compute_hypotheses_residual(sorted_matches[i], match_residuals);
+        for (h=0; h < num_hypotheses; h+=1)
+            hypotheses_num_inliers[h] += (match_residuals[h] < inlier_threshold) ? 1 : 0;
+    }
+
+    int best_hypothesis = 0;
+    for (h=1; h < num_hypotheses; h+=1)
+    {
+        if (hypotheses_num_inliers[h] > hypotheses_num_inliers[best_hypothesis])
+            best_hypothesis = h;
+    }
+
+    model.select_hypothesis(best_hypothesis);
+    residuals.resize(num_matches);
+    for (i=0; i < num_matches; i+=1)
+        residuals[i] = hypotheses_residuals[num_hypotheses * i + best_hypothesis];
+
+    return hypotheses_num_inliers[best_hypothesis];
+}
+
+
+int PROSAC::update_stopping_length(int &n_star) const
+{
+    // residuals are the ones of the current best model, in ranking order
+    const int m = model.get_num_points_to_estimate();
+    const int num_matches = static_cast<int>(residuals.size());
+    const double log_eta0 = log(1.0 - confidence);
+
+    int k_n_star = max_iterations;
+    int inliers_n = 0; // I_n, inliers among the top n matches
+
+    int n;
+    for (n=1; n <= num_matches; n+=1)
+    {
+        inliers_n += (residuals[n - 1] < inlier_threshold) ? 1 : 0;
+
+        if (n < max(m, min_stopping_length) || inliers_n < min_inliers[n])
+            continue; // non-randomness is not satisfied
+
+        // maximality, equation 8 of the paper
+        const double probability_all_inliers = pow(static_cast<double>(inliers_n) / n, m);
+        int k_n = 1;
+        if (probability_all_inliers < 1)
+        {
+            const double t_k_n = ceil(log_eta0 / log(1.0 - probability_all_inliers));
+            k_n = static_cast<int>(min(t_k_n, static_cast<double>(max_iterations)));
+        }
+
+        if (k_n < k_n_star)
+        {
+            k_n_star = k_n;
+            n_star = n;
+        }
+    }
+
+    return k_n_star;
+}
+
+
+const ublas::vector<float> &PROSAC::estimate_model_parameters(const vector< ScoredMatch > &matches)
+{
+    const int m = model.get_num_points_to_estimate();
+    const int num_matches = static_cast<int>(matches.size());
+
+    if (num_matches < m)
+        throw runtime_error("PROSAC::estimate_model_parameters received not enough input data");
+
+    if (have_features(matches) == false)
+        throw runtime_error("PROSAC::estimate_model_parameters requires matches with feature pointers, not only indexes");
+
+    sort_matches(matches);
+    update_min_inliers(num_matches);
+    num_residuals_evaluated = 0;
+    local_optimization_p->reset();
+
+    // T_n, average number of samples containing only matches from the top n,
+    // starts as T_m = T_N * binomial(m, m) / binomial(N, m)
+    double t_n = max_iterations;
+    int i;
+    for (i=0; i < m; i+=1)
+        t_n *= static_cast<double>(m - i) / (num_matches - i);
+
+    int t_n_prime = 1; // T'_n, the growth function
+    int n = m; // size of the current sampling set
+    int n_star = num_matches; // termination length
+    int k_n_star = max_iterations; // number of samples required for termination
+
+    int best_num_inliers = -1;
+
+    int t = 0;
+    for (t = 0; t < k_n_star && t < max_iterations; )
+    {
+        t += 1;
+
+        // choice of the hypothesis generation set
+        if (t > t_n_prime && n < n_star)
+        {
+            const double t_n_next = (t_n * (n + 1)) / (n + 1 - m);
+            t_n_prime += static_cast<int>(ceil(t_n_next - t_n));
+            t_n = t_n_next;
+            n += 1;
+        }
+
+        // semi-random sample of size m
+        // once T'_n < t the sampling set is not growing anymore and PROSAC draws as RANSAC
+        draw_sample(n, t_n_prime >= t);
+
+        int num_hypotheses = 0;
+        try
+        {
+            num_hypotheses = model.estimate_hypotheses_from_minimal_set(minimal_set);
+        }
+        catch (runtime_error &)
+        {
+            continue; // degenerate sample
+        }
+
+        if (num_hypotheses == 0)
+            continue;
+
+        // model verification
+        const int num_inliers = verify_hypotheses(num_hypotheses);
+
+        if (num_inliers > best_num_inliers)
+        {
+            best_num_inliers = num_inliers;
+            const bool is_corrected =
+                model.correct_degenerate_sample(minimal_set, sorted_matches, inlier_threshold, best_num_inliers);
+            if (is_corrected)
+                num_residuals_evaluated += num_matches;
+
+            if (local_optimization_p->optimize(model, sorted_matches, best_num_inliers) || is_corrected)
+            { // the stopping length needs the residuals of the optimized model
+                model.compute_residuals(sorted_matches, residuals);
+                num_residuals_evaluated += num_matches;
+            }
+
+            best_model_parameters = model.get_parameters();
+            k_n_star = update_stopping_length(n_star);
+        }
+    }
+
+    num_hypotheses_tested = t;
+    num_residuals_evaluated += local_optimization_p->get_num_residuals_evaluated();
+
+    // retrieve the estimated parameters and the inliers --
+    is_inlier.resize(num_matches);
+    if (best_num_inliers < 0)
+    {
+        if (trace_level > 0)
+            cout << "PROSAC::estimate_model_parameters did not find any valid model" << endl;
+        fill(is_inlier.begin(), is_inlier.end(), false);
+        estimated_model_parameters.resize(model.get_num_parameters());
+        fill(estimated_model_parameters.begin(), estimated_model_parameters.end(), 0.0f);
+        return estimated_model_parameters;
+    }
+
+    model.set_parameters(best_model_parameters);
+    if (local_optimization_p->uses_graph_cut())
+    { // spatially coherent inliers, labeled on sorted_matches so the graph of the local optimization is reused
+        local_optimization_p->label_inliers(model, sorted_matches, sorted_is_inlier);
+        num_residuals_evaluated += num_matches;
+        for (i=0; i < num_matches; i+=1)
+            is_inlier[sorted_indices[i]] = sorted_is_inlier[i];
+    }
+    else
+    {
+        model.compute_residuals(sorted_matches, residuals);
+        for (i=0; i < num_matches; i+=1)
+            is_inlier[sorted_indices[i]] = (residuals[i] < inlier_threshold);
+    }
+
+    estimated_model_parameters = best_model_parameters;
+    return estimated_model_parameters;
+
+} // end of 'PROSAC::estimate_model_parameters'
+
+
 const vector< bool > &  PROSAC::get_is_inlier()
 {
     return is_inlier;
 }
 
+int PROSAC::get_num_hypotheses_tested() const
+{
+    return num_hypotheses_tested;
+}
+
+long PROSAC::get_num_residuals_evaluated() const
+{
+    return num_residuals_evaluated;
+}
+
 
-}
\ No newline at end of file
+} // end of namespace uniclop
@@ -14,8 +14,11 @@ A new robust matching method is proposed. The Progressive Sample Consensus (PROS
 
 #include "../IModelEstimator.hpp"
 #include "../IParametricModel.hpp"
+#include "LocalOptimization.hpp"
 
+#include <boost/random.hpp>
 #include <boost/program_options.hpp>
+#include <boost/scoped_ptr.hpp>
 
 
 namespace uniclop
@@ -23,12 +26,43 @@ namespace uniclop
 	
 namespace args = ::boost::program_options;
 
+class ScoredMatch;
 
 class PROSAC: public IModelEstimator
 { // given a model and list of scorematches will estimate the best parameters of the model
+  // based on O. Chum and J. Matas "Matching with PROSAC - Progressive Sample Consensus", CVPR 2005
 
     ublas::vector<float> estimated_model_parameters;
     vector<bool> is_inlier;
+
+    IParametricModel &model;
+
+    // prosac algorithm parameters
+    float inlier_threshold; ///< maximum residual of an inlier, in the model residuals units
+    float confidence; ///< 1 - eta0, probability of not missing a better solution (maximality)
+    int max_iterations; ///< T_N, number of samples after which PROSAC behaves as RANSAC
+    float beta; ///< probability that a match is supported by a wrong model (non-randomness)
+    float psi; ///< probability that the selected solution is supported by chance (non-randomness)
+    int min_stopping_length; ///< smallest n* considered, very short prefixes are trivially consistent
+    int trace_level;
+
+    int num_hypotheses_tested;
+    long num_residuals_evaluated;
+
+    boost::mt19937 random_generator; // pseudo-random number generators
+
+    boost::scoped_ptr<LocalOptimization> local_optimization_p; ///< run on each new best model
+
+    // internal buffers, reused between calls
+    vector<int> sorted_indices;
+    vector< ScoredMatch > sorted_matches, minimal_set;
+    vector<bool> sorted_is_inlier;
+    vector<float> residuals;
+    vector<float> hypotheses_residuals; ///< residuals of all the hypotheses of a sample, interleaved per match
+    vector<int> hypotheses_num_inliers;
+    vector<int> min_inliers; ///< I_n^min, minimal support of a non random solution, for each n
+    ublas::vector<float> best_model_parameters;
+
 public:
 
     static args::options_description get_options_description();
@@ -40,6 +74,33 @@ public:
     const ublas::vector<float> &estimate_model_parameters(const vector< ScoredMatch > &);
 
     const vector< bool > & get_is_inlier();
+
+    int get_num_hypotheses_tested() const;
+    ///< number of minimal samples drawn by the last call to estimate_model_parameters
+
+    long get_num_residuals_evaluated() const;
+    ///< number of residuals computed to verify the hypotheses in the last call to estimate_model_parameters
+
+private:
+
+    void sort_matches(const vector< ScoredMatch > &matches);
+
+    void draw_sample(const int n, const bool include_last);
+    ///< fill minimal_set with random matches among the n top ranked ones,
+    ///< when include_last is true the n-th match is part of the sample
+
+    void update_min_inliers(const int num_matches);
+
+    int count_inliers() const;
+
+    int verify_hypotheses(const int num_hypotheses);
+    ///< scores the hypotheses of the last sample on all the matches, in one pass,
+    ///< selects the best one in the model and leaves its residuals in the residuals buffer.
+    ///< Returns its number of inliers
+
+    int update_stopping_length(int &n_star) const;
+    ///< maximality and non-randomness: select the n* that minimizes the number of
+    ///< samples needed, returns k_n*
 };
 
 }
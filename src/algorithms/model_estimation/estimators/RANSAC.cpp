@@ -4,30 +4,19 @@
 
 #include "algorithms/features/ScoredMatch.hpp"
 #include "algorithms/features/fast/FASTFeature.hpp"
-
-#include "algorithms/model_estimation/models/HomographyModel.hpp"
-#include "algorithms/model_estimation/models/FundamentalMatrixModel.hpp"
-
-// Boost http://boost.org
-#include <boost/numeric/ublas/io.hpp>
-#include <boost/tuple/tuple.hpp>
 
-// RANSAC implementation requires VXL installed
-// with the RREL and GEL/vpgl contributions
+#include "StandardVerifier.hpp"
+#include "TddVerifier.hpp"
+#include "SPRTVerifier.hpp"
 
-#include <vxl/vcl/vcl_iostream.h>
-
-#include <vxl/core/vnl/vnl_math.h>
-
-#include <vxl/core/vgl/algo/vgl_homg_operators_2d.h>
+#include "helpers/ThreadPool.hpp"
 
-#include <vxl/contrib/rpl/rrel/rrel_muset_obj.h>
-#include <vxl/contrib/rpl/rrel/rrel_ran_sam_search.h>
-#include <vxl/contrib/rpl/rrel/rrel_homography2d_est.h>
+#include <boost/bind.hpp>
 
-#include <vxl/contrib/gel/mrc/vpgl/vpgl_fundamental_matrix.h>
-#include <vxl/contrib/gel/mrc/vpgl/algo/vpgl_fm_compute_ransac.h>
-#include <vxl/contrib/gel/mrc/vpgl/algo/vpgl_fm_compute_8_point.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <iostream>
 
 namespace uniclop
 {
@@ -41,8 +30,26 @@ args::options_description RANSAC::get_options_description()
     args::options_description desc("RANSAC options");
     desc.add_options()
 
+    ( "ransac.inlier_threshold", args::value<float>()->default_value(1.0f),
+      "maximum residual for a match to be considered an inlier")
+
     ( "ransac.outliers_fraction", args::value<float>()->default_value(0.9f),
-      "percent of outliers in the data")
+      "percent of outliers in the data, upper bound used before a model is found")
+
+    ( "ransac.confidence", args::value<float>()->default_value(0.99f),
+      "probability of drawing at least one sample free of outliers")
+
+    ( "ransac.max_iterations", args::value<int>()->default_value(20000),
+      "maximum number of samples drawn per estimation")
+
+    ( "ransac.preverification", args::value<string>()->default_value("none"),
+      "test used to reject the bad hypotheses before evaluating them on all the matches: none, Tdd or SPRT")
+
+    ( "ransac.threads", args::value<int>()->default_value(1),
+      "number of threads used to draw and score the samples")
+
+    ( "ransac.random_seed", args::value<int>()->default_value(0),
+      "seed of the samples generator, results are reproducible for a given seed and number of threads")
 
     ( "ransac.trace_level", args::value<int>()->default_value(0),
       "debugging verbosity")
@@ -53,28 +60,101 @@ args::options_description RANSAC::get_options_description()
 
 
 
-RANSAC::RANSAC(args::variables_map &options, IParametricModel &model)
-        :outlier_thresh_(1),max_outlier_frac_(0.9),
-        desired_prob_good_(0.99), max_pops_(1), gen_all_(false), trace_level_(0)
+RANSAC::RANSAC(args::variables_map &options, IParametricModel &_model)
+        : model(_model)
 {
 
+    inlier_threshold = 1.0f;
+    max_outliers_fraction = 0.9f;
+    confidence = 0.99f;
+    max_iterations = 20000;
+    samples_per_round = 16;
+    trace_level = 0;
+
+    int num_threads = 1, random_seed = 0;
+    string preverification = "none";
+
+    if (options.count("ransac.inlier_threshold"))
+        inlier_threshold = options["ransac.inlier_threshold"].as<float>();
+
     if (options.count("ransac.outliers_fraction"))
-        max_outlier_frac_ = options["ransac.outliers_fraction"].as<float>();
+        max_outliers_fraction = options["ransac.outliers_fraction"].as<float>();
+
+    if (options.count("ransac.confidence"))
+        confidence = options["ransac.confidence"].as<float>();
+
+    if (options.count("ransac.max_iterations"))
+        max_iterations = options["ransac.max_iterations"].as<int>();
+
+    if (options.count("ransac.preverification"))
+        preverification = options["ransac.preverification"].as<string>();
+
+    if (options.count("ransac.threads"))
+        num_threads = options["ransac.threads"].as<int>();
+
+    if (options.count("ransac.random_seed"))
+        random_seed = options["ransac.random_seed"].as<int>();
 
     if (options.count("ransac.trace_level"))
-        trace_level_ = options["ransac.trace_level"].as<int>();
+        trace_level = options["ransac.trace_level"].as<int>();
+
+    if (confidence <= 0 || confidence >= 1)
+        throw runtime_error("RANSAC expects ransac.confidence to be in the range (0, 1)");
+
+    if (max_outliers_fraction < 0 || max_outliers_fraction >= 1)
+        throw runtime_error("RANSAC expects ransac.outliers_fraction to be in the range [0, 1)");
+
+    if (max_iterations < 1)
+        throw runtime_error("RANSAC expects ransac.max_iterations to be strictly positive");
+
+    num_hypotheses_tested = 0;
+    num_residuals_evaluated = 0;
+    matches_p = NULL;
+    best_num_inliers = -1;
+
+    boost::shared_ptr<IHypothesisVerifier> verifier_p;
+    if (preverification == "none")
+        verifier_p.reset(new StandardVerifier(inlier_threshold));
+    else if (preverification == "Tdd")
+        verifier_p.reset(new TddVerifier(options, inlier_threshold));
+    else if (preverification == "SPRT")
+        verifier_p.reset(new SPRTVerifier(options, inlier_threshold));
+    else
+        throw runtime_error("RANSAC received an unknown ransac.preverification value");
 
-    FundamentalMatrixModel *fundamental_matrix_p = NULL;
-    fundamental_matrix_p = dynamic_cast< FundamentalMatrixModel* >(&model);
-    use_fundamental_matrix_model = (fundamental_matrix_p != NULL);
+    local_optimization_p.reset(new LocalOptimization(options, inlier_threshold));
 
-    HomographyModel *homography_p = NULL;
-    homography_p = dynamic_cast< HomographyModel* >(&model);
-    use_homography_model = (homography_p != NULL);
+    // the buffers that only depend on the model are sized once
+    best_model_parameters.resize(model.get_num_parameters());
 
-    if (!use_fundamental_matrix_model && !use_homography_model)
-        throw runtime_error("Current implementation of RANSAC only "\
-                            "supports the fundamental_matrix model and the homography model");
+    // each worker has its own model and its own random stream,
+    // seeded from the worker index so that the results are reproducible
+    num_threads = max(1, num_threads);
+    workers.resize(num_threads);
+    int w;
+    for (w=0; w < num_threads; w+=1)
+    {
+        Worker &worker = workers[w];
+        if (w == 0)
+            worker.model_p = &model;
+        else
+        {
+            worker.model_clone_p.reset(model.clone());
+            worker.model_p = worker.model_clone_p.get();
+        }
+        worker.random_generator.seed(static_cast<boost::uint32_t>(random_seed + w));
+        if (w == 0)
+            worker.verifier_p = verifier_p;
+        else
+            worker.verifier_p.reset(verifier_p->clone());
+        worker.minimal_set.resize(model.get_num_points_to_estimate());
+        worker.best_model_parameters.resize(model.get_num_parameters());
+        worker.num_samples = 0;
+        worker.best_num_inliers = -1;
+    }
+
+    if (num_threads > 1)
+        thread_pool_p.reset(new ThreadPool(num_threads));
 
     return;
 }
@@ -86,125 +166,234 @@ RANSAC::~RANSAC()
 }
 
 
-
-const ublas::vector<float> &  RANSAC::estimate_model_parameters(const vector< ScoredMatch > &matches)
+int RANSAC::compute_num_iterations(const double inliers_fraction) const
 {
+    const int m = model.get_num_points_to_estimate();
 
+    // a good sample is only found if its model also passes the verification,
+    // the most pessimistic worker is used so that all the workers agree
+    double acceptance_probability = 1.0;
+    int w;
+    for (w=0; w < static_cast<int>(workers.size()); w+=1)
+        acceptance_probability = min(acceptance_probability, workers[w].verifier_p->get_acceptance_probability());
 
-    vcl_vector< vgl_point_2d<double> > from_features;
-    vcl_vector< vgl_point_2d<double> > to_features;
+    const double probability_good_sample = pow(inliers_fraction, m) * acceptance_probability;
 
-    vcl_vector< vgl_homg_point_2d<double> > from_features_hp;
-    vcl_vector< vgl_homg_point_2d<double> > to_features_hp;
+    if (probability_good_sample >= 1)
+        return 1;
 
-    vgl_point_2d<double> t_vgl_point_2d;
-    vector< ScoredMatch >::const_iterator matches_it;
+    if (probability_good_sample <= 0)
+        return max_iterations;
 
-    for (matches_it = matches.begin(); matches_it != matches.end(); ++matches_it)
-    {
-        // we suppose that the datatype T is a ScoredMatch
-        t_vgl_point_2d.set(matches_it->feature_a->x, matches_it->feature_a->y);
-        from_features.push_back(t_vgl_point_2d);
-        from_features_hp.push_back(vgl_homg_point_2d<double>(t_vgl_point_2d));
-
-        t_vgl_point_2d.set(matches_it->feature_b->x, matches_it->feature_b->y);
-        to_features.push_back(t_vgl_point_2d);
-        to_features_hp.push_back(vgl_homg_point_2d<double>(t_vgl_point_2d));
-    }
+    const double num_iterations = ceil(log(1.0 - confidence) / log(1.0 - probability_good_sample));
+    return static_cast<int>(min(num_iterations, static_cast<double>(max_iterations)));
+}
 
-    const vcl_vector< vgl_point_2d<double> >& pr = from_features;
-    const vcl_vector< vgl_point_2d<double> >& pl = to_features;
 
+void RANSAC::draw_sample(Worker &worker, const vector< ScoredMatch > &data)
+{
+    const int m = model.get_num_points_to_estimate();
+    boost::uniform_int<int> uniform_index(0, static_cast<int>(data.size()) - 1);
+
+    // m is small, checking the previously selected indices is cheap
+    int selected_indices[16];
+    if (m > 16)
+        throw runtime_error("RANSAC::draw_sample only supports models with up to 16 points per sample");
 
-    // Check that there are at least 8 points.
-    if ( pr.size() < 8 || pl.size() < 8 )
+    int i = 0;
+    while (i < m)
     {
-        vcl_cerr << "vpgl_fm_compute_ransac: Need at least 8 point pairs.\n"
-        << "Number in each set: " << pr.size() << ", " << pl.size() << vcl_endl;
+        const int index = uniform_index(worker.random_generator);
+        bool already_selected = false;
+        int j;
+        for (j=0; j < i; j+=1)
+            already_selected = already_selected || (selected_indices[j] == index);
 
-        throw runtime_error("RANSAC<F>::estimate_model_parameters received not enough input data");
-    }
+        if (already_selected) continue;
 
-    // Check that the correspondence lists are the same size.
-    if ( pr.size() != pl.size() ) // sanity check
-    {
-        vcl_cerr << "vpgl_fm_compute_ransac: Need correspondence lists of same size.\n";
-        throw runtime_error("RANSAC<F>::estimate_model_parameters internal bug");
+        selected_indices[i] = index;
+        worker.minimal_set[i] = data[index];
+        i += 1;
     }
 
-    // The following block is hacked from similar code in rrel_homography2d_est.
-    rrel_estimation_problem* estimator = NULL;
+    return;
+}
 
-    if (use_fundamental_matrix_model)
-        estimator =  new rrel_fm_problem( pr, pl );
-    else if (use_homography_model)
-        estimator = new rrel_homography2d_est(from_features_hp, to_features_hp);
-    else
-        throw runtime_error("RANSAC<F>::estimate_model_parameters no model selected");
 
-    rrel_muset_obj* ransac = new rrel_muset_obj((int)vcl_floor(pr.size()*.75));
-    estimator->set_prior_scale( 1.0 );
-    rrel_ran_sam_search* ransam = new rrel_ran_sam_search;
-    ransam->set_trace_level(trace_level_);
+void RANSAC::run_worker(const int worker_index)
+{
+    Worker &worker = workers[worker_index];
+    IParametricModel &worker_model = *worker.model_p;
+    const vector< ScoredMatch > &matches = *matches_p;
 
-    if (!gen_all_)
-        ransam->set_sampling_params( max_outlier_frac_,
-                                     desired_prob_good_, max_pops_);
-    else
-        ransam->set_gen_all_samples();
+    worker.best_num_inliers = -1;
 
-    if (true)
-    { // just for debugging
-        printf("RANSAC starting sampling\n");
+    int i;
+    for (i=0; i < worker.num_samples; i+=1)
+    {
+        draw_sample(worker, matches);
+
+        int num_hypotheses = 0;
+        try
+        {
+            num_hypotheses = worker_model.estimate_hypotheses_from_minimal_set(worker.minimal_set);
+        }
+        catch (runtime_error &)
+        {
+            continue; // degenerate sample
+        }
+
+        if (num_hypotheses == 0)
+            continue;
+
+        // only the models better than the best one found so far are of interest,
+        // the verifier stops as soon as it knows none of the sample hypotheses is one of them
+        const int min_num_inliers = max(worker.best_num_inliers, best_num_inliers) + 1;
+        int num_inliers = 0;
+        const int best_hypothesis = worker.verifier_p->verify(worker_model, num_hypotheses, matches, min_num_inliers,
+                                    worker.random_generator, num_inliers);
+        if (best_hypothesis < 0)
+            continue;
+
+        worker_model.select_hypothesis(best_hypothesis);
+        worker.best_num_inliers = num_inliers;
+        worker.best_model_parameters = worker_model.get_parameters();
+        worker.best_minimal_set = worker.minimal_set;
     }
 
-    bool ransac_succeeded = ransam->estimate( estimator, ransac );
+    return;
+}
 
-    if (true)
-    { // just for debugging
-        printf("RANSAC finished testing %i samples\n", ransam->samples_tested());
-    }
 
+const ublas::vector<float> &  RANSAC::estimate_model_parameters(const vector< ScoredMatch > &matches)
+{
+    const int m = model.get_num_points_to_estimate();
+    const int num_matches = static_cast<int>(matches.size());
+    const int num_workers = static_cast<int>(workers.size());
 
-    //vpgl_fundamental_matrix<double> fm; // fundamental matrix estimate
-    //if ( ransac_succeeded )
-    //estimator->params_to_fm( ransam->params(), fm );
+    if (num_matches < m)
+        throw runtime_error("RANSAC::estimate_model_parameters received not enough input data");
 
-    // Get a list of the outliers.
-    vcl_vector< double > residuals;
-    estimator->compute_residuals( ransam->params(), residuals );
+    if (have_features(matches) == false)
+        throw runtime_error("RANSAC::estimate_model_parameters requires matches with feature pointers, not only indexes");
 
-    is_inlier.clear();
-    for ( unsigned i = 0; i < pr.size(); i++ )
+    matches_p = &matches;
+    best_num_inliers = -1;
+    num_residuals_evaluated = 0;
+    local_optimization_p->reset();
+
+    // until a model is found, the number of iterations is bounded by the expected outliers fraction
+    double inliers_fraction = 1.0 - max_outliers_fraction;
+    int w;
+    for (w=0; w < num_workers; w+=1)
     {
-        is_inlier.push_back( ( residuals[i] < outlier_thresh_ ) );
+        workers[w].verifier_p->set_inliers_fraction(inliers_fraction);
+        workers[w].verifier_p->reset_num_residuals_evaluated();
     }
+    int num_iterations = compute_num_iterations(inliers_fraction);
 
-    delete ransac;
-    delete ransam;
-    delete estimator;
-
-    if (ransac_succeeded == false)
-        cout << "RANSAC<>::estimate_model_parameters had a problem" << endl;
+    // the samples are drawn in rounds, each worker draws its share of the round
+    // and the best models are reduced in the workers order, so that the result
+    // does not depend on the threads scheduling
+    int t = 0;
+    while (t < num_iterations)
+    {
+        const int remaining = num_iterations - t;
+        const int samples_per_worker =
+            (num_workers == 1) ? 1 : min(samples_per_round, (remaining + num_workers - 1) / num_workers);
+
+        for (w=0; w < num_workers; w+=1)
+            workers[w].num_samples = samples_per_worker;
+
+        if (thread_pool_p)
+            thread_pool_p->run(num_workers, boost::bind(&RANSAC::run_worker, this, _1));
+        else
+            run_worker(0);
+
+        for (w=0; w < num_workers; w+=1)
+        {
+            const Worker &worker = workers[w];
+            t += worker.num_samples;
+
+            if (worker.best_num_inliers > best_num_inliers)
+            {
+                best_num_inliers = worker.best_num_inliers;
+                best_model_parameters = worker.best_model_parameters;
+
+                // the first worker is idle between two rounds, so its model can be used
+                model.set_parameters(best_model_parameters);
+
+                // the iterations are computed from the support of the corrected model
+                if (model.correct_degenerate_sample(worker.best_minimal_set, matches, inlier_threshold, best_num_inliers))
+                {
+                    best_model_parameters = model.get_parameters();
+                    num_residuals_evaluated += num_matches;
+
+                    if (trace_level > 0)
+                        cout << "RANSAC degenerate sample corrected, " << best_num_inliers << " inliers" << endl;
+                }
+
+                if (local_optimization_p->optimize(model, matches, best_num_inliers))
+                {
+                    best_model_parameters = model.get_parameters();
+
+                    if (trace_level > 0)
+                        cout << "RANSAC local optimization found " << best_num_inliers << " inliers" << endl;
+                }
+
+                inliers_fraction = max(inliers_fraction, static_cast<double>(best_num_inliers) / num_matches);
+                int v;
+                for (v=0; v < num_workers; v+=1)
+                    workers[v].verifier_p->set_inliers_fraction(inliers_fraction);
+
+                if (trace_level > 0)
+                    cout << "RANSAC sample " << t << " found " << best_num_inliers << " inliers" << endl;
+            }
+        }
+
+        // the acceptance probability of the verifiers changes as they learn the data statistics,
+        // so the number of iterations is updated after each round
+        num_iterations = compute_num_iterations(inliers_fraction);
+
+        if (trace_level > 1)
+            cout << "RANSAC will stop after " << num_iterations << " samples" << endl;
+    }
 
-    if (is_inlier.size() != matches.size()) // sanity check
-        throw runtime_error("RANSAC<>::estimate_model_parameters internal bug");
+    num_hypotheses_tested = t;
+    num_residuals_evaluated += local_optimization_p->get_num_residuals_evaluated();
+    for (w=0; w < num_workers; w+=1)
+        num_residuals_evaluated += workers[w].verifier_p->get_num_residuals_evaluated();
 
+    // retrieve the estimated parameters and the inliers --
+    is_inlier.resize(num_matches);
+    if (best_num_inliers < 0)
+    {
+        if (trace_level > 0)
+            cout << "RANSAC::estimate_model_parameters did not find any valid model" << endl;
+        fill(is_inlier.begin(), is_inlier.end(), false);
+        estimated_model_parameters.resize(model.get_num_parameters());
+        fill(estimated_model_parameters.begin(), estimated_model_parameters.end(), 0.0f);
+        return estimated_model_parameters;
+    }
 
-    // retrieve the estimated parameters --
-    //const vnl_matrix_fixed<double,3,3> &fundamental_matrix =  fundamental_matrix_estimate.get_matrix();
-    estimated_model_parameters.resize(9);
-    int i;
-    for (i=0;i<9;i+=1)
+    model.set_parameters(best_model_parameters);
+    if (local_optimization_p->uses_graph_cut())
+    { // spatially coherent inliers
+        local_optimization_p->label_inliers(model, matches, is_inlier);
+        num_residuals_evaluated += num_matches;
+    }
+    else
     {
-        estimated_model_parameters[i] = ransam->params()[i];
-        //estimated_model_parameters[i] = fundamental_matrix[i];
-        // vnl_matrix_fixed[i] is a direct access to the data region, should be ok
+        model.compute_residuals(matches, residuals);
+        int i;
+        for (i=0; i < num_matches; i+=1)
+            is_inlier[i] = (residuals[i] < inlier_threshold);
     }
 
+    estimated_model_parameters = best_model_parameters;
     return estimated_model_parameters;
 
-} // end of 'RANSAC<>::estimate_model_parameters'
+} // end of 'RANSAC::estimate_model_parameters'
 
 
 const vector< bool > &  RANSAC::get_is_inlier()
@@ -212,5 +401,15 @@ const vector< bool > &  RANSAC::get_is_inlier()
     return is_inlier;
 }
 
+int RANSAC::get_num_hypotheses_tested() const
+{
+    return num_hypotheses_tested;
+}
+
+long RANSAC::get_num_residuals_evaluated() const
+{
+    return num_residuals_evaluated;
+}
+
 
 } // end of namespace uniclop
@@ -6,29 +6,70 @@
 
 #include "../IModelEstimator.hpp"
 #include "../IParametricModel.hpp"
+#include "../IHypothesisVerifier.hpp"
+#include "LocalOptimization.hpp"
 
+#include <boost/random.hpp>
 #include <boost/program_options.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 
 
 namespace uniclop
 {
 namespace args = boost::program_options;
 
+class ScoredMatch;
+class ThreadPool; // forward declaration
+
 class RANSAC: public IModelEstimator
 { // given a model and list of scorematches will estimate the best parameters of the model
+  // M. A. Fischler and R. C. Bolles "Random sample consensus", 1981,
+  // with the number of iterations adapted to the inliers fraction of the best model found so far,
+  // and the local optimization of LO-RANSAC applied to the new best models
 
     ublas::vector<float> estimated_model_parameters;
     vector<bool> is_inlier;
 
-    bool use_fundamental_matrix_model,  use_homography_model;
+    IParametricModel &model;
 
     // ransac algorithm parameters
-    double outlier_thresh_;
-    double max_outlier_frac_;
-    double desired_prob_good_;
-    int max_pops_;
-    bool gen_all_;
-    int trace_level_;
+    float inlier_threshold; ///< maximum residual of an inlier, in the model residuals units
+    float max_outliers_fraction; ///< upper bound of the outliers fraction, sets the initial number of iterations
+    float confidence; ///< probability of drawing at least one sample free of outliers
+    int max_iterations;
+    int samples_per_round; ///< samples drawn by each thread between two reductions
+    int trace_level;
+
+    int num_hypotheses_tested;
+    long num_residuals_evaluated;
+
+    /// each thread draws and scores its own samples
+    class Worker
+    {
+    public:
+        IParametricModel *model_p;
+        boost::shared_ptr<IParametricModel> model_clone_p; ///< NULL for the first worker, that uses the input model
+        boost::mt19937 random_generator; // pseudo-random number generators
+        boost::shared_ptr<IHypothesisVerifier> verifier_p; ///< each worker keeps its own test statistics
+
+        vector< ScoredMatch > minimal_set, best_minimal_set;
+
+        int num_samples; ///< samples to draw in the current round
+        int best_num_inliers; ///< best model of the current round, -1 if none
+        ublas::vector<float> best_model_parameters;
+    };
+
+    vector<Worker> workers;
+    boost::scoped_ptr<ThreadPool> thread_pool_p; ///< NULL when using a single thread
+    const vector< ScoredMatch > *matches_p; ///< data of the current call, read by the workers
+    int best_num_inliers; ///< best model of the previous rounds, read by the workers
+
+    boost::scoped_ptr<LocalOptimization> local_optimization_p; ///< run on each new best model, between two rounds
+
+    // internal buffers, reused between calls
+    vector<float> residuals;
+    ublas::vector<float> best_model_parameters;
 
 public:
 
@@ -41,6 +82,22 @@ public:
     const ublas::vector<float> &estimate_model_parameters(const vector< ScoredMatch > &);
 
     const vector< bool > & get_is_inlier();
+
+    int get_num_hypotheses_tested() const;
+    ///< number of samples tested by the last call to estimate_model_parameters
+
+    long get_num_residuals_evaluated() const;
+    ///< number of residuals computed to verify the hypotheses in the last call to estimate_model_parameters
+
+private:
+
+    void run_worker(const int worker_index);
+
+    void draw_sample(Worker &worker, const vector< ScoredMatch > &data);
+
+    int compute_num_iterations(const double inliers_fraction) const;
+    ///< number of samples needed to draw an outlier free sample, that passes the verification,
+    ///< with the desired confidence
 };
 
 }
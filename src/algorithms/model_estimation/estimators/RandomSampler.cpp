@@ -0,0 +1,165 @@
+
+#include "RandomSampler.hpp"
+
+#include "algorithms/features/ScoredMatch.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace uniclop
+{
+
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Class RandomSampler methods implementation
+
+RandomSampler::RandomSampler(const DegeneracyChecks _degeneracy_checks, const int _max_attempts)
+        : degeneracy_checks(_degeneracy_checks), max_attempts(_max_attempts)
+{
+    if (max_attempts < 1)
+        throw runtime_error("RandomSampler expects at least one attempt per sample");
+
+    num_rejected_samples = 0;
+    seed(0, 0);
+    return;
+}
+
+RandomSampler::~RandomSampler()
+{
+    return;
+}
+
+
+void RandomSampler::seed(const boost::uint64_t seed, const boost::uint64_t stream)
+{
+    // PCG32 initialization, the increment has to be odd
+    state = 0;
+    increment = (stream << 1) | 1;
+    get_random_number();
+    state += seed;
+    get_random_number();
+    return;
+}
+
+boost::uint32_t RandomSampler::get_random_number()
+{
+    // PCG32, 64 bits linear congruential generator with a xorshift and a random rotation as output function
+    const boost::uint64_t old_state = state;
+    state = old_state * 6364136223846793005ULL + increment;
+
+    const boost::uint32_t xorshifted = static_cast<boost::uint32_t>(((old_state >> 18) ^ old_state) >> 27);
+    const boost::uint32_t rotation = static_cast<boost::uint32_t>(old_state >> 59);
+    return (xorshifted >> rotation) | (xorshifted << ((32 - rotation) & 31));
+}
+
+int RandomSampler::get_random_index(const int num_indices)
+{
+    // D. Lemire "Fast Random Integer Generation in an Interval", 2019
+    // multiplication instead of modulo, the rare biased values are rejected
+    const boost::uint32_t range = static_cast<boost::uint32_t>(num_indices);
+    boost::uint64_t product = static_cast<boost::uint64_t>(get_random_number()) * range;
+    boost::uint32_t low_bits = static_cast<boost::uint32_t>(product);
+    if (low_bits < range)
+    {
+        const boost::uint32_t threshold = (0u - range) % range;
+        while (low_bits < threshold)
+        {
+            product = static_cast<boost::uint64_t>(get_random_number()) * range;
+            low_bits = static_cast<boost::uint32_t>(product);
+        }
+    }
+
+    return static_cast<int>(product >> 32);
+}
+
+
+void RandomSampler::draw(const int num_data_points, const int sample_size, vector<int> &sample)
+{
+    if (sample_size > num_data_points || sample_size < 0)
+        throw runtime_error("RandomSampler::draw not enough data points to draw the sample");
+
+    // the permutation is only rebuilt when the data size changes,
+    // a partial shuffle of any permutation gives a uniformly distributed sample
+    if (static_cast<int>(permutation.size()) != num_data_points)
+    {
+        permutation.resize(num_data_points);
+        int i;
+        for (i=0; i < num_data_points; i+=1)
+            permutation[i] = i;
+    }
+
+    sample.resize(sample_size);
+    int i;
+    for (i=0; i < sample_size; i+=1)
+    {
+        swap(permutation[i], permutation[i + get_random_index(num_data_points - i)]);
+        sample[i] = permutation[i];
+    }
+
+    return;
+}
+
+void RandomSampler::draw(const vector< ScoredMatch > &data, const int sample_size, vector<int> &sample)
+{
+    int attempt;
+    for (attempt=0; attempt < max_attempts; attempt+=1)
+    {
+        draw(static_cast<int>(data.size()), sample_size, sample);
+        if (degeneracy_checks == no_checks || is_degenerate(data, sample) == false)
+            return;
+
+        num_rejected_samples += 1;
+    }
+
+    throw runtime_error("RandomSampler::draw dataset ill conditioned, only degenerate samples were found");
+    return;
+}
+
+long RandomSampler::get_num_rejected_samples() const
+{
+    return num_rejected_samples;
+}
+
+
+// helper function, true if the point c is less than a pixel away from the line (a, b),
+// or if a and b are the same point
+static bool are_collinear(const IFeature &a, const IFeature &b, const IFeature &c)
+{
+    const double ab_x = b.x - a.x, ab_y = b.y - a.y;
+    const double ac_x = c.x - a.x, ac_y = c.y - a.y;
+    const double cross_product = ab_x * ac_y - ab_y * ac_x; // twice the area of the triangle
+    return cross_product * cross_product <= ab_x * ab_x + ab_y * ab_y;
+}
+
+bool RandomSampler::is_degenerate(const vector< ScoredMatch > &data, const vector<int> &sample) const
+{
+    const int sample_size = static_cast<int>(sample.size());
+    int i, j, k;
+
+    for (i=0; i < sample_size; i+=1)
+        for (j=i+1; j < sample_size; j+=1)
+        {
+            const ScoredMatch &m_i = data[sample[i]], &m_j = data[sample[j]];
+            if (m_i.feature_a == m_j.feature_a || m_i.feature_b == m_j.feature_b)
+                return true;
+        }
+
+    if (degeneracy_checks != distinct_non_collinear)
+        return false;
+
+    // the samples are small, all the triplets are checked
+    for (i=0; i < sample_size; i+=1)
+        for (j=i+1; j < sample_size; j+=1)
+            for (k=j+1; k < sample_size; k+=1)
+            {
+                const ScoredMatch &m_i = data[sample[i]], &m_j = data[sample[j]], &m_k = data[sample[k]];
+                if (are_collinear(*m_i.feature_a, *m_j.feature_a, *m_k.feature_a) ||
+                        are_collinear(*m_i.feature_b, *m_j.feature_b, *m_k.feature_b))
+                    return true;
+            }
+
+    return false;
+}
+
+
+} // end of namespace uniclop
@@ -0,0 +1,77 @@
+#if !defined(RANDOM_SAMPLER_HEADER)
+#define RANDOM_SAMPLER_HEADER
+
+// RandomSampler, minimal samples drawn without replacement
+// M. E. O'Neill "PCG: A Family of Simple Fast Space-Efficient Statistically Good
+// Algorithms for Random Number Generation", 2014
+
+
+#include <boost/cstdint.hpp>
+
+#include <vector>
+
+
+namespace uniclop
+{
+
+using namespace std;
+
+class ScoredMatch;
+
+class RandomSampler
+{ // each sample is a partial Fisher-Yates shuffle of a persistent permutation of the data indices,
+  // so drawing k indices costs O(k) and never needs to retry on repeated indices.
+  // The random numbers come from a PCG32 generator, the (seed, stream) pair fully defines the samples sequence,
+  // so each thread can use its own stream and the results stay reproducible.
+  // Optionally, the samples that would give a degenerate model are rejected before any model fit
+
+public:
+
+    enum DegeneracyChecks
+    {
+        no_checks, ///< any set of distinct indices is accepted
+        distinct_features, ///< two matches of a sample can not share their feature_a or their feature_b
+        distinct_non_collinear ///< also rejects three collinear points, in either image (e.g. for homographies)
+    };
+
+private:
+
+    DegeneracyChecks degeneracy_checks;
+    int max_attempts; ///< number of samples drawn before giving up on finding a non degenerate one
+
+    boost::uint64_t state, increment; ///< PCG32 generator
+
+    vector<int> permutation; ///< persistent permutation of [0, num_data_points)
+    long num_rejected_samples;
+
+public:
+
+    RandomSampler(const DegeneracyChecks degeneracy_checks = no_checks, const int max_attempts = 100);
+    ~RandomSampler();
+
+    void seed(const boost::uint64_t seed, const boost::uint64_t stream = 0);
+
+    boost::uint32_t get_random_number();
+    ///< uniformly distributed 32 bits value
+
+    int get_random_index(const int num_indices);
+    ///< uniformly distributed value in [0, num_indices)
+
+    void draw(const int num_data_points, const int sample_size, vector<int> &sample);
+    ///< sample_size distinct indices in [0, num_data_points), no degeneracy check
+
+    void draw(const vector< ScoredMatch > &data, const int sample_size, vector<int> &sample);
+    ///< sample_size distinct indices of data that pass the degeneracy checks,
+    ///< throws a runtime_error when no such sample is found after max_attempts samples
+
+    long get_num_rejected_samples() const;
+    ///< number of degenerate samples rejected since the sampler creation
+
+private:
+
+    bool is_degenerate(const vector< ScoredMatch > &data, const vector<int> &sample) const;
+};
+
+}
+
+#endif // RANDOM_SAMPLER_HEADER
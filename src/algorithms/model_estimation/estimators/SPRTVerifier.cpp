@@ -0,0 +1,260 @@
+
+#include "SPRTVerifier.hpp"
+
+#include "../IParametricModel.hpp"
+#include "algorithms/features/ScoredMatch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace uniclop
+{
+
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Class SPRTVerifier methods implementation
+
+args::options_description SPRTVerifier::get_options_description()
+{
+
+    args::options_description desc("SPRTVerifier options");
+    desc.add_options()
+
+    ( "sprt.epsilon", args::value<float>()->default_value(0.1f),
+      "lower bound of the probability of a match being consistent with a good model")
+
+    ( "sprt.delta", args::value<float>()->default_value(0.05f),
+      "initial guess of the probability of a match being consistent with a bad model")
+
+    ( "sprt.model_cost", args::value<float>()->default_value(200.0f),
+      "time needed to estimate a model, relative to the time needed to evaluate one match")
+    ;
+
+    return desc;
+}
+
+
+SPRTVerifier::SPRTVerifier(args::variables_map &options, const float _inlier_threshold)
+        : inlier_threshold(_inlier_threshold)
+{
+
+    initial_epsilon = 0.1f;
+    float initial_delta = 0.05f;
+    model_cost = 200.0f;
+
+    if (options.count("sprt.epsilon"))
+        initial_epsilon = options["sprt.epsilon"].as<float>();
+
+    if (options.count("sprt.delta"))
+        initial_delta = options["sprt.delta"].as<float>();
+
+    if (options.count("sprt.model_cost"))
+        model_cost = options["sprt.model_cost"].as<float>();
+
+    if (initial_delta <= 0 || initial_epsilon <= initial_delta || initial_epsilon >= 1)
+        throw runtime_error("SPRTVerifier expects 0 < sprt.delta < sprt.epsilon < 1");
+
+    if (model_cost <= 0)
+        throw runtime_error("SPRTVerifier expects sprt.model_cost to be strictly positive");
+
+    epsilon = initial_epsilon;
+    delta = initial_delta;
+    update_decision_threshold();
+
+    rejected_inliers = 0;
+    rejected_evaluated = 0;
+    num_residuals_evaluated = 0;
+    return;
+}
+
+SPRTVerifier::~SPRTVerifier()
+{
+    return;
+}
+
+
+double SPRTVerifier::compute_decision_threshold(const double epsilon, const double delta, const double model_cost)
+{
+    // based on O. Chum and J. Matas "Optimal Randomized RANSAC", PAMI 2008, section 3.1
+    if (delta >= epsilon)
+        return numeric_limits<double>::max();
+
+    const double c = (1 - delta) * log((1 - delta) / (1 - epsilon)) + delta * log(delta / epsilon);
+    const double k = model_cost * c + 1;
+
+    // A is the fix point of A = k + log(A)
+    double a = k;
+    int i;
+    for (i=0; i < 10; i+=1)
+        a = k + log(a);
+
+    return a;
+}
+
+
+void SPRTVerifier::update_decision_threshold()
+{
+    decision_threshold = compute_decision_threshold(epsilon, delta, model_cost);
+    inlier_factor = delta / epsilon;
+    outlier_factor = (1 - delta) / (1 - epsilon);
+    return;
+}
+
+
+void SPRTVerifier::update_delta(const int num_inliers, const int num_evaluated)
+{
+    // delta is the average inliers fraction of the rejected models,
+    // the older statistics are slowly forgotten so that delta follows the scene
+    rejected_inliers += num_inliers;
+    rejected_evaluated += num_evaluated;
+    if (rejected_evaluated > 1e5)
+    {
+        rejected_inliers *= 0.5;
+        rejected_evaluated *= 0.5;
+    }
+
+    const double new_delta = max(1e-3, rejected_inliers / rejected_evaluated);
+
+    // the threshold is only recomputed when delta changed significantly
+    if (fabs(new_delta - delta) > 0.05 * delta)
+    {
+        delta = new_delta;
+        update_decision_threshold();
+    }
+
+    return;
+}
+
+
+int SPRTVerifier::verify(const IParametricModel &model, const int num_hypotheses,
+                         const vector< ScoredMatch > &data_points,
+                         const int min_num_inliers, boost::mt19937 &random_generator, int &num_inliers)
+{
+    const int num_data_points = static_cast<int>(data_points.size());
+
+    // the evaluation order is a random permutation, only drawn again when the data size changes,
+    // each hypothesis starts at a random position of it
+    if (static_cast<int>(evaluation_order.size()) != num_data_points)
+    {
+        evaluation_order.resize(num_data_points);
+        int i;
+        for (i=0; i < num_data_points; i+=1)
+            evaluation_order[i] = i;
+
+        for (i = num_data_points - 1; i > 0; i-=1)
+        {
+            boost::uniform_int<int> uniform_index(0, i);
+            swap(evaluation_order[i], evaluation_order[uniform_index(random_generator)]);
+        }
+    }
+
+    boost::uniform_int<int> uniform_start(0, num_data_points - 1);
+    int position = uniform_start(random_generator);
+
+    residuals.resize(num_hypotheses);
+    likelihood_ratios.assign(num_hypotheses, 1); // lambda
+    hypotheses_num_inliers.assign(num_hypotheses, 0);
+    hypotheses_num_evaluated.assign(num_hypotheses, 0);
+
+    // delta, hence A, is only updated once all the tests are decided, so that they share the same threshold
+    const double threshold = decision_threshold;
+
+    int num_candidates = num_hypotheses;
+    int i, h;
+    for (i=0; i < num_data_points && num_candidates > 0; i+=1, position+=1)
+    {
+        if (position == num_data_points)
+            position = 0;
+
+        model.compute_hypotheses_residual(data_points[evaluation_order[position]], &residuals[0]);
+
+        for (h=0; h < num_hypotheses; h+=1)
+        {
+            double &likelihood_ratio = likelihood_ratios[h];
+            if (likelihood_ratio < 0 || likelihood_ratio > threshold)
+                continue;
+
+            if (hypotheses_num_inliers[h] + (num_data_points - i) < min_num_inliers)
+            { // even if all the remaining points were inliers, the model would not be good enough
+                likelihood_ratio = -1;
+                num_candidates -= 1;
+                continue;
+            }
+
+            hypotheses_num_evaluated[h] += 1;
+            if (residuals[h] < inlier_threshold)
+            {
+                hypotheses_num_inliers[h] += 1;
+                likelihood_ratio *= inlier_factor;
+            }
+            else
+            {
+                likelihood_ratio *= outlier_factor;
+            }
+
+            if (likelihood_ratio > threshold)
+            { // the model is rejected as bad, the ratio is kept to tell it from the other rejections
+                num_candidates -= 1;
+            }
+        }
+    }
+
+    int best_hypothesis = -1;
+    num_inliers = 0;
+    for (h=0; h < num_hypotheses; h+=1)
+    {
+        num_residuals_evaluated += hypotheses_num_evaluated[h];
+
+        if (likelihood_ratios[h] > threshold)
+        {
+            update_delta(hypotheses_num_inliers[h], hypotheses_num_evaluated[h]);
+        }
+        else if (likelihood_ratios[h] < 0)
+        {
+            continue;
+        }
+        else if (hypotheses_num_inliers[h] >= min_num_inliers
+                 && (best_hypothesis < 0 || hypotheses_num_inliers[h] > num_inliers))
+        {
+            best_hypothesis = h;
+            num_inliers = hypotheses_num_inliers[h];
+        }
+    }
+
+    return best_hypothesis;
+}
+
+
+void SPRTVerifier::set_inliers_fraction(const double inliers_fraction)
+{
+    epsilon = min(0.99, max(inliers_fraction, static_cast<double>(initial_epsilon)));
+    update_decision_threshold();
+    return;
+}
+
+double SPRTVerifier::get_acceptance_probability() const
+{
+    // Wald's bound on the probability of rejecting a good model is 1/A
+    return 1.0 - 1.0 / decision_threshold;
+}
+
+long SPRTVerifier::get_num_residuals_evaluated() const
+{
+    return num_residuals_evaluated;
+}
+
+void SPRTVerifier::reset_num_residuals_evaluated()
+{
+    num_residuals_evaluated = 0;
+    return;
+}
+
+IHypothesisVerifier *SPRTVerifier::clone() const
+{
+    return new SPRTVerifier(*this);
+}
+
+
+} // end of namespace uniclop
@@ -0,0 +1,79 @@
+#if !defined(SPRT_VERIFIER_HEADER)
+#define SPRT_VERIFIER_HEADER
+
+// SPRTVerifier, Wald's sequential probability ratio test
+// J. Matas and O. Chum "Randomized RANSAC with Sequential Probability Ratio Test", ICCV 2005
+// O. Chum and J. Matas "Optimal Randomized RANSAC", PAMI 2008
+
+
+#include "../IHypothesisVerifier.hpp"
+
+#include <boost/program_options.hpp>
+
+
+namespace uniclop
+{
+
+namespace args = ::boost::program_options;
+
+class SPRTVerifier: public IHypothesisVerifier
+{ // the data points are evaluated in random order, the likelihood ratio between
+  // "the model is bad" and "the model is good" is updated after each residual
+  // and the model is rejected as soon as it goes above the decision threshold A.
+  // The hypotheses of a same sample run their tests side by side, on the same data points
+
+    float inlier_threshold; ///< maximum residual of an inlier, in the model residuals units
+    float initial_epsilon; ///< lower bound of epsilon
+    float model_cost; ///< cost of one model estimation, relative to one residual evaluation
+
+    double epsilon; ///< probability that a data point is consistent with a good model
+    double delta; ///< probability that a data point is consistent with a bad model, estimated from the rejected models
+    double decision_threshold; ///< A
+    double inlier_factor, outlier_factor; ///< likelihood ratio updates
+
+    double rejected_inliers, rejected_evaluated; ///< statistics of the rejected models, used to estimate delta
+
+    vector<int> evaluation_order; ///< random permutation of the data points indices
+    long num_residuals_evaluated;
+
+    // internal buffers, reused between calls
+    vector<float> residuals; ///< residuals of one data point, for each hypothesis
+    vector<double> likelihood_ratios; ///< lambda of each hypothesis, -1 when rejected by the min_num_inliers bound
+    vector<int> hypotheses_num_inliers, hypotheses_num_evaluated;
+
+public:
+
+    static args::options_description get_options_description();
+
+    SPRTVerifier(args::variables_map &options, const float inlier_threshold);
+    ~SPRTVerifier();
+
+    ///@name IHypothesisVerifier interface
+    ///@{
+    int verify(const IParametricModel &model, const int num_hypotheses, const vector< ScoredMatch > &data_points,
+               const int min_num_inliers, boost::mt19937 &random_generator, int &num_inliers);
+
+    void set_inliers_fraction(const double inliers_fraction);
+
+    double get_acceptance_probability() const;
+
+    long get_num_residuals_evaluated() const;
+
+    void reset_num_residuals_evaluated();
+
+    IHypothesisVerifier *clone() const;
+    ///@}
+
+    static double compute_decision_threshold(const double epsilon, const double delta, const double model_cost);
+    ///< A, the optimal SPRT threshold (infinite when delta >= epsilon, i.e. the test can not discriminate)
+
+private:
+
+    void update_decision_threshold();
+
+    void update_delta(const int num_inliers, const int num_evaluated);
+};
+
+}
+
+#endif // SPRT_VERIFIER_HEADER
@@ -0,0 +1,125 @@
+
+#include "StandardVerifier.hpp"
+
+#include "../IParametricModel.hpp"
+#include "algorithms/features/ScoredMatch.hpp"
+
+namespace uniclop
+{
+
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Class StandardVerifier methods implementation
+
+StandardVerifier::StandardVerifier(const float _inlier_threshold)
+        : inlier_threshold(_inlier_threshold)
+{
+    num_residuals_evaluated = 0;
+    return;
+}
+
+StandardVerifier::~StandardVerifier()
+{
+    return;
+}
+
+
+void StandardVerifier::reset_hypotheses(const int num_hypotheses)
+{
+    residuals.resize(num_hypotheses);
+    hypotheses_num_inliers.assign(num_hypotheses, 0);
+    return;
+}
+
+
+int StandardVerifier::count_inliers(const IParametricModel &model, const int num_hypotheses,
+                                    const vector< ScoredMatch > &data_points,
+                                    const int min_num_inliers, int &num_inliers)
+{
+    const int num_data_points = static_cast<int>(data_points.size());
+
+    int i, h;
+    for (i=0; i < num_data_points; i+=1)
+    {
+        // even if all the remaining points were inliers, these hypotheses would not be good enough
+        int num_candidates = 0;
+        for (h=0; h < num_hypotheses; h+=1)
+        {
+            int &hypothesis_num_inliers = hypotheses_num_inliers[h];
+            if (hypothesis_num_inliers >= 0 && hypothesis_num_inliers + (num_data_points - i) < min_num_inliers)
+                hypothesis_num_inliers = -1;
+            num_candidates += (hypothesis_num_inliers >= 0) ? 1 : 0;
+        }
+
+        if (num_candidates == 0)
+        {
+            num_residuals_evaluated += static_cast<long>(i) * num_hypotheses;
+            num_inliers = 0;
+            return -1;
+        }
+
+        // the data point is read once for all the hypotheses
+        model.compute_hypotheses_residual(data_points[i], &residuals[0]);
+        for (h=0; h < num_hypotheses; h+=1)
+        {
+            if (hypotheses_num_inliers[h] >= 0 && residuals[h] < inlier_threshold)
+                hypotheses_num_inliers[h] += 1;
+        }
+    }
+
+    num_residuals_evaluated += static_cast<long>(num_data_points) * num_hypotheses;
+
+    int best_hypothesis = -1;
+    num_inliers = 0;
+    for (h=0; h < num_hypotheses; h+=1)
+    {
+        if (hypotheses_num_inliers[h] >= min_num_inliers
+                 && (best_hypothesis < 0 || hypotheses_num_inliers[h] > num_inliers))
+        {
+            best_hypothesis = h;
+            num_inliers = hypotheses_num_inliers[h];
+        }
+    }
+
+    return best_hypothesis;
+}
+
+
+int StandardVerifier::verify(const IParametricModel &model, const int num_hypotheses,
+                             const vector< ScoredMatch > &data_points,
+                             const int min_num_inliers, boost::mt19937 &/*random_generator*/, int &num_inliers)
+{
+    reset_hypotheses(num_hypotheses);
+    return count_inliers(model, num_hypotheses, data_points, min_num_inliers, num_inliers);
+}
+
+
+void StandardVerifier::set_inliers_fraction(const double /*inliers_fraction*/)
+{
+    // nothing to do here
+    return;
+}
+
+double StandardVerifier::get_acceptance_probability() const
+{
+    return 1.0;
+}
+
+long StandardVerifier::get_num_residuals_evaluated() const
+{
+    return num_residuals_evaluated;
+}
+
+void StandardVerifier::reset_num_residuals_evaluated()
+{
+    num_residuals_evaluated = 0;
+    return;
+}
+
+IHypothesisVerifier *StandardVerifier::clone() const
+{
+    return new StandardVerifier(*this);
+}
+
+
+} // end of namespace uniclop
@@ -0,0 +1,58 @@
+#if !defined(STANDARD_VERIFIER_HEADER)
+#define STANDARD_VERIFIER_HEADER
+
+// StandardVerifier, evaluates the hypotheses on all the data points
+
+
+#include "../IHypothesisVerifier.hpp"
+
+
+namespace uniclop
+{
+
+class StandardVerifier: public IHypothesisVerifier
+{ // counts the inliers of the hypotheses over all the data points,
+  // stops as soon as min_num_inliers can not be reached anymore
+
+protected:
+    float inlier_threshold; ///< maximum residual of an inlier, in the model residuals units
+    long num_residuals_evaluated;
+
+    // internal buffers, reused between calls
+    vector<float> residuals; ///< residuals of one data point, for each hypothesis
+    vector<int> hypotheses_num_inliers; ///< -1 marks the rejected hypotheses
+
+public:
+
+    StandardVerifier(const float inlier_threshold);
+    ~StandardVerifier();
+
+    ///@name IHypothesisVerifier interface
+    ///@{
+    int verify(const IParametricModel &model, const int num_hypotheses, const vector< ScoredMatch > &data_points,
+               const int min_num_inliers, boost::mt19937 &random_generator, int &num_inliers);
+
+    void set_inliers_fraction(const double inliers_fraction);
+
+    double get_acceptance_probability() const;
+
+    long get_num_residuals_evaluated() const;
+
+    void reset_num_residuals_evaluated();
+
+    IHypothesisVerifier *clone() const;
+    ///@}
+
+protected:
+
+    void reset_hypotheses(const int num_hypotheses);
+    ///< sizes the buffers, all the hypotheses start with 0 inliers
+
+    int count_inliers(const IParametricModel &model, const int num_hypotheses, const vector< ScoredMatch > &data_points,
+                      const int min_num_inliers, int &num_inliers);
+    ///< interleaved count of the hypotheses not yet rejected, returns the best one
+};
+
+}
+
+#endif // STANDARD_VERIFIER_HEADER
@@ -0,0 +1,110 @@
+
+#include "TddVerifier.hpp"
+
+#include "../IParametricModel.hpp"
+#include "algorithms/features/ScoredMatch.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace uniclop
+{
+
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Class TddVerifier methods implementation
+
+args::options_description TddVerifier::get_options_description()
+{
+
+    args::options_description desc("TddVerifier options");
+    desc.add_options()
+
+    ( "tdd.d", args::value<int>()->default_value(1),
+      "number of random matches that must be inliers before evaluating a hypothesis on all the matches")
+    ;
+
+    return desc;
+}
+
+
+TddVerifier::TddVerifier(args::variables_map &options, const float _inlier_threshold)
+        : StandardVerifier(_inlier_threshold)
+{
+
+    d = 1;
+
+    if (options.count("tdd.d"))
+        d = options["tdd.d"].as<int>();
+
+    if (d < 1)
+        throw runtime_error("TddVerifier expects tdd.d to be strictly positive");
+
+    inliers_fraction = 1.0;
+    return;
+}
+
+TddVerifier::~TddVerifier()
+{
+    return;
+}
+
+
+int TddVerifier::verify(const IParametricModel &model, const int num_hypotheses,
+                        const vector< ScoredMatch > &data_points,
+                        const int min_num_inliers, boost::mt19937 &random_generator, int &num_inliers)
+{
+    boost::uniform_int<int> uniform_index(0, static_cast<int>(data_points.size()) - 1);
+
+    reset_hypotheses(num_hypotheses);
+
+    // T(d,d) pre-verification, the points are drawn with replacement
+    int i, h;
+    for (i=0; i < d; i+=1)
+    {
+        model.compute_hypotheses_residual(data_points[uniform_index(random_generator)], &residuals[0]);
+
+        int num_candidates = 0;
+        for (h=0; h < num_hypotheses; h+=1)
+        {
+            if (hypotheses_num_inliers[h] >= 0)
+            {
+                num_residuals_evaluated += 1;
+                if (residuals[h] >= inlier_threshold)
+                    hypotheses_num_inliers[h] = -1;
+                else
+                    num_candidates += 1;
+            }
+        }
+
+        if (num_candidates == 0)
+        {
+            num_inliers = 0;
+            return -1;
+        }
+    }
+
+    // the surviving hypotheses still have 0 inliers, they are counted on all the data points
+    return count_inliers(model, num_hypotheses, data_points, min_num_inliers, num_inliers);
+}
+
+
+void TddVerifier::set_inliers_fraction(const double _inliers_fraction)
+{
+    inliers_fraction = _inliers_fraction;
+    return;
+}
+
+double TddVerifier::get_acceptance_probability() const
+{
+    // a good model passes the test when the d points are inliers
+    return pow(inliers_fraction, d);
+}
+
+IHypothesisVerifier *TddVerifier::clone() const
+{
+    return new TddVerifier(*this);
+}
+
+
+} // end of namespace uniclop
@@ -0,0 +1,48 @@
+#if !defined(TDD_VERIFIER_HEADER)
+#define TDD_VERIFIER_HEADER
+
+// TddVerifier, the T(d,d) pre-verification test
+// O. Chum and J. Matas "Randomized RANSAC with T(d,d) test", BMVC 2002
+
+
+#include "StandardVerifier.hpp"
+
+#include <boost/program_options.hpp>
+
+
+namespace uniclop
+{
+
+namespace args = ::boost::program_options;
+
+class TddVerifier: public StandardVerifier
+{ // a hypothesis is evaluated on all the data points
+  // only if d randomly selected data points are all inliers,
+  // the hypotheses of a same sample share the d points
+
+    int d; ///< number of data points of the pre-verification test
+    double inliers_fraction; ///< epsilon, used to compute the acceptance probability
+
+public:
+
+    static args::options_description get_options_description();
+
+    TddVerifier(args::variables_map &options, const float inlier_threshold);
+    ~TddVerifier();
+
+    ///@name IHypothesisVerifier interface
+    ///@{
+    int verify(const IParametricModel &model, const int num_hypotheses, const vector< ScoredMatch > &data_points,
+               const int min_num_inliers, boost::mt19937 &random_generator, int &num_inliers);
+
+    void set_inliers_fraction(const double inliers_fraction);
+
+    double get_acceptance_probability() const;
+
+    IHypothesisVerifier *clone() const;
+    ///@}
+};
+
+}
+
+#endif // TDD_VERIFIER_HEADER
@@ -4,7 +4,11 @@
 
 
 #include "estimators/RANSAC.hpp"
+#include "estimators/TddVerifier.hpp"
+#include "estimators/SPRTVerifier.hpp"
+#include "estimators/LocalOptimization.hpp"
 #include "estimators/PROSAC.hpp"
+#include "estimators/ARRSAC.hpp"
 #include "estimators/Ensemble.hpp"
 
 
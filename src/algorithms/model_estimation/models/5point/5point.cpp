@@ -1,4 +1,4 @@
-/* 
+/*
  *  Copyright (c) 2008  Noah Snavely (snavely (at) cs.washington.edu)
  *    and the University of Washington
  *
@@ -14,810 +14,233 @@
  *
  */
 
-/* 5point.c */
+/* 5point.cpp */
 /* Solve the 5-point relative pose problem */
 
 #include "5point.hpp"
 
-#include "poly1.hpp"
-#include "poly3.hpp"
+#include <Eigen/LU>
+#include <Eigen/QR>
+#include <Eigen/Eigenvalues>
 
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <math.h>
-#include <float.h>
-
-#include "defines.h"
-#include "fmatrix.h"
-
-#include "matrix.h"
-#include "qsort.h"
-#include "svd.h"
-#include "triangulate.h"
-#include "vector.h"
-
-namespace 5point {
-	
-// import most common Eigen types 
-USING_PART_OF_NAMESPACE_EIGEN
-
-using Eigen::Vector2f;
-
-#define x_i 0
-#define y_i 1
-#define z_i 2
-
-#define Vx(v) (x)[x_i]
-#define Vy(v) (v)[y_i]
-#define Vz(v) (v)[z_i]
-
-
-void compute_nullspace_basis(const vector<Vector2d> &a, const vector<Vector2d> &b, Matrix<double, 9, 4> &basis) {
-	
-    int i;
-
-	assert(a.size() == b.size());
-	
-	const int n = a.size();
-
-    if (n < 5) {
-        fprintf(stderr, "[compute_nullspace_basis] n must be >= 5\n");
-        return;
-    }
-
-    const int max_dim = MAX(9, n);
-
-    Matrix<double, max_dim, max_dim> Q;
-
-    /* Create the 5x9 epipolar constraint matrix */
-    for (i = 0; i < 5; i++) {
-	    
-        Q.row(i)[0] = Vx(a[i]) * Vx(b[i]);
-        Q.row(i)[1] = Vy(a[i]) * Vx(b[i]);
-        Q.row(i)[2] = Vx(b[i]);
-
-        Q.row(i)[3] = Vx(a[i]) * Vy(b[i]);
-        Q.row(i)[4] = Vy(a[i]) * Vy(b[i]);
-        Q.row(i)[5] = Vy(b[i]);
-
-        Q.row(i)[6] = Vx(a[i]);
-        Q.row(i)[7] = Vy(a[i]);
-        Q.row(i)[8] = 1.0;
-    }
-
-	/* Apply SVD and from the V vector */
-    /* Find four vectors that span the right nullspace of the matrix */
-
-	  
-  // double VT[81];
-  // dgesvd_driver(n, 9, Q, U, S, VT);
-  // memcpy(basis, VT + 5 * 9, 36 * sizeof(double));
-
-	 const Matrix<double, 9, 9> V_transposed = Q.svd().matrixV().transpose();
-     basis.row(0) = V_transposed.row(5);
-     basis.row(1) = V_transposed.row(6);
-     basis.row(2) = V_transposed.row(7);
-     basis.row(3) = V_transposed.row(8);
-     
-   return;
-}
-
-void compute_constraint_matrix(const Matrix<double, 9, 4> &basis, poly3_t constraints[10])
+namespace uniclop
 {
-    /* Basis rows are X, Y, Z, W 
-     * Essential matrix is or form x*X + y*Y + z*Z + W */
-
-    /* Create a polynomial for each entry of E */
-    poly3_t polys[9];
-    poly3_t poly_term1, poly_term2, poly_term3, poly_det;
-    poly3_t poly_EET[6], poly_lambda[6], poly_tr, poly_lambdaE[9];
-
-    int i;
-
-    for (i=0; i < 9; i++) {
-        polys[i] = poly3_new(basis[i], basis[9+i], basis[18+i], basis[27+i]);
-    }
-
-    /* Create a polynormial from the constraint det(E) = 0 */
-    poly_term1 = poly3_mult21( poly3_sub( poly3_mult11(polys[1], polys[5]), 
-                                          poly3_mult11(polys[2], polys[4]) ), 
-                               polys[6] );
-
-    // matrix_print(1, 20, poly_term1.v);
-    
-    poly_term2 = poly3_mult21( poly3_sub( poly3_mult11(polys[2], polys[3]), 
-                                          poly3_mult11(polys[0], polys[5]) ), 
-                               polys[7] );
-
-    poly_term3 = poly3_mult21( poly3_sub( poly3_mult11(polys[0], polys[4]), 
-                                          poly3_mult11(polys[1], polys[3]) ), 
-                               polys[8] );
-
-    poly_det = poly3_add(poly_term1, poly3_add(poly_term2, poly_term3));
-    
-    /* Create polynomials for the singular value constraint */
-    for (i = 0; i < 6; i++) {
-        int r = 0, c = 0, k;
-        poly_EET[i] = poly3_new(0.0, 0.0, 0.0, 0.0);
-        switch(i) {
-        case 0:
-        case 1:
-        case 2:
-            r = 0;
-            c = i;
-            break;
-        case 3:
-        case 4:
-            r = 1;
-            c = i-2;
-            break;
-        case 5:
-            r = 2;
-            c = 2;
-            break;
-        }
-
-        for (k = 0; k < 3; k++) {
-            poly_EET[i] = poly3_add(poly_EET[i], poly3_mult11(polys[r*3+k], polys[c*3+k]));
-        }
-    }
 
-    poly_tr = poly3_add3(poly_EET[0], poly_EET[3], poly_EET[5]);
-    poly_tr = poly3_scale(poly_tr, 0.5);
-
-    poly_lambda[0] = poly3_sub(poly_EET[0], poly_tr);
-    poly_lambda[1] = poly_EET[1];
-    poly_lambda[2] = poly_EET[2];
-    
-    poly_lambda[3] = poly3_sub(poly_EET[3], poly_tr);
-    poly_lambda[4] = poly_EET[4];
-    
-    poly_lambda[5] = poly3_sub(poly_EET[5], poly_tr);
-    
-    poly_lambdaE[0] = poly3_add3(poly3_mult(poly_lambda[0], polys[0]),
-                                 poly3_mult(poly_lambda[1], polys[3]),
-                                 poly3_mult(poly_lambda[2], polys[6]));
-    
-    poly_lambdaE[1] = poly3_add3(poly3_mult(poly_lambda[0], polys[1]),
-                                 poly3_mult(poly_lambda[1], polys[4]),
-                                 poly3_mult(poly_lambda[2], polys[7]));
-
-    poly_lambdaE[2] = poly3_add3(poly3_mult(poly_lambda[0], polys[2]),
-                                 poly3_mult(poly_lambda[1], polys[5]),
-                                 poly3_mult(poly_lambda[2], polys[8]));
-
-    poly_lambdaE[3] = poly3_add3(poly3_mult21(poly_lambda[1], polys[0]),
-                                 poly3_mult21(poly_lambda[3], polys[3]),
-                                 poly3_mult21(poly_lambda[4], polys[6]));
-    
-    poly_lambdaE[4] = poly3_add3(poly3_mult21(poly_lambda[1], polys[1]),
-                                 poly3_mult21(poly_lambda[3], polys[4]),
-                                 poly3_mult21(poly_lambda[4], polys[7]));
-
-    poly_lambdaE[5] = poly3_add3(poly3_mult21(poly_lambda[1], polys[2]),
-                                 poly3_mult21(poly_lambda[3], polys[5]),
-                                 poly3_mult21(poly_lambda[4], polys[8]));
-
-    poly_lambdaE[6] = poly3_add3(poly3_mult21(poly_lambda[2], polys[0]),
-                                 poly3_mult21(poly_lambda[4], polys[3]),
-                                 poly3_mult21(poly_lambda[5], polys[6]));
-    
-    poly_lambdaE[7] = poly3_add3(poly3_mult21(poly_lambda[2], polys[1]),
-                                 poly3_mult21(poly_lambda[4], polys[4]),
-                                 poly3_mult21(poly_lambda[5], polys[7]));
-
-    poly_lambdaE[8] = poly3_add3(poly3_mult21(poly_lambda[2], polys[2]),
-                                 poly3_mult21(poly_lambda[4], polys[5]),
-                                 poly3_mult21(poly_lambda[5], polys[8]));
- 
-    for (i=0; i < 9; i++) 
-        constraints[i] = poly_lambdaE[i];
-
-    constraints[9] = poly_det;
-}
-
-void eliminate_gauss_jordan(poly3_t constraints[10])
+namespace five_point
 {
-    double A[200];
-    int i, j;
 
-    for (i = 0; i < 10; i++) {
-        // memcpy(A + 20 * i, constraints[i].v, sizeof(double) * 20);
-        double *row = A + 20 * i;
-        row[0] = constraints[i].v[POLY3_X3];
-        row[1] = constraints[i].v[POLY3_Y3];
-        row[2] = constraints[i].v[POLY3_X2Y];
-        row[3] = constraints[i].v[POLY3_XY2];
-        row[4] = constraints[i].v[POLY3_X2Z];
-        row[5] = constraints[i].v[POLY3_X2];
-        row[6] = constraints[i].v[POLY3_Y2Z];
-        row[7] = constraints[i].v[POLY3_Y2];
-        row[8] = constraints[i].v[POLY3_XYZ];
-        row[9] = constraints[i].v[POLY3_XY];
-        row[10] = constraints[i].v[POLY3_XZ2];
-        row[11] = constraints[i].v[POLY3_XZ];
-        row[12] = constraints[i].v[POLY3_X];
-        row[13] = constraints[i].v[POLY3_YZ2];
-        row[14] = constraints[i].v[POLY3_YZ];
-        row[15] = constraints[i].v[POLY3_Y];
-        row[16] = constraints[i].v[POLY3_Z3];
-        row[17] = constraints[i].v[POLY3_Z2];
-        row[18] = constraints[i].v[POLY3_Z];
-        row[19] = constraints[i].v[POLY3_UNIT];
-    }
+using namespace Eigen;
 
-    for (i = 0; i < 10; i++) {
-        /* Make the leading coefficient of row i = 1 */
-        double leading = A[20 * i + i];
-        matrix_scale(20, 1, A + 20 * i, 1.0 / leading, A + 20 * i);
-
-        /* Subtract from other rows */
-        for (j = i+1; j < 10; j++) {
-            double leading2 = A[20 * j + i];
-            double scaled_row[20];
-            matrix_scale(20, 1, A + 20 * i, leading2, scaled_row);
-            matrix_diff(20, 1, 20, 1, A + 20 * j, scaled_row, A + 20 * j);
-        }
-    }
+// the polynomials are stored as fixed size coefficient vectors,
+// each degree keeps the monomials order of the Groebner basis elimination
+typedef Matrix<double, 4, 1> Polynomial1; ///< x y z 1
+typedef Matrix<double, 10, 1> Polynomial2; ///< x2 xy y2 xz yz z2 x y z 1
+typedef Matrix<double, 20, 1> Polynomial3; ///< x3 x2y xy2 y3 x2z xyz y2z xz2 yz2 z3 x2 xy y2 xz yz z2 x y z 1
 
-    /* Now, do the back substitution (stopping four rows early) */
-    for (i = 9; i >= 4; i--) {
-        for (j = 0; j < i; j++) {
-            double scale = A[20 * j + i];
-            double scaled_row[20];
-            matrix_scale(20, 1, A + 20 * i, scale, scaled_row);
-            matrix_diff(20, 1, 20, 1, A + 20 * j, scaled_row, A + 20 * j);
-        }
-    }
-
-    /* Copy out results */
-    for (i = 0; i < 10; i++) {
-        // memcpy(constraints[i].v, A + 20 * i, sizeof(double) * 20);
-        double *row = A + 20 * i;
-        constraints[i].v[POLY3_X3] = row[0];
-        constraints[i].v[POLY3_Y3] = row[1];
-        constraints[i].v[POLY3_X2Y] = row[2];
-        constraints[i].v[POLY3_XY2] = row[3];
-        constraints[i].v[POLY3_X2Z] = row[4];
-        constraints[i].v[POLY3_X2] = row[5];
-        constraints[i].v[POLY3_Y2Z] = row[6];
-        constraints[i].v[POLY3_Y2] = row[7];
-        constraints[i].v[POLY3_XYZ] = row[8];
-        constraints[i].v[POLY3_XY] = row[9];
-        constraints[i].v[POLY3_XZ2] = row[10];
-        constraints[i].v[POLY3_XZ] = row[11];
-        constraints[i].v[POLY3_X] = row[12];
-        constraints[i].v[POLY3_YZ2] = row[13];
-        constraints[i].v[POLY3_YZ] = row[14];
-        constraints[i].v[POLY3_Y] = row[15];
-        constraints[i].v[POLY3_Z3] = row[16];
-        constraints[i].v[POLY3_Z2] = row[17];
-        constraints[i].v[POLY3_Z] = row[18];
-        constraints[i].v[POLY3_UNIT] = row[19];
-    }
-}
-
-void compute_B_matrix(poly3_t *constraints, poly1_t *B) 
+// index of the product of two monomials, for each pair of (Polynomial1, Polynomial1) monomials
+static const int product_11[4][4] =
 {
-    poly3_t e = constraints[4];
-    poly3_t f = constraints[5];
-    poly3_t g = constraints[6];
-    poly3_t h = constraints[7];
-    poly3_t i = constraints[8];
-    poly3_t j = constraints[9];
-
-    B[0] = poly1_new3(-poly3_get(f, POLY3_XZ2),
-                      poly3_get(e, POLY3_XZ2) - poly3_get(f, POLY3_XZ),
-                      poly3_get(e, POLY3_XZ) - poly3_get(f, POLY3_X),
-                      poly3_get(e, POLY3_X));
-    
-    B[1] = poly1_new3(-poly3_get(f, POLY3_YZ2),
-                      poly3_get(e, POLY3_YZ2) - poly3_get(f, POLY3_YZ),
-                      poly3_get(e, POLY3_YZ) - poly3_get(f, POLY3_Y),
-                      poly3_get(e, POLY3_Y));
-
-    B[2] = poly1_new4(-poly3_get(f, POLY3_Z3),
-                      poly3_get(e, POLY3_Z3) - poly3_get(f, POLY3_Z2),
-                      poly3_get(e, POLY3_Z2) - poly3_get(f, POLY3_Z),
-                      poly3_get(e, POLY3_Z) - poly3_get(f, POLY3_UNIT),
-                      poly3_get(e, POLY3_UNIT));
-    
-    B[3] = poly1_new3(-poly3_get(h, POLY3_XZ2),
-                      poly3_get(g, POLY3_XZ2) - poly3_get(h, POLY3_XZ),
-                      poly3_get(g, POLY3_XZ) - poly3_get(h, POLY3_X),
-                      poly3_get(g, POLY3_X));
-    
-    B[4] = poly1_new3(-poly3_get(h, POLY3_YZ2),
-                      poly3_get(g, POLY3_YZ2) - poly3_get(h, POLY3_YZ),
-                      poly3_get(g, POLY3_YZ) - poly3_get(h, POLY3_Y),
-                      poly3_get(g, POLY3_Y));
-
-    B[5] = poly1_new4(-poly3_get(h, POLY3_Z3),
-                      poly3_get(g, POLY3_Z3) - poly3_get(h, POLY3_Z2),
-                      poly3_get(g, POLY3_Z2) - poly3_get(h, POLY3_Z),
-                      poly3_get(g, POLY3_Z) - poly3_get(h, POLY3_UNIT),
-                      poly3_get(g, POLY3_UNIT));
-
-    B[6] = poly1_new3(-poly3_get(j, POLY3_XZ2),
-                      poly3_get(i, POLY3_XZ2) - poly3_get(j, POLY3_XZ),
-                      poly3_get(i, POLY3_XZ) - poly3_get(j, POLY3_X),
-                      poly3_get(i, POLY3_X));
-    
-    B[7] = poly1_new3(-poly3_get(j, POLY3_YZ2),
-                      poly3_get(i, POLY3_YZ2) - poly3_get(j, POLY3_YZ),
-                      poly3_get(i, POLY3_YZ) - poly3_get(j, POLY3_Y),
-                      poly3_get(i, POLY3_Y));
-
-    B[8] = poly1_new4(-poly3_get(j, POLY3_Z3),
-                      poly3_get(i, POLY3_Z3) - poly3_get(j, POLY3_Z2),
-                      poly3_get(i, POLY3_Z2) - poly3_get(j, POLY3_Z),
-                      poly3_get(i, POLY3_Z) - poly3_get(j, POLY3_UNIT),
-                      poly3_get(i, POLY3_UNIT));
-}
-
-void compute_determinant(poly1_t *B, poly1_t *p1, poly1_t *p2, poly1_t *p3, 
-                         poly1_t *det)
+    {0, 1, 3, 6}, // x * (x y z 1)
+    {1, 2, 4, 7}, // y * (x y z 1)
+    {3, 4, 5, 8}, // z * (x y z 1)
+    {6, 7, 8, 9}  // 1 * (x y z 1)
+};
+
+// for each pair of (Polynomial2, Polynomial1) monomials
+static const int product_21[10][4] =
 {
-    *p1 = poly1_sub( poly1_mult( B[1], B[5] ), 
-                     poly1_mult( B[2], B[4] ) );
-
-    *p2 = poly1_sub( poly1_mult( B[2], B[3] ), 
-                     poly1_mult( B[0], B[5] ) ); 
-
-    *p3 = poly1_sub( poly1_mult( B[0], B[4] ), 
-                     poly1_mult( B[1], B[3] ) );
-    
-    *det = poly1_add3(poly1_mult(*p1, B[6]), 
-                      poly1_mult(*p2, B[7]),
-                      poly1_mult(*p3, B[8]));
-}
-
-void extract_roots(poly1_t det, int *num_roots, double *roots)
+    {0, 1, 4, 10}, // x2 * (x y z 1)
+    {1, 2, 5, 11}, // xy
+    {2, 3, 6, 12}, // y2
+    {4, 5, 7, 13}, // xz
+    {5, 6, 8, 14}, // yz
+    {7, 8, 9, 15}, // z2
+    {10, 11, 13, 16}, // x
+    {11, 12, 14, 17}, // y
+    {13, 14, 15, 18}, // z
+    {16, 17, 18, 19}  // 1
+};
+
+static Polynomial2 multiply(const Polynomial1 &a, const Polynomial1 &b)
 {
-    double C[100], evec[100], eval[10];
-    
-    /* Scale the determinant */
-    poly1_t det_scale = poly1_normalize(det);
-
-    int i, real;
-
-    /* Fill the companion matrix */
-    for (i = 0; i < 100; i++)
-        C[i] = 0.0;
-
-    for (i = 0; i < 10; i++) 
-        C[i] = -det_scale.v[9-i];
-
-    for (i = 1; i < 10; i++)
-        C[i * 10 + (i-1)] = 1.0;
-    
-    real = dgeev_driver(10, C, evec, eval);
-
-    memcpy(roots, eval, real * sizeof(double));
-    *num_roots = real;
-}
-
-void compute_Ematrices(int n, double *roots, double *basis, 
-                       poly1_t p1, poly1_t p2, poly1_t p3, double *E) {
-    int i;
-    
-    for (i = 0; i < n; i++) {
-        double z = roots[i];
-        double den = poly1_eval(p3, z);
-        double den_inv = 1.0 / den;
-
-        double x = poly1_eval(p1, z) * den_inv;
-        double y = poly1_eval(p2, z) * den_inv;
-        
-        double X[9], Y[9], Z[9], tmp1[9], tmp2[9];
-
-        matrix_scale(9, 1, basis + 0, x, X);
-        matrix_scale(9, 1, basis + 9, y, Y);
-        matrix_scale(9, 1, basis + 18, z, Z);
-
-        matrix_sum(9, 1, 9, 1, X, Y, tmp1);
-        matrix_sum(9, 1, 9, 1, Z, basis + 27, tmp2);
-        matrix_sum(9, 1, 9, 1, tmp1, tmp2, E + 9 * i);
-    }
+    Polynomial2 product = Polynomial2::Zero();
+    int i, j;
+    for (i=0; i < 4; i+=1)
+        for (j=0; j < 4; j+=1)
+            product[product_11[i][j]] += a[i] * b[j];
+    return product;
 }
 
-
-void compute_Grabner_basis(poly3_t *constraints, double *Gbasis) 
+static Polynomial3 multiply(const Polynomial2 &a, const Polynomial1 &b)
 {
-    double A[200];
+    Polynomial3 product = Polynomial3::Zero();
     int i, j;
-
-    for (i = 0; i < 10; i++) {
-        // memcpy(A + 20 * i, constraints[i].v, sizeof(double) * 20);
-        double *row = A + 20 * i;
-
-        /* x3 x2y xy2 y3 x2z xyz y2z xz2 yz2 z3 x2 xy y2 xz yz z2 x  y  z  1 */
-
-        row[0] = constraints[i].v[POLY3_X3];
-        row[1] = constraints[i].v[POLY3_X2Y];
-        row[2] = constraints[i].v[POLY3_XY2];
-        row[3] = constraints[i].v[POLY3_Y3];
-        row[4] = constraints[i].v[POLY3_X2Z];
-        row[5] = constraints[i].v[POLY3_XYZ];
-        row[6] = constraints[i].v[POLY3_Y2Z];
-        row[7] = constraints[i].v[POLY3_XZ2];
-        row[8] = constraints[i].v[POLY3_YZ2];
-        row[9] = constraints[i].v[POLY3_Z3];
-        row[10] = constraints[i].v[POLY3_X2];
-        row[11] = constraints[i].v[POLY3_XY];
-        row[12] = constraints[i].v[POLY3_Y2];
-        row[13] = constraints[i].v[POLY3_XZ];
-        row[14] = constraints[i].v[POLY3_YZ];
-        row[15] = constraints[i].v[POLY3_Z2];
-        row[16] = constraints[i].v[POLY3_X];
-        row[17] = constraints[i].v[POLY3_Y];
-        row[18] = constraints[i].v[POLY3_Z];
-        row[19] = constraints[i].v[POLY3_UNIT];
-    }
-    
-    /* Do a full Gaussian elimination */
-
-    for (i = 0; i < 10; i++) {
-        /* Make the leading coefficient of row i = 1 */
-        double leading = A[20 * i + i];
-        matrix_scale(20, 1, A + 20 * i, 1.0 / leading, A + 20 * i);
-
-        /* Subtract from other rows */
-        for (j = i+1; j < 10; j++) {
-            double leading2 = A[20 * j + i];
-            double scaled_row[20];
-            matrix_scale(20, 1, A + 20 * i, leading2, scaled_row);
-            matrix_diff(20, 1, 20, 1, A + 20 * j, scaled_row, A + 20 * j);
-        }
-    }
-
-    /* Now, do the back substitution */
-    for (i = 9; i >= 0; i--) {
-        for (j = 0; j < i; j++) {
-            double scale = A[20 * j + i];
-            double scaled_row[20];
-            matrix_scale(20, 1, A + 20 * i, scale, scaled_row);
-            matrix_diff(20, 1, 20, 1, A + 20 * j, scaled_row, A + 20 * j);
-        }
-    }
-    
-    /* Copy out results */
-    for (i = 0; i < 10; i++) {
-        memcpy(Gbasis + i * 10, A + i * 20 + 10, sizeof(double) * 10);
-    }
+    for (i=0; i < 10; i+=1)
+        for (j=0; j < 4; j+=1)
+            product[product_21[i][j]] += a[i] * b[j];
+    return product;
 }
 
-void compute_action_matrix(double *Gbasis, double *At) 
-{
-    int i;
-    for (i = 0; i < 100; i++)
-        At[i] = 0.0;
-    
-    matrix_scale(10, 1, Gbasis +  0, -1.0, At +  0);
-    matrix_scale(10, 1, Gbasis + 10, -1.0, At + 10);
-    matrix_scale(10, 1, Gbasis + 20, -1.0, At + 20);
-    matrix_scale(10, 1, Gbasis + 40, -1.0, At + 30);
-    matrix_scale(10, 1, Gbasis + 50, -1.0, At + 40);
-    matrix_scale(10, 1, Gbasis + 70, -1.0, At + 50);
-
-    At[6 * 10 + 0] = 1.0;
-    At[7 * 10 + 1] = 1.0;
-    At[8 * 10 + 3] = 1.0;
-    At[9 * 10 + 6] = 1.0;
-}
 
-void compute_Ematrices_Gb(double *At, double *basis, int *num_solns, double *E)
+void compute_nullspace_basis(const Vector2d points_a[5], const Vector2d points_b[5], NullspaceBasis &basis)
 {
-    double evec[100], eval[10];
-    int real = dgeev_driver(10, At, evec, eval);
+    // the transposed 5x9 epipolar constraints matrix, each column is b^T E a = 0 for E in row major order
+    Matrix<double, 9, 5> constraints_transposed;
     int i;
-    
-    for (i = 0; i < real; i++) {
-        double X[9], Y[9], Z[9], tmp1[9], tmp2[9];
-
-        double x = evec[10 * i + 6];
-        double y = evec[10 * i + 7];
-        double z = evec[10 * i + 8];
-        double w = evec[10 * i + 9];
-        double w_inv = 1.0 / w;
-        
-        x = x * w_inv;
-        y = y * w_inv;
-        z = z * w_inv;
-
-        matrix_scale(9, 1, basis + 0, x, X);
-        matrix_scale(9, 1, basis + 9, y, Y);
-        matrix_scale(9, 1, basis + 18, z, Z);
-
-        matrix_sum(9, 1, 9, 1, X, Y, tmp1);
-        matrix_sum(9, 1, 9, 1, Z, basis + 27, tmp2);
-        matrix_sum(9, 1, 9, 1, tmp1, tmp2, E + 9 * i);
-
-        matrix_scale(9, 1, E + 9 * i, 1.0 / E[9 * i + 8], E + 9 * i);
-    }
-
-    *num_solns = real;
+    for (i=0; i < 5; i+=1)
+    {
+        const Vector2d &a = points_a[i], &b = points_b[i];
+        constraints_transposed.col(i) << a[0]*b[0], a[1]*b[0], b[0],
+        a[0]*b[1], a[1]*b[1], b[1],
+        a[0], a[1], 1.0;
+    }
+
+    // the last four columns of the complete Q are orthogonal to the five constraints,
+    // a QR decomposition is cheaper than the SVD used by Bundler
+    const HouseholderQR< Matrix<double, 9, 5> > qr(constraints_transposed);
+    const Matrix<double, 9, 9> q = qr.householderQ();
+    basis = q.rightCols<4>();
+    return;
 }
 
-void generate_Ematrix_hypotheses(const vector<Vector2d> &rt_pts, const vector<Vector2d> &left_pts, 
-                                 int *num_poses, double *E) 
+void compute_nullspace_basis(const Matrix<double, 9, 9> &normal_matrix, NullspaceBasis &basis)
 {
-	
-	assert( rt_pts.size() == left_pts.size() );
-	const int n =  rt_pts.size();
-	
-    double basis[36], Gbasis[100], At[100];
-    poly3_t constraints[10];
-    // poly1_t B[9], p1, p2, p3, det;
-    // double roots[10];
-
-    if (n < 5) {
-        fprintf(stderr, "[generate_Ematrix_hypotheses] n must be >= 5\n");
-        return;
-    }
-
-    /* Generate the nullspace basis of the epipolar constraint matrix */
-    compute_nullspace_basis(n, rt_pts, left_pts, basis);
-    compute_constraint_matrix(basis, constraints);
-
-#if 0
-    eliminate_gauss_jordan(constraints);
-    compute_B_matrix(constraints, B);
-    compute_determinant(B, &p1, &p2, &p3, &det);
-    extract_roots(det, num_poses, roots);
-    compute_Ematrices(*num_poses, roots, basis, p1, p2, p3, E);
-#else
-    compute_Grabner_basis(constraints, Gbasis);
-    compute_action_matrix(Gbasis, At);
-    compute_Ematrices_Gb(At, basis, num_poses, E);
-#endif
-
-return;
+    // eigenvectors of the four smallest eigenvalues (sorted in increasing order)
+    const SelfAdjointEigenSolver< Matrix<double, 9, 9> > eigen_solver(normal_matrix);
+    basis = eigen_solver.eigenvectors().leftCols<4>();
+    return;
 }
 
-void choose(const int n, vector<int> &arr)
-{
-    int i;
-    const int k = arr.size();
-    
-    if (k > n) {
-        fprintf(stderr, "[choose] Error: k > n\n");
-        return;
-    }
 
-    for (i = 0; i < k; i++) {
-        while (1) {
-            int idx = rand() % n;
-            int j, redo = 0;
-
-            for (j = 0; j < i; j++) {
-                if (idx == arr[j]) {
-                    redo = 1;
-                    break;
-                }
-            }
-
-            if (!redo) {
-                arr[i] = idx;
-                break;
-            }
+void compute_constraint_matrix(const NullspaceBasis &basis, ConstraintMatrix &constraints)
+{
+    // one linear polynomial per entry of E
+    Polynomial1 e[9];
+    int i, r, c, k;
+    for (i=0; i < 9; i+=1)
+        e[i] = basis.row(i).transpose();
+
+    // E E^T - trace(E E^T)/2 * I, symmetric
+    Polynomial2 lambda[3][3];
+    for (r=0; r < 3; r+=1)
+        for (c=r; c < 3; c+=1)
+        {
+            lambda[r][c] = multiply(e[3*r], e[3*c]) + multiply(e[3*r + 1], e[3*c + 1]) + multiply(e[3*r + 2], e[3*c + 2]);
         }
-    }
-    
-    return;
-}
 
-int evaluate_Ematrix(int n, v2_t *r_pts, v2_t *l_pts, double thresh_norm,
-                     double *F, int *best_inlier, double *score)
-{
-    int num_inliers = 0;
-    int i;
-    double min_resid = 1.0e20;
-    double likelihood = 0.0;
-
-    for (i = 0; i < n; i++) {
-#if 1
-        v3_t r = v3_new(Vx(r_pts[i]), Vy(r_pts[i]), 1.0);
-        v3_t l = v3_new(Vx(l_pts[i]), Vy(l_pts[i]), 1.0);
-#else
-        v3_t r = v3_new(-Vx(r_pts[i]), -Vy(r_pts[i]), 1.0);
-        v3_t l = v3_new(-Vx(l_pts[i]), -Vy(l_pts[i]), 1.0);
-#endif
-
-#if 0
-        double resid = fmatrix_compute_residual(E, l, r);
-#else
-        double resid = fmatrix_compute_residual(F, l, r);
-#endif     
-   
-        likelihood += log(1.0 + resid * resid / (thresh_norm));
-
-        if (resid < thresh_norm) {
-            num_inliers++;
-
-            if (resid < min_resid) {
-                min_resid = resid;
-                *best_inlier = i;
-            }
+    const Polynomial2 half_trace = (lambda[0][0] + lambda[1][1] + lambda[2][2]) * 0.5;
+    for (r=0; r < 3; r+=1)
+    {
+        lambda[r][r] -= half_trace;
+        for (c=0; c < r; c+=1)
+            lambda[r][c] = lambda[c][r];
+    }
+
+    // (E E^T - trace(E E^T)/2 * I) E = 0, nine equations
+    for (r=0; r < 3; r+=1)
+        for (c=0; c < 3; c+=1)
+        {
+            Polynomial3 entry = Polynomial3::Zero();
+            for (k=0; k < 3; k+=1)
+                entry += multiply(lambda[r][k], e[3*k + c]);
+            constraints.row(3*r + c) = entry.transpose();
         }
-    }
 
-    *score = likelihood;
-    // *score = 1.0 / num_inliers;
+    // det(E) = 0, expanded along the last row
+    const Polynomial2 cofactor_6 = multiply(e[1], e[5]) - multiply(e[2], e[4]);
+    const Polynomial2 cofactor_7 = multiply(e[2], e[3]) - multiply(e[0], e[5]);
+    const Polynomial2 cofactor_8 = multiply(e[0], e[4]) - multiply(e[1], e[3]);
+    const Polynomial3 determinant = multiply(cofactor_6, e[6]) + multiply(cofactor_7, e[7]) + multiply(cofactor_8, e[8]);
+    constraints.row(9) = determinant.transpose();
 
-    return num_inliers;
+    return;
 }
 
 
-int compute_pose_ransac(const vector<ScoredMatch> &data_points, 
-                        const CalibrationMatrix &K1, const CalibrationMatrix &K2, 
-                        double ransac_threshold, int ransac_rounds, 
-                        RotationMatrix &R_out,  TranslationVector &t_out)
-/*                        
-int compute_pose_ransac(int n, v2_t *r_pts, v2_t *l_pts, 
-                        double *K1, double *K2, 
-                        double ransac_threshold, int ransac_rounds, 
-                        double *R_out, double *t_out)
-                        */
+bool compute_action_matrix(const ConstraintMatrix &constraints, ActionMatrix &action_matrix)
 {
-    const vector<Vector2d> r_pts_norm, l_pts_norm;
-    int i, round;
-    double thresh_norm;
-   	Matrix3d K1_inv, K2_inv;
-    int max_inliers = 0;
-    double min_score = DBL_MAX;
-    Matrix3f E_best[9];
-    Vector2d r_best, l_best;
-
-    r_pts_norm.resize(data_points.size());
-    l_pts_norm.resize(data_points.size());
-
-	K1_inv = K1.inverse();
-	K2_inv = K2.inverse();
-
-    for (i = 0; i < n; i++) {
-        
-        Vector3d r( Vx(r_pts[i]), Vy(r_pts[i]), 1.0 );
-        Vector3d l( Vx(l_pts[i]), Vy(l_pts[i]), 1.0 );
-
-		const Vector3d r_norm = K1_inv*r;
-		const Vector3d l_norm = K2_inv*l;
-		
-        r_pts_norm[i][0] = -r_norm[0];
-        r_pts_norm[i][1] = -r_norm[1];
-        
-        l_pts_norm[i][0] = -l_norm[0];
-        l_pts_norm[i][1] = -l_norm[1];        
-    }
-
-    thresh_norm = ransac_threshold * ransac_threshold;
-
-    for (round = 0; round < ransac_rounds; round++) {
-        /* Pick 5 random points */
-        const int num_random_points = 5;
-        Vector2d r_pts_inner[num_random_points], l_pts_inner[num_random_points];
-        vector<int> indices(num_random_points);
-        int num_hyp;
-        double E[90];
-        int inliers_hyp[10];
-        int first_hyp = -1, first_hyp_idx = -1, second_hyp = -1;
-        int best = 0;
-        int num_ident = 0;
-        int inliers = 0;
-
-        choose(data_points.size(), indices);
-
-        for (i = 0; i < num_random_points; i++) {
-            r_pts_inner[i] = r_pts_norm[indices[i]];
-            l_pts_inner[i] = l_pts_norm[indices[i]];
-
-            /* Check for degeneracy */
-            if (Vx(r_pts_inner[i] == Vx(l_pts_inner[i]) &&
-                Vy(r_pts_inner[i]) == Vy(l_pts_inner[i]))
-                num_ident++;
-        }
-        
-        if (num_ident >= 3)
-            continue;  /* choose another 5 */
-        
-        generate_Ematrix_hypotheses(num_random_points, r_pts_inner, l_pts_inner, &num_hyp, E);
-        
-        for (i = 0; i < num_hyp; i++) {
-            int best_inlier;
-            double score = 0.0;
-
-            double E2[9], tmp[9], F[9];
-            memcpy(E2, E + 9 * i, 9 * sizeof(double));
-            E2[0] = -E2[0];
-            E2[1] = -E2[1];
-            E2[3] = -E2[3];
-            E2[4] = -E2[4];
-            E2[8] = -E2[8];
-
-            matrix_transpose_product(3, 3, 3, 3, K2_inv, E2, tmp);
-            matrix_product(3, 3, 3, 3, tmp, K1_inv, F);
-
-            inliers = evaluate_Ematrix(n, r_pts, l_pts, // r_pts_norm, l_pts_norm, 
-                                       thresh_norm, F, // E + 9 * i, 
-                                       &best_inlier, &score);
-       
-            if (inliers > max_inliers ||
-                (inliers == max_inliers && score < min_score)) {
-                best = 1;
-                max_inliers = inliers;
-                min_score = score;
-                memcpy(E_best, E + 9 * i, sizeof(double) * 9);
-                r_best = r_pts_norm[best_inlier];
-                l_best = l_pts_norm[best_inlier];
-            }
-
-            inliers_hyp[i] = inliers;
-        }
-
-        if (best) {
-            for (i = 0; i < num_hyp; i++) {
-                if (inliers_hyp[i] > first_hyp) {
-                    first_hyp = inliers_hyp[i];
-                    first_hyp_idx = i;
-                }
-            }
-
-            for (i = 0; i < num_hyp; i++) {
-                if (i != first_hyp_idx && inliers_hyp[i] > second_hyp) {
-                    second_hyp = inliers_hyp[i];
-                }
-            }
-
-            // printf("first: %d, second: %d\n", first_hyp, second_hyp);
-        }
-    }
-
-    if (max_inliers > 0) {
-        int best_inlier;
-        double score;
-        // find_extrinsics_essential(E_best, r_best, l_best, R_out, t_out);
-        int success = 
-            find_extrinsics_essential_multipt(E_best, n, 
-                                              r_pts_norm, l_pts_norm, 
-                                              R_out, t_out);
-        int inliers = 0;
-        double E2[9];
-        double tmp[9], F_best[9];
-
-        if (success == 0) {
-            free(r_pts_norm);
-            free(l_pts_norm);
-            return 0;
-        }
-
-        memcpy(E2, E_best, 9 * sizeof(double));
-        E2[0] = -E2[0];
-        E2[1] = -E2[1];
-        E2[3] = -E2[3];
-        E2[4] = -E2[4];
-        E2[8] = -E2[8];
+    // Gauss-Jordan elimination of the cubic monomials, with partial pivoting,
+    // each row i of the Groebner basis gives monomial_i = -groebner_basis.row(i) * (x2 xy y2 xz yz z2 x y z 1)
+    const PartialPivLU< Matrix<double, 10, 10> > lu(constraints.leftCols<10>());
+    const Matrix<double, 10, 10> groebner_basis = lu.solve(constraints.rightCols<10>());
+
+    if (groebner_basis.allFinite() == false)
+        return false;
+
+    // x * (x2 xy y2 xz yz z2 x y z 1) = (x3 x2y xy2 x2z xyz xz2 x2 xy xz x)
+    action_matrix.setZero();
+    action_matrix.row(0) = -groebner_basis.row(0); // x3
+    action_matrix.row(1) = -groebner_basis.row(1); // x2y
+    action_matrix.row(2) = -groebner_basis.row(2); // xy2
+    action_matrix.row(3) = -groebner_basis.row(4); // x2z
+    action_matrix.row(4) = -groebner_basis.row(5); // xyz
+    action_matrix.row(5) = -groebner_basis.row(7); // xz2
+    action_matrix(6, 0) = 1; // x2
+    action_matrix(7, 1) = 1; // xy
+    action_matrix(8, 3) = 1; // xz
+    action_matrix(9, 6) = 1; // x
+
+    return true;
+}
 
-        matrix_transpose_product(3, 3, 3, 3, K2_inv, E2, tmp);
-        matrix_product(3, 3, 3, 3, tmp, K1_inv, F_best);
 
-        inliers = evaluate_Ematrix(n, r_pts, l_pts, // r_pts_norm, l_pts_norm, 
-                                   thresh_norm, F_best, &best_inlier,
-                                   &score);
+int compute_essential_matrices(const ActionMatrix &action_matrix, const NullspaceBasis &basis,
+                               Matrix3d essential_matrices[max_num_solutions])
+{
+    // the eigenvectors are the basis monomials evaluated at the solutions,
+    // the complex conjugated pairs are discarded
+    const EigenSolver<ActionMatrix> eigen_solver(action_matrix, true);
+    if (eigen_solver.info() != Success)
+        return 0;
+
+    int num_solutions = 0, i;
+    for (i=0; i < 10; i+=1)
+    {
+        if (eigen_solver.eigenvalues()[i].imag() != 0)
+            continue;
+
+        const Matrix<double, 10, 1> monomials = eigen_solver.eigenvectors().col(i).real();
+        if (monomials[9] == 0)
+            continue; // solution at infinity
+
+        const double x = monomials[6] / monomials[9], y = monomials[7] / monomials[9], z = monomials[8] / monomials[9];
+        const Matrix<double, 9, 1> e = x * basis.col(0) + y * basis.col(1) + z * basis.col(2) + basis.col(3);
+        const double norm = e.norm();
+        if (norm == 0 || (norm - norm) != 0) // zero, infinite or nan
+            continue;
+
+        Matrix3d &essential_matrix = essential_matrices[num_solutions];
+        essential_matrix << e[0], e[1], e[2],
+        e[3], e[4], e[5],
+        e[6], e[7], e[8];
+        essential_matrix /= norm;
+        num_solutions += 1;
+    }
+
+    return num_solutions;
+}
 
-        // matrix_print(3, 3, F_best);
 
-        // printf("  inliers: %d / %d [score: %0.3e]\n", inliers, n, score);
-        fflush(stdout);
-    }
+int solve(const NullspaceBasis &basis, Matrix3d essential_matrices[max_num_solutions])
+{
+    ConstraintMatrix constraints;
+    ActionMatrix action_matrix;
 
-    // matrix_print(3, 3, E_best);
+    compute_constraint_matrix(basis, constraints);
+    if (compute_action_matrix(constraints, action_matrix) == false)
+        return 0;
 
-    free(r_pts_norm);
-    free(l_pts_norm);
+    return compute_essential_matrices(action_matrix, basis, essential_matrices);
+}
 
-    return max_inliers;
+int solve(const Vector2d points_a[5], const Vector2d points_b[5], Matrix3d essential_matrices[max_num_solutions])
+{
+    NullspaceBasis basis;
+    compute_nullspace_basis(points_a, points_b, basis);
+    return solve(basis, essential_matrices);
 }
 
 
-}
+} // end of namespace five_point
+
+} // end of namespace uniclop
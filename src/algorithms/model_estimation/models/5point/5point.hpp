@@ -1,4 +1,4 @@
-/* 
+/*
  *  Copyright (c) 2008  Noah Snavely (snavely (at) cs.washington.edu)
  *    and the University of Washington
  *
@@ -14,24 +14,63 @@
  *
  */
 
-/* 5point.h */
+/* 5point.hpp */
 /* Solve the 5-point relative pose problem */
 
-#ifndef 5POINT_HEADER
-#define 5POINT_HEADER
+// Based on Bundler 0.3 5point.c, ported to Eigen fixed size matrices.
+// H. Stewenius, C. Engels and D. Nister "Recent developments on direct relative orientation", 2006
+// (Groebner basis and action matrix formulation of D. Nister's five point solver)
+
+#if !defined(FIVE_POINT_HEADER)
+#define FIVE_POINT_HEADER
 
 #include <Eigen/Core>
 
-namespace 5point {
+namespace uniclop
+{
+
+namespace five_point
+{
+
+const int max_num_solutions = 10;
+
+typedef Eigen::Matrix<double, 9, 4> NullspaceBasis; ///< columns X, Y, Z, W, E = x*X + y*Y + z*Z + W (row major)
+typedef Eigen::Matrix<double, 10, 20> ConstraintMatrix; ///< rows are cubic polynomials of x, y, z
+typedef Eigen::Matrix<double, 10, 10> ActionMatrix;
+
+// The points are calibrated (normalized image coordinates),
+// the essential matrices verify b^T E a = 0 for each pair (a, b).
+// None of these functions allocates memory on the heap.
+
+int solve(const Eigen::Vector2d points_a[5], const Eigen::Vector2d points_b[5],
+          Eigen::Matrix3d essential_matrices[max_num_solutions]);
+///< returns the number of real solutions (0 to 10), the essential matrices have unit Frobenius norm
+
+int solve(const NullspaceBasis &basis, Eigen::Matrix3d essential_matrices[max_num_solutions]);
+///< same as above, starting from a given basis of the epipolar constraints nullspace
+
+void compute_nullspace_basis(const Eigen::Vector2d points_a[5], const Eigen::Vector2d points_b[5],
+                             NullspaceBasis &basis);
+///< four vectors that span the right nullspace of the 5x9 epipolar constraints matrix
+
+void compute_nullspace_basis(const Eigen::Matrix<double, 9, 9> &normal_matrix, NullspaceBasis &basis);
+///< least squares version for n > 5 points, normal_matrix is A^T A for the n x 9 epipolar constraints matrix A
+
+void compute_constraint_matrix(const NullspaceBasis &basis, ConstraintMatrix &constraints);
+///< det(E) = 0 and 2 E E^T E - trace(E E^T) E = 0, in the monomials order
+///< x3 x2y xy2 y3 x2z xyz y2z xz2 yz2 z3 x2 xy y2 xz yz z2 x y z 1
+
+bool compute_action_matrix(const ConstraintMatrix &constraints, ActionMatrix &action_matrix);
+///< Groebner basis by elimination of the 10 first monomials,
+///< then the matrix of the multiplication by x in the basis x2 xy y2 xz yz z2 x y z 1.
+///< Returns false for a degenerate configuration
 
-typedef Eigen:Matrix<float, 3,3> RotationMatrix;
-typedef Eigen:Matrix<float, 3,1> TranslationVector;
+int compute_essential_matrices(const ActionMatrix &action_matrix, const NullspaceBasis &basis,
+                               Eigen::Matrix3d essential_matrices[max_num_solutions]);
+///< one solution per real eigenvector of the action matrix
 
-int compute_pose_ransac(const vector< ScoredMatch> &data_points, 
-                        const CalibrationMatrix &K1, const CalibrationMatrix &K2, 
-                        double ransac_threshold, int ransac_rounds, 
-                        RotationMatrix &R_out,  TranslationVector &t_out);
+} // end of namespace five_point
 
-}
+} // end of namespace uniclop
 
-#endif /* 5POINT_HEADER */
+#endif // FIVE_POINT_HEADER
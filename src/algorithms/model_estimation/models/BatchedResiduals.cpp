@@ -0,0 +1,317 @@
+
+#include "BatchedResiduals.hpp"
+
+#include "algorithms/features/ScoredMatch.hpp"
+
+#include "helpers/cpu_features.hpp"
+
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <immintrin.h>
+#endif
+
+namespace uniclop
+{
+
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// class MatchesCoordinates methods implementation
+
+template<typename T>
+void MatchesCoordinates<T>::set_matches(const vector< ScoredMatch > &matches)
+{
+    const size_t n = matches.size();
+    x_a.resize(n);
+    y_a.resize(n);
+    x_b.resize(n);
+    y_b.resize(n);
+
+    size_t i;
+    for (i=0; i < n; i+=1)
+    {
+        x_a[i] = static_cast<T>(matches[i].feature_a->x);
+        y_a[i] = static_cast<T>(matches[i].feature_a->y);
+        x_b[i] = static_cast<T>(matches[i].feature_b->x);
+        y_b[i] = static_cast<T>(matches[i].feature_b->y);
+    }
+
+    return;
+}
+
+template<typename T>
+size_t MatchesCoordinates<T>::size() const
+{
+    return x_a.size();
+}
+
+template class MatchesCoordinates<float>;
+template class MatchesCoordinates<double>;
+
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Kernels, one copy per instruction set (see BatchedResidualsKernels.inc)
+
+namespace scalar_kernels
+{
+
+/// one match at a time, also used for the last matches of the SIMD versions
+template<typename T>
+class Traits
+{
+public:
+    typedef T scalar_t;
+    typedef T vector_t;
+    typedef bool mask_t;
+    enum { width = 1 };
+
+    static inline vector_t load(const T *p) { return *p; }
+    static inline void store(T *p, const vector_t a) { *p = a; }
+    static inline vector_t set1(const T a) { return a; }
+    static inline vector_t add(const vector_t a, const vector_t b) { return a + b; }
+    static inline vector_t sub(const vector_t a, const vector_t b) { return a - b; }
+    static inline vector_t mul(const vector_t a, const vector_t b) { return a * b; }
+    static inline vector_t div(const vector_t a, const vector_t b) { return a / b; }
+    static inline vector_t sqrt(const vector_t a) { return std::sqrt(a); }
+    static inline mask_t is_not_zero(const vector_t a) { return a != 0; }
+    static inline mask_t logical_and(const mask_t a, const mask_t b) { return a && b; }
+    static inline vector_t select(const mask_t mask, const vector_t a, const vector_t b) { return mask ? a : b; }
+};
+
+#include "BatchedResidualsKernels.inc"
+
+} // end of namespace scalar_kernels
+
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define BATCHED_RESIDUALS_X86_KERNELS
+
+// the target pragmas allow to compile the kernels without changing the global compiler flags,
+// the kernels and the traits need to be defined inside the pragma regions to be compiled for their target
+
+#pragma GCC push_options
+#pragma GCC target("sse2")
+
+namespace sse2_kernels
+{
+
+template<typename T> class Traits;
+
+/// 4 matches at a time
+template<>
+class Traits<float>
+{
+public:
+    typedef float scalar_t;
+    typedef __m128 vector_t;
+    typedef __m128 mask_t;
+    enum { width = 4 };
+
+    static inline vector_t load(const float *p) { return _mm_loadu_ps(p); }
+    static inline void store(float *p, const vector_t a) { _mm_storeu_ps(p, a); }
+    static inline vector_t set1(const float a) { return _mm_set1_ps(a); }
+    static inline vector_t add(const vector_t a, const vector_t b) { return _mm_add_ps(a, b); }
+    static inline vector_t sub(const vector_t a, const vector_t b) { return _mm_sub_ps(a, b); }
+    static inline vector_t mul(const vector_t a, const vector_t b) { return _mm_mul_ps(a, b); }
+    static inline vector_t div(const vector_t a, const vector_t b) { return _mm_div_ps(a, b); }
+    static inline vector_t sqrt(const vector_t a) { return _mm_sqrt_ps(a); }
+    static inline mask_t is_not_zero(const vector_t a) { return _mm_cmpneq_ps(a, _mm_setzero_ps()); }
+    static inline mask_t logical_and(const mask_t a, const mask_t b) { return _mm_and_ps(a, b); }
+    static inline vector_t select(const mask_t mask, const vector_t a, const vector_t b)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+};
+
+/// 2 matches at a time
+template<>
+class Traits<double>
+{
+public:
+    typedef double scalar_t;
+    typedef __m128d vector_t;
+    typedef __m128d mask_t;
+    enum { width = 2 };
+
+    static inline vector_t load(const double *p) { return _mm_loadu_pd(p); }
+    static inline void store(double *p, const vector_t a) { _mm_storeu_pd(p, a); }
+    static inline vector_t set1(const double a) { return _mm_set1_pd(a); }
+    static inline vector_t add(const vector_t a, const vector_t b) { return _mm_add_pd(a, b); }
+    static inline vector_t sub(const vector_t a, const vector_t b) { return _mm_sub_pd(a, b); }
+    static inline vector_t mul(const vector_t a, const vector_t b) { return _mm_mul_pd(a, b); }
+    static inline vector_t div(const vector_t a, const vector_t b) { return _mm_div_pd(a, b); }
+    static inline vector_t sqrt(const vector_t a) { return _mm_sqrt_pd(a); }
+    static inline mask_t is_not_zero(const vector_t a) { return _mm_cmpneq_pd(a, _mm_setzero_pd()); }
+    static inline mask_t logical_and(const mask_t a, const mask_t b) { return _mm_and_pd(a, b); }
+    static inline vector_t select(const mask_t mask, const vector_t a, const vector_t b)
+    {
+        return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+    }
+};
+
+#include "BatchedResidualsKernels.inc"
+
+} // end of namespace sse2_kernels
+
+#pragma GCC pop_options
+
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+namespace avx2_kernels
+{
+
+template<typename T> class Traits;
+
+/// 8 matches at a time
+template<>
+class Traits<float>
+{
+public:
+    typedef float scalar_t;
+    typedef __m256 vector_t;
+    typedef __m256 mask_t;
+    enum { width = 8 };
+
+    static inline vector_t load(const float *p) { return _mm256_loadu_ps(p); }
+    static inline void store(float *p, const vector_t a) { _mm256_storeu_ps(p, a); }
+    static inline vector_t set1(const float a) { return _mm256_set1_ps(a); }
+    static inline vector_t add(const vector_t a, const vector_t b) { return _mm256_add_ps(a, b); }
+    static inline vector_t sub(const vector_t a, const vector_t b) { return _mm256_sub_ps(a, b); }
+    static inline vector_t mul(const vector_t a, const vector_t b) { return _mm256_mul_ps(a, b); }
+    static inline vector_t div(const vector_t a, const vector_t b) { return _mm256_div_ps(a, b); }
+    static inline vector_t sqrt(const vector_t a) { return _mm256_sqrt_ps(a); }
+    static inline mask_t is_not_zero(const vector_t a) { return _mm256_cmp_ps(a, _mm256_setzero_ps(), _CMP_NEQ_UQ); }
+    static inline mask_t logical_and(const mask_t a, const mask_t b) { return _mm256_and_ps(a, b); }
+    static inline vector_t select(const mask_t mask, const vector_t a, const vector_t b)
+    {
+        return _mm256_blendv_ps(b, a, mask);
+    }
+};
+
+/// 4 matches at a time
+template<>
+class Traits<double>
+{
+public:
+    typedef double scalar_t;
+    typedef __m256d vector_t;
+    typedef __m256d mask_t;
+    enum { width = 4 };
+
+    static inline vector_t load(const double *p) { return _mm256_loadu_pd(p); }
+    static inline void store(double *p, const vector_t a) { _mm256_storeu_pd(p, a); }
+    static inline vector_t set1(const double a) { return _mm256_set1_pd(a); }
+    static inline vector_t add(const vector_t a, const vector_t b) { return _mm256_add_pd(a, b); }
+    static inline vector_t sub(const vector_t a, const vector_t b) { return _mm256_sub_pd(a, b); }
+    static inline vector_t mul(const vector_t a, const vector_t b) { return _mm256_mul_pd(a, b); }
+    static inline vector_t div(const vector_t a, const vector_t b) { return _mm256_div_pd(a, b); }
+    static inline vector_t sqrt(const vector_t a) { return _mm256_sqrt_pd(a); }
+    static inline mask_t is_not_zero(const vector_t a) { return _mm256_cmp_pd(a, _mm256_setzero_pd(), _CMP_NEQ_UQ); }
+    static inline mask_t logical_and(const mask_t a, const mask_t b) { return _mm256_and_pd(a, b); }
+    static inline vector_t select(const mask_t mask, const vector_t a, const vector_t b)
+    {
+        return _mm256_blendv_pd(b, a, mask);
+    }
+};
+
+#include "BatchedResidualsKernels.inc"
+
+} // end of namespace avx2_kernels
+
+#pragma GCC pop_options
+
+#endif // x86 kernels
+
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Dispatching, the SIMD kernels process most of the matches and the scalar kernel the remaining ones
+
+template<typename T>
+static void dispatch_symmetric_transfer_errors(const T homography[9], const T inverse_homography[9],
+                                               const MatchesCoordinates<T> &coordinates, vector<T> &residuals)
+{
+    const size_t n = coordinates.size();
+    residuals.resize(n);
+    if (n == 0)
+        return;
+
+    const T *x_a = &coordinates.x_a[0], *y_a = &coordinates.y_a[0];
+    const T *x_b = &coordinates.x_b[0], *y_b = &coordinates.y_b[0];
+    T *out = &residuals[0];
+
+    size_t i = 0;
+#if defined(BATCHED_RESIDUALS_X86_KERNELS)
+    if (cpu_has_avx2())
+        i = avx2_kernels::symmetric_transfer_errors< avx2_kernels::Traits<T> >(
+                homography, inverse_homography, x_a, y_a, x_b, y_b, n, out);
+    else if (cpu_has_sse2())
+        i = sse2_kernels::symmetric_transfer_errors< sse2_kernels::Traits<T> >(
+                homography, inverse_homography, x_a, y_a, x_b, y_b, n, out);
+#endif
+
+    scalar_kernels::symmetric_transfer_errors< scalar_kernels::Traits<T> >(
+        homography, inverse_homography, x_a + i, y_a + i, x_b + i, y_b + i, n - i, out + i);
+    return;
+}
+
+template<typename T>
+static void dispatch_sampson_errors(const T fundamental_matrix[9],
+                                    const MatchesCoordinates<T> &coordinates, vector<T> &residuals)
+{
+    const size_t n = coordinates.size();
+    residuals.resize(n);
+    if (n == 0)
+        return;
+
+    const T *x_a = &coordinates.x_a[0], *y_a = &coordinates.y_a[0];
+    const T *x_b = &coordinates.x_b[0], *y_b = &coordinates.y_b[0];
+    T *out = &residuals[0];
+
+    size_t i = 0;
+#if defined(BATCHED_RESIDUALS_X86_KERNELS)
+    if (cpu_has_avx2())
+        i = avx2_kernels::sampson_errors< avx2_kernels::Traits<T> >(
+                fundamental_matrix, x_a, y_a, x_b, y_b, n, out);
+    else if (cpu_has_sse2())
+        i = sse2_kernels::sampson_errors< sse2_kernels::Traits<T> >(
+                fundamental_matrix, x_a, y_a, x_b, y_b, n, out);
+#endif
+
+    scalar_kernels::sampson_errors< scalar_kernels::Traits<T> >(
+        fundamental_matrix, x_a + i, y_a + i, x_b + i, y_b + i, n - i, out + i);
+    return;
+}
+
+
+void compute_symmetric_transfer_errors(const float homography[9], const float inverse_homography[9],
+                                       const MatchesCoordinates<float> &coordinates, vector<float> &residuals)
+{
+    dispatch_symmetric_transfer_errors(homography, inverse_homography, coordinates, residuals);
+    return;
+}
+
+void compute_symmetric_transfer_errors(const double homography[9], const double inverse_homography[9],
+                                       const MatchesCoordinates<double> &coordinates, vector<double> &residuals)
+{
+    dispatch_symmetric_transfer_errors(homography, inverse_homography, coordinates, residuals);
+    return;
+}
+
+void compute_sampson_errors(const float fundamental_matrix[9],
+                            const MatchesCoordinates<float> &coordinates, vector<float> &residuals)
+{
+    dispatch_sampson_errors(fundamental_matrix, coordinates, residuals);
+    return;
+}
+
+void compute_sampson_errors(const double fundamental_matrix[9],
+                            const MatchesCoordinates<double> &coordinates, vector<double> &residuals)
+{
+    dispatch_sampson_errors(fundamental_matrix, coordinates, residuals);
+    return;
+}
+
+
+} // end of namespace uniclop
@@ -0,0 +1,57 @@
+#if !defined(BATCHED_RESIDUALS_HEADER)
+#define BATCHED_RESIDUALS_HEADER
+
+// Residuals of the two view models, computed on batches of matches
+// stored as contiguous coordinates arrays.
+// Uses SSE2 or AVX2 kernels when the cpu supports them (checked at runtime).
+// Compared to the per match compute_residuals (double arithmetic), the relative difference
+// (absolute below 1 pixel) is under 1e-6 for the double variants and under 1e-3 for the
+// float variants; residuals_benchmark checks it on random homographies.
+// So far only residuals_benchmark uses these functions, the estimators do not.
+
+#include <vector>
+#include <cstddef>
+
+namespace uniclop
+{
+
+using namespace std;
+
+class ScoredMatch;
+
+/// Coordinates of a list of matches, as a structure of arrays.
+/// Reading the coordinates once avoids following the two IFeature pointers of each match
+/// every time a model is evaluated, and allows to process several matches per SIMD instruction.
+template<typename T>
+class MatchesCoordinates
+{
+public:
+    vector<T> x_a, y_a, x_b, y_b;
+
+    void set_matches(const vector< ScoredMatch > &matches);
+
+    size_t size() const;
+};
+
+
+/// symmetric transfer error sqrt(|H*a - b|^2 + |H^-1*b - a|^2) of each match,
+/// the inverse homography only needs to be known up to scale
+/// (1e10 when a point is transferred to infinity)
+void compute_symmetric_transfer_errors(const float homography[9], const float inverse_homography[9],
+                                       const MatchesCoordinates<float> &coordinates, vector<float> &residuals);
+
+void compute_symmetric_transfer_errors(const double homography[9], const double inverse_homography[9],
+                                       const MatchesCoordinates<double> &coordinates, vector<double> &residuals);
+
+/// squared Sampson distance (b^T*F*a)^2 / ((F*a)_x^2 + (F*a)_y^2 + (F^T*b)_x^2 + (F^T*b)_y^2) of each match,
+/// the first order approximation of the squared geometric error
+/// (1e10 when the epipolar lines are not defined)
+void compute_sampson_errors(const float fundamental_matrix[9],
+                            const MatchesCoordinates<float> &coordinates, vector<float> &residuals);
+
+void compute_sampson_errors(const double fundamental_matrix[9],
+                            const MatchesCoordinates<double> &coordinates, vector<double> &residuals);
+
+}
+
+#endif // BATCHED_RESIDUALS_HEADER
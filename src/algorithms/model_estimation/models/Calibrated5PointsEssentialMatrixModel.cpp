@@ -0,0 +1,260 @@
+
+#include "Calibrated5PointsEssentialMatrixModel.hpp"
+#include "algorithms/features/ScoredMatch.hpp"
+
+#include <stdexcept>
+
+namespace uniclop
+{
+
+using Eigen::Matrix3d;
+using Eigen::Vector2d;
+
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Class Calibrated5PointsEssentialMatrixModel: IParametricModel methods implementation
+
+Calibrated5PointsEssentialMatrixModel::Calibrated5PointsEssentialMatrixModel
+(const float _focal_length, const float _center_x, const float _center_y)
+        : focal_length(_focal_length), center_x(_center_x), center_y(_center_y)
+{
+    if (focal_length <= 0)
+        throw runtime_error("Calibrated5PointsEssentialMatrixModel expects a positive focal length");
+
+    num_hypotheses = 0;
+    parameters.resize( get_num_parameters() );
+    parameters.clear();
+    fundamental_parameters.resize(9);
+    update_fundamental_matrix();
+    return;
+}
+
+Calibrated5PointsEssentialMatrixModel::~Calibrated5PointsEssentialMatrixModel()
+{
+    return;
+}
+
+
+unsigned int Calibrated5PointsEssentialMatrixModel::get_num_parameters() const
+{ // get the number of free parameters of the model
+    return 9;
+}
+
+unsigned int Calibrated5PointsEssentialMatrixModel::get_num_points_to_estimate() const
+{ // m: is the number of points required to estimate the parameters of the model
+    return 5;
+}
+
+
+void Calibrated5PointsEssentialMatrixModel::normalize
+(const ScoredMatch &data_point, Vector2d &point_a, Vector2d &point_b) const
+{
+    // K^-1 * (x, y, 1)
+    point_a[0] = (data_point.feature_a->x - center_x) / focal_length;
+    point_a[1] = (data_point.feature_a->y - center_y) / focal_length;
+    point_b[0] = (data_point.feature_b->x - center_x) / focal_length;
+    point_b[1] = (data_point.feature_b->y - center_y) / focal_length;
+    return;
+}
+
+
+void Calibrated5PointsEssentialMatrixModel::estimate_from_minimal_set(const vector< ScoredMatch > &data_points)
+{ // given m points estimate the parameters vector
+
+    // all the solutions fit the five points equally well,
+    // without more data the first one is kept
+    if ( estimate_hypotheses_from_minimal_set(data_points) == 0 )
+        throw runtime_error("Calibrated5PointsEssentialMatrixModel::estimate_from_minimal_set failed");
+
+    return;
+}
+
+int Calibrated5PointsEssentialMatrixModel::estimate_hypotheses_from_minimal_set(const vector< ScoredMatch > &data_points)
+{
+    if ( data_points.size() < get_num_points_to_estimate())
+        throw runtime_error("Not enough points to estimate the Calibrated5PointsEssentialMatrixModel parameters");
+
+    Vector2d points_a[5], points_b[5];
+    int i;
+    for (i=0; i < 5; i+=1)
+        normalize(data_points[i], points_a[i], points_b[i]);
+
+    num_hypotheses = five_point::solve(points_a, points_b, hypotheses);
+    update_hypotheses();
+
+    if ( num_hypotheses > 0 )
+        select_hypothesis(0);
+    return num_hypotheses;
+}
+
+void Calibrated5PointsEssentialMatrixModel::estimate(const vector< ScoredMatch > &data_points)
+{ // given n>m points, estimate the parameters vector
+
+    if ( data_points.size() < get_num_points_to_estimate())
+        throw runtime_error("Not enough points to estimate the Calibrated5PointsEssentialMatrixModel parameters");
+
+    // A^T A for the n x 9 epipolar constraints matrix A
+    Eigen::Matrix<double, 9, 9> normal_matrix = Eigen::Matrix<double, 9, 9>::Zero();
+    Eigen::Matrix<double, 9, 1> constraint;
+    Vector2d a, b;
+    vector< ScoredMatch >::const_iterator data_points_it;
+    for (data_points_it = data_points.begin(); data_points_it != data_points.end(); ++data_points_it)
+    {
+        normalize(*data_points_it, a, b);
+        constraint << a[0]*b[0], a[1]*b[0], b[0], a[0]*b[1], a[1]*b[1], b[1], a[0], a[1], 1.0;
+        normal_matrix.selfadjointView<Eigen::Lower>().rankUpdate(constraint);
+    }
+
+    five_point::NullspaceBasis basis;
+    five_point::compute_nullspace_basis(normal_matrix.selfadjointView<Eigen::Lower>(), basis);
+    num_hypotheses = five_point::solve(basis, hypotheses);
+    update_hypotheses();
+
+    if ( num_hypotheses == 0 )
+        throw runtime_error("Calibrated5PointsEssentialMatrixModel::estimate failed");
+
+    // the data points are expected to be inliers, the solution that fits them best is kept
+    double residuals_sums[five_point::max_num_solutions] = {0};
+    float residuals[five_point::max_num_solutions];
+    int index;
+    for (data_points_it = data_points.begin(); data_points_it != data_points.end(); ++data_points_it)
+    {
+        compute_hypotheses_residual(*data_points_it, residuals);
+        for (index=0; index < num_hypotheses; index+=1)
+            residuals_sums[index] += residuals[index];
+    }
+
+    int best_index = 0;
+    for (index=1; index < num_hypotheses; index+=1)
+    {
+        if (residuals_sums[index] < residuals_sums[best_index])
+            best_index = index;
+    }
+
+    select_hypothesis(best_index);
+    return;
+}
+
+
+unsigned int Calibrated5PointsEssentialMatrixModel::get_max_num_hypotheses() const
+{
+    return five_point::max_num_solutions;
+}
+
+int Calibrated5PointsEssentialMatrixModel::get_num_hypotheses() const
+{
+    return num_hypotheses;
+}
+
+void Calibrated5PointsEssentialMatrixModel::select_hypothesis(const int index)
+{
+    if (index < 0 || index >= num_hypotheses)
+        throw runtime_error("Calibrated5PointsEssentialMatrixModel::select_hypothesis index out of range");
+
+    int r, c;
+    for (r=0; r < 3; r+=1)
+        for (c=0; c < 3; c+=1)
+            parameters[3*r + c] = static_cast<float>(hypotheses[index](r, c));
+    update_fundamental_matrix();
+    return;
+}
+
+
+const ublas::vector<float>& Calibrated5PointsEssentialMatrixModel::get_parameters() const
+{ // get current estimate of the parameters
+    return parameters;
+}
+
+IParametricModel *Calibrated5PointsEssentialMatrixModel::clone() const
+{
+    return new Calibrated5PointsEssentialMatrixModel(*this);
+}
+
+void Calibrated5PointsEssentialMatrixModel::set_parameters(const ublas::vector<float> &_parameters)
+{
+    // set an initial guess of the parameters
+    // (useful when the model use iterative methods to estimate his parameters)
+    if (_parameters.size() != get_num_parameters())
+        throw runtime_error("Calibrated5PointsEssentialMatrixModel::set_parameters expects 9 parameters");
+
+    parameters = _parameters;
+    update_fundamental_matrix();
+    num_hypotheses = 0; // the hypotheses of the last estimation do not match the parameters anymore
+    return;
+}
+
+void Calibrated5PointsEssentialMatrixModel::compute_fundamental_matrix
+(const Matrix3d &essential_matrix, double fundamental_matrix[9]) const
+{
+    // F = K^-T E K^-1, with K^-1 = [1/f 0 -cx/f; 0 1/f -cy/f; 0 0 1]
+    Matrix3d k_inverse;
+    k_inverse << 1 / focal_length, 0, -center_x / focal_length,
+    0, 1 / focal_length, -center_y / focal_length,
+    0, 0, 1;
+
+    const Matrix3d f = k_inverse.transpose() * essential_matrix * k_inverse;
+    int r, c;
+    for (r=0; r < 3; r+=1)
+        for (c=0; c < 3; c+=1)
+            fundamental_matrix[3*r + c] = f(r, c);
+    return;
+}
+
+void Calibrated5PointsEssentialMatrixModel::update_fundamental_matrix()
+{
+    Matrix3d essential_matrix;
+    int r, c;
+    for (r=0; r < 3; r+=1)
+        for (c=0; c < 3; c+=1)
+            essential_matrix(r, c) = parameters[3*r + c];
+
+    double fundamental_matrix[9];
+    compute_fundamental_matrix(essential_matrix, fundamental_matrix);
+
+    int i;
+    for (i=0; i < 9; i+=1)
+        fundamental_parameters[i] = static_cast<float>(fundamental_matrix[i]);
+
+    fundamental_matrix_model.set_parameters(fundamental_parameters);
+    return;
+}
+
+void Calibrated5PointsEssentialMatrixModel::update_hypotheses()
+{
+    int index;
+    for (index=0; index < num_hypotheses; index+=1)
+        compute_fundamental_matrix(hypotheses[index], hypotheses_fundamental_matrices[index]);
+    return;
+}
+
+void Calibrated5PointsEssentialMatrixModel::compute_residuals
+(const vector< ScoredMatch > &data_points, vector<float> &residuals) const
+{
+    // residuals -> errors
+    // Compute the residuals relative to the given parameter vector.
+    fundamental_matrix_model.compute_residuals(data_points, residuals);
+    return;
+}
+
+float Calibrated5PointsEssentialMatrixModel::compute_residual(const ScoredMatch &data_point) const
+{
+    // sum of the squared distances from the points to their epipolar lines, in pixels
+    return fundamental_matrix_model.compute_residual(data_point);
+}
+
+void Calibrated5PointsEssentialMatrixModel::compute_hypotheses_residual
+(const ScoredMatch &data_point, float residuals[]) const
+{
+    // the coordinates are loaded once, then each hypothesis is a few multiply-adds
+    const double left_x = data_point.feature_a->x, left_y = data_point.feature_a->y;
+    const double right_x = data_point.feature_b->x, right_y = data_point.feature_b->y;
+
+    int index;
+    for (index=0; index < num_hypotheses; index+=1)
+        residuals[index] = compute_epipolar_residual(hypotheses_fundamental_matrices[index],
+                                                     left_x, left_y, right_x, right_y);
+    return;
+}
+
+
+} // end of namespace uniclop
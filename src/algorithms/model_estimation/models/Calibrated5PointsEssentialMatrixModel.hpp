@@ -3,5 +3,100 @@
 // Based on Bundler 5point implementation
 // http://phototour.cs.washington.edu/bundler/
 
+#if !defined(CALIBRATED_5POINTS_ESSENTIAL_MATRIX_MODEL_HEADER)
+#define CALIBRATED_5POINTS_ESSENTIAL_MATRIX_MODEL_HEADER
 
+// class Calibrated5PointsEssentialMatrixModel
 
+#include "../IParametricModel.hpp"
+#include "FundamentalMatrixModel.hpp"
+#include "5point/5point.hpp"
+
+#include <Eigen/Core>
+
+namespace uniclop
+{
+class ScoredMatch;
+
+
+class Calibrated5PointsEssentialMatrixModel: public IParametricModel
+{
+    // relative pose of a calibrated camera,
+    // both views share the same intrinsic parameters (square pixels, no skew)
+
+    float focal_length, center_x, center_y;
+
+    ublas::vector<float> parameters; ///< the essential matrix, row major, b^T E a = 0 in normalized coordinates
+
+    /// F = K^-T E K^-1, updated each time the parameters change,
+    /// so that the residuals are in pixels, like the FundamentalMatrixModel ones
+    FundamentalMatrixModel fundamental_matrix_model;
+    ublas::vector<float> fundamental_parameters;
+
+    /// all the solutions of the last estimation, the parameters hold one of them
+    Eigen::Matrix3d hypotheses[five_point::max_num_solutions];
+    double hypotheses_fundamental_matrices[five_point::max_num_solutions][9]; ///< K^-T E K^-1, row major
+    int num_hypotheses;
+
+    void compute_fundamental_matrix(const Eigen::Matrix3d &essential_matrix, double fundamental_matrix[9]) const;
+    void update_fundamental_matrix();
+    void update_hypotheses();
+    void normalize(const ScoredMatch &data_point, Eigen::Vector2d &point_a, Eigen::Vector2d &point_b) const;
+
+public:
+    Calibrated5PointsEssentialMatrixModel(const float focal_length = 1, const float center_x = 0, const float center_y = 0);
+    ~Calibrated5PointsEssentialMatrixModel();
+
+    ///@name IParametricModel interface
+    ///@{
+    unsigned int get_num_parameters() const;
+    // get the number of free parameters of the model
+
+    unsigned int get_num_points_to_estimate() const;
+    // m: is the number of points required to estimate the parameters of the model
+
+    void estimate_from_minimal_set(const vector< ScoredMatch> &data_points);
+    // given m points estimate the parameters vector
+    // (the first of the up to 10 solutions, see estimate_hypotheses_from_minimal_set)
+
+    void estimate(const vector< ScoredMatch > &data_points); // given n>m points, estimate the parameters vector
+    // least squares nullspace of the epipolar constraints, then the solution with the lowest residuals
+
+    const ublas::vector<float>& get_parameters() const;
+    // get current estimate of the parameters
+
+    void set_parameters(const ublas::vector<float> &);
+    // set an initial guess of the parameters
+    // (useful when the model use iterative methods to estimate his parameters)
+
+    void compute_residuals (const vector< ScoredMatch > &data_points, vector<float> &residuals) const;
+    // residuals -> errors
+    // Compute the residuals relative to the given parameter vector.
+
+    float compute_residual(const ScoredMatch &data_point) const;
+
+    IParametricModel *clone() const;
+
+    unsigned int get_max_num_hypotheses() const;
+
+    int estimate_hypotheses_from_minimal_set(const vector< ScoredMatch > &data_points);
+    // all the real solutions of the five point problem, the parameters hold the first one
+
+    void select_hypothesis(const int index);
+    // sets the parameters to the given solution of the last estimation
+
+    void compute_hypotheses_residual(const ScoredMatch &data_point, float residuals[]) const;
+
+    ///@}
+
+    int get_num_hypotheses() const;
+    ///< number of solutions of the last estimation
+
+}
+; // end of class Calibrated5PointsEssentialMatrixModel declaration
+
+
+} // end of namespace uniclop
+
+
+#endif // !defined(CALIBRATED_5POINTS_ESSENTIAL_MATRIX_MODEL_HEADER)
@@ -3,36 +3,40 @@
 #include "FundamentalMatrixModel.hpp"
 #include "algorithms/features/ScoredMatch.hpp"
 
-// RANSAC implementation requires VXL installed
-// with the RREL and GEL/vpgl contributions
+#include <Eigen/Core>
+#include <Eigen/LU>
+#include <Eigen/SVD>
+#include <Eigen/Eigenvalues>
 
-#include <vxl/vcl/vcl_iostream.h>
-
-#include <vxl/core/vnl/vnl_math.h>
-
-#include <vxl/core/vgl/algo/vgl_homg_operators_2d.h>
-
-#include <vxl/contrib/rpl/rrel/rrel_muset_obj.h>
-#include <vxl/contrib/rpl/rrel/rrel_ran_sam_search.h>
-#include <vxl/contrib/rpl/rrel/rrel_homography2d_est.h>
-
-#include <vxl/contrib/gel/mrc/vpgl/vpgl_fundamental_matrix.h>
-#include <vxl/contrib/gel/mrc/vpgl/algo/vpgl_fm_compute_ransac.h>
-#include <vxl/contrib/gel/mrc/vpgl/algo/vpgl_fm_compute_8_point.h>
-
-#include <boost/numeric/ublas/io.hpp>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
 
 namespace uniclop
 {
 
+using Eigen::Matrix3d;
+typedef Eigen::Matrix<double, 9, 1> Vector9d;
+typedef Eigen::Matrix<double, 3, 3, Eigen::RowMajor> RowMajorMatrix3d;
 
 
 // ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
 // Class FundamentalMatrixModel: IParametricModel< ScoredMatch > methods implementation
 
-FundamentalMatrixModel::FundamentalMatrixModel()
+FundamentalMatrixModel::FundamentalMatrixModel(const int _num_points_to_estimate, const float _homography_threshold)
+        : num_points_to_estimate(_num_points_to_estimate), homography_threshold(_homography_threshold)
 {
+    if (num_points_to_estimate != 7 && num_points_to_estimate != 8)
+        throw runtime_error("FundamentalMatrixModel expects minimal sets of 7 or 8 points");
+
+    if (homography_threshold < 0)
+        throw runtime_error("FundamentalMatrixModel homography_threshold should be positive (or 0 to disable the degeneracy test)");
+
+    num_hypotheses = 0;
+    num_degenerate_samples = 0;
     parameters.resize( get_num_parameters() );
+    parameters.clear();
+    update_matrix();
     return;
 }
 
@@ -49,63 +53,588 @@ unsigned int FundamentalMatrixModel::get_num_parameters() const
 
 unsigned int FundamentalMatrixModel::get_num_points_to_estimate() const
 { // m: is the number of points required to estimate the parameters of the model
-    return 8;
+    return num_points_to_estimate;
+}
+
+unsigned int FundamentalMatrixModel::get_max_num_hypotheses() const
+{
+    return (num_points_to_estimate == 7) ? 3 : 1;
+}
+
+int FundamentalMatrixModel::get_num_degenerate_samples() const
+{
+    return num_degenerate_samples;
+}
+
+
+// helper function, similarities that move the centroid of the points to the origin
+// and their mean distance to it to sqrt(2), for the feature_a and the feature_b points
+static void compute_normalizations(const vector< ScoredMatch > &data_points, const int num_points,
+                                   Matrix3d &transform_a, Matrix3d &transform_b)
+{
+    double sum_a_x = 0, sum_a_y = 0, sum_b_x = 0, sum_b_y = 0;
+    int i;
+    for (i=0; i < num_points; i+=1)
+    {
+        sum_a_x += data_points[i].feature_a->x;
+        sum_a_y += data_points[i].feature_a->y;
+        sum_b_x += data_points[i].feature_b->x;
+        sum_b_y += data_points[i].feature_b->y;
+    }
+
+    const double center_a_x = sum_a_x / num_points, center_a_y = sum_a_y / num_points;
+    const double center_b_x = sum_b_x / num_points, center_b_y = sum_b_y / num_points;
+
+    double sum_distance_a = 0, sum_distance_b = 0;
+    for (i=0; i < num_points; i+=1)
+    {
+        const double a_x = data_points[i].feature_a->x - center_a_x, a_y = data_points[i].feature_a->y - center_a_y;
+        const double b_x = data_points[i].feature_b->x - center_b_x, b_y = data_points[i].feature_b->y - center_b_y;
+        sum_distance_a += sqrt(a_x*a_x + a_y*a_y);
+        sum_distance_b += sqrt(b_x*b_x + b_y*b_y);
+    }
+
+    if (sum_distance_a == 0 || sum_distance_b == 0)
+        throw runtime_error("FundamentalMatrixModel received coincident points");
+
+    const double scale_a = sqrt(2.0) * num_points / sum_distance_a;
+    const double scale_b = sqrt(2.0) * num_points / sum_distance_b;
+
+    transform_a << scale_a, 0, -scale_a * center_a_x,
+    0, scale_a, -scale_a * center_a_y,
+    0, 0, 1;
+
+    transform_b << scale_b, 0, -scale_b * center_b_x,
+    0, scale_b, -scale_b * center_b_y,
+    0, 0, 1;
+    return;
+}
+
+// helper function, the row of b^T F a = 0 for F in row major order, in normalized coordinates
+static void compute_epipolar_constraint(const ScoredMatch &data_point,
+                                        const Matrix3d &transform_a, const Matrix3d &transform_b,
+                                        Vector9d &constraint)
+{
+    const double a_x = transform_a(0, 0) * data_point.feature_a->x + transform_a(0, 2);
+    const double a_y = transform_a(1, 1) * data_point.feature_a->y + transform_a(1, 2);
+    const double b_x = transform_b(0, 0) * data_point.feature_b->x + transform_b(0, 2);
+    const double b_y = transform_b(1, 1) * data_point.feature_b->y + transform_b(1, 2);
+
+    constraint << a_x*b_x, a_y*b_x, b_x, a_x*b_y, a_y*b_y, b_y, a_x, a_y, 1.0;
+    return;
+}
+
+// helper function, F = T_b^T F' T_a, with unit Frobenius norm
+static bool denormalize(const Matrix3d &normalized_f, const Matrix3d &transform_a, const Matrix3d &transform_b,
+                        double f[9])
+{
+    const Matrix3d denormalized_f = transform_b.transpose() * normalized_f * transform_a;
+    const double norm = denormalized_f.norm();
+    if (norm == 0 || (norm - norm) != 0) // zero, infinite or nan
+        return false;
+
+    Eigen::Map<RowMajorMatrix3d> f_map(f);
+    f_map = denormalized_f / norm;
+    return true;
+}
+
+// helper function, real roots of c3 x^3 + c2 x^2 + c1 x + c0 = 0
+static int solve_cubic(const double c3, const double c2, const double c1, const double c0, double roots[3])
+{
+    const double scale = max(max(fabs(c3), fabs(c2)), max(fabs(c1), fabs(c0)));
+    if (scale == 0)
+        return 0;
+
+    int num_roots = 0;
+    if (fabs(c3) < 1e-12 * scale)
+    { // the leading coefficient vanishes, quadratic or linear equation
+        if (fabs(c2) < 1e-12 * scale)
+        {
+            if (c1 == 0)
+                return 0;
+            roots[0] = -c0 / c1;
+            return 1;
+        }
+
+        const double discriminant = c1*c1 - 4*c2*c0;
+        if (discriminant < 0)
+            return 0;
+
+        // the numerically stable form, without cancellation
+        const double q = -0.5 * (c1 + ((c1 < 0) ? -sqrt(discriminant) : sqrt(discriminant)));
+        roots[num_roots++] = q / c2;
+        if (q != 0)
+            roots[num_roots++] = c0 / q;
+        return num_roots;
+    }
+
+    // depressed cubic t^3 + p t + q = 0, with x = t - b/3
+    const double b = c2 / c3, c = c1 / c3, d = c0 / c3;
+    const double p = c - b*b / 3;
+    const double q = 2*b*b*b / 27 - b*c / 3 + d;
+    const double offset = -b / 3;
+    const double discriminant = q*q / 4 + p*p*p / 27;
+
+    if (discriminant > 0)
+    { // one real root, Cardano's formula
+        const double sqrt_discriminant = sqrt(discriminant);
+        const double u = -q / 2 + sqrt_discriminant, v = -q / 2 - sqrt_discriminant;
+        const double cbrt_u = (u < 0) ? -pow(-u, 1.0 / 3) : pow(u, 1.0 / 3);
+        const double cbrt_v = (v < 0) ? -pow(-v, 1.0 / 3) : pow(v, 1.0 / 3);
+        roots[num_roots++] = cbrt_u + cbrt_v + offset;
+    }
+    else if (p == 0)
+    { // triple root
+        roots[num_roots++] = offset;
+    }
+    else
+    { // three real roots, trigonometric method
+        const double r = 2 * sqrt(-p / 3);
+        const double cosine = max(-1.0, min(1.0, (3 * q) / (2 * p) * sqrt(-3 / p)));
+        const double phi = acos(cosine) / 3;
+        const double two_pi_third = 2.0943951023931957;
+        int k;
+        for (k=0; k < 3; k+=1)
+            roots[num_roots++] = r * cos(phi - k * two_pi_third) + offset;
+    }
+
+    // one Newton step refines the closed form roots
+    int i;
+    for (i=0; i < num_roots; i+=1)
+    {
+        const double x = roots[i];
+        const double value = ((c3*x + c2)*x + c1)*x + c0;
+        const double derivative = (3*c3*x + 2*c2)*x + c1;
+        if (derivative != 0)
+            roots[i] = x - value / derivative;
+    }
+
+    return num_roots;
+}
+
+
+// helper function, normalized eight point algorithm on the num_points first data points,
+// least squares solution of the epipolar constraints with rank 2 enforced
+static bool solve_eight_points(const vector< ScoredMatch > &data_points, const int num_points, double f[9])
+{
+    Matrix3d transform_a, transform_b;
+    compute_normalizations(data_points, num_points, transform_a, transform_b);
+
+    // A^T A for the n x 9 epipolar constraints matrix A
+    Eigen::Matrix<double, 9, 9> normal_matrix = Eigen::Matrix<double, 9, 9>::Zero();
+    Vector9d constraint;
+    int i;
+    for (i=0; i < num_points; i+=1)
+    {
+        compute_epipolar_constraint(data_points[i], transform_a, transform_b, constraint);
+        normal_matrix.selfadjointView<Eigen::Lower>().rankUpdate(constraint);
+    }
+
+    // the eigenvector of the smallest eigenvalue
+    const Eigen::SelfAdjointEigenSolver< Eigen::Matrix<double, 9, 9> >
+    eigen_solver(normal_matrix.selfadjointView<Eigen::Lower>());
+    const Vector9d solution = eigen_solver.eigenvectors().col(0);
+
+    // closest rank 2 matrix, in Frobenius norm
+    const Eigen::JacobiSVD<Matrix3d> svd(Matrix3d(Eigen::Map<const RowMajorMatrix3d>(solution.data())),
+                                         Eigen::ComputeFullU | Eigen::ComputeFullV);
+    const Eigen::Vector3d singular_values(svd.singularValues()[0], svd.singularValues()[1], 0);
+    const Matrix3d normalized_f = svd.matrixU() * singular_values.asDiagonal() * svd.matrixV().transpose();
+
+    return denormalize(normalized_f, transform_a, transform_b, f);
 }
 
 
 void FundamentalMatrixModel::estimate_from_minimal_set(const vector< ScoredMatch > &data_points)
 { // given m points estimate the parameters vector
 
-    // based on vxl rrel_fm_problem::fit_from_minimal_set
+    // the solutions fit the minimal set equally well,
+    // without more data the first one is kept
+    if ( estimate_hypotheses_from_minimal_set(data_points) == 0 )
+        throw runtime_error("FundamentalMatrixModel::estimate_from_minimal_set failed");
+
+    return;
+}
+
+int FundamentalMatrixModel::estimate_hypotheses_from_minimal_set(const vector< ScoredMatch > &data_points)
+{
     if ( data_points.size() < get_num_points_to_estimate())
         throw runtime_error("Not enough points to estimate the FundamentalMatrixModel parameters");
 
-    vcl_vector< vgl_homg_point_2d<double> > set_pr, set_pl;
-    for ( int i = 0; i < 8; i++ )
+    num_hypotheses = 0;
+
+    if (num_points_to_estimate == 8)
     {
-        const ScoredMatch data_point = data_points[i];
-        set_pr.push_back( vgl_homg_point_2d<double>(data_point.feature_b->x, data_point.feature_b->y) );
-        set_pl.push_back( vgl_homg_point_2d<double>(data_point.feature_a->x, data_point.feature_a->y) );
+        if (solve_eight_points(data_points, 8, hypotheses[0]))
+        {
+            num_hypotheses = 1;
+            select_hypothesis(0);
+        }
+        return num_hypotheses;
     }
 
-    vpgl_fundamental_matrix<double> fundamental_matrix;
-    vpgl_fm_compute_8_point fmc8(true);
-    bool success = fmc8.compute( set_pr, set_pl, fundamental_matrix );
+    // seven point algorithm
+    Matrix3d transform_a, transform_b;
+    compute_normalizations(data_points, 7, transform_a, transform_b);
 
-    if ( success == false )
-        throw runtime_error("FundamentalMatrixModel::estimate_from_minimal_set failed");
-
-    // fundamental_matrix_to_parameters( fundamental_matrix, parameters );
-    parameters.resize(9);
-    vnl_matrix_fixed<double,3,3> fm_vnl = fundamental_matrix.get_matrix();
-    for ( int r = 0; r < 3; r++ )
-        for ( int c = 0; c < 3; c++ )
-            parameters[ 3*r + c ] = fm_vnl( r, c );
+    Eigen::Matrix<double, 7, 9> constraints;
+    Vector9d constraint;
+    int i;
+    for (i=0; i < 7; i+=1)
+    {
+        compute_epipolar_constraint(data_points[i], transform_a, transform_b, constraint);
+        constraints.row(i) = constraint.transpose();
+    }
 
-    if ( false ) cout << "FundamentalMatrixModel parameters: " << parameters << endl;
+    // the right nullspace is two dimensional, F = x * F1 + (1 - x) * F2
+    const Eigen::JacobiSVD< Eigen::Matrix<double, 7, 9> > svd(constraints, Eigen::ComputeFullV);
+    if (svd.singularValues()[6] <= 1e-10 * svd.singularValues()[0])
+        return 0; // degenerate configuration, the nullspace is larger
+
+    const Vector9d f1 = svd.matrixV().col(7), f2 = svd.matrixV().col(8);
+    const RowMajorMatrix3d matrix_2 = Eigen::Map<const RowMajorMatrix3d>(f2.data());
+    const RowMajorMatrix3d difference = Eigen::Map<const RowMajorMatrix3d>(f1.data()) - matrix_2;
+
+    // det(F2 + x * (F1 - F2)) = c3 x^3 + c2 x^2 + c1 x + c0, from its values at 0, 1 and -1
+    const double c0 = matrix_2.determinant();
+    const double c3 = difference.determinant();
+    const double value_plus = (matrix_2 + difference).determinant();
+    const double value_minus = (matrix_2 - difference).determinant();
+    const double c2 = (value_plus + value_minus) / 2 - c0;
+    const double c1 = (value_plus - value_minus) / 2 - c3;
+
+    double roots[3];
+    const int num_roots = solve_cubic(c3, c2, c1, c0, roots);
+    for (i=0; i < num_roots; i+=1)
+    {
+        const Matrix3d normalized_f = matrix_2 + roots[i] * difference;
+        if (denormalize(normalized_f, transform_a, transform_b, hypotheses[num_hypotheses]))
+            num_hypotheses += 1;
+    }
 
-    return;
+    if (num_hypotheses > 0)
+        select_hypothesis(0);
+    return num_hypotheses;
 }
 
 void FundamentalMatrixModel::estimate(const vector< ScoredMatch > &data_points)
 { // given n>m points, estimate the parameters vector
 
-    //throw runtime_error("FundamentalMatrixModel::estimate is not yet implemented");
-    // <<< can implement this based on FMatrixComputeLinear
-    cout << "FundamentalMatrixModel::estimate is not yet implemented" << endl;
+    if ( data_points.size() < 8)
+        throw runtime_error("FundamentalMatrixModel::estimate needs at least 8 points");
+
+    // the least squares solution replaces the hypotheses of the last minimal estimation
+    num_hypotheses = 0;
+    if (solve_eight_points(data_points, static_cast<int>(data_points.size()), hypotheses[0]) == false)
+        throw runtime_error("FundamentalMatrixModel::estimate failed");
+
+    num_hypotheses = 1;
+    select_hypothesis(0);
+    return;
+}
+
+
+void FundamentalMatrixModel::select_hypothesis(const int index)
+{
+    if (index < 0 || index >= num_hypotheses)
+        throw runtime_error("FundamentalMatrixModel::select_hypothesis index out of range");
+
+    int i;
+    for (i=0; i < 9; i+=1)
+    {
+        F[i] = hypotheses[index][i];
+        parameters[i] = static_cast<float>(hypotheses[index][i]);
+    }
+    return;
+}
+
+void FundamentalMatrixModel::compute_hypotheses_residual(const ScoredMatch &data_point, float residuals[]) const
+{
+    // the coordinates are loaded once, then each hypothesis is a few multiply-adds
+    const double left_x = data_point.feature_a->x, left_y = data_point.feature_a->y;
+    const double right_x = data_point.feature_b->x, right_y = data_point.feature_b->y;
+
+    int index;
+    for (index=0; index < num_hypotheses; index+=1)
+        residuals[index] = compute_epipolar_residual(hypotheses[index], left_x, left_y, right_x, right_y);
     return;
 }
 
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Degenerate samples, DEGENSAC
+// O. Chum, T. Werner and J. Matas "Two-view geometry estimation unaffected by a dominant plane", CVPR 2005
+
+// the number of points of the minimal set on a plane that makes it degenerate
+// (the F of a 7 points sample with 5 points on a plane is the plane plus any pair of the other points)
+static const int min_planar_points = 5;
+
+// plane and parallax samples, at most, and the confidence of their adaptive number
+static const int max_parallax_samples = 500;
+static const double parallax_confidence = 0.99;
+
+static Eigen::Vector3d cross_product(const Eigen::Vector3d &a, const Eigen::Vector3d &b)
+{
+    return Eigen::Vector3d(a[1]*b[2] - a[2]*b[1], a[2]*b[0] - a[0]*b[2], a[0]*b[1] - a[1]*b[0]);
+}
+
+static Matrix3d skew_symmetric(const Eigen::Vector3d &v)
+{ // [v]x, such that [v]x w = v x w
+    Matrix3d m;
+    m << 0, -v[2], v[1],
+    v[2], 0, -v[0],
+    -v[1], v[0], 0;
+    return m;
+}
+
+// helper function, the homography induced by the plane through three points,
+// H = A - e' (M^-1 b)^T with A = [e']x F, R. Hartley and A. Zisserman "Multiple View Geometry", result 13.6.
+// Returns false when the points are collinear or one of them is at the epipole
+static bool compute_plane_homography(const Matrix3d &f, const Eigen::Vector3d &epipole_b,
+                                     const ScoredMatch *points[3], Matrix3d &homography)
+{
+    const Matrix3d a = skew_symmetric(epipole_b) * f;
+
+    Matrix3d m;
+    Eigen::Vector3d b;
+    int i;
+    for (i=0; i < 3; i+=1)
+    {
+        const Eigen::Vector3d point_a(points[i]->feature_a->x, points[i]->feature_a->y, 1);
+        const Eigen::Vector3d point_b(points[i]->feature_b->x, points[i]->feature_b->y, 1);
+        const Eigen::Vector3d epipolar_direction = cross_product(point_b, epipole_b);
+        const double squared_norm = epipolar_direction.squaredNorm();
+        if (squared_norm == 0)
+            return false;
+
+        m.row(i) = point_a.transpose();
+        b[i] = cross_product(point_b, a * point_a).dot(epipolar_direction) / squared_norm;
+    }
+
+    const Eigen::FullPivLU<Matrix3d> lu(m);
+    if (lu.isInvertible() == false)
+        return false;
+
+    homography = a - epipole_b * lu.solve(b).transpose();
+    return true;
+}
+
+bool FundamentalMatrixModel::find_dominant_plane(const vector< ScoredMatch > &minimal_set)
+{
+    const Matrix3d f = Eigen::Map<const RowMajorMatrix3d>(F);
+
+    // the epipole in the b image, F^T e' = 0
+    const Eigen::JacobiSVD<Matrix3d> svd(f, Eigen::ComputeFullU);
+    const Eigen::Vector3d epipole_b = svd.matrixU().col(2);
+
+    // each triplet of points gives the homography of its plane, the one consistent with the most points is kept
+    // (with five points on the plane, at least one triplet lies on it)
+    const int m = num_points_to_estimate;
+    ublas::vector<float> homography_parameters(9), best_homography_parameters;
+    int best_num_planar = 0;
+    const ScoredMatch *triplet[3];
+    int i, j, k, l;
+    for (i=0; i < m; i+=1)
+        for (j=i + 1; j < m; j+=1)
+            for (k=j + 1; k < m; k+=1)
+            {
+                triplet[0] = &minimal_set[i];
+                triplet[1] = &minimal_set[j];
+                triplet[2] = &minimal_set[k];
+
+                Matrix3d homography;
+                if (compute_plane_homography(f, epipole_b, triplet, homography) == false)
+                    continue;
+
+                const double norm = homography.norm();
+                if (norm == 0 || (norm - norm) != 0) // zero, infinite or nan
+                    continue;
+
+                for (l=0; l < 9; l+=1)
+                    homography_parameters[l] = static_cast<float>(homography(l / 3, l % 3) / norm);
+                homography_model.set_parameters(homography_parameters);
+
+                int num_planar = 0;
+                for (l=0; l < m; l+=1)
+                    num_planar += (homography_model.compute_residual(minimal_set[l]) < homography_threshold) ? 1 : 0;
+
+                if (num_planar > best_num_planar)
+                {
+                    best_num_planar = num_planar;
+                    best_homography_parameters = homography_parameters;
+                }
+            }
+
+    if (best_num_planar < min_planar_points)
+        return false;
+
+    homography_model.set_parameters(best_homography_parameters);
+    return true;
+}
+
+bool FundamentalMatrixModel::correct_degenerate_sample(const vector< ScoredMatch > &minimal_set,
+        const vector< ScoredMatch > &data_points,
+        const float inlier_threshold, int &num_inliers)
+{
+    if (homography_threshold == 0 || minimal_set.size() < get_num_points_to_estimate())
+        return false;
+
+    if (find_dominant_plane(minimal_set) == false)
+        return false;
+
+    num_degenerate_samples += 1;
+
+    // the homography of the sample is refined on all the matches of the plane
+    const int num_data_points = static_cast<int>(data_points.size());
+    int i;
+    planar_matches.clear();
+    for (i=0; i < num_data_points; i+=1)
+    {
+        if (homography_model.compute_residual(data_points[i]) < homography_threshold)
+            planar_matches.push_back(data_points[i]);
+    }
+
+    if (static_cast<int>(planar_matches.size()) > min_planar_points)
+    {
+        try
+        {
+            homography_model.estimate(planar_matches);
+        }
+        catch (runtime_error &)
+        {
+            // the homography of the sample is kept
+        }
+    }
+
+    const ublas::vector<float> &homography_parameters = homography_model.get_parameters();
+    Matrix3d homography;
+    for (i=0; i < 9; i+=1)
+        homography(i / 3, i % 3) = homography_parameters[i];
+
+    // the matches off the plane, each one gives a line through the epipole, b x H a
+    off_plane_indices.clear();
+    parallax_lines.clear();
+    for (i=0; i < num_data_points; i+=1)
+    {
+        const ScoredMatch &data_point = data_points[i];
+        if (homography_model.compute_residual(data_point) < homography_threshold)
+            continue;
+
+        const Eigen::Vector3d point_a(data_point.feature_a->x, data_point.feature_a->y, 1);
+        const Eigen::Vector3d point_b(data_point.feature_b->x, data_point.feature_b->y, 1);
+        const Eigen::Vector3d line = cross_product(point_b, homography * point_a);
+        const double norm = line.norm();
+        if (norm == 0)
+            continue;
+
+        off_plane_indices.push_back(i);
+        parallax_lines.push_back(line[0] / norm);
+        parallax_lines.push_back(line[1] / norm);
+        parallax_lines.push_back(line[2] / norm);
+    }
+
+    const int num_off_plane = static_cast<int>(off_plane_indices.size());
+    if (num_off_plane < 2)
+        return false; // a planar scene, the epipolar geometry is not defined
+
+    // plane and parallax RANSAC, the epipole is the intersection of two lines,
+    // the support of the planar matches is the same for all the samples, so only the matches off the plane are scored,
+    // and the number of samples follows the inliers fraction among them
+    const double log_eta = log(1.0 - parallax_confidence);
+    boost::uniform_int<int> uniform_index(0, num_off_plane - 1);
+    double best_f[9];
+    int best_off_plane_inliers = 0, num_samples = max_parallax_samples, t;
+    for (t=0; t < num_samples; t+=1)
+    {
+        const int first = uniform_index(random_generator);
+        int second = uniform_index(random_generator);
+        if (second == first)
+            second = (second + 1) % num_off_plane;
+
+        const double *first_line = &parallax_lines[3 * first], *second_line = &parallax_lines[3 * second];
+        const Eigen::Vector3d epipole_b = cross_product(Eigen::Vector3d(first_line[0], first_line[1], first_line[2]),
+                                          Eigen::Vector3d(second_line[0], second_line[1], second_line[2]));
+
+        const Matrix3d f = skew_symmetric(epipole_b) * homography;
+        const double norm = f.norm();
+        if (norm == 0 || (norm - norm) != 0) // zero, infinite or nan
+            continue;
+
+        double sample_f[9];
+        Eigen::Map<RowMajorMatrix3d> f_map(sample_f);
+        f_map = f / norm;
+
+        int off_plane_inliers = 0;
+        for (i=0; i < num_off_plane; i+=1)
+        {
+            const ScoredMatch &data_point = data_points[off_plane_indices[i]];
+            off_plane_inliers += (compute_epipolar_residual(sample_f, data_point.feature_a->x, data_point.feature_a->y,
+                                  data_point.feature_b->x, data_point.feature_b->y) < inlier_threshold) ? 1 : 0;
+        }
+
+        if (off_plane_inliers > best_off_plane_inliers)
+        {
+            best_off_plane_inliers = off_plane_inliers;
+            copy(sample_f, sample_f + 9, best_f);
+
+            const double off_plane_fraction = static_cast<double>(off_plane_inliers) / num_off_plane;
+            const double probability_all_inliers = off_plane_fraction * off_plane_fraction;
+            if (probability_all_inliers >= 1)
+                num_samples = t + 1;
+            else
+                num_samples = static_cast<int>(min(ceil(log_eta / log(1.0 - probability_all_inliers)),
+                                                   static_cast<double>(max_parallax_samples)));
+        }
+    }
+
+    if (best_off_plane_inliers < 2)
+        return false;
+
+    // the plane and parallax model replaces the degenerate one if it has a larger support
+    int plane_and_parallax_inliers = 0;
+    for (i=0; i < num_data_points; i+=1)
+    {
+        const ScoredMatch &data_point = data_points[i];
+        plane_and_parallax_inliers += (compute_epipolar_residual(best_f, data_point.feature_a->x, data_point.feature_a->y,
+                                       data_point.feature_b->x, data_point.feature_b->y) < inlier_threshold) ? 1 : 0;
+    }
+
+    if (plane_and_parallax_inliers <= num_inliers)
+        return false;
+
+    num_inliers = plane_and_parallax_inliers;
+    for (i=0; i < 9; i+=1)
+    {
+        F[i] = best_f[i];
+        parameters[i] = static_cast<float>(best_f[i]);
+    }
+    return true;
+}
+
 const ublas::vector<float>& FundamentalMatrixModel::get_parameters() const
 { // get current estimate of the parameters
     return parameters;
 }
 
+IParametricModel *FundamentalMatrixModel::clone() const
+{
+    return new FundamentalMatrixModel(*this);
+}
+
 void FundamentalMatrixModel::set_parameters(const ublas::vector<float> &_parameters)
 {
     // set an initial guess of the parameters
     // (useful when the model use iterative methods to estimate his parameters)
     parameters = _parameters;
+    update_matrix();
+    num_hypotheses = 0; // the hypotheses of the last estimation do not match the parameters anymore
+    return;
+}
+
+void FundamentalMatrixModel::update_matrix()
+{
+    int i;
+    for (i=0; i < 9; i+=1)
+        F[i] = parameters[i];
     return;
 }
 
@@ -115,19 +644,8 @@ void FundamentalMatrixModel::compute_residuals
     // residuals -> errors
     // Compute the residuals relative to the given parameter vector.
 
-    vpgl_fundamental_matrix<double> fundamental_matrix;
-    // fill the fundamental_matrix
-    vnl_matrix_fixed<double,3,3> fm_vnl;
-    for ( int r = 0; r < 3; r++ )
-        for ( int c = 0; c < 3; c++ )
-            fm_vnl( r, c ) = parameters[ 3*r + c ];
-    fundamental_matrix.set_matrix( fm_vnl );
-
     residuals.resize(data_points.size());
 
-    // The residual for each correspondence is the sum of the squared distances from
-    // the points to their epipolar lines.
-
     vector< ScoredMatch >::const_iterator data_points_it;
     vector<float>::iterator residuals_it;
 
@@ -135,19 +653,39 @@ void FundamentalMatrixModel::compute_residuals
             data_points_it != data_points.end() && residuals_it != residuals.end();
             ++data_points_it, ++residuals_it)
     {
-        // left is feature a, right is feature b (because 'abcde..' )
-
-        vgl_homg_point_2d<double> t_pl(data_points_it->feature_a->x, data_points_it->feature_a->y);
-        vgl_homg_point_2d<double> t_pr(data_points_it->feature_b->x, data_points_it->feature_b->y);
-
-        vgl_homg_line_2d<double> lr = fundamental_matrix.r_epipolar_line( t_pl );
-        vgl_homg_line_2d<double> ll = fundamental_matrix.l_epipolar_line( t_pr );
-        *residuals_it = vgl_homg_operators_2d<double>::perp_dist_squared( lr, t_pr )
-                        + vgl_homg_operators_2d<double>::perp_dist_squared( ll, t_pl );
+        *residuals_it = compute_residual(*data_points_it);
     } // end of 'for each data point'
 
     return;
 } // end of method FundamentalMatrixModel::compute_residuals
 
 
+void FundamentalMatrixModel::compute_sampson_errors
+(const MatchesCoordinates<float> &coordinates, vector<float> &residuals) const
+{
+    float f[9];
+    int i;
+    for (i=0; i < 9; i+=1)
+        f[i] = static_cast<float>(F[i]);
+
+    uniclop::compute_sampson_errors(f, coordinates, residuals);
+    return;
+}
+
+void FundamentalMatrixModel::compute_sampson_errors
+(const MatchesCoordinates<double> &coordinates, vector<double> &residuals) const
+{
+    uniclop::compute_sampson_errors(F, coordinates, residuals);
+    return;
+}
+
+
+float FundamentalMatrixModel::compute_residual(const ScoredMatch &data_point) const
+{
+    // sum of the squared distances from the points to their epipolar lines
+    return compute_epipolar_residual(F, data_point.feature_a->x, data_point.feature_a->y,
+                                     data_point.feature_b->x, data_point.feature_b->y);
+} // end of method FundamentalMatrixModel::compute_residual
+
+
 }
\ No newline at end of file
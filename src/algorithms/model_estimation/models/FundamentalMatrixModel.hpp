@@ -6,19 +6,79 @@
 // class FundamentalMatrixModel
 
 #include "../IParametricModel.hpp"
+#include "BatchedResiduals.hpp"
+#include "HomographyModel.hpp"
+
+#include <boost/random.hpp>
 
 namespace uniclop
 {
 class ScoredMatch;
+
+
+inline float compute_epipolar_residual(const double F[9],
+                                       const double left_x, const double left_y,
+                                       const double right_x, const double right_y)
+{
+    // The residual for each correspondence is the sum of the squared distances from
+    // the points to their epipolar lines.
+    // left is feature a, right is feature b (because 'abcde..' ),
+    // same conventions as vpgl_fundamental_matrix r_epipolar_line and l_epipolar_line
+
+    // right epipolar line F * pl, left epipolar line F^T * pr
+    const double lr_a = F[0]*left_x + F[1]*left_y + F[2];
+    const double lr_b = F[3]*left_x + F[4]*left_y + F[5];
+    const double lr_c = F[6]*left_x + F[7]*left_y + F[8];
+    const double ll_a = F[0]*right_x + F[3]*right_y + F[6];
+    const double ll_b = F[1]*right_x + F[4]*right_y + F[7];
+
+    const double lr_norm = lr_a*lr_a + lr_b*lr_b;
+    const double ll_norm = ll_a*ll_a + ll_b*ll_b;
+    if ( lr_norm == 0 || ll_norm == 0 )
+        return 1e10f;
+
+    // pr^T * F * pl, the same algebraic error for both lines
+    const double algebraic_error = lr_a*right_x + lr_b*right_y + lr_c;
+    const double squared_error = algebraic_error * algebraic_error;
+
+    return static_cast<float>(squared_error / lr_norm + squared_error / ll_norm);
+}
 
 
 class FundamentalMatrixModel: public IParametricModel
 {
-    // based on code from VXL RREL rrel_fm_problem
+    // the minimal samples are solved by the seven point algorithm (up to 3 solutions),
+    // the least squares fits by the normalized eight point algorithm, with rank 2 enforced
+    // R. Hartley and A. Zisserman "Multiple View Geometry", sections 11.1 to 11.3
+
+    int num_points_to_estimate; ///< 7, or 8 for the linear eight point algorithm on the minimal sets
 
     ublas::vector<float> parameters;
+
+    double F[9]; ///< updated each time the parameters change, used by compute_residual
+
+    /// all the solutions of the last minimal estimation, row major, the parameters hold one of them
+    double hypotheses[3][9];
+    int num_hypotheses;
+
+    /// plane and parallax estimation of the samples dominated by a plane,
+    /// O. Chum, T. Werner and J. Matas "Two-view geometry estimation unaffected by a dominant plane", CVPR 2005
+    float homography_threshold; ///< maximum symmetric transfer error of a point on the plane, in pixels, 0 disables the test
+    int num_degenerate_samples;
+    HomographyModel homography_model;
+    boost::mt19937 random_generator; // pseudo-random number generator
+    vector< ScoredMatch > planar_matches;
+    vector<int> off_plane_indices;
+    vector<double> parallax_lines; ///< b x H a for each match off the plane, 3 coefficients per line
+
+    void update_matrix();
+
+    bool find_dominant_plane(const vector< ScoredMatch > &minimal_set);
+    ///< tests the homographies given by F and three points of the minimal set,
+    ///< returns true when one of them is consistent with five or more points, and sets the homography_model to it
+
 public:
-    FundamentalMatrixModel();
+    FundamentalMatrixModel(const int num_points_to_estimate = 7, const float homography_threshold = 0);
     ~FundamentalMatrixModel();
 
     ///@name IParametricModel interface
@@ -31,8 +91,10 @@ public:
 
     void estimate_from_minimal_set(const vector< ScoredMatch> &data_points);
     // given m points estimate the parameters vector
+    // (the first of the up to 3 solutions, see estimate_hypotheses_from_minimal_set)
 
     void estimate(const vector< ScoredMatch > &data_points); // given n>m points, estimate the parameters vector
+    // normalized eight point algorithm, needs at least 8 points
 
     const ublas::vector<float>& get_parameters() const;
     // get current estimate of the parameters
@@ -45,6 +107,37 @@ public:
     // residuals -> errors
     // Compute the residuals relative to the given parameter vector.
 
+    float compute_residual(const ScoredMatch &data_point) const;
+
+    IParametricModel *clone() const;
+
+    unsigned int get_max_num_hypotheses() const;
+
+    int estimate_hypotheses_from_minimal_set(const vector< ScoredMatch > &data_points);
+    // all the real solutions of the seven point problem (one for the eight point algorithm),
+    // the parameters hold the first one
+
+    void select_hypothesis(const int index);
+
+    void compute_hypotheses_residual(const ScoredMatch &data_point, float residuals[]) const;
+
+    bool correct_degenerate_sample(const vector< ScoredMatch > &minimal_set,
+                                   const vector< ScoredMatch > &data_points,
+                                   const float inlier_threshold, int &num_inliers);
+    // when five or more points of the minimal set lie on a plane (DEGENSAC test), samples pairs
+    // of matches off the plane, F = [e']x H, the number of samples is computed from the support off the plane
+
+    ///@}
+
+    int get_num_degenerate_samples() const;
+    ///< number of minimal sets found dominated by a plane since the construction
+
+    ///@name batched squared Sampson distances (see BatchedResiduals.hpp)
+    ///@{
+    // the first order approximation of the geometric error, not the residuals of compute_residuals
+    void compute_sampson_errors(const MatchesCoordinates<float> &coordinates, vector<float> &residuals) const;
+
+    void compute_sampson_errors(const MatchesCoordinates<double> &coordinates, vector<double> &residuals) const;
     ///@}
 
 }
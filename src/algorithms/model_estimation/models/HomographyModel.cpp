@@ -2,36 +2,41 @@
 #include "HomographyModel.hpp"
 #include "algorithms/features/ScoredMatch.hpp"
 
-// RANSAC implementation requires VXL installed
-// with the RREL and GEL/vpgl contributions
+// the minimal set estimation requires VXL installed (vnl and vgl)
 
 #include <vxl/vcl/vcl_iostream.h>
 
 #include <vxl/core/vnl/vnl_math.h>
+#include <vxl/core/vnl/algo/vnl_svd.h>
 
 #include <vxl/core/vgl/algo/vgl_homg_operators_2d.h>
 
-#include <vxl/contrib/rpl/rrel/rrel_muset_obj.h>
-#include <vxl/contrib/rpl/rrel/rrel_ran_sam_search.h>
-#include <vxl/contrib/rpl/rrel/rrel_homography2d_est.h>
-
-#include <vxl/contrib/gel/mrc/vpgl/vpgl_fundamental_matrix.h>
-#include <vxl/contrib/gel/mrc/vpgl/algo/vpgl_fm_compute_ransac.h>
-#include <vxl/contrib/gel/mrc/vpgl/algo/vpgl_fm_compute_8_point.h>
+#include <Eigen/Core>
+#include <Eigen/SVD>
 
 #include <boost/numeric/ublas/io.hpp>
 
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
 namespace uniclop
 {
 
+typedef Eigen::Matrix<double, 9, 9> Matrix9d;
+
 
 // Class HomographyModel:IParametricModel< ScoredMatch> methods implementation
 
 // based on vxl rrel_homography2d_est, HMatrix2D and HMatrix2DCompute
 
-HomographyModel::HomographyModel()
+HomographyModel::HomographyModel(const int _max_refinement_iterations)
+        : max_refinement_iterations(_max_refinement_iterations)
 {
     parameters.resize( get_num_parameters() );
+    num_refinement_iterations = 0;
+    update_transforms();
     return;
 }
 
@@ -96,22 +101,7 @@ void HomographyModel::estimate_from_minimal_set(const vector< ScoredMatch> &data
 
     const unsigned int homog_dof_ = 8;
     if ( svd.rank() < homog_dof_ )
-    {
-        // singular fit
-        if (true)
-        { // just for debugging
-            cout << "svd.rank() == " << svd.rank() << endl;
-
-            for ( unsigned int i=0; i<get_num_points_to_estimate(); ++i )
-            {
-                vgl_homg_point_2d<double> from_point(data_points[i].feature_a->x, data_points[i].feature_a->y);
-                vgl_homg_point_2d<double> to_point(data_points[i].feature_b->x, data_points[i].feature_b->y);
-
-                cout << "from->to point[i]-> " << from_point << "->" << to_point << endl;
-            }
-
-        }
-
+    { // singular fit, the estimators catch it and draw another sample
         throw runtime_error("HomographyModel::estimate_from_minimal_set failed");
     }
 
@@ -127,6 +117,7 @@ void HomographyModel::estimate_from_minimal_set(const vector< ScoredMatch> &data
     {
         parameters[i] = params[i]; // copy the result
     }
+    update_transforms();
 
    if ( false ) {
 	    cout << "HomographyModel parameters: " << parameters << endl;
@@ -136,14 +127,397 @@ void HomographyModel::estimate_from_minimal_set(const vector< ScoredMatch> &data
 } // end of 'HomographyModel::estimate_from_minimal_set'
 
 
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// helper functions of HomographyModel::estimate
+
+// adjugate of a 3x3 matrix, the inverse up to the determinant scale factor
+static void compute_adjugate(const double m[9], double adjugate[9])
+{
+    adjugate[0] = m[4]*m[8] - m[5]*m[7];
+    adjugate[1] = m[2]*m[7] - m[1]*m[8];
+    adjugate[2] = m[1]*m[5] - m[2]*m[4];
+    adjugate[3] = m[5]*m[6] - m[3]*m[8];
+    adjugate[4] = m[0]*m[8] - m[2]*m[6];
+    adjugate[5] = m[2]*m[3] - m[0]*m[5];
+    adjugate[6] = m[3]*m[7] - m[4]*m[6];
+    adjugate[7] = m[1]*m[6] - m[0]*m[7];
+    adjugate[8] = m[0]*m[4] - m[1]*m[3];
+    return;
+}
+
+static void multiply_3x3(const double a[9], const double b[9], double result[9])
+{
+    int r, c;
+    for (r=0; r < 3; r+=1)
+        for (c=0; c < 3; c+=1)
+            result[3*r + c] = a[3*r]*b[c] + a[3*r + 1]*b[3 + c] + a[3*r + 2]*b[6 + c];
+    return;
+}
+
+// Hartley normalization, moves the centroid of the points to the origin
+// and scales them so that their mean distance to the origin is sqrt(2),
+// the normalization matrix is [scale 0 -scale*center_x; 0 scale -scale*center_y; 0 0 1]
+static void normalize_points(vector<double> &x, vector<double> &y, double &scale, double &center_x, double &center_y)
+{
+    const size_t num_points = x.size();
+    size_t i;
+
+    center_x = 0;
+    center_y = 0;
+    for (i=0; i < num_points; i+=1)
+    {
+        center_x += x[i];
+        center_y += y[i];
+    }
+    center_x /= num_points;
+    center_y /= num_points;
+
+    double mean_distance = 0;
+    for (i=0; i < num_points; i+=1)
+        mean_distance += sqrt((x[i] - center_x)*(x[i] - center_x) + (y[i] - center_y)*(y[i] - center_y));
+    mean_distance /= num_points;
+
+    if (mean_distance == 0)
+        throw runtime_error("HomographyModel::estimate failed, all the points are at the same position");
+
+    scale = sqrt(2.0) / mean_distance;
+    for (i=0; i < num_points; i+=1)
+    {
+        x[i] = (x[i] - center_x) * scale;
+        y[i] = (y[i] - center_y) * scale;
+    }
+    return;
+}
+
+// updates the upper triangular factor r of the QR decomposition of A
+// with a new row of A, using Givens rotations. The row is overwritten
+static void add_row_to_r_factor(Matrix9d &r, double row[9])
+{
+    int k, j;
+    for (k=0; k < 9; k+=1)
+    {
+        if (row[k] == 0)
+            continue;
+
+        const double norm = sqrt(r(k, k)*r(k, k) + row[k]*row[k]);
+        const double cosine = r(k, k) / norm, sine = row[k] / norm;
+        for (j=k; j < 9; j+=1)
+        {
+            const double r_value = r(k, j);
+            r(k, j) = cosine * r_value + sine * row[j];
+            row[j] = cosine * row[j] - sine * r_value;
+        }
+    }
+    return;
+}
+
+// sum of the squared symmetric transfer errors of the normalized homography h,
+// measured in the original (not normalized) pixel units
+static double compute_transfer_cost(const double h[9], const MatchesCoordinates<double> &points,
+                                    const double scale_a, const double scale_b)
+{
+    double h_inv[9];
+    compute_adjugate(h, h_inv);
+
+    const double weight_a = 1 / (scale_a * scale_a), weight_b = 1 / (scale_b * scale_b);
+    double cost = 0;
+    size_t i;
+    for (i=0; i < points.size(); i+=1)
+    {
+        const double from_x = points.x_a[i], from_y = points.y_a[i];
+        const double to_x = points.x_b[i], to_y = points.y_b[i];
+
+        const double trans_w = h[6]*from_x + h[7]*from_y + h[8];
+        const double inv_trans_w = h_inv[6]*to_x + h_inv[7]*to_y + h_inv[8];
+
+        if ( trans_w == 0 || inv_trans_w == 0 )
+            return numeric_limits<double>::max();
+
+        const double del_x = (h[0]*from_x + h[1]*from_y + h[2]) / trans_w - to_x;
+        const double del_y = (h[3]*from_x + h[4]*from_y + h[5]) / trans_w - to_y;
+        const double inv_del_x = (h_inv[0]*to_x + h_inv[1]*to_y + h_inv[2]) / inv_trans_w - from_x;
+        const double inv_del_y = (h_inv[3]*to_x + h_inv[4]*to_y + h_inv[5]) / inv_trans_w - from_y;
+
+        cost += (del_x*del_x + del_y*del_y) * weight_b + (inv_del_x*inv_del_x + inv_del_y*inv_del_y) * weight_a;
+    }
+
+    return cost;
+}
+
+// solves a x = b by Gaussian elimination with partial pivoting,
+// a is a n x n row major matrix, a and b are overwritten, x is returned in b
+static bool solve_linear_system(double *a, double *b, const int n)
+{
+    int i, j, k;
+    for (k=0; k < n; k+=1)
+    {
+        int pivot = k;
+        for (i=k+1; i < n; i+=1)
+            if (fabs(a[n*i + k]) > fabs(a[n*pivot + k]))
+                pivot = i;
+
+        if (a[n*pivot + k] == 0)
+            return false;
+
+        if (pivot != k)
+        {
+            for (j=k; j < n; j+=1)
+                swap(a[n*k + j], a[n*pivot + j]);
+            swap(b[k], b[pivot]);
+        }
+
+        for (i=k+1; i < n; i+=1)
+        {
+            const double factor = a[n*i + k] / a[n*k + k];
+            for (j=k; j < n; j+=1)
+                a[n*i + j] -= factor * a[n*k + j];
+            b[i] -= factor * b[k];
+        }
+    }
+
+    for (k=n-1; k >= 0; k-=1)
+    {
+        for (j=k+1; j < n; j+=1)
+            b[k] -= a[n*k + j] * b[j];
+        b[k] /= a[n*k + k];
+    }
+    return true;
+}
+
+// Levenberg-Marquardt minimization of the symmetric transfer error of the normalized homography h,
+// the largest element of h stays constant (removes the scale ambiguity) and the 8 others are optimized,
+// returns the number of iterations done
+static int refine_homography(double h[9], const MatchesCoordinates<double> &points,
+                             const double scale_a, const double scale_b, const int max_iterations)
+{
+    int fixed_index = 0, k;
+    for (k=1; k < 9; k+=1)
+        if (fabs(h[k]) > fabs(h[fixed_index]))
+            fixed_index = k;
+
+    int free_indexes[8], num_free = 0;
+    for (k=0; k < 9; k+=1)
+        if (k != fixed_index)
+        {
+            free_indexes[num_free] = k;
+            num_free += 1;
+        }
+
+    const double weight_a = 1 / scale_a, weight_b = 1 / scale_b;
+    double cost = compute_transfer_cost(h, points, scale_a, scale_b);
+    double lambda = 1e-3;
+
+    int iteration = 0;
+    while (iteration < max_iterations)
+    {
+        iteration += 1;
+
+        // h_inv is the true inverse, d(h^-1) = -h^-1 * dh * h^-1
+        double h_inv[9];
+        compute_adjugate(h, h_inv);
+        const double determinant = h[0]*h_inv[0] + h[1]*h_inv[3] + h[2]*h_inv[6];
+        if (determinant == 0)
+            break;
+        for (k=0; k < 9; k+=1)
+            h_inv[k] /= determinant;
+
+        // normal equations J^T J and J^T r, for the 9 elements of h
+        double jtj[9*9], jtr[9];
+        fill(jtj, jtj + 9*9, 0.0);
+        fill(jtr, jtr + 9, 0.0);
+
+        size_t i;
+        for (i=0; i < points.size(); i+=1)
+        {
+            const double a[3] = { points.x_a[i], points.y_a[i], 1 };
+            const double b[3] = { points.x_b[i], points.y_b[i], 1 };
+
+            const double f[3] = { h[0]*a[0] + h[1]*a[1] + h[2], h[3]*a[0] + h[4]*a[1] + h[5], h[6]*a[0] + h[7]*a[1] + h[8] };
+            const double g[3] = { h_inv[0]*b[0] + h_inv[1]*b[1] + h_inv[2],
+                                  h_inv[3]*b[0] + h_inv[4]*b[1] + h_inv[5],
+                                  h_inv[6]*b[0] + h_inv[7]*b[1] + h_inv[8]
+                                };
+            if (f[2] == 0 || g[2] == 0)
+                continue;
+
+            const double f_x = f[0] / f[2], f_y = f[1] / f[2], g_x = g[0] / g[2], g_y = g[1] / g[2];
+            const double r[4] = { (f_x - b[0]) * weight_b, (f_y - b[1]) * weight_b,
+                                  (g_x - a[0]) * weight_a, (g_y - a[1]) * weight_a
+                                };
+
+            // derivatives of the 4 residuals with respect to h[3*row + column]
+            double jacobian[4][9];
+            int row, column;
+            for (row=0; row < 3; row+=1)
+                for (column=0; column < 3; column+=1)
+                {
+                    const int index = 3*row + column;
+                    jacobian[0][index] = (row == 0) ? a[column] / f[2] * weight_b :
+                                         (row == 2) ? -f_x * a[column] / f[2] * weight_b : 0;
+                    jacobian[1][index] = (row == 1) ? a[column] / f[2] * weight_b :
+                                         (row == 2) ? -f_y * a[column] / f[2] * weight_b : 0;
+
+                    const double dg_x = -h_inv[row] * g[column];
+                    const double dg_y = -h_inv[3 + row] * g[column];
+                    const double dg_w = -h_inv[6 + row] * g[column];
+                    jacobian[2][index] = (dg_x - g_x * dg_w) / g[2] * weight_a;
+                    jacobian[3][index] = (dg_y - g_y * dg_w) / g[2] * weight_a;
+                }
+
+            int residual_index, u, v;
+            for (residual_index=0; residual_index < 4; residual_index+=1)
+            {
+                const double *j_row = jacobian[residual_index];
+                for (u=0; u < 9; u+=1)
+                {
+                    jtr[u] += j_row[u] * r[residual_index];
+                    for (v=u; v < 9; v+=1)
+                        jtj[9*u + v] += j_row[u] * j_row[v];
+                }
+            }
+        } // end of 'for each point'
+
+        // the damping is increased until the step decreases the cost
+        bool cost_decreased = false;
+        double relative_decrease = 0;
+        while (cost_decreased == false && lambda < 1e10)
+        {
+            double system[8*8], step[8];
+            int u, v;
+            for (u=0; u < num_free; u+=1)
+            {
+                const int index_u = free_indexes[u];
+                for (v=0; v < num_free; v+=1)
+                {
+                    const int index_v = free_indexes[v];
+                    system[8*u + v] = (index_u <= index_v) ? jtj[9*index_u + index_v] : jtj[9*index_v + index_u];
+                }
+                system[8*u + u] *= 1 + lambda;
+                step[u] = -jtr[index_u];
+            }
+
+            if (solve_linear_system(system, step, num_free))
+            {
+                double new_h[9];
+                copy(h, h + 9, new_h);
+                for (u=0; u < num_free; u+=1)
+                    new_h[free_indexes[u]] += step[u];
+
+                const double new_cost = compute_transfer_cost(new_h, points, scale_a, scale_b);
+                if (new_cost < cost)
+                {
+                    relative_decrease = (cost - new_cost) / cost;
+                    copy(new_h, new_h + 9, h);
+                    cost = new_cost;
+                    cost_decreased = true;
+                    lambda = max(lambda * 0.1, 1e-12);
+                }
+            }
+
+            if (cost_decreased == false)
+                lambda *= 10;
+        }
+
+        if (cost_decreased == false || relative_decrease < 1e-10)
+            break; // converged
+    }
+
+    return iteration;
+}
+
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+
 void HomographyModel::estimate(const vector< ScoredMatch> &data_points)
 { // given n>m points, estimate the parameters vector
 
-    //throw runtime_error("HomographyModel::estimate is not yet implemented");
-    // <<< can implement this based on HMatrix2DCompute
-    cout << "HomographyModel::estimate is not yet implemented" << endl;
+    // normalized DLT, see R. Hartley and A. Zisserman "Multiple View Geometry", algorithm 4.2,
+    // followed by a Levenberg-Marquardt minimization of the symmetric transfer error
+    if ( data_points.size() < get_num_points_to_estimate())
+        throw runtime_error("Not enough points to estimate the HomographyModel parameters");
+
+    MatchesCoordinates<double> points;
+    points.set_matches(data_points);
+
+    double scale_a, center_a_x, center_a_y, scale_b, center_b_x, center_b_y;
+    normalize_points(points.x_a, points.y_a, scale_a, center_a_x, center_a_y);
+    normalize_points(points.x_b, points.y_b, scale_b, center_b_x, center_b_y);
+
+    // the 2n x 9 matrix A is reduced to the 9x9 triangular factor R of its QR decomposition,
+    // R has the same singular values and right singular vectors as A.
+    // So the SVD has a fixed size whatever the number of points, without squaring
+    // the condition number as A^T A would
+    Matrix9d r_factor = Matrix9d::Zero();
+    size_t i;
+    for (i=0; i < points.size(); i+=1)
+    {
+        const double from_x = points.x_a[i], from_y = points.y_a[i];
+        const double to_x = points.x_b[i], to_y = points.y_b[i];
+
+        double row_x[9] = { from_x, from_y, 1, 0, 0, 0, -from_x*to_x, -from_y*to_x, -to_x };
+        double row_y[9] = { 0, 0, 0, from_x, from_y, 1, -from_x*to_y, -from_y*to_y, -to_y };
+
+        add_row_to_r_factor(r_factor, row_x);
+        add_row_to_r_factor(r_factor, row_y);
+    }
+
+    const Eigen::JacobiSVD<Matrix9d> svd(r_factor, Eigen::ComputeFullV);
+
+    // rank(A) < 8
+    if ( svd.singularValues()[7] <= 1.0e-8 * svd.singularValues()[0] )
+        throw runtime_error("HomographyModel::estimate failed, degenerate points configuration");
+
+    double h[9];
+    int k;
+    for (k=0; k < 9; k+=1)
+        h[k] = svd.matrixV()(k, 8);
+
+    // normalization matrices
+    const double t_a[9] = { scale_a, 0, -scale_a*center_a_x, 0, scale_a, -scale_a*center_a_y, 0, 0, 1 };
+    const double t_a_inv[9] = { 1 / scale_a, 0, center_a_x, 0, 1 / scale_a, center_a_y, 0, 0, 1 };
+    const double t_b[9] = { scale_b, 0, -scale_b*center_b_x, 0, scale_b, -scale_b*center_b_y, 0, 0, 1 };
+    const double t_b_inv[9] = { 1 / scale_b, 0, center_b_x, 0, 1 / scale_b, center_b_y, 0, 0, 1 };
+    double temporary[9];
+
+    num_refinement_iterations = 0;
+    if (max_refinement_iterations > 0)
+    {
+        // the current parameters (given by set_parameters or by a previous estimation)
+        // are used as starting point when they fit the points better than the DLT solution
+        if (is_invertible)
+        {
+            double h_current[9];
+            multiply_3x3(H, t_a_inv, temporary);
+            multiply_3x3(t_b, temporary, h_current);
+            if (compute_transfer_cost(h_current, points, scale_a, scale_b) < compute_transfer_cost(h, points, scale_a, scale_b))
+                copy(h_current, h_current + 9, h);
+        }
+
+        num_refinement_iterations = refine_homography(h, points, scale_a, scale_b, max_refinement_iterations);
+    }
+
+    // back to the pixel coordinates, H = T_b^-1 * h * T_a
+    double h_pixels[9];
+    multiply_3x3(h, t_a, temporary);
+    multiply_3x3(t_b_inv, temporary, h_pixels);
+
+    double norm = 0;
+    for (k=0; k < 9; k+=1)
+        norm += h_pixels[k]*h_pixels[k];
+    norm = sqrt(norm);
+
+    parameters.resize(get_num_parameters());
+    for (k=0; k < 9; k+=1)
+        parameters[k] = h_pixels[k] / norm;
+    update_transforms();
 
     return;
+} // end of 'HomographyModel::estimate'
+
+
+int HomographyModel::get_num_refinement_iterations() const
+{
+    return num_refinement_iterations;
 }
 
 const ublas::vector<float>& HomographyModel::get_parameters() const
@@ -151,11 +525,32 @@ const ublas::vector<float>& HomographyModel::get_parameters() const
     return parameters;
 }
 
+IParametricModel *HomographyModel::clone() const
+{
+    return new HomographyModel(*this);
+}
+
 void HomographyModel::set_parameters(const ublas::vector<float> &_parameters)
 {
     // set an initial guess of the parameters
     // (useful when the model use iterative methods to estimate his parameters)
     parameters = _parameters;
+    update_transforms();
+    return;
+}
+
+void HomographyModel::update_transforms()
+{
+    int i;
+    for (i=0; i < 9; i+=1)
+        H[i] = parameters[i];
+
+    // the adjugate matrix is the inverse up to a scale factor,
+    // which is enough to transfer homogeneous points
+    compute_adjugate(H, H_inv);
+
+    const double determinant = H[0]*H_inv[0] + H[1]*H_inv[3] + H[2]*H_inv[6];
+    is_invertible = (determinant != 0);
     return;
 }
 
@@ -165,70 +560,68 @@ void HomographyModel::compute_residuals
     // residuals -> errors
     // Compute the residuals relative to the given parameter vector.
 
-// based on rrel_homography2d_est :: compute_residuals
-
-    vnl_matrix< double > H(3,3);
-    int r,c;
-    for ( r=0; r<3; ++r )
-        for ( c=0; c<3; ++c )
-            H( r, c ) = parameters[ 3*r + c ];
-
-    vnl_svd< double > svd_H( H );
-    if ( svd_H.rank() < 3 )
-    {
-        if (true) cout << "H == " << H << endl;
-        //throw runtime_error("HomographyModel::compute_residuals rank(H) < 3!!");
-        cout << "HomographyModel::compute_residuals rank(H) < 3!!" << endl;
-    }
-    vnl_matrix< double > H_inv( svd_H.inverse() );
-
     residuals.resize(data_points.size());
 
     // compute the residual of each data point
     vector< ScoredMatch>::const_iterator data_points_it;
     vector<float>::iterator residuals_it;
 
-    vnl_vector< double > from_point( 3 ), to_point( 3 );
-    vnl_vector< double > trans_pt( 3 ), inv_trans_pt( 3 );
-    double del_x, del_y, inv_del_x, inv_del_y;
-
     for (data_points_it = data_points.begin(), residuals_it = residuals.begin();
             data_points_it != data_points.end() && residuals_it != residuals.end();
             ++data_points_it, ++residuals_it)
     {
-        // from feature a to feature b
-        from_point[0] = data_points_it->feature_a->x;
-        from_point[1] = data_points_it->feature_a->y;
-        from_point[2] = 1.0;
-
-        to_point[0] = data_points_it->feature_b->x;
-        to_point[1] = data_points_it->feature_b->y;
-        to_point[2] = 1.0;
+        *residuals_it = compute_residual(*data_points_it);
+    } // end of 'for each data point'
 
-        trans_pt = H * from_point;
-        inv_trans_pt = H_inv * to_point;
+    return;
+} // end of method HomographyModel::compute_residuals
 
-        if ( from_point[ 2 ] == 0 || to_point[ 2 ] == 0
-                || trans_pt[ 2 ] == 0 || inv_trans_pt[ 2 ] == 0 )
-        {
-            *residuals_it = 1e10;
-        }
-        else
-        {
-            del_x = trans_pt[ 0 ] / trans_pt[ 2 ] - to_point[ 0 ] /to_point[ 2 ];
-            del_y = trans_pt[ 1 ] / trans_pt[ 2 ] - to_point[ 1 ] / to_point[ 2 ];
-            inv_del_x = inv_trans_pt[ 0 ] / inv_trans_pt[ 2 ] -from_point[ 0 ] / from_point[ 2 ];
-            inv_del_y = inv_trans_pt[ 1 ] / inv_trans_pt[ 2 ] - from_point[ 1 ] / from_point[ 2 ];
-            const double t_value = vnl_math_sqr(del_x) + vnl_math_sqr(del_y)
-                                      + vnl_math_sqr(inv_del_x) + vnl_math_sqr(inv_del_y);
-            *residuals_it = vcl_sqrt( t_value );
-        }
 
+void HomographyModel::compute_residuals
+(const MatchesCoordinates<float> &coordinates, vector<float> &residuals) const
+{
+    float h[9], h_inv[9];
+    int i;
+    for (i=0; i < 9; i+=1)
+    {
+        h[i] = static_cast<float>(H[i]);
+        h_inv[i] = static_cast<float>(H_inv[i]);
+    }
 
-    } // end of 'for each data point'
+    compute_symmetric_transfer_errors(h, h_inv, coordinates, residuals);
+    return;
+}
 
+void HomographyModel::compute_residuals
+(const MatchesCoordinates<double> &coordinates, vector<double> &residuals) const
+{
+    compute_symmetric_transfer_errors(H, H_inv, coordinates, residuals);
     return;
-} // end of method FundamentalMatrixModel<F>::compute_residuals
+}
+
+
+float HomographyModel::compute_residual(const ScoredMatch &data_point) const
+{
+    // based on rrel_homography2d_est :: compute_residuals,
+    // symmetric transfer error, from feature a to feature b and back
+
+    const double from_x = data_point.feature_a->x, from_y = data_point.feature_a->y;
+    const double to_x = data_point.feature_b->x, to_y = data_point.feature_b->y;
+
+    const double trans_w = H[6]*from_x + H[7]*from_y + H[8];
+    const double inv_trans_w = H_inv[6]*to_x + H_inv[7]*to_y + H_inv[8];
+
+    if ( trans_w == 0 || inv_trans_w == 0 )
+        return 1e10f;
+
+    const double del_x = (H[0]*from_x + H[1]*from_y + H[2]) / trans_w - to_x;
+    const double del_y = (H[3]*from_x + H[4]*from_y + H[5]) / trans_w - to_y;
+    const double inv_del_x = (H_inv[0]*to_x + H_inv[1]*to_y + H_inv[2]) / inv_trans_w - from_x;
+    const double inv_del_y = (H_inv[3]*to_x + H_inv[4]*to_y + H_inv[5]) / inv_trans_w - from_y;
+
+    return static_cast<float>(sqrt(del_x*del_x + del_y*del_y + inv_del_x*inv_del_x + inv_del_y*inv_del_y));
+}
+
 
 
 
@@ -5,6 +5,7 @@
 
 
 #include "../IParametricModel.hpp"
+#include "BatchedResiduals.hpp"
 #include "algorithms/features/ScoredMatch.hpp"
 
 namespace uniclop
@@ -16,8 +17,19 @@ class HomographyModel: public IParametricModel
     // based on code from VXL RREL rrel_homography2d_est
 
     ublas::vector<float> parameters;
+
+    // H and its inverse (up to scale), updated each time the parameters change
+    // so that compute_residual does not need any allocation
+    double H[9], H_inv[9];
+    bool is_invertible;
+
+    void update_transforms();
+
+    // Levenberg-Marquardt refinement done by estimate, 0 iterations disables it
+    int max_refinement_iterations, num_refinement_iterations;
+
 public:
-    HomographyModel();
+    HomographyModel(const int max_refinement_iterations = 10);
     ~HomographyModel();
 
     ///@name IParametricModel interface
@@ -32,6 +44,7 @@ public:
     // given m points estimate the parameters vector
 
     void estimate(const vector< ScoredMatch > &data_points); // given n>m points, estimate the parameters vector
+    // least squares estimate, minimizes the symmetric transfer error
 
     const ublas::vector<float>& get_parameters() const;
     // get current estimate of the parameters
@@ -44,8 +57,22 @@ public:
     // residuals -> errors
     // Compute the residuals relative to the given parameter vector.
 
+    float compute_residual(const ScoredMatch &data_point) const;
+
+    IParametricModel *clone() const;
+
     ///@}
 
+    ///@name batched residuals, compute_residual values up to the tolerances given in BatchedResiduals.hpp
+    ///@{
+    void compute_residuals(const MatchesCoordinates<float> &coordinates, vector<float> &residuals) const;
+
+    void compute_residuals(const MatchesCoordinates<double> &coordinates, vector<double> &residuals) const;
+    ///@}
+
+    int get_num_refinement_iterations() const;
+    // number of Levenberg-Marquardt iterations done by the last call to estimate
+
 }
 ; // end of class HomographyModel declaration
 
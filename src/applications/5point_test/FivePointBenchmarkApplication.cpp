@@ -0,0 +1,511 @@
+/*
+Microbenchmark of the five point relative pose solver, running on a synthetic scene,
+and comparison of the seven and eight point minimal sets for the fundamental matrix
+*/
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Headers
+
+#include "FivePointBenchmarkApplication.hpp"
+
+#include "algorithms/model_estimation/models/Calibrated5PointsEssentialMatrixModel.hpp"
+#include "algorithms/model_estimation/models/FundamentalMatrixModel.hpp"
+#include "algorithms/model_estimation/models/5point/5point.hpp"
+#include "algorithms/model_estimation/estimators/RANSAC.hpp"
+#include "algorithms/model_estimation/estimators/PROSAC.hpp"
+#include "algorithms/model_estimation/estimators/ARRSAC.hpp"
+#include "algorithms/model_estimation/estimators/TddVerifier.hpp"
+#include "algorithms/model_estimation/estimators/SPRTVerifier.hpp"
+#include "algorithms/model_estimation/estimators/LocalOptimization.hpp"
+#include "algorithms/model_estimation/estimators/RandomSampler.hpp"
+
+#include <Eigen/Geometry>
+
+#include <boost/random.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+
+namespace uniclop
+{
+
+using namespace std;
+namespace posix_time = boost::posix_time;
+
+using Eigen::Matrix3d;
+using Eigen::Vector2d;
+using Eigen::Vector3d;
+
+// the synthetic camera
+const int width = 640, height = 480;
+const double focal_length = 500, center_x = 320, center_y = 240;
+
+
+string FivePointBenchmarkApplication::get_application_title() const
+{
+    return "Five and seven point solvers benchmark. Uniclop 2009";
+}
+
+args::options_description FivePointBenchmarkApplication::get_command_line_options(void) const
+{
+    args::options_description desc("FivePointBenchmarkApplication options");
+
+    desc.add_options()
+
+    ("benchmark.num_samples", args::value<int>()->default_value(20000),
+     "number of minimal samples solved by the microbenchmark")
+
+    ("benchmark.num_matches", args::value<int>()->default_value(500),
+     "number of matches per synthetic frame, for the estimators")
+
+    ("benchmark.num_frames", args::value<int>()->default_value(20),
+     "number of synthetic frames to estimate")
+
+    ("benchmark.inliers_fraction", args::value<float>()->default_value(0.5f),
+     "fraction of the matches that follow the camera motion")
+
+    ("benchmark.planar_fraction", args::value<float>()->default_value(0.8f),
+     "fraction of the inliers on a plane, for the degeneracy test benchmark")
+
+    ("benchmark.homography_threshold", args::value<float>()->default_value(2.0f),
+     "maximum symmetric transfer error of the points on the plane, in pixels, for the degeneracy test")
+    ;
+
+    desc.add(RANSAC::get_options_description());
+    desc.add(TddVerifier::get_options_description());
+    desc.add(SPRTVerifier::get_options_description());
+    desc.add(LocalOptimization::get_options_description());
+    desc.add(PROSAC::get_options_description());
+    desc.add(ARRSAC::get_options_description());
+
+    return desc;
+}
+
+
+// helper function, distance between two essential or fundamental matrices, which are defined up to scale and sign
+double matrices_distance(const Matrix3d &a, const Matrix3d &b)
+{
+    const Matrix3d normalized_a = a / a.norm(), normalized_b = b / b.norm();
+    return min((normalized_a - normalized_b).norm(), (normalized_a + normalized_b).norm());
+}
+
+// helper function, essential or fundamental matrix from the model parameters (row major)
+Matrix3d parameters_to_matrix(const ublas::vector<float> &parameters)
+{
+    Matrix3d matrix;
+    int r, c;
+    for (r=0; r < 3; r+=1)
+        for (c=0; c < 3; c+=1)
+            matrix(r, c) = parameters[3*r + c];
+    return matrix;
+}
+
+
+// helper class, accumulates the results of one estimator over the synthetic frames
+class EstimatorStatistics
+{
+public:
+    string name;
+    posix_time::time_duration duration;
+    long num_hypotheses_tested;
+    long num_true_inliers, num_true_inliers_found, num_false_inliers_found;
+    double sum_error;
+
+    EstimatorStatistics(const string &_name)
+            : name(_name)
+    {
+        num_hypotheses_tested = 0;
+        num_true_inliers = 0;
+        num_true_inliers_found = 0;
+        num_false_inliers_found = 0;
+        sum_error = 0;
+        return;
+    }
+
+    template<typename Estimator>
+    void run(Estimator &estimator, const vector< ScoredMatch > &matches, const vector<bool> &is_true_inlier,
+             const Matrix3d &true_matrix)
+    {
+        const posix_time::ptime start_time = posix_time::microsec_clock::local_time();
+        const ublas::vector<float> parameters = estimator.estimate_model_parameters(matches);
+        duration += posix_time::microsec_clock::local_time() - start_time;
+
+        num_hypotheses_tested += estimator.get_num_hypotheses_tested();
+
+        const vector<bool> &is_inlier = estimator.get_is_inlier();
+        unsigned int i;
+        for (i=0; i < is_inlier.size(); i+=1)
+        {
+            num_true_inliers += is_true_inlier[i] ? 1 : 0;
+            num_true_inliers_found += (is_true_inlier[i] && is_inlier[i]) ? 1 : 0;
+            num_false_inliers_found += (!is_true_inlier[i] && is_inlier[i]) ? 1 : 0;
+        }
+
+        sum_error += matrices_distance(parameters_to_matrix(parameters), true_matrix);
+        return;
+    }
+
+    void print(const int num_frames) const
+    {
+        printf("%s: %.1f hypotheses/frame, %.3f [ms/frame], %.1f%% of the inliers found, "
+               "%.1f false inliers/frame, mean matrix error %.2e\n",
+               name.c_str(), static_cast<double>(num_hypotheses_tested) / num_frames,
+               duration.total_microseconds() / (1000.0 * num_frames),
+               (100.0 * num_true_inliers_found) / max(num_true_inliers, 1L),
+               static_cast<double>(num_false_inliers_found) / num_frames,
+               sum_error / num_frames);
+        return;
+    }
+};
+
+
+int FivePointBenchmarkApplication::main_loop(args::variables_map &options)
+{
+
+    const int num_samples = options["benchmark.num_samples"].as<int>();
+    const int num_matches = options["benchmark.num_matches"].as<int>();
+    const int num_frames = options["benchmark.num_frames"].as<int>();
+    const float inliers_fraction = options["benchmark.inliers_fraction"].as<float>();
+
+    // minimal solver --
+    generate_scene(num_matches, inliers_fraction);
+    const int num_points = static_cast<int>(points_a.size());
+    if (num_points < 5)
+        throw runtime_error("FivePointBenchmarkApplication needs at least 5 inliers, "
+                            "increase benchmark.num_matches or benchmark.inliers_fraction");
+
+    // the samples are drawn before the measure
+    Points samples_a(5 * num_samples), samples_b(5 * num_samples);
+    RandomSampler sampler;
+    vector<int> sample;
+    int i, j;
+    for (i=0; i < num_samples; i+=1)
+    {
+        sampler.draw(num_points, 5, sample);
+        for (j=0; j < 5; j+=1)
+        {
+            samples_a[5*i + j] = points_a[sample[j]];
+            samples_b[5*i + j] = points_b[sample[j]];
+        }
+    }
+
+    Matrix3d solutions[five_point::max_num_solutions];
+    long num_solutions = 0, num_found = 0;
+    double max_error = 0;
+
+    const posix_time::ptime start_time = posix_time::microsec_clock::local_time();
+    for (i=0; i < num_samples; i+=1)
+    {
+        const int n = five_point::solve(&samples_a[5*i], &samples_b[5*i], solutions);
+        num_solutions += n;
+
+        // the true essential matrix has to be one of the solutions
+        double error = 1;
+        for (j=0; j < n; j+=1)
+            error = min(error, matrices_distance(solutions[j], true_essential_matrix));
+
+        num_found += (error < 1e-6) ? 1 : 0;
+        max_error = max(max_error, error);
+    }
+    const posix_time::time_duration duration = posix_time::microsec_clock::local_time() - start_time;
+
+    printf("five_point::solve: %.2f [us/solve], %.2f real solutions/sample, "
+           "true essential matrix found in %.2f%% of the samples (max error %.2e)\n",
+           duration.total_microseconds() / static_cast<double>(num_samples),
+           static_cast<double>(num_solutions) / num_samples,
+           (100.0 * num_found) / num_samples, max_error);
+
+    // the same through the model interface, from the rounded pixel positions of the inliers
+    Calibrated5PointsEssentialMatrixModel model(focal_length, center_x, center_y);
+    vector< ScoredMatch > inliers, minimal_set(5);
+    for (i=0; i < num_matches; i+=1)
+        if (is_true_inlier[i])
+            inliers.push_back(matches[i]);
+
+    long num_failures = 0;
+    const posix_time::ptime model_start_time = posix_time::microsec_clock::local_time();
+    for (i=0; i < num_samples; i+=1)
+    {
+        sampler.draw(static_cast<int>(inliers.size()), 5, sample);
+        for (j=0; j < 5; j+=1)
+            minimal_set[j] = inliers[sample[j]];
+
+        try
+        {
+            model.estimate_from_minimal_set(minimal_set);
+        }
+        catch (runtime_error &)
+        {
+            num_failures += 1;
+        }
+    }
+    const posix_time::time_duration model_duration = posix_time::microsec_clock::local_time() - model_start_time;
+
+    printf("Calibrated5PointsEssentialMatrixModel::estimate_from_minimal_set: %.2f [us/solve], %li failed samples\n",
+           model_duration.total_microseconds() / static_cast<double>(num_samples), num_failures);
+
+    // robust estimators --
+    RANSAC ransac(options, model);
+    PROSAC prosac(options, model);
+    ARRSAC arrsac(options, model);
+
+    EstimatorStatistics ransac_statistics("RANSAC"), prosac_statistics("PROSAC"), arrsac_statistics("ARRSAC");
+
+    int frame;
+    for (frame=0; frame < num_frames; frame+=1)
+    {
+        generate_scene(num_matches, inliers_fraction);
+        ransac_statistics.run(ransac, matches, is_true_inlier, true_essential_matrix);
+        prosac_statistics.run(prosac, matches, is_true_inlier, true_essential_matrix);
+        arrsac_statistics.run(arrsac, matches, is_true_inlier, true_essential_matrix);
+    }
+
+    printf("%i frames of %i matches, %.0f%% inliers\n", num_frames, num_matches, 100.0 * inliers_fraction);
+    ransac_statistics.print(num_frames);
+    prosac_statistics.print(num_frames);
+    arrsac_statistics.print(num_frames);
+
+    benchmark_fundamental_matrix(options);
+    benchmark_dominant_plane(options);
+    return 0;
+}
+
+
+void FivePointBenchmarkApplication::benchmark_fundamental_matrix(args::variables_map &options)
+{
+    const int num_samples = options["benchmark.num_samples"].as<int>();
+    const int num_matches = options["benchmark.num_matches"].as<int>();
+    const int num_frames = options["benchmark.num_frames"].as<int>();
+    const float inliers_fraction = options["benchmark.inliers_fraction"].as<float>();
+    const float confidence = options["ransac.confidence"].as<float>();
+
+    // the number of samples RANSAC needs to draw an outlier free one with the given confidence
+    printf("\nfundamental matrix, %.0f%% inliers, %.0f%% confidence\n", 100.0 * inliers_fraction, 100.0 * confidence);
+    int m;
+    for (m=7; m <= 8; m+=1)
+    {
+        const double iterations = log(1.0 - confidence) / log(1.0 - pow(static_cast<double>(inliers_fraction), m));
+        printf("%i points: %.0f iterations to confidence\n", m, ceil(iterations));
+    }
+
+    FundamentalMatrixModel seven_points_model(7), eight_points_model(8);
+    FundamentalMatrixModel *models[2] = { &seven_points_model, &eight_points_model };
+    const char *names[2] = { "7 points", "8 points" };
+
+    // minimal solvers, from the rounded pixel positions of the inliers
+    generate_scene(num_matches, inliers_fraction);
+    Matrix3d true_fundamental_matrix = compute_true_fundamental_matrix();
+
+    vector< ScoredMatch > inliers;
+    int i, j;
+    for (i=0; i < num_matches; i+=1)
+        if (is_true_inlier[i])
+            inliers.push_back(matches[i]);
+
+    if (inliers.size() < 8)
+        throw runtime_error("FivePointBenchmarkApplication needs at least 8 inliers, "
+                            "increase benchmark.num_matches or benchmark.inliers_fraction");
+
+    RandomSampler sampler;
+    vector<int> sample;
+    int model_index;
+    for (model_index=0; model_index < 2; model_index+=1)
+    {
+        FundamentalMatrixModel &model = *models[model_index];
+        const int sample_size = model.get_num_points_to_estimate();
+        vector< ScoredMatch > minimal_set(sample_size);
+
+        long num_solutions = 0;
+        double sum_error = 0;
+        posix_time::time_duration duration;
+        for (i=0; i < num_samples; i+=1)
+        {
+            sampler.draw(static_cast<int>(inliers.size()), sample_size, sample);
+            for (j=0; j < sample_size; j+=1)
+                minimal_set[j] = inliers[sample[j]];
+
+            const posix_time::ptime start_time = posix_time::microsec_clock::local_time();
+            int n = 0;
+            try
+            {
+                n = model.estimate_hypotheses_from_minimal_set(minimal_set);
+            }
+            catch (runtime_error &)
+            {
+                n = 0;
+            }
+            duration += posix_time::microsec_clock::local_time() - start_time;
+
+            // the solution closest to the true fundamental matrix
+            double error = 1;
+            for (j=0; j < n; j+=1)
+            {
+                model.select_hypothesis(j);
+                error = min(error, matrices_distance(parameters_to_matrix(model.get_parameters()), true_fundamental_matrix));
+            }
+            num_solutions += n;
+            sum_error += error;
+        }
+
+        printf("%s minimal solver: %.2f [us/solve], %.2f solutions/sample, mean error of the best solution %.2e\n",
+               names[model_index], duration.total_microseconds() / static_cast<double>(num_samples),
+               static_cast<double>(num_solutions) / num_samples, sum_error / num_samples);
+    }
+
+    // robust estimators, on the same frames for both minimal set sizes
+    RANSAC seven_points_ransac(options, seven_points_model), eight_points_ransac(options, eight_points_model);
+    PROSAC seven_points_prosac(options, seven_points_model), eight_points_prosac(options, eight_points_model);
+
+    EstimatorStatistics
+    seven_points_ransac_statistics("RANSAC 7 points"), eight_points_ransac_statistics("RANSAC 8 points"),
+    seven_points_prosac_statistics("PROSAC 7 points"), eight_points_prosac_statistics("PROSAC 8 points");
+
+    int frame;
+    for (frame=0; frame < num_frames; frame+=1)
+    {
+        generate_scene(num_matches, inliers_fraction);
+        true_fundamental_matrix = compute_true_fundamental_matrix();
+        seven_points_ransac_statistics.run(seven_points_ransac, matches, is_true_inlier, true_fundamental_matrix);
+        eight_points_ransac_statistics.run(eight_points_ransac, matches, is_true_inlier, true_fundamental_matrix);
+        seven_points_prosac_statistics.run(seven_points_prosac, matches, is_true_inlier, true_fundamental_matrix);
+        eight_points_prosac_statistics.run(eight_points_prosac, matches, is_true_inlier, true_fundamental_matrix);
+    }
+
+    seven_points_ransac_statistics.print(num_frames);
+    eight_points_ransac_statistics.print(num_frames);
+    seven_points_prosac_statistics.print(num_frames);
+    eight_points_prosac_statistics.print(num_frames);
+    return;
+}
+
+
+void FivePointBenchmarkApplication::benchmark_dominant_plane(args::variables_map &options)
+{
+    const int num_matches = options["benchmark.num_matches"].as<int>();
+    const int num_frames = options["benchmark.num_frames"].as<int>();
+    const float inliers_fraction = options["benchmark.inliers_fraction"].as<float>();
+    const float planar_fraction = options["benchmark.planar_fraction"].as<float>();
+    const float homography_threshold = options["benchmark.homography_threshold"].as<float>();
+
+    printf("\nfundamental matrix, %.0f%% inliers, %.0f%% of them on a plane\n",
+           100.0 * inliers_fraction, 100.0 * planar_fraction);
+
+    FundamentalMatrixModel model(7);
+    FundamentalMatrixModel ransac_degensac_model(7, homography_threshold), prosac_degensac_model(7, homography_threshold);
+
+    RANSAC ransac(options, model), degensac_ransac(options, ransac_degensac_model);
+    PROSAC prosac(options, model), degensac_prosac(options, prosac_degensac_model);
+
+    EstimatorStatistics
+    ransac_statistics("RANSAC 7 points"), degensac_ransac_statistics("RANSAC 7 points, degeneracy test"),
+    prosac_statistics("PROSAC 7 points"), degensac_prosac_statistics("PROSAC 7 points, degeneracy test");
+
+    int frame;
+    for (frame=0; frame < num_frames; frame+=1)
+    {
+        generate_scene(num_matches, inliers_fraction, planar_fraction);
+        const Matrix3d true_fundamental_matrix = compute_true_fundamental_matrix();
+        ransac_statistics.run(ransac, matches, is_true_inlier, true_fundamental_matrix);
+        degensac_ransac_statistics.run(degensac_ransac, matches, is_true_inlier, true_fundamental_matrix);
+        prosac_statistics.run(prosac, matches, is_true_inlier, true_fundamental_matrix);
+        degensac_prosac_statistics.run(degensac_prosac, matches, is_true_inlier, true_fundamental_matrix);
+    }
+
+    ransac_statistics.print(num_frames);
+    degensac_ransac_statistics.print(num_frames);
+    prosac_statistics.print(num_frames);
+    degensac_prosac_statistics.print(num_frames);
+    printf("degenerate best samples/frame: RANSAC %.1f, PROSAC %.1f\n",
+           static_cast<double>(ransac_degensac_model.get_num_degenerate_samples()) / num_frames,
+           static_cast<double>(prosac_degensac_model.get_num_degenerate_samples()) / num_frames);
+    return;
+}
+
+
+Matrix3d FivePointBenchmarkApplication::compute_true_fundamental_matrix() const
+{
+    // F = K^-T E K^-1, in pixels
+    Matrix3d k_inverse;
+    k_inverse << 1 / focal_length, 0, -center_x / focal_length,
+    0, 1 / focal_length, -center_y / focal_length,
+    0, 0, 1;
+
+    const Matrix3d fundamental_matrix = k_inverse.transpose() * true_essential_matrix * k_inverse;
+    return fundamental_matrix / fundamental_matrix.norm();
+}
+
+
+void FivePointBenchmarkApplication::generate_scene(const int num_matches, const float inliers_fraction,
+        const float planar_fraction)
+{
+    static boost::mt19937 random_generator;
+    boost::variate_generator<boost::mt19937&, boost::uniform_real<double> >
+    random_uniform(random_generator, boost::uniform_real<double>(0, 1));
+
+    // a random camera motion, mostly sideways, with a small rotation
+    Vector3d axis(random_uniform() - 0.5, random_uniform() - 0.5, random_uniform() - 0.5);
+    const Matrix3d rotation = Eigen::AngleAxisd(0.2 * (random_uniform() - 0.5), axis.normalized()).toRotationMatrix();
+    const Vector3d translation = Vector3d(1, 0.2 * (random_uniform() - 0.5), 0.2 * (random_uniform() - 0.5)).normalized();
+
+    Matrix3d translation_cross;
+    translation_cross << 0, -translation[2], translation[1],
+    translation[2], 0, -translation[0],
+    -translation[1], translation[0], 0;
+    true_essential_matrix = translation_cross * rotation;
+    true_essential_matrix /= true_essential_matrix.norm();
+
+    // the vectors are sized before taking pointers to their elements
+    features_a.resize(num_matches);
+    features_b.resize(num_matches);
+    matches.resize(num_matches);
+    is_true_inlier.resize(num_matches);
+    points_a.clear();
+    points_b.clear();
+
+    int i;
+    for (i=0; i < num_matches; i+=1)
+    {
+        FASTFeature &a = features_a[i];
+        FASTFeature &b = features_b[i];
+
+        // a 3d point in front of the first camera, between 4 and 12 times the baseline
+        const Vector2d point_a((random_uniform() * (width - 1) - center_x) / focal_length,
+                               (random_uniform() * (height - 1) - center_y) / focal_length);
+        // or a point on the slanted plane 0.1 x + 0.05 y + z = 6
+        const double depth = (planar_fraction > 0 && random_uniform() < planar_fraction) ?
+                             6 / (0.1 * point_a[0] + 0.05 * point_a[1] + 1) : 4 + 8 * random_uniform();
+        const Vector3d point_3d = rotation * (depth * Vector3d(point_a[0], point_a[1], 1)) + translation;
+        const Vector2d point_b(point_3d[0] / point_3d[2], point_3d[1] / point_3d[2]);
+
+        a.x = static_cast<int>(floor(focal_length * point_a[0] + center_x + 0.5));
+        a.y = static_cast<int>(floor(focal_length * point_a[1] + center_y + 0.5));
+
+        is_true_inlier[i] = (random_uniform() < inliers_fraction);
+        if (is_true_inlier[i])
+        {
+            b.x = static_cast<int>(floor(focal_length * point_b[0] + center_x + 0.5));
+            b.y = static_cast<int>(floor(focal_length * point_b[1] + center_y + 0.5));
+            points_a.push_back(point_a);
+            points_b.push_back(point_b);
+        }
+        else
+        {
+            b.x = static_cast<int>(random_uniform() * (width - 1));
+            b.y = static_cast<int>(random_uniform() * (height - 1));
+        }
+
+        ScoredMatch &match = matches[i];
+        match.feature_a = &a;
+        match.feature_b = &b;
+        match.index_a = i;
+        match.index_b = i;
+        match.distance = is_true_inlier[i] ? 0.5f * random_uniform() : random_uniform();
+    }
+
+    return;
+}
+
+
+} // end of namespace uniclop
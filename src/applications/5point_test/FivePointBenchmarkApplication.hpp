@@ -0,0 +1,62 @@
+#if !defined(FIVE_POINT_BENCHMARK_APPLICATION_HEADER)
+#define FIVE_POINT_BENCHMARK_APPLICATION_HEADER
+
+#include "applications/AbstractApplication.hpp"
+
+#include "algorithms/features/ScoredMatch.hpp"
+#include "algorithms/features/fast/FASTFeature.hpp"
+
+#include <Eigen/Core>
+#include <Eigen/StdVector>
+
+#include <vector>
+
+namespace uniclop
+{
+
+using namespace std;
+
+/**
+ * Microbenchmark of the five point essential matrix solver (five_point::solve),
+ * reports the time per minimal solve and checks that the true essential matrix is among the solutions.
+ * Then runs the robust estimators with the Calibrated5PointsEssentialMatrixModel,
+ * and compares the seven and eight point minimal sets of the FundamentalMatrixModel,
+ * with and without the degeneracy test, on a scene dominated by a plane.
+ * Runs on a random synthetic scene seen by a calibrated camera, no video input is required.
+ */
+class FivePointBenchmarkApplication : public AbstractApplication
+{
+
+public:
+    string get_application_title() const;
+    args::options_description get_command_line_options(void) const;
+    int main_loop(args::variables_map &options);
+
+private:
+
+    typedef vector< Eigen::Vector2d, Eigen::aligned_allocator<Eigen::Vector2d> > Points;
+
+    // normalized image coordinates of the inliers, without noise nor rounding
+    Points points_a, points_b;
+    Eigen::Matrix3d true_essential_matrix;
+
+    vector<FASTFeature> features_a, features_b;
+    vector< ScoredMatch > matches;
+    vector<bool> is_true_inlier;
+
+    void generate_scene(const int num_matches, const float inliers_fraction, const float planar_fraction = 0);
+    ///< planar_fraction of the inliers lie on a plane, the others are spread in depth
+
+    Eigen::Matrix3d compute_true_fundamental_matrix() const;
+
+    void benchmark_fundamental_matrix(args::variables_map &options);
+    ///< iterations to confidence, minimal solvers and robust estimators, for 7 and 8 points samples
+
+    void benchmark_dominant_plane(args::variables_map &options);
+    ///< robust estimators with and without the degeneracy test (DEGENSAC), when most inliers lie on a plane
+
+};
+
+}
+
+#endif // FIVE_POINT_BENCHMARK_APPLICATION_HEADER
@@ -0,0 +1,297 @@
+/*
+Benchmark of the features matchers, running on synthetic FASTFeatures
+*/
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Headers
+
+#include "FeaturesMatchingBenchmarkApplication.hpp"
+
+#include "algorithms/features/SimpleFeaturesMatcher.hpp"
+#include "algorithms/features/fast/FASTFeaturesMatcher.hpp"
+#include "algorithms/features/fast/FASTFeatureSet.hpp"
+
+#include <boost/random.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <new>
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Allocations counting
+// the global operator new is replaced only in this application,
+// so that we can check that the matchers do not allocate memory at steady state
+
+static unsigned long num_allocations = 0;
+
+// dynamic exception specifications are ill-formed since C++17, throw() is only kept for C++98 compilers
+#if __cplusplus >= 201103L
+#define NO_THROW noexcept
+#else
+#define NO_THROW throw()
+#endif
+
+void *operator new(std::size_t size)
+{
+    num_allocations += 1;
+    void *p = malloc(size == 0 ? 1 : size);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) NO_THROW
+{
+    free(p);
+    return;
+}
+
+#if __cplusplus >= 201402L
+// the sized version is used by the C++14 compilers, it has to match the replaced operator new
+void operator delete(void *p, std::size_t) noexcept
+{
+    free(p);
+    return;
+}
+#endif
+
+namespace uniclop
+{
+
+using namespace std;
+namespace posix_time = boost::posix_time;
+
+
+string FeaturesMatchingBenchmarkApplication::get_application_title() const
+{
+    return "Features matching benchmark. Uniclop 2009";
+}
+
+args::options_description FeaturesMatchingBenchmarkApplication::get_command_line_options(void) const
+{
+    args::options_description desc("FeaturesMatchingBenchmarkApplication options");
+
+    desc.add_options()
+
+    ("benchmark.num_features", args::value<int>()->default_value(3000),
+     "number of features per synthetic frame")
+
+    ("benchmark.num_frames", args::value<int>()->default_value(20),
+     "number of synthetic frames to match")
+
+    ("benchmark.noise_level", args::value<int>()->default_value(8),
+     "maximum intensity perturbation applied to the circle intensities of the matching features")
+
+    ("benchmark.outliers_fraction", args::value<float>()->default_value(0.2f),
+     "fraction of the features in frame a that have no correspondent in frame b")
+    ;
+
+    desc.add(FASTFeaturesMatcher::get_options_description());
+    desc.add(SimpleFeaturesMatcher<FASTFeature>::get_options_description());
+
+    return desc;
+}
+
+
+// helper function, returns the best distance found for each feature of the list a
+void get_best_distances(const vector<FASTFeature> &features_a, const vector< ScoredMatch > &matches,
+                        vector<float> &best_distances)
+{
+    best_distances.assign(features_a.size(), numeric_limits<float>::max());
+
+    vector< ScoredMatch >::const_iterator matches_it;
+    for (matches_it = matches.begin(); matches_it != matches.end(); ++matches_it)
+    {
+        const FASTFeature *feature_a_p = static_cast<const FASTFeature *>(matches_it->feature_a);
+        const int index = feature_a_p - &features_a[0];
+        best_distances[index] = min(best_distances[index], matches_it->distance);
+    }
+    return;
+}
+
+
+// helper function, assigns a large set into a non empty smaller one
+// (its descriptors buffer has to grow), returns the number of features that were not copied exactly
+int count_assignment_errors(const FASTFeatureSet &features_set)
+{
+    const uint8_t circle_intensities[16] = {0};
+    FASTFeatureSet small_set;
+    small_set.push_back(1, 2, 3, circle_intensities);
+
+    small_set = features_set;
+
+    int num_errors = (small_set.size() == features_set.size()) ? 0 : 1;
+    size_t i;
+    for (i=0; i < min(small_set.size(), features_set.size()); i+=1)
+    {
+        num_errors += (small_set.x[i] == features_set.x[i] && small_set.y[i] == features_set.y[i] &&
+                       memcmp(small_set.circle_intensities(i), features_set.circle_intensities(i), 16) == 0) ? 0 : 1;
+    }
+    return num_errors;
+}
+
+
+int FeaturesMatchingBenchmarkApplication::main_loop(args::variables_map &options)
+{
+
+    const int num_features = options["benchmark.num_features"].as<int>();
+    const int num_frames = options["benchmark.num_frames"].as<int>();
+    const int noise_level = options["benchmark.noise_level"].as<int>();
+    const float outliers_fraction = options["benchmark.outliers_fraction"].as<float>();
+
+    SimpleFeaturesMatcher<FASTFeature> simple_features_matcher(options);
+    FASTFeaturesMatcher fast_features_matcher(options);
+
+    vector<FASTFeature> features_a, features_b;
+    FASTFeatureSet features_set_a, features_set_b;
+    vector<float> simple_best_distances, fast_best_distances;
+    vector< ScoredMatch > fast_matches_copy;
+
+    posix_time::time_duration simple_duration, fast_duration, fast_set_duration;
+    int num_agreements = 0, num_queries = 0, num_set_disagreements = 0, num_assignment_errors = 0;
+
+    // the first frame is excluded, it is the one that sizes the internal buffers
+    unsigned long simple_allocations = 0, fast_allocations = 0, fast_set_allocations = 0;
+    unsigned long allocations_before = 0;
+
+    int frame;
+    for (frame=0; frame < num_frames; frame+=1)
+    {
+        generate_frames(num_features, noise_level, outliers_fraction, features_a, features_b);
+        features_set_a.from_features(features_a);
+        features_set_b.from_features(features_b);
+        num_assignment_errors += count_assignment_errors(features_set_a);
+
+        allocations_before = num_allocations;
+        posix_time::ptime start_time = posix_time::microsec_clock::local_time();
+        const vector< ScoredMatch > &simple_matches = simple_features_matcher.match(features_a, features_b);
+        posix_time::ptime end_time = posix_time::microsec_clock::local_time();
+        simple_duration += end_time - start_time;
+        if (frame > 0)
+            simple_allocations += num_allocations - allocations_before;
+
+        allocations_before = num_allocations;
+        start_time = posix_time::microsec_clock::local_time();
+        const vector< ScoredMatch > &fast_matches = fast_features_matcher.match(features_a, features_b);
+        end_time = posix_time::microsec_clock::local_time();
+        fast_duration += end_time - start_time;
+        if (frame > 0)
+            fast_allocations += num_allocations - allocations_before;
+
+        // how often does the tree find the same best match than the exhaustive search ?
+        get_best_distances(features_a, simple_matches, simple_best_distances);
+        get_best_distances(features_a, fast_matches, fast_best_distances);
+
+        // the same matcher over the structure of arrays storage should give exactly the same matches
+        // (fast_matches is overwritten by the next call, so we keep a copy)
+        fast_matches_copy = fast_matches;
+        allocations_before = num_allocations;
+        start_time = posix_time::microsec_clock::local_time();
+        const vector< ScoredMatch > &fast_set_matches = fast_features_matcher.match(features_set_a, features_set_b);
+        end_time = posix_time::microsec_clock::local_time();
+        fast_set_duration += end_time - start_time;
+        if (frame > 0)
+            fast_set_allocations += num_allocations - allocations_before;
+
+        unsigned int m;
+        for (m=0; m < fast_set_matches.size(); m+=1)
+        {
+            num_set_disagreements +=
+                (fast_set_matches[m].index_a == fast_matches_copy[m].index_a &&
+                 fast_set_matches[m].index_b == fast_matches_copy[m].index_b) ? 0 : 1;
+        }
+
+        unsigned int i;
+        for (i=0; i < features_a.size(); i+=1)
+        {
+            num_agreements += (simple_best_distances[i] == fast_best_distances[i]) ? 1 : 0;
+            num_queries += 1;
+        }
+    }
+
+    const double simple_ms = simple_duration.total_microseconds() / (1000.0 * num_frames);
+    const double fast_ms = fast_duration.total_microseconds() / (1000.0 * num_frames);
+    const double fast_set_ms = fast_set_duration.total_microseconds() / (1000.0 * num_frames);
+
+    printf("%i frames of %i features\n", num_frames, num_features);
+    printf("SimpleFeaturesMatcher (brute force) %.3f [ms/frame]\n", simple_ms);
+    printf("FASTFeaturesMatcher (decision tree) %.3f [ms/frame], speedup %.1fx\n",
+           fast_ms, simple_ms / max(fast_ms, 1e-6));
+    printf("FASTFeaturesMatcher over FASTFeatureSet %.3f [ms/frame], %i matches differ from the vector version\n",
+           fast_set_ms, num_set_disagreements);
+    printf("FASTFeatureSet assignment into a smaller set, %i features differ from the original\n",
+           num_assignment_errors);
+    printf("FASTFeaturesMatcher found the exhaustive search best match in %.2f%% of the queries\n",
+           (100.0 * num_agreements) / max(num_queries, 1));
+
+    const double steady_frames = max(num_frames - 1, 1);
+    printf("Memory allocations per frame (after the first frame): "
+           "SimpleFeaturesMatcher %.1f, FASTFeaturesMatcher %.1f, FASTFeaturesMatcher over FASTFeatureSet %.1f\n",
+           simple_allocations / steady_frames, fast_allocations / steady_frames,
+           fast_set_allocations / steady_frames);
+
+    return 0;
+}
+
+
+void FeaturesMatchingBenchmarkApplication::generate_frames(
+    const int num_features, const int noise_level, const float outliers_fraction,
+    vector<FASTFeature> &features_a, vector<FASTFeature> &features_b)
+{
+    static boost::mt19937 random_generator;
+    boost::variate_generator<boost::mt19937&, boost::uniform_int<int> >
+    random_intensity(random_generator, boost::uniform_int<int>(0, 255));
+    boost::variate_generator<boost::mt19937&, boost::uniform_int<int> >
+    random_noise(random_generator, boost::uniform_int<int>(-noise_level, noise_level));
+    boost::variate_generator<boost::mt19937&, boost::uniform_int<int> >
+    random_index(random_generator, boost::uniform_int<int>(0, num_features - 1));
+    boost::variate_generator<boost::mt19937&, boost::uniform_real<float> >
+    random_uniform(random_generator, boost::uniform_real<float>(0, 1));
+
+    features_b.resize(num_features);
+    features_a.resize(num_features);
+
+    int i, j;
+    for (i=0; i < num_features; i+=1)
+    {
+        FASTFeature &f = features_b[i];
+        f.x = random_index() % 640;
+        f.y = random_index() % 480;
+        for (j=0; j < 16; j+=1)
+            f.circle_intensities[j] = static_cast<uint8_t>(random_intensity());
+    }
+
+    for (i=0; i < num_features; i+=1)
+    {
+        FASTFeature &f = features_a[i];
+
+        if (random_uniform() < outliers_fraction)
+        { // a feature without correspondent
+            f.x = random_index() % 640;
+            f.y = random_index() % 480;
+            for (j=0; j < 16; j+=1)
+                f.circle_intensities[j] = static_cast<uint8_t>(random_intensity());
+        }
+        else
+        { // a noisy copy of a random feature b
+            const FASTFeature &fb = features_b[random_index()];
+            f.x = fb.x;
+            f.y = fb.y;
+            for (j=0; j < 16; j+=1)
+            {
+                const int value = fb.circle_intensities[j] + random_noise();
+                f.circle_intensities[j] = static_cast<uint8_t>(max(0, min(255, value)));
+            }
+        }
+    }
+
+    return;
+}
+
+
+} // end of namespace uniclop
@@ -0,0 +1,39 @@
+
+
+#if !defined(FEATURES_MATCHING_BENCHMARK_APPLICATION_HEADER)
+#define FEATURES_MATCHING_BENCHMARK_APPLICATION_HEADER
+
+#include "applications/AbstractApplication.hpp"
+
+#include "algorithms/features/fast/FASTFeature.hpp"
+
+#include <vector>
+
+namespace uniclop
+{
+
+using namespace std;
+
+/**
+ * Compares the different FASTFeature matchers on synthetic frames.
+ * Frame b is a set of random features, frame a is a noisy and shuffled copy of frame b
+ * (plus some outliers). No video input is required.
+ */
+class FeaturesMatchingBenchmarkApplication : public AbstractApplication
+{
+
+public:
+    string get_application_title() const;
+    args::options_description get_command_line_options(void) const;
+    int main_loop(args::variables_map &options);
+
+private:
+
+    void generate_frames(const int num_features, const int noise_level, const float outliers_fraction,
+                         vector<FASTFeature> &features_a, vector<FASTFeature> &features_b);
+
+};
+
+}
+
+#endif // FEATURES_MATCHING_BENCHMARK_APPLICATION_HEADER
@@ -0,0 +1,14 @@
+
+
+#include "FeaturesMatchingBenchmarkApplication.hpp"
+#include <boost/scoped_ptr.hpp>
+
+
+int main(int argc, char *argv[])
+{
+    using uniclop::FeaturesMatchingBenchmarkApplication;
+    using uniclop::AbstractApplication;
+
+    boost::scoped_ptr<AbstractApplication> application_p(new FeaturesMatchingBenchmarkApplication());
+    return application_p->main(argc, argv);
+}
@@ -46,7 +46,8 @@ using boost::gil::gray8_image_t;
 
 // function prototype
 template<typename FeatureType, typename ImageView>
-int main_loop(args::variables_map &options, IFeaturesDetector<FeatureType, ImageView> &features_detector, GstVideoInput &video_input);
+int main_loop(args::variables_map &options, IFeaturesDetector<FeatureType, ImageView> &features_detector,
+              IFeaturesMatcher<FeatureType> &features_matcher, GstVideoInput &video_input);
 
 
 string FeaturesTrackingApplication::get_application_title() const
@@ -64,12 +65,15 @@ desc.add_options()
 
         ("features_detection_method", args::value<string>()->default_value("FAST"),
          "choose the features detection method: FAST, Harris or SIFT")
+
+        ("features_matching_method", args::value<string>()->default_value("simple"),
+         "choose the features matching method: simple (brute force) or FAST (decision tree)")
 
         ("model", args::value<string>()->default_value("homography"),
          "choose the model to use: homography or fundamental_matrix")
 
         ("estimation_method", args::value<string>()->default_value("none"),
-         "choose the robust estimation method: none, RANSAC, PROSAC, Ensemble or DenseEnsemble")
+         "choose the robust estimation method: none, RANSAC, PROSAC, ARRSAC, Ensemble or DenseEnsemble")
 
         ("show_features_points", args::value<bool>()->default_value(false),
          "show the detected features")
@@ -81,12 +85,16 @@ desc.add_options()
     desc.add(SimpleFAST::get_options_description());
     desc.add(FASTFeaturesMatcher::get_options_description());
     desc.add(SimpleFeaturesMatcher<features_t>::get_options_description());
+    desc.add(RANSAC::get_options_description());
+    desc.add(TddVerifier::get_options_description());
+    desc.add(SPRTVerifier::get_options_description());
+    desc.add(LocalOptimization::get_options_description());
+    desc.add(PROSAC::get_options_description());
+    desc.add(ARRSAC::get_options_description());
+    desc.add(EnsembleMethod::get_options_description());
 
 		//desc.add( ImagesInput<uint8_t>::get_options_description() );
         //desc.add( SimpleSIFT::get_options_description() );
-        //desc.add( EnsembleMethod< ScoredMatch<FASTFeature> >::get_options_description() );
-        //desc.add( PROSAC< ScoredMatch<FASTFeature> >::get_options_description() );
-        //desc.add( RANSAC< ScoredMatch<FASTFeature> >::get_options_description() );
         
     return desc;
 }
@@ -105,9 +113,17 @@ int FeaturesTrackingApplication::main_loop(args::variables_map &options)
    // initialization ---
     gst_video_input_p.reset(new GstVideoInput(options));
 	features_detector_p.reset(new SimpleFAST(options));
-
-	features_matcher_p.reset(new  SimpleFeaturesMatcher<features_t>(options));
-    //features_matcher_p.reset(new FASTFeaturesMatcher(options));
+
+    string features_matching_method = "simple";
+    if (options.count("features_matching_method"))
+        features_matching_method = options["features_matching_method"].as<string>();
+
+    if (features_matching_method == "FAST")
+        features_matcher_p.reset(new FASTFeaturesMatcher(options));
+    else if (features_matching_method == "simple")
+        features_matcher_p.reset(new SimpleFeaturesMatcher<features_t>(options));
+    else
+        throw runtime_error("No known features matcher selected");
 
 
 	 // select the features detection method ---
@@ -123,7 +139,7 @@ int FeaturesTrackingApplication::main_loop(args::variables_map &options)
         {
             boost::scoped_ptr< IFeaturesDetector<SimpleFAST::features_t, SimpleFAST::image_view_t> > features_detector_p;
             features_detector_p.reset( new SimpleFAST(options) );
-            return uniclop::main_loop<SimpleFAST::features_t, SimpleFAST::image_view_t>(options, *features_detector_p, *gst_video_input_p);
+            return uniclop::main_loop<SimpleFAST::features_t, SimpleFAST::image_view_t>(options, *features_detector_p, *features_matcher_p, *gst_video_input_p);
         }
         else if (features_detection_method == "Harris")
         {
@@ -333,7 +349,8 @@ void FeaturesTrackingApplication::draw_tracks(const FeaturesTracks &tracks, rgb8
 // ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
 
 template<typename FeatureType, typename ImageView>
-int main_loop(args::variables_map &options, IFeaturesDetector<FeatureType, ImageView> &features_detector, GstVideoInput &video_input)
+int main_loop(args::variables_map &options, IFeaturesDetector<FeatureType, ImageView> &features_detector,
+              IFeaturesMatcher<FeatureType> &features_matcher, GstVideoInput &video_input)
 {
     // part of the code needs to be templated...
 
@@ -365,9 +382,7 @@ int main_loop(args::variables_map &options, IFeaturesDetector<FeatureType, Image
         cout << "template_features.size() == " << template_features.size() << endl;
     }
 
-    // create the features matcher, and model estimator objects --
-
-    SimpleFeaturesMatcher<FeatureType> simple_features_matcher(options);
+    // create the model estimator objects --
 
     string estimation_method;
     if (options.count("estimation_method"))
@@ -401,6 +416,9 @@ int main_loop(args::variables_map &options, IFeaturesDetector<FeatureType, Image
     else if (estimation_method == "PROSAC")
         estimator_p.reset( new PROSAC(options, model) );
 
+    else if (estimation_method == "ARRSAC")
+        estimator_p.reset( new ARRSAC(options, model) );
+
     else if (estimation_method == "Ensemble")
     {
         EnsembleMethod *t_ensemble_method_p = new EnsembleMethod(options, model);
@@ -453,7 +471,7 @@ int main_loop(args::variables_map &options, IFeaturesDetector<FeatureType, Image
 
         // obtain features matches candidates -
         vector< ScoredMatch > & matches =
-            simple_features_matcher.match(template_features, current_features);
+            features_matcher.match(template_features, current_features);
 
         sort(matches.begin(), matches.end());
         // introsort C++ standard algorithm O(NlogN)
@@ -634,26 +652,27 @@ int main_loop(args::variables_map &options, IFeaturesDetector<FeatureType, Image
         if ( ensemble_method_estimator_p == NULL)
             throw runtime_error("Estimation method does not compute histograms");
 
-        const vector< HistogramKurtosis<double> > &hk_estimators =
-            ensemble_method_estimator_p->histogram_kurtosis_estimators;
+        const KurtosisAccumulators &kurtosis_accumulators =
+            ensemble_method_estimator_p->kurtosis_accumulators;
 
         const vector<double> &kurtosis_values =
             ensemble_method_estimator_p->kurtosis_values;
 
-        if ( hk_estimators.empty() == false )
+        if ( kurtosis_accumulators.has_histograms() )
         {
 
 
-            unsigned int h_index = 0; // index to one of the histograms
+            int h_index = 0; // index to one of the histograms
             int graphs_max_val = 0;
 
-            const vector<int> &t_bins = hk_estimators[h_index].get_bins();
+            vector<int> t_bins;
+            kurtosis_accumulators.get_histogram(h_index, t_bins);
             graphs_max_val = max(*max_element(t_bins.begin(), t_bins.end()), graphs_max_val);
             const float t_kurtosis = static_cast<float>(kurtosis_values[h_index]);
 
             CImgDisplay histograms_display;
-            HistogramKurtosis<>::display_histogram(t_kurtosis,
-                                                   t_bins, graphs_max_val, histograms_display);
+            KurtosisAccumulators::display_histogram(t_kurtosis,
+                                                    t_bins, graphs_max_val, histograms_display);
             histograms_display.set_title("Generated histogram");
             histograms_display.show();
 
@@ -668,14 +687,14 @@ int main_loop(args::variables_map &options, IFeaturesDetector<FeatureType, Image
                 if (histograms_display.button)
                 {
                     h_index += 1;
-                    if (h_index == hk_estimators.size() ) h_index = 0;
+                    if (h_index == kurtosis_accumulators.size() ) h_index = 0;
 
-                    const vector<int> &t_bins = hk_estimators[h_index].get_bins();
+                    kurtosis_accumulators.get_histogram(h_index, t_bins);
                     graphs_max_val = max(*max_element(t_bins.begin(), t_bins.end()), graphs_max_val);
                     const float t_kurtosis = static_cast<float>(kurtosis_values[h_index]);
 
-                    HistogramKurtosis<>::display_histogram(t_kurtosis,
-                                                           t_bins, graphs_max_val, histograms_display);
+                    KurtosisAccumulators::display_histogram(t_kurtosis,
+                                                            t_bins, graphs_max_val, histograms_display);
 
                 } // end of 'if histograms_display.button'
 
@@ -685,7 +704,7 @@ int main_loop(args::variables_map &options, IFeaturesDetector<FeatureType, Image
 
         }
         else
-        { // hk_estimators.empty() == true
+        { // ensemble_method.histogram_bins == 0
 
             //throw runtime_error("No histograms to show");
             cout << "No histograms to show" << endl;
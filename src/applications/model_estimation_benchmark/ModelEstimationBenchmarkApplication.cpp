@@ -0,0 +1,393 @@
+/*
+Benchmark of the robust model estimators, running on synthetic matches
+*/
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Headers
+
+#include "ModelEstimationBenchmarkApplication.hpp"
+
+#include "algorithms/model_estimation/estimators/RANSAC.hpp"
+#include "algorithms/model_estimation/estimators/PROSAC.hpp"
+#include "algorithms/model_estimation/estimators/ARRSAC.hpp"
+#include "algorithms/model_estimation/estimators/TddVerifier.hpp"
+#include "algorithms/model_estimation/estimators/SPRTVerifier.hpp"
+#include "algorithms/model_estimation/estimators/LocalOptimization.hpp"
+#include "algorithms/model_estimation/models/HomographyModel.hpp"
+
+#include <boost/random.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <iostream>
+
+namespace uniclop
+{
+
+using namespace std;
+namespace posix_time = boost::posix_time;
+
+
+string ModelEstimationBenchmarkApplication::get_application_title() const
+{
+    return "Model estimation benchmark. Uniclop 2009";
+}
+
+args::options_description ModelEstimationBenchmarkApplication::get_command_line_options(void) const
+{
+    args::options_description desc("ModelEstimationBenchmarkApplication options");
+
+    desc.add_options()
+
+    ("benchmark.num_matches", args::value<int>()->default_value(500),
+     "number of matches per synthetic frame")
+
+    ("benchmark.num_frames", args::value<int>()->default_value(20),
+     "number of synthetic frames to estimate")
+
+    ("benchmark.inliers_fraction", args::value<float>()->default_value(0.3f),
+     "fraction of the matches that follow the homography")
+
+    ("benchmark.ranking_quality", args::value<float>()->default_value(0.5f),
+     "how much the matches distance predicts the inliers, "
+     "0 means no correlation, 1 means that all inliers rank before the outliers")
+
+    ("benchmark.inliers_noise", args::value<float>()->default_value(0.0f),
+     "standard deviation of the gaussian noise added to the inliers positions, in pixels")
+
+    ("benchmark.clustered_inliers", args::value<bool>()->default_value(false),
+     "the inliers lie on an object covering the center quarter of the image, "
+     "instead of being spread like the outliers over the whole image")
+
+    ("benchmark.estimators", args::value<string>()->default_value("RANSAC,RANSAC-Tdd,RANSAC-SPRT,RANSAC-GC,PROSAC,ARRSAC"),
+     "comma separated list of the estimators to compare: RANSAC, RANSAC-Tdd, RANSAC-SPRT, RANSAC-GC, PROSAC, ARRSAC "
+     "(RANSAC-Tdd and RANSAC-SPRT override ransac.preverification, RANSAC-GC overrides lo.graph_cut)")
+    ;
+
+    desc.add(RANSAC::get_options_description());
+    desc.add(TddVerifier::get_options_description());
+    desc.add(SPRTVerifier::get_options_description());
+    desc.add(LocalOptimization::get_options_description());
+    desc.add(PROSAC::get_options_description());
+    desc.add(ARRSAC::get_options_description());
+
+    return desc;
+}
+
+
+// helper function, mean distance between the points mapped by the estimated homography
+// and by the true homography, over a grid covering the image
+double compute_mean_transfer_error(const ublas::vector<float> &parameters, const float true_homography[9])
+{
+    const float *h = true_homography;
+    const ublas::vector<float> &p = parameters;
+
+    double error = 0;
+    int num_points = 0, x, y;
+    for (x=0; x < 640; x+=32)
+        for (y=0; y < 480; y+=32)
+        {
+            const double w = h[6]*x + h[7]*y + h[8];
+            const double estimated_w = p[6]*x + p[7]*y + p[8];
+            if (estimated_w == 0)
+                return numeric_limits<double>::max();
+
+            const double del_x = (p[0]*x + p[1]*y + p[2]) / estimated_w - (h[0]*x + h[1]*y + h[2]) / w;
+            const double del_y = (p[3]*x + p[4]*y + p[5]) / estimated_w - (h[3]*x + h[4]*y + h[5]) / w;
+            error += sqrt(del_x*del_x + del_y*del_y);
+            num_points += 1;
+        }
+
+    return error / num_points;
+}
+
+
+// helper class, accumulates the results of one estimator over the synthetic frames
+class EstimatorStatistics
+{
+public:
+    string name;
+    posix_time::time_duration duration;
+    long num_hypotheses_tested, num_residuals_evaluated;
+    long num_true_inliers, num_true_inliers_found, num_false_inliers_found;
+
+    // accuracy of the estimated models, and of the models refined on their inliers
+    posix_time::time_duration refinement_duration;
+    double sum_error, sum_refined_error;
+    long num_refinement_iterations;
+
+    EstimatorStatistics(const string &_name)
+            : name(_name)
+    {
+        num_hypotheses_tested = 0;
+        num_residuals_evaluated = 0;
+        num_true_inliers = 0;
+        num_true_inliers_found = 0;
+        num_false_inliers_found = 0;
+        sum_error = 0;
+        sum_refined_error = 0;
+        num_refinement_iterations = 0;
+        return;
+    }
+
+    template<typename Estimator>
+    void run(Estimator &estimator, const vector< ScoredMatch > &matches, const vector<bool> &is_true_inlier,
+             const float true_homography[9], HomographyModel &refinement_model)
+    {
+        const posix_time::ptime start_time = posix_time::microsec_clock::local_time();
+        const ublas::vector<float> parameters = estimator.estimate_model_parameters(matches);
+        const posix_time::ptime end_time = posix_time::microsec_clock::local_time();
+        duration += end_time - start_time;
+
+        num_hypotheses_tested += estimator.get_num_hypotheses_tested();
+        num_residuals_evaluated += estimator.get_num_residuals_evaluated();
+
+        const vector<bool> &is_inlier = estimator.get_is_inlier();
+        unsigned int i;
+        for (i=0; i < is_inlier.size(); i+=1)
+        {
+            num_true_inliers += is_true_inlier[i] ? 1 : 0;
+            num_true_inliers_found += (is_true_inlier[i] && is_inlier[i]) ? 1 : 0;
+            num_false_inliers_found += (!is_true_inlier[i] && is_inlier[i]) ? 1 : 0;
+        }
+
+        // least squares estimation on the inliers, starting from the estimated model
+        vector< ScoredMatch > inliers;
+        for (i=0; i < is_inlier.size(); i+=1)
+            if (is_inlier[i])
+                inliers.push_back(matches[i]);
+
+        const double error = compute_mean_transfer_error(parameters, true_homography);
+        sum_error += error;
+        if (inliers.size() > refinement_model.get_num_points_to_estimate())
+        {
+            const posix_time::ptime refinement_start_time = posix_time::microsec_clock::local_time();
+            refinement_model.set_parameters(parameters);
+            refinement_model.estimate(inliers);
+            refinement_duration += posix_time::microsec_clock::local_time() - refinement_start_time;
+
+            num_refinement_iterations += refinement_model.get_num_refinement_iterations();
+            sum_refined_error += compute_mean_transfer_error(refinement_model.get_parameters(), true_homography);
+        }
+        else
+            sum_refined_error += error;
+
+        return;
+    }
+
+    void print(const int num_frames, const double reference_ms) const
+    {
+        const double ms = duration.total_microseconds() / (1000.0 * num_frames);
+        printf("%s: %.1f hypotheses/frame, %.0f residuals/frame, %.3f [ms/frame], speedup %.1fx, "
+               "%.1f%% of the inliers found, %.1f false inliers/frame\n",
+               name.c_str(), static_cast<double>(num_hypotheses_tested) / num_frames,
+               static_cast<double>(num_residuals_evaluated) / num_frames, ms,
+               reference_ms / max(ms, 1e-6),
+               (100.0 * num_true_inliers_found) / max(num_true_inliers, 1L),
+               static_cast<double>(num_false_inliers_found) / num_frames);
+        printf("%s: mean error %.3f [pixels], %.3f [pixels] after refinement on the inliers "
+               "(%.1f iterations, %.3f [ms/frame])\n",
+               name.c_str(), sum_error / num_frames, sum_refined_error / num_frames,
+               static_cast<double>(num_refinement_iterations) / num_frames,
+               refinement_duration.total_microseconds() / (1000.0 * num_frames));
+        return;
+    }
+};
+
+
+// helper function, copy of the options with one option overridden
+template<typename T>
+args::variables_map set_option(const args::variables_map &options, const string &name, const T &value)
+{
+    args::variables_map new_options = options;
+    new_options.erase(name);
+    new_options.insert(make_pair(name, args::variable_value(boost::any(value), false)));
+    return new_options;
+}
+
+
+int ModelEstimationBenchmarkApplication::main_loop(args::variables_map &options)
+{
+
+    const int num_matches = options["benchmark.num_matches"].as<int>();
+    const int num_frames = options["benchmark.num_frames"].as<int>();
+    const float inliers_fraction = options["benchmark.inliers_fraction"].as<float>();
+    const float ranking_quality = options["benchmark.ranking_quality"].as<float>();
+    const float inliers_noise = options["benchmark.inliers_noise"].as<float>();
+    const bool clustered_inliers = options["benchmark.clustered_inliers"].as<bool>();
+    const string estimators = "," + options["benchmark.estimators"].as<string>() + ",";
+
+    const bool use_ransac = (estimators.find(",RANSAC,") != string::npos);
+    const bool use_ransac_tdd = (estimators.find(",RANSAC-Tdd,") != string::npos);
+    const bool use_ransac_sprt = (estimators.find(",RANSAC-SPRT,") != string::npos);
+    const bool use_ransac_gc = (estimators.find(",RANSAC-GC,") != string::npos);
+    const bool use_prosac = (estimators.find(",PROSAC,") != string::npos);
+    const bool use_arrsac = (estimators.find(",ARRSAC,") != string::npos);
+
+    HomographyModel model, refinement_model;
+    RANSAC ransac(options, model);
+    args::variables_map tdd_options = set_option(options, "ransac.preverification", string("Tdd"));
+    args::variables_map sprt_options = set_option(options, "ransac.preverification", string("SPRT"));
+    args::variables_map gc_options = set_option(options, "lo.graph_cut", true);
+    RANSAC ransac_tdd(tdd_options, model);
+    RANSAC ransac_sprt(sprt_options, model);
+    RANSAC ransac_gc(gc_options, model);
+    PROSAC prosac(options, model);
+    ARRSAC arrsac(options, model);
+
+    EstimatorStatistics ransac_statistics("RANSAC"), prosac_statistics("PROSAC"), arrsac_statistics("ARRSAC");
+    EstimatorStatistics ransac_tdd_statistics("RANSAC-Tdd"), ransac_sprt_statistics("RANSAC-SPRT");
+    EstimatorStatistics ransac_gc_statistics("RANSAC-GC");
+
+    int frame;
+    for (frame=0; frame < num_frames; frame+=1)
+    {
+        generate_matches(num_matches, inliers_fraction, ranking_quality, inliers_noise, clustered_inliers);
+
+        if (use_ransac)
+            ransac_statistics.run(ransac, matches, is_true_inlier, true_homography, refinement_model);
+
+        if (use_ransac_tdd)
+            ransac_tdd_statistics.run(ransac_tdd, matches, is_true_inlier, true_homography, refinement_model);
+
+        if (use_ransac_sprt)
+            ransac_sprt_statistics.run(ransac_sprt, matches, is_true_inlier, true_homography, refinement_model);
+
+        if (use_ransac_gc)
+            ransac_gc_statistics.run(ransac_gc, matches, is_true_inlier, true_homography, refinement_model);
+
+        if (use_prosac)
+            prosac_statistics.run(prosac, matches, is_true_inlier, true_homography, refinement_model);
+
+        if (use_arrsac)
+            arrsac_statistics.run(arrsac, matches, is_true_inlier, true_homography, refinement_model);
+    }
+
+    printf("%i frames of %i matches, %.0f%% inliers%s, ranking quality %.2f, inliers noise %.2f [pixels]\n",
+           num_frames, num_matches, 100.0 * inliers_fraction, clustered_inliers ? " (clustered)" : "",
+           ranking_quality, inliers_noise);
+
+    // speedups are relative to the first estimator of the list
+    double reference_ms = 0;
+    if (use_ransac)
+        reference_ms = ransac_statistics.duration.total_microseconds() / (1000.0 * num_frames);
+    else if (use_ransac_tdd)
+        reference_ms = ransac_tdd_statistics.duration.total_microseconds() / (1000.0 * num_frames);
+    else if (use_ransac_sprt)
+        reference_ms = ransac_sprt_statistics.duration.total_microseconds() / (1000.0 * num_frames);
+    else if (use_ransac_gc)
+        reference_ms = ransac_gc_statistics.duration.total_microseconds() / (1000.0 * num_frames);
+    else if (use_prosac)
+        reference_ms = prosac_statistics.duration.total_microseconds() / (1000.0 * num_frames);
+    else if (use_arrsac)
+        reference_ms = arrsac_statistics.duration.total_microseconds() / (1000.0 * num_frames);
+
+    if (use_ransac)
+        ransac_statistics.print(num_frames, reference_ms);
+
+    if (use_ransac_tdd)
+        ransac_tdd_statistics.print(num_frames, reference_ms);
+
+    if (use_ransac_sprt)
+        ransac_sprt_statistics.print(num_frames, reference_ms);
+
+    if (use_ransac_gc)
+        ransac_gc_statistics.print(num_frames, reference_ms);
+
+    if (use_prosac)
+        prosac_statistics.print(num_frames, reference_ms);
+
+    if (use_arrsac)
+        arrsac_statistics.print(num_frames, reference_ms);
+
+    return 0;
+}
+
+
+void ModelEstimationBenchmarkApplication::generate_matches(
+    const int num_matches, const float inliers_fraction, const float ranking_quality,
+    const float inliers_noise, const bool clustered_inliers)
+{
+    static boost::mt19937 random_generator;
+    boost::variate_generator<boost::mt19937&, boost::uniform_real<float> >
+    random_uniform(random_generator, boost::uniform_real<float>(0, 1));
+    boost::variate_generator<boost::mt19937&, boost::normal_distribution<float> >
+    random_normal(random_generator, boost::normal_distribution<float>(0, 1));
+
+    const int width = 640, height = 480;
+
+    // a random homography, close to a rotation, translation and scaling
+    const float angle = 0.2f * (random_uniform() - 0.5f);
+    const float scale = 0.9f + 0.2f * random_uniform();
+    float *h = true_homography;
+    h[0] = scale * cos(angle);
+    h[1] = -scale * sin(angle);
+    h[2] = 40.0f * (random_uniform() - 0.5f);
+    h[3] = scale * sin(angle);
+    h[4] = scale * cos(angle);
+    h[5] = 40.0f * (random_uniform() - 0.5f);
+    h[6] = 1e-4f * (random_uniform() - 0.5f);
+    h[7] = 1e-4f * (random_uniform() - 0.5f);
+    h[8] = 1.0f;
+
+    // the vectors are sized before taking pointers to their elements
+    features_a.resize(num_matches);
+    features_b.resize(num_matches);
+    matches.resize(num_matches);
+    is_true_inlier.resize(num_matches);
+
+    int i;
+    for (i=0; i < num_matches; i+=1)
+    {
+        FASTFeature &a = features_a[i];
+        FASTFeature &b = features_b[i];
+        a.x = static_cast<int>(random_uniform() * (width - 1));
+        a.y = static_cast<int>(random_uniform() * (height - 1));
+
+        is_true_inlier[i] = (random_uniform() < inliers_fraction);
+        if (is_true_inlier[i])
+        {
+            if (clustered_inliers)
+            {
+                a.x = width / 4 + a.x / 2;
+                a.y = height / 4 + a.y / 2;
+            }
+
+            float noise_x = 0, noise_y = 0;
+            if (inliers_noise > 0)
+            {
+                noise_x = inliers_noise * random_normal();
+                noise_y = inliers_noise * random_normal();
+            }
+
+            const float w = h[6]*a.x + h[7]*a.y + h[8];
+            b.x = static_cast<int>(floor((h[0]*a.x + h[1]*a.y + h[2]) / w + noise_x + 0.5f));
+            b.y = static_cast<int>(floor((h[3]*a.x + h[4]*a.y + h[5]) / w + noise_y + 0.5f));
+        }
+        else
+        {
+            b.x = static_cast<int>(random_uniform() * (width - 1));
+            b.y = static_cast<int>(random_uniform() * (height - 1));
+        }
+
+        ScoredMatch &match = matches[i];
+        match.feature_a = &a;
+        match.feature_b = &b;
+        match.index_a = i;
+        match.index_b = i;
+        match.distance = random_uniform();
+        if (is_true_inlier[i])
+            match.distance *= (1.0f - ranking_quality);
+        else
+            match.distance = ranking_quality + (1.0f - ranking_quality) * match.distance;
+    }
+
+    return;
+}
+
+
+} // end of namespace uniclop
+
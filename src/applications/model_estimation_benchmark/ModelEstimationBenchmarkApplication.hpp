@@ -0,0 +1,47 @@
+
+
+#if !defined(MODEL_ESTIMATION_BENCHMARK_APPLICATION_HEADER)
+#define MODEL_ESTIMATION_BENCHMARK_APPLICATION_HEADER
+
+#include "applications/AbstractApplication.hpp"
+
+#include "algorithms/features/ScoredMatch.hpp"
+#include "algorithms/features/fast/FASTFeature.hpp"
+
+#include <vector>
+
+namespace uniclop
+{
+
+using namespace std;
+
+/**
+ * Compares the robust model estimators on synthetic matches.
+ * The matches follow a random homography (plus some outliers), and their ScoredMatch::distance
+ * is more likely to be small for the inliers than for the outliers. No video input is required.
+ * The estimated models are compared to the true homography, before and after HomographyModel::estimate
+ * is run on their inliers.
+ */
+class ModelEstimationBenchmarkApplication : public AbstractApplication
+{
+
+public:
+    string get_application_title() const;
+    args::options_description get_command_line_options(void) const;
+    int main_loop(args::variables_map &options);
+
+private:
+
+    vector<FASTFeature> features_a, features_b;
+    vector< ScoredMatch > matches;
+    vector<bool> is_true_inlier;
+    float true_homography[9];
+
+    void generate_matches(const int num_matches, const float inliers_fraction, const float ranking_quality,
+                          const float inliers_noise, const bool clustered_inliers);
+
+};
+
+}
+
+#endif // MODEL_ESTIMATION_BENCHMARK_APPLICATION_HEADER
@@ -0,0 +1,14 @@
+
+
+#include "ModelEstimationBenchmarkApplication.hpp"
+#include <boost/scoped_ptr.hpp>
+
+
+int main(int argc, char *argv[])
+{
+    using uniclop::ModelEstimationBenchmarkApplication;
+    using uniclop::AbstractApplication;
+
+    boost::scoped_ptr<AbstractApplication> application_p(new ModelEstimationBenchmarkApplication());
+    return application_p->main(argc, argv);
+}
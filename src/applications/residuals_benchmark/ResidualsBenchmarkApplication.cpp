@@ -0,0 +1,294 @@
+/*
+Benchmark of the models residuals computation, per match and batched
+*/
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// Headers
+
+#include "ResidualsBenchmarkApplication.hpp"
+
+#include "algorithms/model_estimation/models/HomographyModel.hpp"
+#include "algorithms/model_estimation/models/FundamentalMatrixModel.hpp"
+#include "algorithms/model_estimation/models/BatchedResiduals.hpp"
+
+#include <boost/random.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+
+namespace uniclop
+{
+
+using namespace std;
+namespace posix_time = boost::posix_time;
+
+
+string ResidualsBenchmarkApplication::get_application_title() const
+{
+    return "Residuals benchmark. Uniclop 2009";
+}
+
+args::options_description ResidualsBenchmarkApplication::get_command_line_options(void) const
+{
+    args::options_description desc("ResidualsBenchmarkApplication options");
+
+    desc.add_options()
+
+    ("benchmark.num_matches", args::value<int>()->default_value(1000),
+     "number of matches evaluated by each call")
+
+    ("benchmark.repetitions", args::value<int>()->default_value(2000),
+     "number of calls per measure")
+
+    ("benchmark.num_homographies", args::value<int>()->default_value(200),
+     "number of random homographies on which the batched residuals are compared to compute_residuals")
+    ;
+
+    return desc;
+}
+
+
+// helper function, prints the throughput of a measure
+void print_throughput(const string &name, const posix_time::time_duration &duration, const double num_evaluated)
+{
+    const double seconds = max(duration.total_microseconds() * 1e-6, 1e-9);
+    printf("%s: %.1f [Mmatches/second]\n", name.c_str(), num_evaluated / (seconds * 1e6));
+    return;
+}
+
+// helper function, largest difference relative to the reference residuals
+template<typename T>
+double max_relative_difference(const vector<float> &reference, const vector<T> &residuals)
+{
+    double max_difference = 0;
+    unsigned int i;
+    for (i=0; i < reference.size(); i+=1)
+    {
+        const double difference = fabs(static_cast<double>(residuals[i]) - reference[i]);
+        max_difference = max(max_difference, difference / max(1.0, fabs(static_cast<double>(reference[i]))));
+    }
+    return max_difference;
+}
+
+
+int ResidualsBenchmarkApplication::main_loop(args::variables_map &options)
+{
+
+    const int num_matches = options["benchmark.num_matches"].as<int>();
+    const int repetitions = options["benchmark.repetitions"].as<int>();
+    const double num_evaluated = static_cast<double>(num_matches) * repetitions;
+
+    generate_matches(num_matches);
+
+    // a homography close to a rotation plus translation
+    ublas::vector<float> homography(9);
+    homography[0] = 0.98f; homography[1] = -0.17f; homography[2] = 12.0f;
+    homography[3] = 0.17f; homography[4] = 0.98f; homography[5] = -7.0f;
+    homography[6] = 1e-5f; homography[7] = -2e-5f; homography[8] = 1.0f;
+
+    HomographyModel homography_model;
+    homography_model.set_parameters(homography);
+
+    // F = K^-T [t]x R K^-1, for a camera moving sideways and rotating around the vertical axis
+    const double focal_length = 500, center_x = 320, center_y = 240;
+    const double angle = 0.1, t[3] = {1.0, 0.1, 0.05};
+    const double rotation[9] = { cos(angle), 0, sin(angle), 0, 1, 0, -sin(angle), 0, cos(angle) };
+    const double t_cross[9] = { 0, -t[2], t[1], t[2], 0, -t[0], -t[1], t[0], 0 };
+    const double k_inverse[9] = { 1 / focal_length, 0, -center_x / focal_length,
+                                  0, 1 / focal_length, -center_y / focal_length,
+                                  0, 0, 1
+                                };
+    double essential[9], fundamental[9], temporary[9];
+    int r, c, k;
+    for (r=0; r < 3; r+=1)
+        for (c=0; c < 3; c+=1)
+        {
+            essential[3*r + c] = 0;
+            for (k=0; k < 3; k+=1)
+                essential[3*r + c] += t_cross[3*r + k] * rotation[3*k + c];
+        }
+    for (r=0; r < 3; r+=1)
+        for (c=0; c < 3; c+=1)
+        {
+            temporary[3*r + c] = 0;
+            for (k=0; k < 3; k+=1)
+                temporary[3*r + c] += essential[3*r + k] * k_inverse[3*k + c];
+        }
+    ublas::vector<float> fundamental_parameters(9);
+    for (r=0; r < 3; r+=1)
+        for (c=0; c < 3; c+=1)
+        {
+            fundamental[3*r + c] = 0;
+            for (k=0; k < 3; k+=1)
+                fundamental[3*r + c] += k_inverse[3*k + r] * temporary[3*k + c];
+            fundamental_parameters[3*r + c] = static_cast<float>(fundamental[3*r + c]);
+        }
+
+    FundamentalMatrixModel fundamental_matrix_model;
+    fundamental_matrix_model.set_parameters(fundamental_parameters);
+
+    MatchesCoordinates<float> coordinates_float;
+    MatchesCoordinates<double> coordinates_double;
+    vector<float> residuals, residuals_float;
+    vector<double> residuals_double;
+
+    printf("%i matches, %i repetitions\n", num_matches, repetitions);
+
+    int i;
+    posix_time::ptime start_time;
+
+    // reading the coordinates --
+    start_time = posix_time::microsec_clock::local_time();
+    for (i=0; i < repetitions; i+=1)
+        coordinates_float.set_matches(matches);
+    print_throughput("MatchesCoordinates<float>::set_matches",
+                     posix_time::microsec_clock::local_time() - start_time, num_evaluated);
+
+    coordinates_double.set_matches(matches);
+
+    // homography --
+    start_time = posix_time::microsec_clock::local_time();
+    for (i=0; i < repetitions; i+=1)
+        homography_model.compute_residuals(matches, residuals);
+    print_throughput("HomographyModel per match",
+                     posix_time::microsec_clock::local_time() - start_time, num_evaluated);
+
+    start_time = posix_time::microsec_clock::local_time();
+    for (i=0; i < repetitions; i+=1)
+        homography_model.compute_residuals(coordinates_float, residuals_float);
+    print_throughput("HomographyModel batched float",
+                     posix_time::microsec_clock::local_time() - start_time, num_evaluated);
+
+    start_time = posix_time::microsec_clock::local_time();
+    for (i=0; i < repetitions; i+=1)
+        homography_model.compute_residuals(coordinates_double, residuals_double);
+    print_throughput("HomographyModel batched double",
+                     posix_time::microsec_clock::local_time() - start_time, num_evaluated);
+
+    printf("HomographyModel batched residuals, max relative difference: float %.2e, double %.2e\n",
+           max_relative_difference(residuals, residuals_float),
+           max_relative_difference(residuals, residuals_double));
+
+    // fundamental matrix --
+    start_time = posix_time::microsec_clock::local_time();
+    for (i=0; i < repetitions; i+=1)
+        fundamental_matrix_model.compute_residuals(matches, residuals);
+    print_throughput("FundamentalMatrixModel per match",
+                     posix_time::microsec_clock::local_time() - start_time, num_evaluated);
+
+    start_time = posix_time::microsec_clock::local_time();
+    for (i=0; i < repetitions; i+=1)
+        fundamental_matrix_model.compute_sampson_errors(coordinates_float, residuals_float);
+    print_throughput("FundamentalMatrixModel batched Sampson float",
+                     posix_time::microsec_clock::local_time() - start_time, num_evaluated);
+
+    start_time = posix_time::microsec_clock::local_time();
+    for (i=0; i < repetitions; i+=1)
+        fundamental_matrix_model.compute_sampson_errors(coordinates_double, residuals_double);
+    print_throughput("FundamentalMatrixModel batched Sampson double",
+                     posix_time::microsec_clock::local_time() - start_time, num_evaluated);
+
+    vector<float> sampson_reference(residuals_double.begin(), residuals_double.end());
+    printf("FundamentalMatrixModel batched Sampson float, max relative difference to double: %.2e\n",
+           max_relative_difference(sampson_reference, residuals_float));
+
+    check_random_homographies(options["benchmark.num_homographies"].as<int>());
+
+    return 0;
+}
+
+
+void ResidualsBenchmarkApplication::check_random_homographies(const int num_homographies)
+{
+    // the tolerances stated in BatchedResiduals.hpp
+    const double float_tolerance = 1e-3, double_tolerance = 1e-6;
+
+    boost::mt19937 random_generator(42);
+    boost::variate_generator<boost::mt19937&, boost::uniform_real<double> >
+    random_value(random_generator, boost::uniform_real<double>(-1, 1));
+
+    HomographyModel homography_model;
+    ublas::vector<float> homography(9);
+    MatchesCoordinates<float> coordinates_float;
+    MatchesCoordinates<double> coordinates_double;
+    vector<float> residuals, residuals_float;
+    vector<double> residuals_double;
+
+    coordinates_float.set_matches(matches);
+    coordinates_double.set_matches(matches);
+
+    double max_float_difference = 0, max_double_difference = 0;
+    int num_float_failures = 0, num_double_failures = 0;
+
+    int i;
+    for (i=0; i < num_homographies; i+=1)
+    {
+        // rotation, scale, shear, translation and perspective of the amplitude
+        // expected between two frames of a 640x480 video
+        const double angle = 0.5 * random_value(), scale = 1 + 0.3 * random_value();
+        homography[0] = scale * cos(angle) + 0.05 * random_value();
+        homography[1] = -scale * sin(angle) + 0.05 * random_value();
+        homography[2] = 100 * random_value();
+        homography[3] = scale * sin(angle) + 0.05 * random_value();
+        homography[4] = scale * cos(angle) + 0.05 * random_value();
+        homography[5] = 100 * random_value();
+        homography[6] = 2e-4 * random_value();
+        homography[7] = 2e-4 * random_value();
+        homography[8] = 1;
+        homography_model.set_parameters(homography);
+
+        homography_model.compute_residuals(matches, residuals);
+        homography_model.compute_residuals(coordinates_float, residuals_float);
+        homography_model.compute_residuals(coordinates_double, residuals_double);
+
+        const double float_difference = max_relative_difference(residuals, residuals_float);
+        const double double_difference = max_relative_difference(residuals, residuals_double);
+        max_float_difference = max(max_float_difference, float_difference);
+        max_double_difference = max(max_double_difference, double_difference);
+        num_float_failures += (float_difference > float_tolerance) ? 1 : 0;
+        num_double_failures += (double_difference > double_tolerance) ? 1 : 0;
+    }
+
+    printf("HomographyModel batched residuals on %i random homographies, max relative difference to "
+           "compute_residuals: float %.2e (%i above %.0e), double %.2e (%i above %.0e)\n",
+           num_homographies, max_float_difference, num_float_failures, float_tolerance,
+           max_double_difference, num_double_failures, double_tolerance);
+    return;
+}
+
+
+void ResidualsBenchmarkApplication::generate_matches(const int num_matches)
+{
+    boost::mt19937 random_generator;
+    boost::variate_generator<boost::mt19937&, boost::uniform_int<int> >
+    random_x(random_generator, boost::uniform_int<int>(0, 639)),
+    random_y(random_generator, boost::uniform_int<int>(0, 479));
+
+    // the vectors are sized before taking pointers to their elements
+    features_a.resize(num_matches);
+    features_b.resize(num_matches);
+    matches.resize(num_matches);
+
+    int i;
+    for (i=0; i < num_matches; i+=1)
+    {
+        features_a[i].x = random_x();
+        features_a[i].y = random_y();
+        features_b[i].x = random_x();
+        features_b[i].y = random_y();
+
+        matches[i].feature_a = &features_a[i];
+        matches[i].feature_b = &features_b[i];
+        matches[i].index_a = i;
+        matches[i].index_b = i;
+        matches[i].distance = 0;
+    }
+
+    return;
+}
+
+
+} // end of namespace uniclop
+
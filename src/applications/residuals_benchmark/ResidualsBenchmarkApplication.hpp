@@ -0,0 +1,44 @@
+#if !defined(RESIDUALS_BENCHMARK_APPLICATION_HEADER)
+#define RESIDUALS_BENCHMARK_APPLICATION_HEADER
+
+#include "applications/AbstractApplication.hpp"
+
+#include "algorithms/features/ScoredMatch.hpp"
+#include "algorithms/features/fast/FASTFeature.hpp"
+
+#include <vector>
+
+namespace uniclop
+{
+
+using namespace std;
+
+/**
+ * Measures how many matches per second the two view models can evaluate,
+ * with the per match residuals and with the batched (SIMD) residuals.
+ * Runs on random matches, no video input is required.
+ */
+class ResidualsBenchmarkApplication : public AbstractApplication
+{
+
+public:
+    string get_application_title() const;
+    args::options_description get_command_line_options(void) const;
+    int main_loop(args::variables_map &options);
+
+private:
+
+    vector<FASTFeature> features_a, features_b;
+    vector< ScoredMatch > matches;
+
+    void generate_matches(const int num_matches);
+
+    /// compares the batched homography residuals with compute_residuals,
+    /// prints the largest differences and the number of homographies above the tolerances
+    void check_random_homographies(const int num_homographies);
+
+};
+
+}
+
+#endif // RESIDUALS_BENCHMARK_APPLICATION_HEADER
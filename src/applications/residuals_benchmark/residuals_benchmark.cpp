@@ -0,0 +1,14 @@
+
+
+#include "ResidualsBenchmarkApplication.hpp"
+#include <boost/scoped_ptr.hpp>
+
+
+int main(int argc, char *argv[])
+{
+    using uniclop::ResidualsBenchmarkApplication;
+    using uniclop::AbstractApplication;
+
+    boost::scoped_ptr<AbstractApplication> application_p(new ResidualsBenchmarkApplication());
+    return application_p->main(argc, argv);
+}
@@ -0,0 +1,153 @@
+
+
+#include "ThreadPool.hpp"
+
+#include <exception>
+#include <stdexcept>
+
+#include <boost/bind.hpp>
+
+namespace uniclop
+{
+
+// ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+// class ThreadPool methods implementation
+
+ThreadPool::ThreadPool(const int _num_threads)
+{
+    num_threads = (_num_threads < 1) ? 1 : _num_threads;
+
+    current_task_p = NULL;
+    num_tasks = 0;
+    next_task = 0;
+    num_finished_tasks = 0;
+    batch_index = 0;
+    stop = false;
+    task_failed = false;
+
+    int i;
+    for (i=1; i < num_threads; i+=1)
+    { // the calling thread is the first thread of the pool
+        worker_threads.create_thread(boost::bind(&ThreadPool::worker_loop, this));
+    }
+
+    return;
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        stop = true;
+    }
+    batch_started.notify_all();
+    worker_threads.join_all();
+    return;
+}
+
+int ThreadPool::get_num_threads() const
+{
+    return num_threads;
+}
+
+void ThreadPool::run(const int _num_tasks, const task_t &task)
+{
+    if (_num_tasks <= 0)
+        return;
+
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        current_task_p = &task;
+        num_tasks = _num_tasks;
+        next_task = 0;
+        num_finished_tasks = 0;
+        task_failed = false;
+        batch_index += 1;
+    }
+    batch_started.notify_all();
+
+    execute_tasks();
+
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        while (num_finished_tasks < num_tasks)
+            batch_finished.wait(lock);
+
+        current_task_p = NULL;
+
+        if (task_failed)
+            throw runtime_error("ThreadPool task failed: " + failure_message);
+    }
+
+    return;
+}
+
+void ThreadPool::worker_loop()
+{
+    int last_batch_index = 0;
+
+    while (true)
+    {
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            while (stop == false && (batch_index == last_batch_index || current_task_p == NULL))
+                batch_started.wait(lock);
+
+            if (stop)
+                return;
+
+            last_batch_index = batch_index;
+        }
+
+        execute_tasks();
+    }
+
+    return;
+}
+
+void ThreadPool::execute_tasks()
+{
+    while (true)
+    {
+        // the task and its index are retrieved together,
+        // so that a late worker can not mix two batches
+        const task_t *task_p;
+        int task_index;
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            if (current_task_p == NULL || next_task >= num_tasks)
+                return;
+            task_p = current_task_p;
+            task_index = next_task;
+            next_task += 1;
+        }
+
+        try
+        {
+            (*task_p)(task_index);
+        }
+        catch (std::exception &e)
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            task_failed = true;
+            failure_message = e.what();
+        }
+        catch (...)
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            task_failed = true;
+            failure_message = "unknown exception";
+        }
+
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            num_finished_tasks += 1;
+            if (num_finished_tasks == num_tasks)
+                batch_finished.notify_all();
+        }
+    }
+
+    return;
+}
+
+}
@@ -0,0 +1,65 @@
+#if !defined(THREAD_POOL_HEADER)
+#define THREAD_POOL_HEADER
+
+// Minimal pool of persistent worker threads
+
+#include <boost/function.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include <string>
+
+namespace uniclop
+{
+
+using namespace std;
+
+/**
+Runs batches of indexed tasks over a fixed set of threads.
+
+run(num_tasks, task) calls task(i) for every i in [0, num_tasks) and returns once all
+the calls have finished. The calling thread also executes tasks, so a pool of
+N threads uses N-1 worker threads. The workers are created once and sleep between batches,
+so launching a batch costs no thread creation nor memory allocation.
+
+Tasks must not throw, if they do the exception is reported by run() as a runtime_error,
+after the whole batch has completed.
+*/
+class ThreadPool
+{
+
+public:
+
+    typedef boost::function<void (int)> task_t;
+
+    ThreadPool(const int num_threads);
+    ~ThreadPool();
+
+    int get_num_threads() const;
+
+    void run(const int num_tasks, const task_t &task);
+
+private:
+
+    int num_threads;
+    boost::thread_group worker_threads;
+
+    boost::mutex mutex;
+    boost::condition_variable batch_started, batch_finished;
+
+    const task_t *current_task_p;
+    int num_tasks, next_task, num_finished_tasks;
+    int batch_index; ///< incremented at each call of run, used to wake up the workers
+    bool stop;
+
+    bool task_failed;
+    string failure_message;
+
+    void worker_loop();
+    void execute_tasks();
+};
+
+}
+
+#endif // THREAD_POOL_HEADER
@@ -0,0 +1,41 @@
+
+
+#include "cpu_features.hpp"
+
+namespace uniclop
+{
+
+// the queries are done only once, at first call,
+// so that the dispatching code can call these functions freely
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+
+bool cpu_has_sse2()
+{
+    // __builtin_cpu_init is required when called before the static constructors have been run
+    static const bool has_sse2 = (__builtin_cpu_init(), __builtin_cpu_supports("sse2") != 0);
+    return has_sse2;
+}
+
+bool cpu_has_avx2()
+{
+    // __builtin_cpu_supports also checks that the OS saves the ymm registers
+    static const bool has_avx2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2") != 0);
+    return has_avx2;
+}
+
+#else // not a x86 gcc compiler, only the scalar code paths will be used
+
+bool cpu_has_sse2()
+{
+    return false;
+}
+
+bool cpu_has_avx2()
+{
+    return false;
+}
+
+#endif
+
+}
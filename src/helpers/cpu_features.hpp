@@ -0,0 +1,17 @@
+#if !defined(CPU_FEATURES_HEADER)
+#define CPU_FEATURES_HEADER
+
+// Runtime detection of the SIMD instruction sets supported by the cpu
+
+namespace uniclop
+{
+
+/// true if the cpu supports the SSE2 instructions
+bool cpu_has_sse2();
+
+/// true if the cpu (and the operating system) support the AVX2 instructions
+bool cpu_has_avx2();
+
+}
+
+#endif // CPU_FEATURES_HEADER